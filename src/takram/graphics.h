@@ -37,14 +37,54 @@ extern const unsigned char version_string[];
 }  // namespace graphics
 }  // namespace takram
 
+#include "takram/graphics/blend_mode.h"
+#include "takram/graphics/blending.h"
+#include "takram/graphics/boolean.h"
+#include "takram/graphics/boolean_operation.h"
 #include "takram/graphics/channel.h"
+#include "takram/graphics/channel_order.h"
 #include "takram/graphics/color.h"
+#include "takram/graphics/color_lut.h"
+#include "takram/graphics/color_space.h"
 #include "takram/graphics/depth.h"
+#include "takram/graphics/depth_conversion.h"
+#include "takram/graphics/dither.h"
+#include "takram/graphics/dither_method.h"
+#include "takram/graphics/fill_rule.h"
+#include "takram/graphics/fixed_point.h"
+#include "takram/graphics/gradient.h"
+#include "takram/graphics/gradient_spread.h"
+#include "takram/graphics/half.h"
+#include "takram/graphics/histogram.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+#include "takram/graphics/image_view.h"
 #include "takram/graphics/conic.h"
 #include "takram/graphics/command.h"
 #include "takram/graphics/command_type.h"
+#include "takram/graphics/composite_operation.h"
+#include "takram/graphics/compositing.h"
+#include "takram/graphics/hasher.h"
+#include "takram/graphics/intersector.h"
+#include "takram/graphics/join_type.h"
+#include "takram/graphics/monotone_segments.h"
+#include "takram/graphics/offsetter.h"
+#include "takram/graphics/packed_color.h"
+#include "takram/graphics/palette.h"
+#include "takram/graphics/palette_method.h"
 #include "takram/graphics/path.h"
 #include "takram/graphics/path_direction.h"
+#include "takram/graphics/premultiplied_color.h"
+#include "takram/graphics/projector.h"
+#include "takram/graphics/rect_clipper.h"
+#include "takram/graphics/segment.h"
+#include "takram/graphics/segment_range.h"
+#include "takram/graphics/segment_views.h"
 #include "takram/graphics/shape.h"
+#include "takram/graphics/shape_interner.h"
+#include "takram/graphics/shared_shape.h"
+#include "takram/graphics/srgb.h"
+#include "takram/graphics/tone_map_operator.h"
+#include "takram/graphics/tone_mapping.h"
 
 #endif  // TAKRAM_GRAPHICS_H_
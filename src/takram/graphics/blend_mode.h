@@ -0,0 +1,81 @@
+//
+//  takram/graphics/blend_mode.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_BLEND_MODE_H_
+#define TAKRAM_GRAPHICS_BLEND_MODE_H_
+
+#include <cassert>
+#include <ostream>
+
+namespace takram {
+namespace graphics {
+
+enum class BlendMode {
+  NORMAL,
+  MULTIPLY,
+  SCREEN,
+  OVERLAY,
+  DARKEN,
+  LIGHTEN,
+  COLOR_DODGE,
+  COLOR_BURN,
+  HARD_LIGHT,
+  SOFT_LIGHT,
+  DIFFERENCE,
+  EXCLUSION
+};
+
+inline std::ostream& operator<<(std::ostream& os, BlendMode mode) {
+  switch (mode) {
+    case BlendMode::NORMAL: os << "normal"; break;
+    case BlendMode::MULTIPLY: os << "multiply"; break;
+    case BlendMode::SCREEN: os << "screen"; break;
+    case BlendMode::OVERLAY: os << "overlay"; break;
+    case BlendMode::DARKEN: os << "darken"; break;
+    case BlendMode::LIGHTEN: os << "lighten"; break;
+    case BlendMode::COLOR_DODGE: os << "color dodge"; break;
+    case BlendMode::COLOR_BURN: os << "color burn"; break;
+    case BlendMode::HARD_LIGHT: os << "hard light"; break;
+    case BlendMode::SOFT_LIGHT: os << "soft light"; break;
+    case BlendMode::DIFFERENCE: os << "difference"; break;
+    case BlendMode::EXCLUSION: os << "exclusion"; break;
+    default:
+      assert(false);
+      break;
+  }
+  return os;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::BlendMode;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_BLEND_MODE_H_
@@ -0,0 +1,482 @@
+//
+//  takram/graphics/blending.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_BLENDING_H_
+#define TAKRAM_GRAPHICS_BLENDING_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "takram/graphics/blend_mode.h"
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/depth_conversion.h"
+#include "takram/graphics/image_view.h"
+#include "takram/graphics/premultiplied_color.h"
+#include "takram/graphics/simd.h"
+
+namespace takram {
+namespace graphics {
+
+// Blends source colors onto backdrop colors with the separable blend modes of
+// the W3C compositing specification, then composites the result with the
+// source-over operator. Every channel of the result is the sum of the source
+// weighted by the absence of the backdrop, the backdrop weighted by the
+// absence of the source, and the blend function of the two weighted by their
+// coverage. Each mode is compiled into a loop of its own, so that the mode is
+// switched on once per span rather than per pixel. The channels of a pixel are
+// computed in the four lanes of an SSE2 vector where available, and integer
+// channels are converted to and from floats on the way. Images are assumed to
+// hold premultiplied colors, as in compositing.
+
+template <class T>
+Color4<T> blend(const Color4<T>& source,
+                const Color4<T>& backdrop,
+                BlendMode mode);
+template <class T>
+PremultipliedColor<T> blend(const PremultipliedColor<T>& source,
+                            const PremultipliedColor<T>& backdrop,
+                            BlendMode mode);
+template <class T>
+void blend(const Color4<T> *source,
+           Color4<T> *destination,
+           std::size_t size,
+           BlendMode mode);
+template <class T>
+void blend(const PremultipliedColor<T> *source,
+           PremultipliedColor<T> *destination,
+           std::size_t size,
+           BlendMode mode);
+template <class T, class U>
+void blend(const ImageView<U, 4>& source,
+           ImageView<T, 4> destination,
+           BlendMode mode);
+
+#pragma mark -
+
+namespace detail {
+
+#if TAKRAM_GRAPHICS_HAS_SSE2
+
+inline Lanes broadcastAlpha(const Lanes& a) {
+  return _mm_shuffle_ps(a.value, a.value, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// Replaces the alpha lane of the color with that of the other
+inline Lanes replaceAlpha(const Lanes& color, const Lanes& alpha) {
+  const auto mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+  return _mm_or_ps(_mm_and_ps(mask, alpha.value),
+                   _mm_andnot_ps(mask, color.value));
+}
+
+inline Lanes loadLanes(const std::uint8_t *values) {
+  std::int32_t packed;
+  std::memcpy(&packed, values, sizeof(packed));
+  const auto zero = _mm_setzero_si128();
+  const auto integers = _mm_unpacklo_epi16(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+  return _mm_mul_ps(_mm_cvtepi32_ps(integers), _mm_set1_ps(1.0f / 0xff));
+}
+
+// Rounds halves away from zero as Depth does
+inline void storeLanes(const Lanes& lanes, std::uint8_t *values) {
+  const auto integers = convertDepthFromFloat(lanes.value, _mm_set1_ps(0xff));
+  const auto words = _mm_packs_epi32(integers, integers);
+  const std::int32_t packed = _mm_cvtsi128_si32(
+      _mm_packus_epi16(words, words));
+  std::memcpy(values, &packed, sizeof(packed));
+}
+
+#else  // TAKRAM_GRAPHICS_HAS_SSE2
+
+inline Lanes broadcastAlpha(const Lanes& a) {
+  return Lanes(a.value[3]);
+}
+
+inline Lanes replaceAlpha(const Lanes& color, const Lanes& alpha) {
+  auto result = color;
+  result.value[3] = alpha.value[3];
+  return result;
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+
+// Other channel types go through their depth conversions
+template <class T>
+inline Lanes loadLanes(const T *values) {
+  float converted[4];
+  for (int i{}; i < 4; ++i) {
+    converted[i] = Depth<float>::convert(values[i]);
+  }
+  return loadLanes(static_cast<const float *>(converted));
+}
+
+template <class T>
+inline void storeLanes(const Lanes& lanes, T *values) {
+  float converted[4];
+  storeLanes(min(max(lanes, Lanes(0)), Lanes(1)),
+             static_cast<float *>(converted));
+  for (int i{}; i < 4; ++i) {
+    values[i] = Depth<T>::convert(converted[i]);
+  }
+}
+
+// The blend functions of the backdrop and source colors
+template <BlendMode Mode>
+struct BlendFunction;
+
+template <>
+struct BlendFunction<BlendMode::NORMAL> {
+  static Lanes apply(const Lanes&, const Lanes& source) {
+    return source;
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::MULTIPLY> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    return backdrop * source;
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::SCREEN> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    return backdrop + source - backdrop * source;
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::HARD_LIGHT> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    const auto doubled = source + source;
+    const auto screened = doubled - Lanes(1);
+    return select(lessEqual(source, Lanes(0.5)),
+                  backdrop * doubled,
+                  backdrop + screened - backdrop * screened);
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::OVERLAY> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    return BlendFunction<BlendMode::HARD_LIGHT>::apply(source, backdrop);
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::DARKEN> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    return min(backdrop, source);
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::LIGHTEN> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    return max(backdrop, source);
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::COLOR_DODGE> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    const Lanes one(1);
+    return select(lessEqual(backdrop, Lanes(0)), Lanes(0),
+                  select(lessEqual(one, source), one,
+                         min(one, backdrop / (one - source))));
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::COLOR_BURN> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    const Lanes one(1);
+    return select(lessEqual(one, backdrop), one,
+                  select(lessEqual(source, Lanes(0)), Lanes(0),
+                         one - min(one, (one - backdrop) / source)));
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::SOFT_LIGHT> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    const Lanes one(1);
+    const auto polynomial = ((Lanes(16) * backdrop - Lanes(12)) *
+                             backdrop + Lanes(4)) * backdrop;
+    const auto darkened = select(lessEqual(backdrop, Lanes(0.25)),
+                                 polynomial, sqrt(backdrop));
+    const auto doubled = source + source;
+    return select(lessEqual(source, Lanes(0.5)),
+                  backdrop - (one - doubled) * backdrop * (one - backdrop),
+                  backdrop + (doubled - one) * (darkened - backdrop));
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::DIFFERENCE> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    return max(backdrop - source, source - backdrop);
+  }
+};
+
+template <>
+struct BlendFunction<BlendMode::EXCLUSION> {
+  static Lanes apply(const Lanes& backdrop, const Lanes& source) {
+    const auto product = backdrop * source;
+    return backdrop + source - product - product;
+  }
+};
+
+// Blends straight colors given with their alphas in every lane, and returns
+// the premultiplied result
+template <BlendMode Mode>
+inline Lanes blendPixel(const Lanes& source,
+                        const Lanes& source_alpha,
+                        const Lanes& backdrop,
+                        const Lanes& backdrop_alpha) {
+  const auto coverage = source_alpha * backdrop_alpha;
+  const auto result = (
+      source * (source_alpha - coverage) +
+      backdrop * (backdrop_alpha - coverage) +
+      BlendFunction<Mode>::apply(backdrop, source) * coverage);
+  return replaceAlpha(result, source_alpha + backdrop_alpha - coverage);
+}
+
+// Divides color lanes by their alphas, leaving zero for zero alpha
+inline Lanes unpremultiplyLanes(const Lanes& color, const Lanes& alpha) {
+  const Lanes zero(0);
+  return select(lessEqual(alpha, zero), zero, color / alpha);
+}
+
+template <BlendMode Mode, class T>
+inline void blendSpan(const Color4<T> *source,
+                      Color4<T> *destination,
+                      std::size_t size) {
+  for (std::size_t i{}; i < size; ++i) {
+    const auto s = loadLanes(source[i].pointer());
+    const auto d = loadLanes(destination[i].pointer());
+    const auto result = blendPixel<Mode>(s, broadcastAlpha(s),
+                                         d, broadcastAlpha(d));
+    const auto alpha = broadcastAlpha(result);
+    storeLanes(replaceAlpha(unpremultiplyLanes(result, alpha), alpha),
+               destination[i].pointer());
+  }
+}
+
+template <BlendMode Mode, class T>
+inline void blendSpan(const PremultipliedColor<T> *source,
+                      PremultipliedColor<T> *destination,
+                      std::size_t size) {
+  for (std::size_t i{}; i < size; ++i) {
+    const auto s = loadLanes(source[i].pointer());
+    const auto d = loadLanes(destination[i].pointer());
+    const auto source_alpha = broadcastAlpha(s);
+    const auto destination_alpha = broadcastAlpha(d);
+    storeLanes(blendPixel<Mode>(unpremultiplyLanes(s, source_alpha),
+                                source_alpha,
+                                unpremultiplyLanes(d, destination_alpha),
+                                destination_alpha),
+               destination[i].pointer());
+  }
+}
+
+// Source-over needs no blend function, nor division by alpha
+template <class T>
+inline void blendNormal(const PremultipliedColor<T> *source,
+                        PremultipliedColor<T> *destination,
+                        std::size_t size) {
+  const Lanes one(1);
+  for (std::size_t i{}; i < size; ++i) {
+    const auto s = loadLanes(source[i].pointer());
+    const auto d = loadLanes(destination[i].pointer());
+    storeLanes(s + d * (one - broadcastAlpha(s)), destination[i].pointer());
+  }
+}
+
+}  // namespace detail
+
+template <class T>
+inline Color4<T> blend(const Color4<T>& source,
+                       const Color4<T>& backdrop,
+                       BlendMode mode) {
+  auto result = backdrop;
+  blend(&source, &result, 1, mode);
+  return result;
+}
+
+template <class T>
+inline PremultipliedColor<T> blend(const PremultipliedColor<T>& source,
+                                   const PremultipliedColor<T>& backdrop,
+                                   BlendMode mode) {
+  auto result = backdrop;
+  blend(&source, &result, 1, mode);
+  return result;
+}
+
+template <class T>
+inline void blend(const Color4<T> *source,
+                  Color4<T> *destination,
+                  std::size_t size,
+                  BlendMode mode) {
+  using detail::blendSpan;
+  switch (mode) {
+    case BlendMode::NORMAL:
+      blendSpan<BlendMode::NORMAL>(source, destination, size);
+      break;
+    case BlendMode::MULTIPLY:
+      blendSpan<BlendMode::MULTIPLY>(source, destination, size);
+      break;
+    case BlendMode::SCREEN:
+      blendSpan<BlendMode::SCREEN>(source, destination, size);
+      break;
+    case BlendMode::OVERLAY:
+      blendSpan<BlendMode::OVERLAY>(source, destination, size);
+      break;
+    case BlendMode::DARKEN:
+      blendSpan<BlendMode::DARKEN>(source, destination, size);
+      break;
+    case BlendMode::LIGHTEN:
+      blendSpan<BlendMode::LIGHTEN>(source, destination, size);
+      break;
+    case BlendMode::COLOR_DODGE:
+      blendSpan<BlendMode::COLOR_DODGE>(source, destination, size);
+      break;
+    case BlendMode::COLOR_BURN:
+      blendSpan<BlendMode::COLOR_BURN>(source, destination, size);
+      break;
+    case BlendMode::HARD_LIGHT:
+      blendSpan<BlendMode::HARD_LIGHT>(source, destination, size);
+      break;
+    case BlendMode::SOFT_LIGHT:
+      blendSpan<BlendMode::SOFT_LIGHT>(source, destination, size);
+      break;
+    case BlendMode::DIFFERENCE:
+      blendSpan<BlendMode::DIFFERENCE>(source, destination, size);
+      break;
+    case BlendMode::EXCLUSION:
+      blendSpan<BlendMode::EXCLUSION>(source, destination, size);
+      break;
+    default:
+      assert(false);
+      break;
+  }
+}
+
+template <class T>
+inline void blend(const PremultipliedColor<T> *source,
+                  PremultipliedColor<T> *destination,
+                  std::size_t size,
+                  BlendMode mode) {
+  using detail::blendSpan;
+  switch (mode) {
+    case BlendMode::NORMAL:
+      detail::blendNormal(source, destination, size);
+      break;
+    case BlendMode::MULTIPLY:
+      blendSpan<BlendMode::MULTIPLY>(source, destination, size);
+      break;
+    case BlendMode::SCREEN:
+      blendSpan<BlendMode::SCREEN>(source, destination, size);
+      break;
+    case BlendMode::OVERLAY:
+      blendSpan<BlendMode::OVERLAY>(source, destination, size);
+      break;
+    case BlendMode::DARKEN:
+      blendSpan<BlendMode::DARKEN>(source, destination, size);
+      break;
+    case BlendMode::LIGHTEN:
+      blendSpan<BlendMode::LIGHTEN>(source, destination, size);
+      break;
+    case BlendMode::COLOR_DODGE:
+      blendSpan<BlendMode::COLOR_DODGE>(source, destination, size);
+      break;
+    case BlendMode::COLOR_BURN:
+      blendSpan<BlendMode::COLOR_BURN>(source, destination, size);
+      break;
+    case BlendMode::HARD_LIGHT:
+      blendSpan<BlendMode::HARD_LIGHT>(source, destination, size);
+      break;
+    case BlendMode::SOFT_LIGHT:
+      blendSpan<BlendMode::SOFT_LIGHT>(source, destination, size);
+      break;
+    case BlendMode::DIFFERENCE:
+      blendSpan<BlendMode::DIFFERENCE>(source, destination, size);
+      break;
+    case BlendMode::EXCLUSION:
+      blendSpan<BlendMode::EXCLUSION>(source, destination, size);
+      break;
+    default:
+      assert(false);
+      break;
+  }
+}
+
+template <class T, class U>
+inline void blend(const ImageView<U, 4>& source,
+                  ImageView<T, 4> destination,
+                  BlendMode mode) {
+  static_assert(std::is_same<typename std::remove_const<U>::type, T>::value,
+                "Source and destination must have the same type of values");
+  static_assert(sizeof(PremultipliedColor<T>) == sizeof(T) * 4, "");
+  assert(source.width() == destination.width());
+  assert(source.height() == destination.height());
+  if (source.interleaved() && destination.interleaved()) {
+    for (int y{}; y < source.height(); ++y) {
+      blend(reinterpret_cast<const PremultipliedColor<T> *>(source.row(y)),
+            reinterpret_cast<PremultipliedColor<T> *>(destination.row(y)),
+            source.width(), mode);
+    }
+    return;
+  }
+  for (int y{}; y < source.height(); ++y) {
+    for (int x{}; x < source.width(); ++x) {
+      const auto s = source.pixel(x, y);
+      const auto d = destination.pixel(x, y);
+      const auto result = blend(PremultipliedColor<T>(s.r, s.g, s.b, s.a),
+                                PremultipliedColor<T>(d.r, d.g, d.b, d.a),
+                                mode);
+      destination.setPixel(x, y, Color4<T>(result.r, result.g,
+                                           result.b, result.a));
+    }
+  }
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::blend;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_BLENDING_H_
@@ -0,0 +1,616 @@
+//
+//  takram/graphics/boolean2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_BOOLEAN2_H_
+#define TAKRAM_GRAPHICS_BOOLEAN2_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "takram/graphics/boolean_operation.h"
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/fill_rule.h"
+#include "takram/graphics/intersector.h"
+#include "takram/graphics/monotone_segments.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment.h"
+#include "takram/math/promotion.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+template <class T, int D>
+class Boolean;
+
+template <class T>
+using Boolean2 = Boolean<T, 2>;
+
+// Boolean operations on lists of closed paths, each filled by the given fill
+// rule, which is the nonzero winding rule by default. The crossings between
+// the segments of both operands are found by Intersector2, which only pairs up
+// the monotone pieces whose bounds overlap. Segments are then divided at the
+// crossings and at their extrema without flattening, and each piece is kept
+// or discarded by the winding numbers of both operands on either side of it,
+// counted by MonotoneSegments2 along a ray that only visits the pieces near
+// it. The remaining pieces are finally linked back into closed paths.
+
+template <class T>
+class Boolean<T, 2> final {
+ public:
+  using Type = T;
+  static constexpr const int dimensions = 2;
+
+ public:
+  // Operations
+  static std::list<Path2<T>> apply(const std::list<Path2<T>>& lhs,
+                                   const std::list<Path2<T>>& rhs,
+                                   BooleanOperation operation,
+                                   FillRule rule = FillRule::NON_ZERO);
+  static std::list<Path2<T>> unite(
+      const std::vector<std::list<Path2<T>>>& operands);
+
+ private:
+  using Real = math::Promote<T>;
+
+  using MonotonePiece = typename MonotoneSegments2<T>::Piece;
+
+  struct Edge {
+    Segment2<T> segment;
+    int operand;
+    std::vector<std::pair<Real, Vec2<T>>> splits;
+  };
+
+  struct Piece {
+    Segment2<T> segment;
+    int operand;
+    std::size_t group;
+  };
+
+  Boolean(BooleanOperation operation, FillRule rule, Real tolerance);
+
+  // Disallow copy semantics
+  Boolean(const Boolean&) = delete;
+  Boolean& operator=(const Boolean&) = delete;
+
+  // Stages
+  void add(const std::list<Path2<T>>& paths, int operand);
+  void intersect();
+  void divide();
+  void group();
+  void classify();
+  std::list<Path2<T>> link() const;
+
+  // Vertices
+  template <class U>
+  bool near(const Vec2<Real>& a, const Vec2<U>& b) const;
+  Vec2<T> snap(const Vec2<T>& point);
+
+  // Classification
+  bool contains(int winding) const;
+  bool contains(const int *windings) const;
+  void wind(const Vec2<Real>& point,
+            int axis,
+            std::size_t group,
+            int *front,
+            int *behind) const;
+  static int direction(const Segment2<T>& segment, int axis);
+
+ private:
+  BooleanOperation operation_;
+  FillRule rule_;
+  Real tolerance_;
+  Path2<T> path_;
+  std::vector<Edge> edges_;
+  std::vector<Piece> pieces_;
+  std::vector<std::vector<std::size_t>> groups_;
+  std::vector<Segment2<T>> results_;
+  std::unordered_map<std::int64_t, std::vector<Vec2<T>>> vertices_;
+  MonotoneSegments2<T> windings_[2];
+};
+
+using Boolean2i = Boolean2<int>;
+using Boolean2f = Boolean2<float>;
+using Boolean2d = Boolean2<double>;
+
+#pragma mark -
+
+template <class T>
+inline Boolean<T, 2>::Boolean(BooleanOperation operation,
+                              FillRule rule,
+                              Real tolerance)
+    : operation_(operation),
+      rule_(rule),
+      tolerance_(tolerance) {}
+
+#pragma mark Operations
+
+template <class T>
+inline std::list<Path2<T>> Boolean<T, 2>::apply(
+    const std::list<Path2<T>>& lhs,
+    const std::list<Path2<T>>& rhs,
+    BooleanOperation operation,
+    FillRule rule) {
+  // Tolerance is relative to the magnitude of the coordinates, which is what
+  // limits the precision of the crossings.
+  Real scale{};
+  for (const auto *paths : {&lhs, &rhs}) {
+    for (const auto& path : *paths) {
+      const auto bounds = path.bounds();
+      scale = std::max({scale,
+                        std::abs(bounds.minX()), std::abs(bounds.maxX()),
+                        std::abs(bounds.minY()), std::abs(bounds.maxY())});
+    }
+  }
+  if (!scale) {
+    scale = 1;
+  }
+  const auto epsilon = std::numeric_limits<Real>::epsilon();
+  Boolean engine(operation, rule, scale / 16 * std::sqrt(epsilon));
+  engine.add(lhs, 0);
+  engine.add(rhs, 1);
+  engine.intersect();
+  engine.divide();
+  engine.group();
+  engine.classify();
+  return engine.link();
+}
+
+template <class T>
+inline std::list<Path2<T>> Boolean<T, 2>::unite(
+    const std::vector<std::list<Path2<T>>>& operands) {
+  if (operands.empty()) {
+    return std::list<Path2<T>>();
+  }
+  if (operands.size() == 1) {
+    return apply(operands.front(), std::list<Path2<T>>(),
+                 BooleanOperation::UNION);
+  }
+  // Unite pairs of operands in parallel, halving their number at each level
+  std::vector<std::list<Path2<T>>> current(operands);
+  while (current.size() > 1) {
+    std::vector<std::list<Path2<T>>> next((current.size() + 1) / 2);
+    parallelFor(next.size(), [&](std::size_t index) {
+      if (2 * index + 1 < current.size()) {
+        next[index] = apply(current[2 * index], current[2 * index + 1],
+                            BooleanOperation::UNION);
+      } else {
+        next[index].swap(current[2 * index]);
+      }
+    });
+    current.swap(next);
+  }
+  return std::move(current.front());
+}
+
+#pragma mark Stages
+
+template <class T>
+inline void Boolean<T, 2>::add(const std::list<Path2<T>>& paths,
+                               int operand) {
+  // Every subpath is filled, and therefore explicitly closed here. Vertices
+  // are snapped, so that both operands share the points where they meet, and
+  // segments that collapse to a point are dropped.
+  Path2<T> closed;
+  auto& commands = closed.commands();
+  Vec2<T> first;
+  const auto close = [&]() {
+    if (!commands.empty() && commands.back().point() != first) {
+      commands.emplace_back(CommandType::LINE, first);
+    }
+  };
+  for (const auto& path : paths) {
+    auto itr = std::begin(path.commands());
+    for (; itr != std::end(path.commands()); ++itr) {
+      if (itr == std::begin(path.commands()) ||
+          itr->type() == CommandType::MOVE) {
+        close();
+        first = snap(itr->point());
+        commands.emplace_back(CommandType::MOVE, first);
+      } else if (itr->type() == CommandType::CLOSE) {
+        close();
+        commands.emplace_back(CommandType::MOVE, first);
+      } else {
+        auto command = *itr;
+        command.point() = snap(command.point());
+        const auto& start = commands.back().point();
+        const auto bounds = Segment2<T>(start, command).bounds();
+        if (command.point() != start ||
+            bounds.width() > 2 * tolerance_ ||
+            bounds.height() > 2 * tolerance_) {
+          commands.emplace_back(command);
+        }
+      }
+    }
+    close();
+  }
+
+  // Segments are also divided at their extrema later, so that every piece is
+  // monotone.
+  const auto offset = edges_.size();
+  for (const auto& segment : closed.segments()) {
+    edges_.push_back({segment, operand, {}});
+  }
+  for (const auto& piece : MonotoneSegments2<T>(closed)) {
+    if (piece.begin > 0) {
+      edges_[offset + piece.index].splits.emplace_back(
+          piece.begin, snap(piece.segment.start()));
+    }
+  }
+  path_.commands().insert(std::end(path_.commands()),
+                          std::begin(commands), std::end(commands));
+}
+
+template <class T>
+inline void Boolean<T, 2>::intersect() {
+  const Intersector2<T> intersector(tolerance_);
+  for (const auto& intersection : intersector.intersect(path_)) {
+    auto& a = edges_[intersection.index1];
+    auto& b = edges_[intersection.index2];
+    auto ta = intersection.t1;
+    auto tb = intersection.t2;
+    const auto& point = intersection.point;
+    // Crossings at end points reuse the vertex that is already there
+    const Vec2<T> *vertex{};
+    if (near(point, a.segment.start())) {
+      ta = 0;
+      vertex = &a.segment.start();
+    } else if (near(point, a.segment.point())) {
+      ta = 1;
+      vertex = &a.segment.point();
+    }
+    if (near(point, b.segment.start())) {
+      tb = 0;
+      vertex = &b.segment.start();
+    } else if (near(point, b.segment.point())) {
+      tb = 1;
+      vertex = &b.segment.point();
+    }
+    const auto shared = vertex ? *vertex : snap(Vec2<T>(point.x, point.y));
+    if (0 < ta && ta < 1) {
+      a.splits.emplace_back(ta, shared);
+    }
+    if (0 < tb && tb < 1) {
+      b.splits.emplace_back(tb, shared);
+    }
+  }
+  path_.reset();
+}
+
+template <class T>
+inline void Boolean<T, 2>::divide() {
+  for (auto& edge : edges_) {
+    auto& splits = edge.splits;
+    std::sort(std::begin(splits), std::end(splits),
+              [](const std::pair<Real, Vec2<T>>& a,
+                 const std::pair<Real, Vec2<T>>& b) {
+      return a.first < b.first;
+    });
+    splits.emplace_back(1, edge.segment.point());
+    auto start = edge.segment.start();
+    Real t1{};
+    for (const auto& split : splits) {
+      if (split.first <= t1 || split.second == start) {
+        continue;
+      }
+      auto piece = edge.segment.subsegment(t1, split.first);
+      piece.start() = start;
+      piece.point() = split.second;
+      pieces_.push_back({piece, edge.operand, 0});
+      start = split.second;
+      t1 = split.first;
+    }
+  }
+  edges_.clear();
+}
+
+template <class T>
+inline void Boolean<T, 2>::group() {
+  // Coincident pieces, which typically come from edges shared by both
+  // operands, are classified together and emitted at most once.
+  std::map<std::array<T, 4>, std::vector<std::size_t>> candidates;
+  for (std::size_t i{}; i < pieces_.size(); ++i) {
+    const auto& a = pieces_[i].segment.start();
+    const auto& b = pieces_[i].segment.point();
+    const bool ordered = a.x < b.x || (a.x == b.x && a.y < b.y);
+    const auto& first = ordered ? a : b;
+    const auto& second = ordered ? b : a;
+    candidates[{{first.x, first.y, second.x, second.y}}].emplace_back(i);
+  }
+  for (const auto& candidate : candidates) {
+    const auto begin = groups_.size();
+    for (const auto index : candidate.second) {
+      auto& piece = pieces_[index];
+      const auto middle = piece.segment.evaluateAt(0.5);
+      auto group = begin;
+      for (; group < groups_.size(); ++group) {
+        const auto& other = pieces_[groups_[group].front()].segment;
+        if (near(middle, other.evaluateAt(0.5))) {
+          break;
+        }
+      }
+      if (group == groups_.size()) {
+        groups_.emplace_back();
+      }
+      groups_[group].emplace_back(index);
+      piece.group = group;
+    }
+  }
+}
+
+template <class T>
+inline void Boolean<T, 2>::classify() {
+  // Every piece makes a subpath of its own, so that the indices of monotone
+  // pieces are those of the pieces. Rays toward +y are cast toward +x on the
+  // transposed pieces.
+  Path2<T> paths[2];
+  for (const auto& piece : pieces_) {
+    const auto& start = piece.segment.start();
+    auto command = piece.segment.command();
+    paths[1].commands().emplace_back(CommandType::MOVE, start);
+    paths[1].commands().emplace_back(command);
+    for (auto *point : {&command.control1(),
+                        &command.control2(),
+                        &command.point()}) {
+      std::swap(point->x, point->y);
+    }
+    paths[0].commands().emplace_back(CommandType::MOVE,
+                                     Vec2<T>(start.y, start.x));
+    paths[0].commands().emplace_back(command);
+  }
+  windings_[0].set(paths[0]);
+  windings_[1].set(paths[1]);
+
+  // Groups are classified in the order of their rays, so that consecutive
+  // rays mostly visit the nodes that the previous ones left in cache, but the
+  // results are kept in the order of the groups, which link() follows.
+  std::vector<std::tuple<int, Real, std::size_t>> rays;
+  rays.reserve(groups_.size());
+  for (std::size_t group{}; group < groups_.size(); ++group) {
+    const auto& segment = pieces_[groups_[group].front()].segment;
+    const auto dx = std::abs(segment.point().x - segment.start().x);
+    const auto dy = std::abs(segment.point().y - segment.start().y);
+    const int axis = dy >= dx ? 1 : 0;
+    const auto middle = segment.evaluateAt(0.5);
+    rays.emplace_back(axis, axis ? middle.y : middle.x, group);
+  }
+  std::sort(std::begin(rays), std::end(rays));
+  std::vector<int> orientations(groups_.size());
+  for (const auto& ray : rays) {
+    const auto axis = std::get<0>(ray);
+    const auto group = std::get<2>(ray);
+    const auto& segment = pieces_[groups_[group].front()].segment;
+    int front[2]{};
+    int behind[2]{};
+    wind(segment.evaluateAt(0.5), axis, group, front, behind);
+    const bool inside = contains(behind);
+    if (inside == contains(front)) {
+      continue;
+    }
+    // Orient so that the result winds positively inside
+    orientations[group] = inside == (direction(segment, axis) > 0) ? 1 : -1;
+  }
+  for (std::size_t group{}; group < groups_.size(); ++group) {
+    if (orientations[group]) {
+      results_.emplace_back(pieces_[groups_[group].front()].segment);
+      if (orientations[group] < 0) {
+        results_.back().reverse();
+      }
+    }
+  }
+}
+
+template <class T>
+inline std::list<Path2<T>> Boolean<T, 2>::link() const {
+  std::map<std::pair<T, T>, std::vector<std::size_t>> outgoing;
+  for (std::size_t i{}; i < results_.size(); ++i) {
+    const auto& start = results_[i].start();
+    outgoing[std::make_pair(start.x, start.y)].emplace_back(i);
+  }
+  std::list<Path2<T>> result;
+  std::vector<bool> used(results_.size());
+  for (std::size_t i{}; i < results_.size(); ++i) {
+    if (used[i]) {
+      continue;
+    }
+    const auto& first = results_[i].start();
+    result.emplace_back();
+    auto& commands = result.back().commands();
+    commands.emplace_back(CommandType::MOVE, first);
+    for (auto current = i; !used[current];) {
+      used[current] = true;
+      const auto& segment = results_[current];
+      commands.emplace_back(segment.command());
+      if (segment.point() == first) {
+        break;
+      }
+      const auto itr = outgoing.find(std::make_pair(segment.point().x,
+                                                    segment.point().y));
+      if (itr == std::end(outgoing)) {
+        break;
+      }
+      for (const auto next : itr->second) {
+        if (!used[next]) {
+          current = next;
+          break;
+        }
+      }
+    }
+    commands.emplace_back(CommandType::CLOSE);
+  }
+  return result;
+}
+
+#pragma mark Vertices
+
+template <class T>
+template <class U>
+inline bool Boolean<T, 2>::near(const Vec2<Real>& a,
+                                const Vec2<U>& b) const {
+  return (std::abs(a.x - b.x) <= 2 * tolerance_ &&
+          std::abs(a.y - b.y) <= 2 * tolerance_);
+}
+
+template <class T>
+inline Vec2<T> Boolean<T, 2>::snap(const Vec2<T>& point) {
+  // Vertices closer than the tolerance are merged, so that the pieces of
+  // both operands meet at identical points and can be linked exactly.
+  const auto cell = 4 * tolerance_;
+  const auto x = static_cast<std::int64_t>(std::floor(point.x / cell));
+  const auto y = static_cast<std::int64_t>(std::floor(point.y / cell));
+  const auto key = [](std::int64_t x, std::int64_t y) {
+    return x * 73856093 ^ y * 19349663;
+  };
+  for (std::int64_t i = -1; i <= 1; ++i) {
+    for (std::int64_t j = -1; j <= 1; ++j) {
+      const auto itr = vertices_.find(key(x + i, y + j));
+      if (itr == std::end(vertices_)) {
+        continue;
+      }
+      for (const auto& vertex : itr->second) {
+        if (std::abs(vertex.x - point.x) <= tolerance_ &&
+            std::abs(vertex.y - point.y) <= tolerance_) {
+          return vertex;
+        }
+      }
+    }
+  }
+  vertices_[key(x, y)].emplace_back(point);
+  return point;
+}
+
+#pragma mark Classification
+
+template <class T>
+inline bool Boolean<T, 2>::contains(int winding) const {
+  switch (rule_) {
+    case FillRule::NON_ZERO:
+      return winding;
+    case FillRule::EVEN_ODD:
+      return winding % 2;
+    case FillRule::POSITIVE:
+      return winding > 0;
+    default:
+      assert(false);
+      break;
+  }
+  return false;
+}
+
+template <class T>
+inline bool Boolean<T, 2>::contains(const int *windings) const {
+  const bool a = contains(windings[0]);
+  const bool b = contains(windings[1]);
+  switch (operation_) {
+    case BooleanOperation::UNION:
+      return a || b;
+    case BooleanOperation::INTERSECTION:
+      return a && b;
+    case BooleanOperation::DIFFERENCE:
+      return a && !b;
+    case BooleanOperation::XOR:
+      return a != b;
+    default:
+      assert(false);
+      break;
+  }
+  return false;
+}
+
+template <class T>
+inline void Boolean<T, 2>::wind(const Vec2<Real>& point,
+                                int axis,
+                                std::size_t group,
+                                int *front,
+                                int *behind) const {
+  // Windings on the side of the group toward +x for axis 1 and +y for axis 0,
+  // and on the other side, which differ by the crossings of its members. The
+  // ray is cast toward the nearer side of the bounds, whose crossings count
+  // negatively toward -x or -y. Transposing reverses the signs of crossings
+  // of a ray along y.
+  const auto& windings = windings_[axis];
+  const auto origin = axis ? point : Vec2<Real>(point.y, point.x);
+  const auto& bounds = windings.bounds();
+  const bool reversed = origin.x - bounds.minX() < bounds.maxX() - origin.x;
+  const int side = reversed ? -1 : 1;
+  const int sign = axis ? side : -side;
+  auto *counted = reversed ? behind : front;
+  windings.crossings(origin, reversed, [&](const MonotonePiece& monotone,
+                                           int direction) {
+    const auto& piece = pieces_[monotone.index];
+    if (piece.group != group) {
+      counted[piece.operand] += sign * direction;
+    }
+  });
+  auto *other = reversed ? front : behind;
+  other[0] = counted[0];
+  other[1] = counted[1];
+  for (const auto member : groups_[group]) {
+    const auto& piece = pieces_[member];
+    other[piece.operand] += side * direction(piece.segment, axis);
+  }
+}
+
+template <class T>
+inline int Boolean<T, 2>::direction(const Segment2<T>& segment, int axis) {
+  // Signs of crossings of a ray toward +x for axis 1 and +y for axis 0
+  if (axis) {
+    const auto d = segment.point().y - segment.start().y;
+    return d > 0 ? 1 : (d < 0 ? -1 : 0);
+  }
+  const auto d = segment.point().x - segment.start().x;
+  return d < 0 ? 1 : (d > 0 ? -1 : 0);
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Boolean;
+using graphics::Boolean2;
+using graphics::Boolean2i;
+using graphics::Boolean2f;
+using graphics::Boolean2d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_BOOLEAN2_H_
@@ -0,0 +1,66 @@
+//
+//  takram/graphics/channel_order.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_CHANNEL_ORDER_H_
+#define TAKRAM_GRAPHICS_CHANNEL_ORDER_H_
+
+#include <cassert>
+#include <ostream>
+
+namespace takram {
+namespace graphics {
+
+// The order of the bytes of packed 8-bit colors in memory
+enum class ChannelOrder {
+  RGBA,
+  BGRA,
+  ARGB,
+  ABGR
+};
+
+inline std::ostream& operator<<(std::ostream& os, ChannelOrder order) {
+  switch (order) {
+    case ChannelOrder::RGBA: os << "rgba"; break;
+    case ChannelOrder::BGRA: os << "bgra"; break;
+    case ChannelOrder::ARGB: os << "argb"; break;
+    case ChannelOrder::ABGR: os << "abgr"; break;
+    default:
+      assert(false);
+      break;
+  }
+  return os;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::ChannelOrder;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_CHANNEL_ORDER_H_
@@ -189,6 +189,7 @@ bool operator!=(const Color3<T>& lhs, const Color3<U>& rhs);
 using Color3u = Color3<std::uint8_t>;
 using Color3s = Color3<std::uint16_t>;
 using Color3i = Color3<std::uint32_t>;
+using Color3h = Color3<Half>;
 using Color3f = Color3<float>;
 using Color3d = Color3<double>;
 
@@ -477,6 +478,7 @@ using graphics::Color3;
 using graphics::Color3u;
 using graphics::Color3s;
 using graphics::Color3i;
+using graphics::Color3h;
 using graphics::Color3f;
 using graphics::Color3d;
 
@@ -200,6 +200,7 @@ bool operator!=(const Color4<T>& lhs, const Color4<U>& rhs);
 using Color4u = Color4<std::uint8_t>;
 using Color4s = Color4<std::uint16_t>;
 using Color4i = Color4<std::uint32_t>;
+using Color4h = Color4<Half>;
 using Color4f = Color4<float>;
 using Color4d = Color4<double>;
 
@@ -547,6 +548,7 @@ using graphics::Color4;
 using graphics::Color4u;
 using graphics::Color4s;
 using graphics::Color4i;
+using graphics::Color4h;
 using graphics::Color4f;
 using graphics::Color4d;
 
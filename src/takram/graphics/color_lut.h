@@ -0,0 +1,381 @@
+//
+//  takram/graphics/color_lut.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_COLOR_LUT_H_
+#define TAKRAM_GRAPHICS_COLOR_LUT_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/image_view.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/simd.h"
+
+namespace takram {
+namespace graphics {
+
+// A 3D lookup table that maps colors to colors for color grading, holding a
+// cube of size^3 entries over a domain of input colors. It is loaded from
+// .cube files as Resolve and Adobe write them, or built from a function of
+// colors in the domain. Lookups map colors into the cube, clamping them to
+// its faces, and interpolate the four entries of the tetrahedron that holds
+// them. Every tetrahedron has the gray axis of its cell as an edge, so that
+// grays are interpolated along the axis alone, and a lookup reads half the
+// entries that trilinear interpolation does.
+//
+// Entries are padded to four floats, so that the weighted sum of a lookup
+// runs on all the channels at once with SSE2 where available. Buffers are
+// split into chunks and images into rows, which run in parallel. Alpha is
+// left as it is, and integral channels are converted to and from floats.
+
+class ColorLUT final {
+ public:
+  ColorLUT();
+  explicit ColorLUT(int size);
+  template <class Function>
+  ColorLUT(int size, Function function);
+
+  // Copy semantics
+  ColorLUT(const ColorLUT&) = default;
+  ColorLUT& operator=(const ColorLUT&) = default;
+
+  // Mutators
+  template <class Function>
+  void set(int size, Function function);
+  bool load(std::istream& stream);
+  bool load(const std::string& path);
+  void reset();
+
+  // Properties
+  const Color3f& domain_min() const { return domain_min_; }
+  void set_domain_min(const Color3f& value) { domain_min_ = value; }
+  const Color3f& domain_max() const { return domain_max_; }
+  void set_domain_max(const Color3f& value) { domain_max_ = value; }
+
+  // Attributes
+  bool empty() const { return !size_; }
+  int size() const { return size_; }
+
+  // Element access
+  Color3f entry(int red, int green, int blue) const;
+  void setEntry(int red, int green, int blue, const Color3f& color);
+
+  // Lookup
+  Color3f apply(const Color3f& color) const;
+  template <class T, int C>
+  void apply(const Color<T, C> *colors,
+             std::size_t size,
+             Color<T, C> *result) const;
+  template <class T, class U, int C>
+  void apply(const ImageView<U, C>& image, ImageView<T, C> result) const;
+
+ private:
+  std::size_t index(int red, int green, int blue) const;
+  void lookup(const float *color, float *result) const;
+  template <class T, int C>
+  void applySpan(const Color<T, C> *colors,
+                 std::size_t size,
+                 Color<T, C> *result) const;
+
+ private:
+  int size_;
+  Color3f domain_min_;
+  Color3f domain_max_;
+  std::vector<float> entries_;
+};
+
+#pragma mark -
+
+inline ColorLUT::ColorLUT()
+    : size_(),
+      domain_min_(0.0f, 0.0f, 0.0f),
+      domain_max_(1.0f, 1.0f, 1.0f) {}
+
+inline ColorLUT::ColorLUT(int size) : ColorLUT() {
+  set(size, [](const Color3f& color) { return color; });
+}
+
+template <class Function>
+inline ColorLUT::ColorLUT(int size, Function function) : ColorLUT() {
+  set(size, function);
+}
+
+#pragma mark Mutators
+
+template <class Function>
+inline void ColorLUT::set(int size, Function function) {
+  assert(size >= 2);
+  size_ = size;
+  entries_.assign(static_cast<std::size_t>(size) * size * size * 4, 0.0f);
+  const auto& lower = domain_min_;
+  const auto& upper = domain_max_;
+  const auto last = static_cast<float>(size - 1);
+  for (int blue{}; blue < size; ++blue) {
+    for (int green{}; green < size; ++green) {
+      for (int red{}; red < size; ++red) {
+        const Color3f color(lower.r + (upper.r - lower.r) * red / last,
+                            lower.g + (upper.g - lower.g) * green / last,
+                            lower.b + (upper.b - lower.b) * blue / last);
+        setEntry(red, green, blue, function(color));
+      }
+    }
+  }
+}
+
+inline bool ColorLUT::load(std::istream& stream) {
+  int size{};
+  Color3f domain_min(0.0f, 0.0f, 0.0f);
+  Color3f domain_max(1.0f, 1.0f, 1.0f);
+  std::vector<float> entries;
+  std::string line;
+  while (std::getline(stream, line)) {
+    std::istringstream tokens(line);
+    std::string keyword;
+    if (!(tokens >> keyword) || keyword[0] == '#' || keyword == "TITLE") {
+      continue;
+    }
+    if (keyword == "LUT_3D_SIZE") {
+      if (!(tokens >> size) || size < 2 || size > 256 || !entries.empty()) {
+        return false;
+      }
+      entries.reserve(static_cast<std::size_t>(size) * size * size * 4);
+    } else if (keyword == "DOMAIN_MIN") {
+      if (!(tokens >> domain_min.r >> domain_min.g >> domain_min.b)) {
+        return false;
+      }
+    } else if (keyword == "DOMAIN_MAX") {
+      if (!(tokens >> domain_max.r >> domain_max.g >> domain_max.b)) {
+        return false;
+      }
+    } else if (keyword == "LUT_3D_INPUT_RANGE") {
+      if (!(tokens >> domain_min.r >> domain_max.r)) {
+        return false;
+      }
+      domain_min.g = domain_min.b = domain_min.r;
+      domain_max.g = domain_max.b = domain_max.r;
+    } else {
+      // Lines of entries, whose red changes fastest as the cube is laid out,
+      // and keywords of 1D tables, which have no meaning here
+      std::istringstream values(line);
+      Color3f color;
+      if (!size || !(values >> color.r >> color.g >> color.b)) {
+        return false;
+      }
+      entries.insert(entries.end(), {color.r, color.g, color.b, 0.0f});
+    }
+  }
+  if (!size ||
+      entries.size() != static_cast<std::size_t>(size) * size * size * 4 ||
+      !(domain_min.r < domain_max.r) ||
+      !(domain_min.g < domain_max.g) ||
+      !(domain_min.b < domain_max.b)) {
+    return false;
+  }
+  size_ = size;
+  domain_min_ = domain_min;
+  domain_max_ = domain_max;
+  entries_ = std::move(entries);
+  return true;
+}
+
+inline bool ColorLUT::load(const std::string& path) {
+  std::ifstream stream(path);
+  return stream && load(stream);
+}
+
+inline void ColorLUT::reset() {
+  *this = ColorLUT();
+}
+
+#pragma mark Element access
+
+inline std::size_t ColorLUT::index(int red, int green, int blue) const {
+  assert(0 <= red && red < size_);
+  assert(0 <= green && green < size_);
+  assert(0 <= blue && blue < size_);
+  return ((static_cast<std::size_t>(blue) * size_ + green) * size_ + red) * 4;
+}
+
+inline Color3f ColorLUT::entry(int red, int green, int blue) const {
+  return Color3f(&entries_[index(red, green, blue)], 3);
+}
+
+inline void ColorLUT::setEntry(int red,
+                               int green,
+                               int blue,
+                               const Color3f& color) {
+  const auto i = index(red, green, blue);
+  entries_[i + 0] = color.r;
+  entries_[i + 1] = color.g;
+  entries_[i + 2] = color.b;
+}
+
+#pragma mark Lookup
+
+inline void ColorLUT::lookup(const float *color, float *result) const {
+  using detail::Lanes;
+  const auto last = static_cast<float>(size_ - 1);
+  const float lower[4]{domain_min_.r, domain_min_.g, domain_min_.b, 0.0f};
+  const float upper[4]{domain_max_.r, domain_max_.g, domain_max_.b, 1.0f};
+  const float values[4]{color[0], color[1], color[2], 0.0f};
+
+  // Positions in the cube, taking NaN to zero, and the cells that hold them,
+  // whose far faces hold the last entries
+  const auto origin = detail::loadLanes(lower);
+  const auto position = detail::min(detail::max(
+      (detail::loadLanes(values) - origin) /
+      (detail::loadLanes(upper) - origin), Lanes(0.0f)), Lanes(1.0f)) *
+      Lanes(last);
+  const auto cell = detail::min(detail::floor(position), Lanes(last - 1));
+  float fractions[4];
+  detail::storeLanes(position - cell, fractions);
+  std::int32_t cells[4];
+  detail::roundLanes(cell, cells);
+
+  // Axes in the descending order of the fractions, which determines the
+  // tetrahedron and the vertices along its path from the near corner
+  const std::size_t strides[3]{4, std::size_t(size_) * 4,
+                               std::size_t(size_) * size_ * 4};
+  int first = 0;
+  int second = 1;
+  int third = 2;
+  if (fractions[first] < fractions[second]) {
+    std::swap(first, second);
+  }
+  if (fractions[second] < fractions[third]) {
+    std::swap(second, third);
+  }
+  if (fractions[first] < fractions[second]) {
+    std::swap(first, second);
+  }
+  const auto origin_entry = entries_.data() + index(cells[0], cells[1],
+                                                    cells[2]);
+  const auto v0 = detail::loadLanes(origin_entry);
+  const auto v1 = detail::loadLanes(origin_entry + strides[first]);
+  const auto v2 = detail::loadLanes(origin_entry + strides[first] +
+                                    strides[second]);
+  const auto v3 = detail::loadLanes(origin_entry + strides[0] + strides[1] +
+                                    strides[2]);
+  const auto interpolated =
+      v0 * Lanes(1.0f - fractions[first]) +
+      v1 * Lanes(fractions[first] - fractions[second]) +
+      v2 * Lanes(fractions[second] - fractions[third]) +
+      v3 * Lanes(fractions[third]);
+  float mapped[4];
+  detail::storeLanes(interpolated, mapped);
+  result[0] = mapped[0];
+  result[1] = mapped[1];
+  result[2] = mapped[2];
+}
+
+inline Color3f ColorLUT::apply(const Color3f& color) const {
+  assert(!empty());
+  Color3f result;
+  lookup(color.pointer(), result.pointer());
+  return result;
+}
+
+template <class T, int C>
+inline void ColorLUT::applySpan(const Color<T, C> *colors,
+                                std::size_t size,
+                                Color<T, C> *result) const {
+  for (std::size_t i{}; i < size; ++i) {
+    const auto& color = colors[i];
+    float values[3];
+    for (int channel{}; channel < 3; ++channel) {
+      values[channel] = Depth<float>::convert(color.vector[channel]);
+    }
+    lookup(values, values);
+    auto& target = result[i];
+    for (int channel{}; channel < 3; ++channel) {
+      target.vector[channel] = Depth<T>::convert(values[channel]);
+    }
+    for (int channel = 3; channel < C; ++channel) {
+      target.vector[channel] = color.vector[channel];
+    }
+  }
+}
+
+template <class T, int C>
+inline void ColorLUT::apply(const Color<T, C> *colors,
+                            std::size_t size,
+                            Color<T, C> *result) const {
+  assert(!empty());
+  const std::size_t chunk = 0x4000;
+  parallelFor((size + chunk - 1) / chunk, [&](std::size_t index) {
+    const auto begin = index * chunk;
+    applySpan(colors + begin, std::min(chunk, size - begin), result + begin);
+  });
+}
+
+template <class T, class U, int C>
+inline void ColorLUT::apply(const ImageView<U, C>& image,
+                            ImageView<T, C> result) const {
+  static_assert(std::is_same<typename std::remove_const<U>::type, T>::value,
+                "Images must have the same type of values");
+  static_assert(sizeof(Color<T, C>) == sizeof(T) * C,
+                "Colors must be tightly packed");
+  assert(!empty());
+  assert(image.width() == result.width());
+  assert(image.height() == result.height());
+  parallelFor(image.height(), [&](std::size_t index) {
+    const auto y = static_cast<int>(index);
+    if (image.interleaved() && result.interleaved()) {
+      applySpan(reinterpret_cast<const Color<T, C> *>(image.row(y)),
+                image.width(),
+                reinterpret_cast<Color<T, C> *>(result.row(y)));
+      return;
+    }
+    for (int x{}; x < image.width(); ++x) {
+      const auto color = image.pixel(x, y);
+      Color<T, C> mapped;
+      applySpan(&color, 1, &mapped);
+      result.setPixel(x, y, mapped);
+    }
+  });
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::ColorLUT;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_COLOR_LUT_H_
@@ -0,0 +1,872 @@
+//
+//  takram/graphics/color_space.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_COLOR_SPACE_H_
+#define TAKRAM_GRAPHICS_COLOR_SPACE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/simd.h"
+#include "takram/math/constants.h"
+#include "takram/math/enablers.h"
+
+namespace takram {
+namespace graphics {
+
+// Converts colors between RGB and other color spaces, whose coordinates are
+// held in the red, green and blue channels of Color3 in the order of their
+// names. Alpha of Color4 spans is left as it is.
+//
+// - HSV and HSL take hue in degrees in [0, 360), and saturation, value and
+//   lightness in [0, 1]. They are defined on RGB values as they are, which
+//   usually means sRGB-encoded values.
+// - XYZ is CIE 1931 XYZ of linear sRGB relative to the D65 white point, whose
+//   luminance is 1.
+// - Lab is CIE L*a*b* relative to D65, whose lightness is in [0, 100], and
+//   LCh holds its chroma and hue in degrees.
+// - OKLab is the perceptual color space by Björn Ottosson, whose lightness is
+//   in [0, 1].
+//
+// XYZ, Lab and OKLab are converted from and to linear RGB; decode sRGB values
+// first with decodeSRGB(). Single colors are converted by the exact formulas
+// in their own precision. Spans of float colors are converted four at a time
+// with SSE2 where available, and take cube roots by a bit-level estimate
+// refined with two Halley iterations, whose relative error is within a few
+// units in the last place. The interpolations blend linear RGB colors in the
+// perceptual spaces, taking the shorter arc of hue in LCh.
+
+template <class T>
+EnableIfFloating<T, Color3<T>> rgbToHSV(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> hsvToRGB(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> rgbToHSL(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> hslToRGB(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> rgbToXYZ(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> xyzToRGB(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> xyzToLab(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> labToXYZ(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> rgbToLab(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> labToRGB(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> labToLCh(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> lchToLab(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> rgbToOKLab(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> oklabToRGB(const Color3<T>& color);
+
+// Spans, which may be converted in place
+template <class T, int C>
+void rgbToHSV(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void hsvToRGB(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void rgbToHSL(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void hslToRGB(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void rgbToXYZ(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void xyzToRGB(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void xyzToLab(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void labToXYZ(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void rgbToLab(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void labToRGB(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void labToLCh(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void lchToLab(const Color<T, C> *colors, std::size_t size, Color<T, C> *result);
+template <class T, int C>
+void rgbToOKLab(const Color<T, C> *colors,
+                std::size_t size,
+                Color<T, C> *result);
+template <class T, int C>
+void oklabToRGB(const Color<T, C> *colors,
+                std::size_t size,
+                Color<T, C> *result);
+
+// Interpolation
+template <class T, class V>
+EnableIfFloating<T, Color3<T>> lerpLab(const Color3<T>& color1,
+                                       const Color3<T>& color2,
+                                       V factor);
+template <class T, class V>
+EnableIfFloating<T, Color4<T>> lerpLab(const Color4<T>& color1,
+                                       const Color4<T>& color2,
+                                       V factor);
+template <class T, class V>
+EnableIfFloating<T, Color3<T>> lerpLCh(const Color3<T>& color1,
+                                       const Color3<T>& color2,
+                                       V factor);
+template <class T, class V>
+EnableIfFloating<T, Color4<T>> lerpLCh(const Color4<T>& color1,
+                                       const Color4<T>& color2,
+                                       V factor);
+template <class T, class V>
+EnableIfFloating<T, Color3<T>> lerpOKLab(const Color3<T>& color1,
+                                         const Color3<T>& color2,
+                                         V factor);
+template <class T, class V>
+EnableIfFloating<T, Color4<T>> lerpOKLab(const Color4<T>& color1,
+                                         const Color4<T>& color2,
+                                         V factor);
+
+#pragma mark -
+
+namespace detail {
+
+// Scalar counterparts of the lane operations, so that the conversions below
+// are written once for single colors and lanes
+template <class T>
+inline EnableIfFloating<T, bool> lessEqual(T a, T b) {
+  return a <= b;
+}
+
+template <class T>
+inline EnableIfFloating<T, T> select(bool mask, T a, T b) {
+  return mask ? a : b;
+}
+
+template <class T>
+inline EnableIfFloating<T, T> min(T a, T b) {
+  return std::min(a, b);
+}
+
+template <class T>
+inline EnableIfFloating<T, T> max(T a, T b) {
+  return std::max(a, b);
+}
+
+template <class T>
+inline EnableIfFloating<T, T> abs(T value) {
+  return std::abs(value);
+}
+
+template <class T>
+inline EnableIfFloating<T, T> floor(T value) {
+  return std::floor(value);
+}
+
+template <class T>
+inline EnableIfFloating<T, T> cubeRoot(T value) {
+  return std::cbrt(value);
+}
+
+template <class T>
+inline EnableIfFloating<T, T> length(T x, T y) {
+  return std::hypot(x, y);
+}
+
+// The angle of a vector in degrees between 0 and 360, and the unit vector of
+// an angle in degrees
+template <class T>
+inline EnableIfFloating<T, T> hueAngle(T y, T x) {
+  const auto hue = std::atan2(y, x) * 180 / math::pi<T>;
+  return hue < T() ? hue + 360 : hue;
+}
+
+template <class T>
+inline EnableIfFloating<T, void> hueVector(T hue, T *x, T *y) {
+  const auto angle = hue * math::pi<T> / 180;
+  *x = std::cos(angle);
+  *y = std::sin(angle);
+}
+
+// Estimates the cube root from the exponent and mantissa bits, and refines it
+// with Halley's method, which triples the number of correct digits at each
+// iteration
+inline float fastCubeRoot(float value) {
+  const auto magnitude = std::abs(value);
+  if (magnitude == 0.0f) {
+    return value;
+  }
+  std::uint32_t bits;
+  std::memcpy(&bits, &magnitude, sizeof(bits));
+  bits = bits / 3 + 0x2a508935;
+  float root;
+  std::memcpy(&root, &bits, sizeof(root));
+  for (int i{}; i < 2; ++i) {
+    const auto cube = root * root * root;
+    root *= (cube + 2.0f * magnitude) / (2.0f * cube + magnitude);
+  }
+  return std::copysign(root, value);
+}
+
+#if TAKRAM_GRAPHICS_HAS_SSE2
+
+inline Lanes cubeRoot(const Lanes& value) {
+  const auto sign_mask = _mm_set1_ps(-0.0f);
+  const auto sign = _mm_and_ps(value.value, sign_mask);
+  const auto magnitude = _mm_andnot_ps(sign_mask, value.value);
+  // Integer division by 3 through floats, which is exact enough for a guess
+  const auto bits = _mm_cvttps_epi32(_mm_mul_ps(
+      _mm_cvtepi32_ps(_mm_castps_si128(magnitude)), _mm_set1_ps(1.0f / 3)));
+  auto root = _mm_castsi128_ps(
+      _mm_add_epi32(bits, _mm_set1_epi32(0x2a508935)));
+  for (int i{}; i < 2; ++i) {
+    const auto cube = _mm_mul_ps(_mm_mul_ps(root, root), root);
+    root = _mm_mul_ps(root, _mm_div_ps(
+        _mm_add_ps(cube, _mm_add_ps(magnitude, magnitude)),
+        _mm_add_ps(_mm_add_ps(cube, cube), magnitude)));
+  }
+  const auto zero = _mm_cmpeq_ps(magnitude, _mm_setzero_ps());
+  return _mm_or_ps(_mm_andnot_ps(zero, root), sign);
+}
+
+#else  // TAKRAM_GRAPHICS_HAS_SSE2
+
+inline Lanes cubeRoot(const Lanes& value) {
+  Lanes result;
+  for (int i{}; i < 4; ++i) {
+    result.value[i] = fastCubeRoot(value.value[i]);
+  }
+  return result;
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+
+inline Lanes length(const Lanes& x, const Lanes& y) {
+  return sqrt(x * x + y * y);
+}
+
+// The arctangent of the ratio of the smaller to the larger magnitude, reduced
+// below tan(pi / 8) around pi / 4, is approximated by a polynomial accurate to
+// a few units in the last place of floats, and unfolded into the octants
+inline Lanes hueAngle(const Lanes& y, const Lanes& x) {
+  const Lanes zero(0.0f);
+  const auto x_magnitude = abs(x);
+  const auto y_magnitude = abs(y);
+  const auto larger = max(x_magnitude, y_magnitude);
+  const auto ratio = select(lessEqual(larger, zero), zero,
+                            min(x_magnitude, y_magnitude) / larger);
+  const auto reduced = lessEqual(Lanes(0.414213562f), ratio);
+  const auto t = select(reduced,
+                        (ratio - Lanes(1.0f)) / (ratio + Lanes(1.0f)),
+                        ratio);
+  const auto z = t * t;
+  auto angle = (((Lanes(8.05374449538e-2f) * z -
+                  Lanes(1.38776856032e-1f)) * z +
+                  Lanes(1.99777106478e-1f)) * z -
+                  Lanes(3.33329491539e-1f)) * z * t + t;
+  angle = angle + select(reduced, Lanes(0.785398163f), zero);
+  angle = select(lessEqual(y_magnitude, x_magnitude),
+                 angle, Lanes(1.570796327f) - angle);
+  angle = select(lessEqual(zero, x), angle, Lanes(3.141592654f) - angle);
+  angle = angle * Lanes(57.29577951f);
+  return select(lessEqual(zero, y), angle, Lanes(360.0f) - angle);
+}
+
+// The angle is reduced to within 45 degrees of a quadrant, where polynomials
+// approximate the sine and cosine, which are swapped and negated by quadrant
+inline void hueVector(const Lanes& hue, Lanes *x, Lanes *y) {
+  const Lanes zero(0.0f);
+  const auto quadrant = floor(hue * Lanes(1.0f / 90.0f) + Lanes(0.5f));
+  const auto angle = (hue - quadrant * Lanes(90.0f)) * Lanes(0.0174532925f);
+  const auto z = angle * angle;
+  const auto sine = ((Lanes(-1.9515295891e-4f) * z +
+                      Lanes(8.3321608736e-3f)) * z -
+                      Lanes(1.6666654611e-1f)) * z * angle + angle;
+  const auto cosine = ((Lanes(2.443315711809948e-5f) * z -
+                        Lanes(1.388731625493765e-3f)) * z +
+                        Lanes(4.166664568298827e-2f)) * z * z -
+                        Lanes(0.5f) * z + Lanes(1.0f);
+  const auto index = quadrant - Lanes(4.0f) * floor(quadrant * Lanes(0.25f));
+  const auto odd = lessEqual(
+      Lanes(0.5f), index - Lanes(2.0f) * floor(index * Lanes(0.5f)));
+  const auto swapped_sine = select(odd, cosine, sine);
+  const auto swapped_cosine = select(odd, sine, cosine);
+  *x = select(lessEqual(abs(index - Lanes(1.5f)), Lanes(0.5f)),
+              zero - swapped_cosine, swapped_cosine);
+  *y = select(lessEqual(Lanes(2.0f), index),
+              zero - swapped_sine, swapped_sine);
+}
+
+// Hue of RGB in degrees, shared by HSV and HSL
+template <class V>
+inline V rgbHue(const V& r, const V& g, const V& b,
+                const V& maximum, const V& delta) {
+  const auto red = (g - b) / delta;
+  auto hue = select(lessEqual(maximum, g),
+                    (b - r) / delta + V(2),
+                    (r - g) / delta + V(4));
+  hue = select(lessEqual(maximum, r),
+               select(lessEqual(V(0), red), red, red + V(6)),
+               hue);
+  return select(lessEqual(delta, V(0)), V(0), hue * V(60));
+}
+
+template <class V>
+inline V wrapHue(const V& hue, const V& period) {
+  return hue - period * floor(hue / period);
+}
+
+// The transforms between linear RGB and the other spaces, on three channels
+// of scalars or lanes in place
+struct RGBToHSV {
+  template <class V>
+  static void apply(V *r, V *g, V *b) {
+    const auto maximum = max(max(*r, *g), *b);
+    const auto minimum = min(min(*r, *g), *b);
+    const auto delta = maximum - minimum;
+    *r = rgbHue(*r, *g, *b, maximum, delta);
+    *g = select(lessEqual(maximum, V(0)), V(0), delta / maximum);
+    *b = maximum;
+  }
+};
+
+struct HSVToRGB {
+  template <class V>
+  static V channel(const V& n, const V& hue, const V& value, const V& chroma) {
+    const auto k = wrapHue(n + hue, V(6));
+    return value - chroma * max(V(0), min(min(k, V(4) - k), V(1)));
+  }
+
+  template <class V>
+  static void apply(V *h, V *s, V *v) {
+    const auto hue = *h / V(60);
+    const auto value = *v;
+    const auto chroma = value * *s;
+    *h = channel(V(5), hue, value, chroma);
+    *s = channel(V(3), hue, value, chroma);
+    *v = channel(V(1), hue, value, chroma);
+  }
+};
+
+struct RGBToHSL {
+  template <class V>
+  static void apply(V *r, V *g, V *b) {
+    const auto maximum = max(max(*r, *g), *b);
+    const auto minimum = min(min(*r, *g), *b);
+    const auto delta = maximum - minimum;
+    const auto divisor = V(1) - abs(maximum + minimum - V(1));
+    *r = rgbHue(*r, *g, *b, maximum, delta);
+    *g = select(lessEqual(divisor, V(0)), V(0), delta / divisor);
+    *b = (maximum + minimum) / V(2);
+  }
+};
+
+struct HSLToRGB {
+  template <class V>
+  static V channel(const V& n,
+                   const V& hue,
+                   const V& lightness,
+                   const V& amplitude) {
+    const auto k = wrapHue(n + hue, V(12));
+    return lightness - amplitude * max(V(-1), min(min(k - V(3), V(9) - k),
+                                                  V(1)));
+  }
+
+  template <class V>
+  static void apply(V *h, V *s, V *l) {
+    const auto hue = *h / V(30);
+    const auto lightness = *l;
+    const auto amplitude = *s * min(lightness, V(1) - lightness);
+    *h = channel(V(0), hue, lightness, amplitude);
+    *s = channel(V(8), hue, lightness, amplitude);
+    *l = channel(V(4), hue, lightness, amplitude);
+  }
+};
+
+struct RGBToXYZ {
+  template <class V>
+  static void apply(V *x, V *y, V *z) {
+    const auto r = *x;
+    const auto g = *y;
+    const auto b = *z;
+    *x = V(0.4124564) * r + V(0.3575761) * g + V(0.1804375) * b;
+    *y = V(0.2126729) * r + V(0.7151522) * g + V(0.0721750) * b;
+    *z = V(0.0193339) * r + V(0.1191920) * g + V(0.9503041) * b;
+  }
+};
+
+struct XYZToRGB {
+  template <class V>
+  static void apply(V *r, V *g, V *b) {
+    const auto x = *r;
+    const auto y = *g;
+    const auto z = *b;
+    *r = V(3.2404542) * x - V(1.5371385) * y - V(0.4985314) * z;
+    *g = V(1.8760108) * y - V(0.9692660) * x + V(0.0415560) * z;
+    *b = V(0.0556434) * x - V(0.2040259) * y + V(1.0572252) * z;
+  }
+};
+
+// The nonlinearity of Lab, which is linear below (6 / 29)^3
+struct XYZToLab {
+  template <class V>
+  static V transfer(const V& value) {
+    return select(lessEqual(value, V(216.0 / 24389.0)),
+                  value * V(841.0 / 108.0) + V(4.0 / 29.0),
+                  cubeRoot(value));
+  }
+
+  template <class V>
+  static void apply(V *x, V *y, V *z) {
+    const auto fx = transfer(*x * V(1.0 / 0.95047));
+    const auto fy = transfer(*y);
+    const auto fz = transfer(*z * V(1.0 / 1.08883));
+    *x = V(116) * fy - V(16);
+    *y = V(500) * (fx - fy);
+    *z = V(200) * (fy - fz);
+  }
+};
+
+struct LabToXYZ {
+  template <class V>
+  static V transfer(const V& value) {
+    return select(lessEqual(value, V(6.0 / 29.0)),
+                  (value - V(4.0 / 29.0)) * V(108.0 / 841.0),
+                  value * value * value);
+  }
+
+  template <class V>
+  static void apply(V *l, V *a, V *b) {
+    const auto fy = (*l + V(16)) * V(1.0 / 116.0);
+    const auto fx = fy + *a * V(1.0 / 500.0);
+    const auto fz = fy - *b * V(1.0 / 200.0);
+    *l = transfer(fx) * V(0.95047);
+    *a = transfer(fy);
+    *b = transfer(fz) * V(1.08883);
+  }
+};
+
+struct RGBToLab {
+  template <class V>
+  static void apply(V *x, V *y, V *z) {
+    RGBToXYZ::apply(x, y, z);
+    XYZToLab::apply(x, y, z);
+  }
+};
+
+struct LabToRGB {
+  template <class V>
+  static void apply(V *x, V *y, V *z) {
+    LabToXYZ::apply(x, y, z);
+    XYZToRGB::apply(x, y, z);
+  }
+};
+
+struct LabToLCh {
+  template <class V>
+  static void apply(V *, V *a, V *b) {
+    const auto x = *a;
+    const auto y = *b;
+    *a = length(x, y);
+    *b = hueAngle(y, x);
+  }
+};
+
+struct LChToLab {
+  template <class V>
+  static void apply(V *, V *c, V *h) {
+    V x;
+    V y;
+    hueVector(*h, &x, &y);
+    const auto chroma = *c;
+    *c = chroma * x;
+    *h = chroma * y;
+  }
+};
+
+struct RGBToOKLab {
+  template <class V>
+  static void apply(V *x, V *y, V *z) {
+    const auto r = *x;
+    const auto g = *y;
+    const auto b = *z;
+    const auto l = cubeRoot(
+        V(0.4122214708) * r + V(0.5363325363) * g + V(0.0514459929) * b);
+    const auto m = cubeRoot(
+        V(0.2119034982) * r + V(0.6806995451) * g + V(0.1073969566) * b);
+    const auto s = cubeRoot(
+        V(0.0883024619) * r + V(0.2817188376) * g + V(0.6299787005) * b);
+    *x = V(0.2104542553) * l + V(0.7936177850) * m - V(0.0040720468) * s;
+    *y = V(1.9779984951) * l - V(2.4285922050) * m + V(0.4505937099) * s;
+    *z = V(0.0259040371) * l + V(0.7827717662) * m - V(0.8086757660) * s;
+  }
+};
+
+struct OKLabToRGB {
+  template <class V>
+  static void apply(V *x, V *y, V *z) {
+    const auto l = *x + V(0.3963377774) * *y + V(0.2158037573) * *z;
+    const auto m = *x - V(0.1055613458) * *y - V(0.0638541728) * *z;
+    const auto s = *x - V(0.0894841775) * *y - V(1.2914855480) * *z;
+    const auto l3 = l * l * l;
+    const auto m3 = m * m * m;
+    const auto s3 = s * s * s;
+    *x = V(4.0767416621) * l3 - V(3.3077115913) * m3 + V(0.2309699292) * s3;
+    *y = V(2.6097574011) * m3 - V(1.2684380046) * l3 - V(0.3413193965) * s3;
+    *z = V(1.7076147010) * s3 - V(0.0041960863) * l3 - V(0.7034186147) * m3;
+  }
+};
+
+template <class Transform, class T>
+inline Color3<T> transformColor(const Color3<T>& color) {
+  auto result = color;
+  Transform::apply(&result.r, &result.g, &result.b);
+  return result;
+}
+
+template <class T>
+inline void copyAlpha(const Color3<T>&, Color3<T> *) {}
+
+template <class T>
+inline void copyAlpha(const Color4<T>& color, Color4<T> *result) {
+  result->a = color.a;
+}
+
+template <class Transform, class T, int C>
+inline void transformColors(const Color<T, C> *colors,
+                            std::size_t size,
+                            Color<T, C> *result) {
+  for (std::size_t i{}; i < size; ++i) {
+    auto& color = result[i];
+    color.r = colors[i].r;
+    color.g = colors[i].g;
+    color.b = colors[i].b;
+    copyAlpha(colors[i], &color);
+    Transform::apply(&color.r, &color.g, &color.b);
+  }
+}
+
+// Float colors are transposed into lanes of four colors
+template <class Transform, int C>
+inline void transformColors(const Color<float, C> *colors,
+                            std::size_t size,
+                            Color<float, C> *result) {
+  for (std::size_t i{}; i < size; i += 4) {
+    const auto count = std::min<std::size_t>(size - i, 4);
+    float r[4]{};
+    float g[4]{};
+    float b[4]{};
+    for (std::size_t j{}; j < count; ++j) {
+      r[j] = colors[i + j].r;
+      g[j] = colors[i + j].g;
+      b[j] = colors[i + j].b;
+    }
+    auto x = loadLanes(static_cast<const float *>(r));
+    auto y = loadLanes(static_cast<const float *>(g));
+    auto z = loadLanes(static_cast<const float *>(b));
+    Transform::apply(&x, &y, &z);
+    storeLanes(x, static_cast<float *>(r));
+    storeLanes(y, static_cast<float *>(g));
+    storeLanes(z, static_cast<float *>(b));
+    for (std::size_t j{}; j < count; ++j) {
+      auto& color = result[i + j];
+      copyAlpha(colors[i + j], &color);
+      color.r = r[j];
+      color.g = g[j];
+      color.b = b[j];
+    }
+  }
+}
+
+}  // namespace detail
+
+#pragma mark HSV and HSL
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> rgbToHSV(const Color3<T>& color) {
+  return detail::transformColor<detail::RGBToHSV>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> hsvToRGB(const Color3<T>& color) {
+  return detail::transformColor<detail::HSVToRGB>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> rgbToHSL(const Color3<T>& color) {
+  return detail::transformColor<detail::RGBToHSL>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> hslToRGB(const Color3<T>& color) {
+  return detail::transformColor<detail::HSLToRGB>(color);
+}
+
+#pragma mark XYZ, Lab and OKLab
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> rgbToXYZ(const Color3<T>& color) {
+  return detail::transformColor<detail::RGBToXYZ>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> xyzToRGB(const Color3<T>& color) {
+  return detail::transformColor<detail::XYZToRGB>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> xyzToLab(const Color3<T>& color) {
+  return detail::transformColor<detail::XYZToLab>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> labToXYZ(const Color3<T>& color) {
+  return detail::transformColor<detail::LabToXYZ>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> rgbToLab(const Color3<T>& color) {
+  return detail::transformColor<detail::RGBToLab>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> labToRGB(const Color3<T>& color) {
+  return detail::transformColor<detail::LabToRGB>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> labToLCh(const Color3<T>& color) {
+  return detail::transformColor<detail::LabToLCh>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> lchToLab(const Color3<T>& color) {
+  return detail::transformColor<detail::LChToLab>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> rgbToOKLab(const Color3<T>& color) {
+  return detail::transformColor<detail::RGBToOKLab>(color);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> oklabToRGB(const Color3<T>& color) {
+  return detail::transformColor<detail::OKLabToRGB>(color);
+}
+
+#pragma mark Spans
+
+template <class T, int C>
+inline void rgbToHSV(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::RGBToHSV>(colors, size, result);
+}
+
+template <class T, int C>
+inline void hsvToRGB(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::HSVToRGB>(colors, size, result);
+}
+
+template <class T, int C>
+inline void rgbToHSL(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::RGBToHSL>(colors, size, result);
+}
+
+template <class T, int C>
+inline void hslToRGB(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::HSLToRGB>(colors, size, result);
+}
+
+template <class T, int C>
+inline void rgbToXYZ(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::RGBToXYZ>(colors, size, result);
+}
+
+template <class T, int C>
+inline void xyzToRGB(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::XYZToRGB>(colors, size, result);
+}
+
+template <class T, int C>
+inline void xyzToLab(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::XYZToLab>(colors, size, result);
+}
+
+template <class T, int C>
+inline void labToXYZ(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::LabToXYZ>(colors, size, result);
+}
+
+template <class T, int C>
+inline void rgbToLab(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::RGBToLab>(colors, size, result);
+}
+
+template <class T, int C>
+inline void labToRGB(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::LabToRGB>(colors, size, result);
+}
+
+template <class T, int C>
+inline void labToLCh(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::LabToLCh>(colors, size, result);
+}
+
+template <class T, int C>
+inline void lchToLab(const Color<T, C> *colors,
+                     std::size_t size,
+                     Color<T, C> *result) {
+  detail::transformColors<detail::LChToLab>(colors, size, result);
+}
+
+template <class T, int C>
+inline void rgbToOKLab(const Color<T, C> *colors,
+                       std::size_t size,
+                       Color<T, C> *result) {
+  detail::transformColors<detail::RGBToOKLab>(colors, size, result);
+}
+
+template <class T, int C>
+inline void oklabToRGB(const Color<T, C> *colors,
+                       std::size_t size,
+                       Color<T, C> *result) {
+  detail::transformColors<detail::OKLabToRGB>(colors, size, result);
+}
+
+#pragma mark Interpolation
+
+template <class T, class V>
+inline EnableIfFloating<T, Color3<T>> lerpLab(const Color3<T>& color1,
+                                              const Color3<T>& color2,
+                                              V factor) {
+  return labToRGB(rgbToLab(color1).lerp(rgbToLab(color2), factor));
+}
+
+template <class T, class V>
+inline EnableIfFloating<T, Color4<T>> lerpLab(const Color4<T>& color1,
+                                              const Color4<T>& color2,
+                                              V factor) {
+  return Color4<T>(lerpLab(Color3<T>(color1), Color3<T>(color2), factor),
+                   color1.a + (color2.a - color1.a) * factor);
+}
+
+template <class T, class V>
+inline EnableIfFloating<T, Color3<T>> lerpLCh(const Color3<T>& color1,
+                                              const Color3<T>& color2,
+                                              V factor) {
+  auto lch1 = labToLCh(rgbToLab(color1));
+  auto lch2 = labToLCh(rgbToLab(color2));
+  // Hue of an achromatic color is meaningless, and follows the other
+  const T epsilon = 1e-4;
+  if (lch1.g < epsilon) {
+    lch1.b = lch2.b;
+  } else if (lch2.g < epsilon) {
+    lch2.b = lch1.b;
+  }
+  auto delta = lch2.b - lch1.b;
+  if (delta > 180) {
+    delta -= 360;
+  } else if (delta < -180) {
+    delta += 360;
+  }
+  const Color3<T> lch(lch1.r + (lch2.r - lch1.r) * factor,
+                      lch1.g + (lch2.g - lch1.g) * factor,
+                      detail::wrapHue<T>(lch1.b + delta * factor, 360));
+  return labToRGB(lchToLab(lch));
+}
+
+template <class T, class V>
+inline EnableIfFloating<T, Color4<T>> lerpLCh(const Color4<T>& color1,
+                                              const Color4<T>& color2,
+                                              V factor) {
+  return Color4<T>(lerpLCh(Color3<T>(color1), Color3<T>(color2), factor),
+                   color1.a + (color2.a - color1.a) * factor);
+}
+
+template <class T, class V>
+inline EnableIfFloating<T, Color3<T>> lerpOKLab(const Color3<T>& color1,
+                                                const Color3<T>& color2,
+                                                V factor) {
+  return oklabToRGB(rgbToOKLab(color1).lerp(rgbToOKLab(color2), factor));
+}
+
+template <class T, class V>
+inline EnableIfFloating<T, Color4<T>> lerpOKLab(const Color4<T>& color1,
+                                                const Color4<T>& color2,
+                                                V factor) {
+  return Color4<T>(lerpOKLab(Color3<T>(color1), Color3<T>(color2), factor),
+                   color1.a + (color2.a - color1.a) * factor);
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::hslToRGB;
+using graphics::hsvToRGB;
+using graphics::labToLCh;
+using graphics::labToRGB;
+using graphics::labToXYZ;
+using graphics::lchToLab;
+using graphics::lerpLab;
+using graphics::lerpLCh;
+using graphics::lerpOKLab;
+using graphics::oklabToRGB;
+using graphics::rgbToHSL;
+using graphics::rgbToHSV;
+using graphics::rgbToLab;
+using graphics::rgbToOKLab;
+using graphics::rgbToXYZ;
+using graphics::xyzToLab;
+using graphics::xyzToRGB;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_COLOR_SPACE_H_
@@ -70,8 +70,8 @@ class Command final {
   Vec2<T>& control1() { return control1_; }
   const Vec2<T>& control2() const { return control2_; }
   Vec2<T>& control2() { return control2_; }
-  const T& weight() const { return weight_; }
-  T& weight() { return weight_; }
+  const math::Promote<T>& weight() const { return weight_; }
+  math::Promote<T>& weight() { return weight_; }
   const Vec2<T>& point() const { return point_; }
   Vec2<T>& point() { return point_; }
 
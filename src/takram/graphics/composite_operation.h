@@ -0,0 +1,84 @@
+//
+//  takram/graphics/composite_operation.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_COMPOSITE_OPERATION_H_
+#define TAKRAM_GRAPHICS_COMPOSITE_OPERATION_H_
+
+#include <cassert>
+#include <ostream>
+
+namespace takram {
+namespace graphics {
+
+enum class CompositeOperation {
+  CLEAR,
+  SOURCE,
+  DESTINATION,
+  SOURCE_OVER,
+  DESTINATION_OVER,
+  SOURCE_IN,
+  DESTINATION_IN,
+  SOURCE_OUT,
+  DESTINATION_OUT,
+  SOURCE_ATOP,
+  DESTINATION_ATOP,
+  XOR,
+  PLUS
+};
+
+inline std::ostream& operator<<(std::ostream& os,
+                                CompositeOperation operation) {
+  switch (operation) {
+    case CompositeOperation::CLEAR: os << "clear"; break;
+    case CompositeOperation::SOURCE: os << "source"; break;
+    case CompositeOperation::DESTINATION: os << "destination"; break;
+    case CompositeOperation::SOURCE_OVER: os << "source over"; break;
+    case CompositeOperation::DESTINATION_OVER: os << "destination over"; break;
+    case CompositeOperation::SOURCE_IN: os << "source in"; break;
+    case CompositeOperation::DESTINATION_IN: os << "destination in"; break;
+    case CompositeOperation::SOURCE_OUT: os << "source out"; break;
+    case CompositeOperation::DESTINATION_OUT: os << "destination out"; break;
+    case CompositeOperation::SOURCE_ATOP: os << "source atop"; break;
+    case CompositeOperation::DESTINATION_ATOP: os << "destination atop"; break;
+    case CompositeOperation::XOR: os << "xor"; break;
+    case CompositeOperation::PLUS: os << "plus"; break;
+    default:
+      assert(false);
+      break;
+  }
+  return os;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::CompositeOperation;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_COMPOSITE_OPERATION_H_
@@ -28,9 +28,11 @@
 #ifndef TAKRAM_GRAPHICS_DEPTH_H_
 #define TAKRAM_GRAPHICS_DEPTH_H_
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
+#include "takram/graphics/half.h"
 #include "takram/math/functions.h"
 #include "takram/math/enablers.h"
 
@@ -56,6 +58,7 @@ struct Depth<T, EnableIfIntegral<T>> {
   static EnableIfIntegral<U, T> convert(U value);
   template <class U>
   static EnableIfFloating<U, T> convert(U value);
+  static T convert(Half value);
 };
 
 template <class T>
@@ -69,6 +72,23 @@ struct Depth<T, EnableIfFloating<T>> {
   static EnableIfIntegral<U, T> convert(U value);
   template <class U>
   static EnableIfFloating<U, T> convert(U value);
+  static T convert(Half value);
+};
+
+// Half-precision channels have the range of floating-point ones, though the
+// limits are of float since Half has no constant expressions.
+template <>
+struct Depth<Half> {
+  static constexpr const int bits = 16;
+  static constexpr const float min = 0;
+  static constexpr const float max = 1;
+
+  static Half clamp(Half value);
+  template <class U>
+  static EnableIfIntegral<U, Half> convert(U value);
+  template <class U>
+  static EnableIfFloating<U, Half> convert(U value);
+  static Half convert(Half value);
 };
 
 #pragma mark -
@@ -102,6 +122,11 @@ inline EnableIfFloating<U, T> IntegralDepth<T>::convert(U value) {
   return std::round(max * value);
 }
 
+template <class T>
+inline T IntegralDepth<T>::convert(Half value) {
+  return convert(static_cast<float>(value));
+}
+
 template <class T>
 template <class U>
 inline EnableIfIntegral<U, T> FloatingDepth<T>::convert(U value) {
@@ -114,6 +139,29 @@ inline EnableIfFloating<U, T> FloatingDepth<T>::convert(U value) {
   return value;
 }
 
+template <class T>
+inline T FloatingDepth<T>::convert(Half value) {
+  return static_cast<float>(value);
+}
+
+inline Half Depth<Half>::clamp(Half value) {
+  return std::min(std::max(static_cast<float>(value), 0.0f), 1.0f);
+}
+
+template <class U>
+inline EnableIfIntegral<U, Half> Depth<Half>::convert(U value) {
+  return static_cast<float>(value) / Depth<U>::max;
+}
+
+template <class U>
+inline EnableIfFloating<U, Half> Depth<Half>::convert(U value) {
+  return static_cast<float>(value);
+}
+
+inline Half Depth<Half>::convert(Half value) {
+  return value;
+}
+
 }  // namespace graphics
 
 namespace gfx = graphics;
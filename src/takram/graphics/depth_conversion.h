@@ -0,0 +1,419 @@
+//
+//  takram/graphics/depth_conversion.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_DEPTH_CONVERSION_H_
+#define TAKRAM_GRAPHICS_DEPTH_CONVERSION_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/half.h"
+#include "takram/graphics/image_view.h"
+#include "takram/graphics/simd.h"
+
+namespace takram {
+namespace graphics {
+
+// Converts buffers of channel values, colors or images from one depth to
+// another. The results are bit-identical to those of Depth<T>::convert for
+// every input it defines. Conversions from floats to integers saturate values
+// outside [0, 1] and take NaNs as zero, wherever they are in the buffer.
+// Conversions between floats and 8 or 16-bit integers run on blocks of values
+// with SSE2 or NEON where available, and those with 8-bit integers on wider
+// blocks with AVX2 where the processor supports it, rounding halves away from
+// zero as std::round does. Other pairs of depths and the remainder of blocks
+// run through the scalar conversion. Conversions between floats and halves
+// run on blocks of eight values with F16C where the target enables it, which
+// rounds as Half does.
+
+template <class T, class U>
+void convertDepth(const U *values, std::size_t size, T *result);
+template <class T, class U, int C>
+void convertDepth(const Color<U, C> *colors,
+                  std::size_t size,
+                  Color<T, C> *result);
+template <class T, class U, int C>
+void convertDepth(const ImageView<U, C>& image, ImageView<T, C> result);
+
+#pragma mark -
+
+namespace detail {
+
+// Converts a single value, saturating floats as the blocks do
+template <class T, class U>
+inline T convertDepthValue(U value, std::false_type) {
+  return Depth<T>::convert(value);
+}
+
+template <class T, class U>
+inline T convertDepthValue(U value, std::true_type) {
+  return Depth<T>::convert(value > 0 ? (value < 1 ? value : U(1)) : U(0));
+}
+
+template <class T, class U>
+inline T convertDepthValue(U value) {
+  using Saturates = std::integral_constant<
+      bool, std::is_integral<T>::value && !std::is_integral<U>::value>;
+  return convertDepthValue<T>(value, Saturates());
+}
+
+// Converts the leading blocks of values and returns how many it converted
+template <class T, class U>
+inline std::size_t convertDepthBlocks(const U *, std::size_t, T *) {
+  return 0;
+}
+
+#if TAKRAM_GRAPHICS_HAS_SSE2
+
+inline __m128 convertDepthToFloat(__m128i integers, __m128 max) {
+  return _mm_div_ps(_mm_cvtepi32_ps(integers), max);
+}
+
+// Scales values in [0, 1] by max and rounds them. The fraction after
+// truncation is exact for non-negative values, so comparing it against a half
+// rounds exactly as std::round does.
+inline __m128i convertDepthFromFloat(__m128 value, __m128 max) {
+  const auto scaled = _mm_min_ps(
+      _mm_max_ps(_mm_mul_ps(value, max), _mm_setzero_ps()), max);
+  const auto truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(scaled));
+  const auto fraction = _mm_sub_ps(scaled, truncated);
+  const auto up = _mm_and_ps(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f)),
+                             _mm_set1_ps(1.0f));
+  return _mm_cvttps_epi32(_mm_add_ps(truncated, up));
+}
+
+#if TAKRAM_GRAPHICS_HAS_AVX2
+
+// The AVX2 kernels are compiled for it even where the target does not enable
+// it, and only run where hasAVX2() holds.
+TAKRAM_GRAPHICS_TARGET_AVX2
+inline __m256i convertDepthFromFloat(__m256 value, __m256 max) {
+  const auto scaled = _mm256_min_ps(
+      _mm256_max_ps(_mm256_mul_ps(value, max), _mm256_setzero_ps()), max);
+  const auto truncated = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(scaled));
+  const auto fraction = _mm256_sub_ps(scaled, truncated);
+  const auto up = _mm256_and_ps(
+      _mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ),
+      _mm256_set1_ps(1.0f));
+  return _mm256_cvttps_epi32(_mm256_add_ps(truncated, up));
+}
+
+TAKRAM_GRAPHICS_TARGET_AVX2
+inline std::size_t convertDepthBlocksAVX2(const std::uint8_t *values,
+                                          std::size_t size,
+                                          float *result) {
+  const auto max = _mm256_set1_ps(Depth<std::uint8_t>::max);
+  std::size_t i{};
+  for (; i + 8 <= size; i += 8) {
+    const auto bytes = _mm_loadl_epi64(
+        reinterpret_cast<const __m128i *>(values + i));
+    _mm256_storeu_ps(result + i, _mm256_div_ps(
+        _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)), max));
+  }
+  return i;
+}
+
+TAKRAM_GRAPHICS_TARGET_AVX2
+inline std::size_t convertDepthBlocksAVX2(const float *values,
+                                          std::size_t size,
+                                          std::uint8_t *result) {
+  // Packing works within halves of the registers, which the permutation puts
+  // back in order
+  const auto max = _mm256_set1_ps(Depth<std::uint8_t>::max);
+  const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  std::size_t i{};
+  for (; i + 32 <= size; i += 32) {
+    const auto a = convertDepthFromFloat(_mm256_loadu_ps(values + i), max);
+    const auto b = convertDepthFromFloat(_mm256_loadu_ps(values + i + 8), max);
+    const auto c = convertDepthFromFloat(
+        _mm256_loadu_ps(values + i + 16), max);
+    const auto d = convertDepthFromFloat(
+        _mm256_loadu_ps(values + i + 24), max);
+    const auto packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b),
+                                            _mm256_packs_epi32(c, d));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i),
+                        _mm256_permutevar8x32_epi32(packed, order));
+  }
+  return i;
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_AVX2
+
+inline std::size_t convertDepthBlocks(const std::uint8_t *values,
+                                      std::size_t size,
+                                      float *result) {
+  const auto max = _mm_set1_ps(Depth<std::uint8_t>::max);
+  const auto zero = _mm_setzero_si128();
+  std::size_t i{};
+#if TAKRAM_GRAPHICS_HAS_AVX2
+  if (hasAVX2()) {
+    i = convertDepthBlocksAVX2(values, size, result);
+  }
+#endif  // TAKRAM_GRAPHICS_HAS_AVX2
+  for (; i + 16 <= size; i += 16) {
+    const auto bytes = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(values + i));
+    const auto low = _mm_unpacklo_epi8(bytes, zero);
+    const auto high = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_ps(result + i, convertDepthToFloat(
+        _mm_unpacklo_epi16(low, zero), max));
+    _mm_storeu_ps(result + i + 4, convertDepthToFloat(
+        _mm_unpackhi_epi16(low, zero), max));
+    _mm_storeu_ps(result + i + 8, convertDepthToFloat(
+        _mm_unpacklo_epi16(high, zero), max));
+    _mm_storeu_ps(result + i + 12, convertDepthToFloat(
+        _mm_unpackhi_epi16(high, zero), max));
+  }
+  return i;
+}
+
+inline std::size_t convertDepthBlocks(const std::uint16_t *values,
+                                      std::size_t size,
+                                      float *result) {
+  const auto max = _mm_set1_ps(Depth<std::uint16_t>::max);
+  const auto zero = _mm_setzero_si128();
+  std::size_t i{};
+  for (; i + 8 <= size; i += 8) {
+    const auto words = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(values + i));
+    _mm_storeu_ps(result + i, convertDepthToFloat(
+        _mm_unpacklo_epi16(words, zero), max));
+    _mm_storeu_ps(result + i + 4, convertDepthToFloat(
+        _mm_unpackhi_epi16(words, zero), max));
+  }
+  return i;
+}
+
+inline std::size_t convertDepthBlocks(const float *values,
+                                      std::size_t size,
+                                      std::uint8_t *result) {
+  const auto max = _mm_set1_ps(Depth<std::uint8_t>::max);
+  std::size_t i{};
+#if TAKRAM_GRAPHICS_HAS_AVX2
+  if (hasAVX2()) {
+    i = convertDepthBlocksAVX2(values, size, result);
+  }
+#endif  // TAKRAM_GRAPHICS_HAS_AVX2
+  for (; i + 16 <= size; i += 16) {
+    const auto a = convertDepthFromFloat(_mm_loadu_ps(values + i), max);
+    const auto b = convertDepthFromFloat(_mm_loadu_ps(values + i + 4), max);
+    const auto c = convertDepthFromFloat(_mm_loadu_ps(values + i + 8), max);
+    const auto d = convertDepthFromFloat(_mm_loadu_ps(values + i + 12), max);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i),
+                     _mm_packus_epi16(_mm_packs_epi32(a, b),
+                                      _mm_packs_epi32(c, d)));
+  }
+  return i;
+}
+
+inline std::size_t convertDepthBlocks(const float *values,
+                                      std::size_t size,
+                                      std::uint16_t *result) {
+  // SSE2 has no unsigned saturating pack from 32 to 16 bits, so the values
+  // are biased into the signed range and back.
+  const auto max = _mm_set1_ps(Depth<std::uint16_t>::max);
+  const auto bias = _mm_set1_epi32(0x8000);
+  const auto sign = _mm_set1_epi16(static_cast<std::int16_t>(0x8000));
+  std::size_t i{};
+  for (; i + 8 <= size; i += 8) {
+    const auto a = convertDepthFromFloat(_mm_loadu_ps(values + i), max);
+    const auto b = convertDepthFromFloat(_mm_loadu_ps(values + i + 4), max);
+    const auto packed = _mm_packs_epi32(_mm_sub_epi32(a, bias),
+                                        _mm_sub_epi32(b, bias));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i),
+                     _mm_xor_si128(packed, sign));
+  }
+  return i;
+}
+
+#elif TAKRAM_GRAPHICS_HAS_NEON
+
+inline float32x4_t convertDepthToFloat(uint32x4_t integers, float32x4_t max) {
+  return vdivq_f32(vcvtq_f32_u32(integers), max);
+}
+
+// Scales values in [0, 1] by max and rounds them halves away from zero, as
+// std::round does. The minimum and maximum that ignore NaNs take them as zero.
+inline uint32x4_t convertDepthFromFloat(float32x4_t value, float32x4_t max) {
+  const auto scaled = vminnmq_f32(
+      vmaxnmq_f32(vmulq_f32(value, max), vdupq_n_f32(0.0f)), max);
+  return vcvtaq_u32_f32(scaled);
+}
+
+inline std::size_t convertDepthBlocks(const std::uint8_t *values,
+                                      std::size_t size,
+                                      float *result) {
+  const auto max = vdupq_n_f32(Depth<std::uint8_t>::max);
+  std::size_t i{};
+  for (; i + 16 <= size; i += 16) {
+    const auto bytes = vld1q_u8(values + i);
+    const auto low = vmovl_u8(vget_low_u8(bytes));
+    const auto high = vmovl_u8(vget_high_u8(bytes));
+    vst1q_f32(result + i, convertDepthToFloat(
+        vmovl_u16(vget_low_u16(low)), max));
+    vst1q_f32(result + i + 4, convertDepthToFloat(
+        vmovl_u16(vget_high_u16(low)), max));
+    vst1q_f32(result + i + 8, convertDepthToFloat(
+        vmovl_u16(vget_low_u16(high)), max));
+    vst1q_f32(result + i + 12, convertDepthToFloat(
+        vmovl_u16(vget_high_u16(high)), max));
+  }
+  return i;
+}
+
+inline std::size_t convertDepthBlocks(const std::uint16_t *values,
+                                      std::size_t size,
+                                      float *result) {
+  const auto max = vdupq_n_f32(Depth<std::uint16_t>::max);
+  std::size_t i{};
+  for (; i + 8 <= size; i += 8) {
+    const auto words = vld1q_u16(values + i);
+    vst1q_f32(result + i, convertDepthToFloat(
+        vmovl_u16(vget_low_u16(words)), max));
+    vst1q_f32(result + i + 4, convertDepthToFloat(
+        vmovl_u16(vget_high_u16(words)), max));
+  }
+  return i;
+}
+
+// The values are within max, so narrowing needs no saturation
+inline std::size_t convertDepthBlocks(const float *values,
+                                      std::size_t size,
+                                      std::uint8_t *result) {
+  const auto max = vdupq_n_f32(Depth<std::uint8_t>::max);
+  std::size_t i{};
+  for (; i + 16 <= size; i += 16) {
+    const auto a = convertDepthFromFloat(vld1q_f32(values + i), max);
+    const auto b = convertDepthFromFloat(vld1q_f32(values + i + 4), max);
+    const auto c = convertDepthFromFloat(vld1q_f32(values + i + 8), max);
+    const auto d = convertDepthFromFloat(vld1q_f32(values + i + 12), max);
+    const auto low = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+    const auto high = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+    vst1q_u8(result + i, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+  }
+  return i;
+}
+
+inline std::size_t convertDepthBlocks(const float *values,
+                                      std::size_t size,
+                                      std::uint16_t *result) {
+  const auto max = vdupq_n_f32(Depth<std::uint16_t>::max);
+  std::size_t i{};
+  for (; i + 8 <= size; i += 8) {
+    const auto a = convertDepthFromFloat(vld1q_f32(values + i), max);
+    const auto b = convertDepthFromFloat(vld1q_f32(values + i + 4), max);
+    vst1q_u16(result + i, vcombine_u16(vmovn_u32(a), vmovn_u32(b)));
+  }
+  return i;
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+
+#if TAKRAM_GRAPHICS_HAS_F16C
+
+inline std::size_t convertDepthBlocks(const Half *values,
+                                      std::size_t size,
+                                      float *result) {
+  std::size_t i{};
+  for (; i + 8 <= size; i += 8) {
+    const auto halves = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(values + i));
+    _mm256_storeu_ps(result + i, _mm256_cvtph_ps(halves));
+  }
+  return i;
+}
+
+inline std::size_t convertDepthBlocks(const float *values,
+                                      std::size_t size,
+                                      Half *result) {
+  std::size_t i{};
+  for (; i + 8 <= size; i += 8) {
+    const auto halves = _mm256_cvtps_ph(_mm256_loadu_ps(values + i),
+                                        _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i), halves);
+  }
+  return i;
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_F16C
+
+}  // namespace detail
+
+template <class T, class U>
+inline void convertDepth(const U *values, std::size_t size, T *result) {
+  auto i = detail::convertDepthBlocks(values, size, result);
+  for (; i < size; ++i) {
+    result[i] = detail::convertDepthValue<T>(values[i]);
+  }
+}
+
+template <class T, class U, int C>
+inline void convertDepth(const Color<U, C> *colors,
+                         std::size_t size,
+                         Color<T, C> *result) {
+  static_assert(sizeof(Color<U, C>) == sizeof(U) * C &&
+                sizeof(Color<T, C>) == sizeof(T) * C,
+                "Colors must be tightly packed");
+  if (size) {
+    convertDepth(colors->pointer(), size * C, result->pointer());
+  }
+}
+
+template <class T, class U, int C>
+inline void convertDepth(const ImageView<U, C>& image,
+                         ImageView<T, C> result) {
+  assert(image.width() == result.width());
+  assert(image.height() == result.height());
+  if (image.interleaved() && result.interleaved()) {
+    for (int y{}; y < image.height(); ++y) {
+      convertDepth(image.row(y), image.width() * C, result.row(y));
+    }
+    return;
+  }
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      for (int channel{}; channel < C; ++channel) {
+        result.at(x, y, channel) = detail::convertDepthValue<T>(
+            image.at(x, y, channel));
+      }
+    }
+  }
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::convertDepth;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_DEPTH_CONVERSION_H_
@@ -0,0 +1,440 @@
+//
+//  takram/graphics/dither.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_DITHER_H_
+#define TAKRAM_GRAPHICS_DITHER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "takram/graphics/depth.h"
+#include "takram/graphics/dither_method.h"
+#include "takram/graphics/image_view.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/simd.h"
+
+namespace takram {
+namespace graphics {
+
+// Converts images of floating-point values to 8 or 16-bit integers with
+// dithering, so that gradients do not band where Depth<T>::convert would
+// round neighboring values to the same code. Values outside [0, 1] are
+// clamped, and every channel is dithered alike, alpha included.
+//
+// - Bayer and blue-noise dithering add the thresholds of an 8x8 Bayer matrix
+//   or a 64x64 blue-noise mask, generated by the void-and-cluster method, to
+//   the scaled values and truncate them. Rows are independent, so they run
+//   in parallel and four values at a time with SSE2 where available.
+// - Floyd-Steinberg dithering diffuses the error of every value to its right
+//   and lower neighbors in raster order. Each row only needs the row above it
+//   to be two pixels ahead, so rows run in parallel as a pipeline, and the
+//   result is the same as that of a single thread.
+
+template <class T, class U, int C>
+void ditherDepth(const ImageView<U, C>& image,
+                 ImageView<T, C> result,
+                 DitherMethod method = DitherMethod::BLUE_NOISE);
+
+#pragma mark -
+
+namespace detail {
+
+// Thresholds in (0, 1) of a square matrix, tiled over images
+struct DitherMatrix {
+  int size;
+  std::vector<float> thresholds;
+};
+
+inline DitherMatrix makeBayerMatrix() {
+  // Recursive construction of the matrix from the 2x2 one
+  const int offsets[2][2]{{0, 2}, {3, 1}};
+  std::vector<int> ranks{0};
+  int size = 1;
+  for (; size < 8; size *= 2) {
+    std::vector<int> next(size * size * 4);
+    for (int y{}; y < size * 2; ++y) {
+      for (int x{}; x < size * 2; ++x) {
+        next[y * size * 2 + x] = ranks[(y % size) * size + x % size] * 4 +
+                                 offsets[y / size][x / size];
+      }
+    }
+    ranks.swap(next);
+  }
+  DitherMatrix matrix{size, std::vector<float>(ranks.size())};
+  for (std::size_t i{}; i < ranks.size(); ++i) {
+    matrix.thresholds[i] = (ranks[i] + 0.5f) / ranks.size();
+  }
+  return matrix;
+}
+
+// Ulichney's void-and-cluster method, with a Gaussian filter on the torus.
+// The clusters of empty cells in the second half of the ranking are the
+// largest voids of the filled cells, because the energies of both add up to a
+// constant, so that a single ranking loop covers both halves.
+inline DitherMatrix makeBlueNoiseMatrix() {
+  const int size = 64;
+  const int count = size * size;
+  const float sigma = 1.5f;
+  std::vector<float> filter(count);
+  for (int y{}; y < size; ++y) {
+    for (int x{}; x < size; ++x) {
+      const int dx = std::min(x, size - x);
+      const int dy = std::min(y, size - y);
+      filter[y * size + x] = std::exp(-(dx * dx + dy * dy) /
+                                      (2 * sigma * sigma));
+    }
+  }
+  std::vector<bool> pattern(count);
+  std::vector<float> energy(count);
+  const auto toggle = [&](int index) {
+    pattern[index] = !pattern[index];
+    const auto sign = pattern[index] ? 1.0f : -1.0f;
+    const int cx = index % size;
+    const int cy = index / size;
+    for (int y{}; y < size; ++y) {
+      const auto row = filter.data() + ((y - cy) & (size - 1)) * size;
+      for (int x{}; x < size; ++x) {
+        energy[y * size + x] += sign * row[(x - cx) & (size - 1)];
+      }
+    }
+  };
+  const auto tightestCluster = [&]() {
+    int result = -1;
+    for (int i{}; i < count; ++i) {
+      if (pattern[i] && (result < 0 || energy[i] > energy[result])) {
+        result = i;
+      }
+    }
+    return result;
+  };
+  const auto largestVoid = [&]() {
+    int result = -1;
+    for (int i{}; i < count; ++i) {
+      if (!pattern[i] && (result < 0 || energy[i] < energy[result])) {
+        result = i;
+      }
+    }
+    return result;
+  };
+
+  // Initial pattern of a tenth of the cells from a fixed sequence, spread
+  // evenly by moving its tightest clusters to its largest voids
+  const int ones = count / 10;
+  std::uint32_t state = 1;
+  for (int filled{}; filled < ones;) {
+    state = state * 1664525 + 1013904223;
+    const auto index = static_cast<int>(state >> 20);
+    if (!pattern[index]) {
+      toggle(index);
+      ++filled;
+    }
+  }
+  for (int i{}; i < count; ++i) {
+    const auto cluster = tightestCluster();
+    toggle(cluster);
+    const auto empty = largestVoid();
+    toggle(empty);
+    if (empty == cluster) {
+      break;
+    }
+  }
+  const auto prototype = pattern;
+  const auto prototype_energy = energy;
+
+  std::vector<int> ranks(count);
+  for (int rank = ones - 1; rank >= 0; --rank) {
+    const auto cluster = tightestCluster();
+    toggle(cluster);
+    ranks[cluster] = rank;
+  }
+  pattern = prototype;
+  energy = prototype_energy;
+  for (int rank = ones; rank < count; ++rank) {
+    const auto empty = largestVoid();
+    toggle(empty);
+    ranks[empty] = rank;
+  }
+  DitherMatrix matrix{size, std::vector<float>(count)};
+  for (int i{}; i < count; ++i) {
+    matrix.thresholds[i] = (ranks[i] + 0.5f) / count;
+  }
+  return matrix;
+}
+
+inline const DitherMatrix& bayerMatrix() {
+  static const auto matrix = makeBayerMatrix();
+  return matrix;
+}
+
+inline const DitherMatrix& blueNoiseMatrix() {
+  static const auto matrix = makeBlueNoiseMatrix();
+  return matrix;
+}
+
+// Returns the values of a row of an image interleaved in floats, pointing
+// into the image itself when it already is
+template <int C>
+inline const float * ditherSource(const ImageView<float, C>& image,
+                                  int y,
+                                  std::vector<float> *buffer) {
+  if (image.interleaved()) {
+    return image.row(y);
+  }
+  buffer->resize(image.width() * C);
+  for (int x{}; x < image.width(); ++x) {
+    for (int channel{}; channel < C; ++channel) {
+      (*buffer)[x * C + channel] = image.at(x, y, channel);
+    }
+  }
+  return buffer->data();
+}
+
+template <class U, int C>
+inline const float * ditherSource(const ImageView<U, C>& image,
+                                  int y,
+                                  std::vector<float> *buffer) {
+  buffer->resize(image.width() * C);
+  for (int x{}; x < image.width(); ++x) {
+    for (int channel{}; channel < C; ++channel) {
+      (*buffer)[x * C + channel] = image.at(x, y, channel);
+    }
+  }
+  return buffer->data();
+}
+
+// Returns where to write a row of an image interleaved, which is either the
+// image itself or the buffer to pass to ditherFlush() afterwards
+template <class T, int C>
+inline T * ditherTarget(ImageView<T, C> *image,
+                        int y,
+                        std::vector<T> *buffer) {
+  if (image->interleaved()) {
+    return image->row(y);
+  }
+  buffer->resize(image->width() * C);
+  return buffer->data();
+}
+
+template <class T, int C>
+inline void ditherFlush(ImageView<T, C> *image,
+                        int y,
+                        const std::vector<T>& buffer) {
+  if (image->interleaved()) {
+    return;
+  }
+  for (int x{}; x < image->width(); ++x) {
+    for (int channel{}; channel < C; ++channel) {
+      image->at(x, y, channel) = buffer[x * C + channel];
+    }
+  }
+}
+
+inline void ditherOrdered(const Lanes& values,
+                          const Lanes& thresholds,
+                          const Lanes& scale,
+                          std::int32_t *result) {
+  // Taking the maximum with the scaled value first turns NaN into zero
+  const auto dithered = floor(values * scale + thresholds);
+  roundLanes(min(max(dithered, Lanes(0.0f)), scale), result);
+}
+
+// Dithers a row against a row of thresholds repeating every period values,
+// which must be a multiple of four
+template <class T>
+inline void ditherOrdered(const float *values,
+                          std::size_t size,
+                          const float *thresholds,
+                          std::size_t period,
+                          T *result) {
+  assert(period % 4 == 0);
+  const Lanes scale(Depth<T>::max);
+  std::int32_t codes[4];
+  std::size_t i{};
+  std::size_t offset{};
+  for (; i + 4 <= size; i += 4) {
+    ditherOrdered(loadLanes(values + i), loadLanes(thresholds + offset),
+                  scale, codes);
+    for (int j{}; j < 4; ++j) {
+      result[i + j] = static_cast<T>(codes[j]);
+    }
+    offset += 4;
+    if (offset == period) {
+      offset = 0;
+    }
+  }
+  if (i < size) {
+    float remainder[4]{};
+    std::copy(values + i, values + size, remainder);
+    ditherOrdered(loadLanes(remainder), loadLanes(thresholds + offset),
+                  scale, codes);
+    for (std::size_t j{}; i + j < size; ++j) {
+      result[i + j] = static_cast<T>(codes[j]);
+    }
+  }
+}
+
+template <class T, class U, int C>
+inline void ditherOrdered(const ImageView<U, C>& image,
+                          ImageView<T, C> result,
+                          const DitherMatrix& matrix) {
+  // Rows of thresholds with every threshold repeated for all the channels
+  const auto size = matrix.size;
+  const std::size_t period = size * C;
+  std::vector<float> thresholds(size * period);
+  for (std::size_t i{}; i < thresholds.size(); ++i) {
+    thresholds[i] = matrix.thresholds[i / C];
+  }
+  parallelFor(image.height(), [&](std::size_t index) {
+    const auto y = static_cast<int>(index);
+    std::vector<float> source;
+    std::vector<T> target;
+    const auto values = ditherSource(image, y, &source);
+    const auto row = ditherTarget(&result, y, &target);
+    ditherOrdered(values, image.width() * C,
+                  thresholds.data() + (y % size) * period, period, row);
+    ditherFlush(&result, y, target);
+  });
+}
+
+inline float ditherClamp(float value) {
+  return value > 0.0f ? std::min(value, 1.0f) : 0.0f;
+}
+
+template <class T, class U, int C>
+inline void ditherFloydSteinberg(const ImageView<U, C>& image,
+                                 ImageView<T, C> result) {
+  const auto width = image.width();
+  const auto height = image.height();
+  if (!width || !height) {
+    return;
+  }
+  const float scale = Depth<T>::max;
+
+  // The errors for the next row are written while the row after it may still
+  // be reading those for its own, though only behind the pixels written, so
+  // that two rows of errors with a pixel of margin on either side suffice.
+  const std::size_t stride = (width + 2) * C;
+  std::vector<float> errors(stride * 2);
+  std::unique_ptr<std::atomic<int>[]> progress(new std::atomic<int>[height]);
+  for (int y{}; y < height; ++y) {
+    progress[y].store(0, std::memory_order_relaxed);
+  }
+  const int interval = 32;
+
+  parallelFor(height, [&](std::size_t index) {
+    const auto y = static_cast<int>(index);
+    std::vector<float> source;
+    std::vector<T> target;
+    const auto values = ditherSource(image, y, &source);
+    const auto row = ditherTarget(&result, y, &target);
+    const auto current = errors.data() + (y % 2) * stride + C;
+    const auto next = errors.data() + ((y + 1) % 2) * stride + C;
+
+    // Waits until the row above has finished the pixels that diffuse their
+    // errors to the pixel at x, and read the errors written there
+    int ready = y ? 0 : width;
+    const auto wait = [&](int x) {
+      const auto needed = std::min(x + 2, width);
+      while (ready < needed) {
+        ready = progress[y - 1].load(std::memory_order_acquire);
+        if (ready < needed) {
+          std::this_thread::yield();
+        }
+      }
+    };
+    wait(0);
+    std::fill(next - C, next + C, 0.0f);
+    float right[C]{};
+    for (int x{}; x < width; ++x) {
+      wait(x);
+      for (int channel{}; channel < C; ++channel) {
+        const auto i = x * C + channel;
+        const auto diffused = y ? current[i] + right[channel] : right[channel];
+        const auto value = ditherClamp(values[i]) * scale + diffused;
+        const auto code = std::min(std::max(std::floor(value + 0.5f), 0.0f),
+                                   scale);
+        row[i] = static_cast<T>(code);
+        const auto error = value - code;
+        right[channel] = error * (7.0f / 16.0f);
+        next[i - C] += error * (3.0f / 16.0f);
+        next[i] += error * (5.0f / 16.0f);
+        next[i + C] = error * (1.0f / 16.0f);
+      }
+      if ((x + 1) % interval == 0) {
+        progress[y].store(x + 1, std::memory_order_release);
+      }
+    }
+    ditherFlush(&result, y, target);
+    progress[y].store(width, std::memory_order_release);
+  });
+}
+
+}  // namespace detail
+
+template <class T, class U, int C>
+inline void ditherDepth(const ImageView<U, C>& image,
+                        ImageView<T, C> result,
+                        DitherMethod method) {
+  static_assert(std::is_integral<T>::value && Depth<T>::bits <= 16,
+                "Results must be of 8 or 16-bit integers");
+  static_assert(std::is_floating_point<U>::value,
+                "Values must be of floating point");
+  assert(image.width() == result.width());
+  assert(image.height() == result.height());
+  switch (method) {
+    case DitherMethod::BAYER:
+      detail::ditherOrdered(image, result, detail::bayerMatrix());
+      break;
+    case DitherMethod::BLUE_NOISE:
+      detail::ditherOrdered(image, result, detail::blueNoiseMatrix());
+      break;
+    case DitherMethod::FLOYD_STEINBERG:
+      detail::ditherFloydSteinberg(image, result);
+      break;
+    default:
+      assert(false);
+      break;
+  }
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::ditherDepth;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_DITHER_H_
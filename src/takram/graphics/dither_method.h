@@ -0,0 +1,63 @@
+//
+//  takram/graphics/dither_method.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_DITHER_METHOD_H_
+#define TAKRAM_GRAPHICS_DITHER_METHOD_H_
+
+#include <cassert>
+#include <ostream>
+
+namespace takram {
+namespace graphics {
+
+enum class DitherMethod {
+  BAYER,
+  BLUE_NOISE,
+  FLOYD_STEINBERG
+};
+
+inline std::ostream& operator<<(std::ostream& os, DitherMethod method) {
+  switch (method) {
+    case DitherMethod::BAYER: os << "bayer"; break;
+    case DitherMethod::BLUE_NOISE: os << "blue noise"; break;
+    case DitherMethod::FLOYD_STEINBERG: os << "floyd steinberg"; break;
+    default:
+      assert(false);
+      break;
+  }
+  return os;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::DitherMethod;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_DITHER_METHOD_H_
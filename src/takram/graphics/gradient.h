@@ -0,0 +1,396 @@
+//
+//  takram/graphics/gradient.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_GRADIENT_H_
+#define TAKRAM_GRAPHICS_GRADIENT_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/gradient_spread.h"
+#include "takram/graphics/premultiplied_color.h"
+#include "takram/graphics/simd.h"
+#include "takram/graphics/srgb.h"
+
+namespace takram {
+namespace graphics {
+
+// Maps the parameters of linear, radial or conic gradients to colors through
+// a table of premultiplied colors baked from the stops, so that filling a
+// span of pixels costs a lookup per pixel rather than a search for stops and
+// an interpolation. Colors are interpolated in premultiplied space as CSS
+// does, which keeps transparent stops from darkening their neighbors, and
+// optionally in linear light, treating the stops as sRGB-encoded. Stops of
+// equal offsets make hard edges. Parameters are wrapped by the spread mode and
+// rounded to the nearest entry, four at a time with SSE2 where available;
+// NaN takes the first entry. The table is rebaked whenever the stops or the
+// interpolation change, and holds 256 entries by default, which occupies 4KB
+// for float colors.
+
+template <class T>
+class Gradient final {
+ public:
+  using Type = T;
+
+  struct Stop {
+    Stop() : offset() {}
+    Stop(double offset, const Color4<T>& color)
+        : offset(offset),
+          color(color) {}
+
+    double offset;
+    Color4<T> color;
+  };
+
+ public:
+  Gradient();
+  explicit Gradient(const std::vector<Stop>& stops,
+                    GradientSpread spread = GradientSpread::PAD,
+                    bool linear_light = false,
+                    int resolution = 256);
+
+  // Copy semantics
+  Gradient(const Gradient&) = default;
+  Gradient& operator=(const Gradient&) = default;
+
+  // Mutators
+  void set(const std::vector<Stop>& stops);
+  void addStop(double offset, const Color4<T>& color);
+  void reset();
+
+  // Properties
+  const std::vector<Stop>& stops() const { return stops_; }
+  GradientSpread spread() const { return spread_; }
+  void set_spread(GradientSpread value) { spread_ = value; }
+  bool linear_light() const { return linear_light_; }
+  void set_linear_light(bool value);
+  int resolution() const { return resolution_; }
+  void set_resolution(int value);
+
+  // Attributes
+  bool empty() const { return stops_.empty(); }
+  const std::vector<PremultipliedColor<T>>& table() const { return table_; }
+
+  // Evaluation
+  PremultipliedColor<T> evaluate(float parameter) const;
+  void fill(const float *parameters,
+            std::size_t size,
+            PremultipliedColor<T> *result) const;
+  void fill(const float *parameters,
+            const T *coverage,
+            std::size_t size,
+            PremultipliedColor<T> *result) const;
+  void fill(float start,
+            float step,
+            std::size_t size,
+            PremultipliedColor<T> *result) const;
+
+ private:
+  template <class Parameters>
+  void fillSpan(Parameters parameters,
+                std::size_t size,
+                PremultipliedColor<T> *result) const;
+  template <GradientSpread Spread, class Parameters>
+  void fillSpread(Parameters parameters,
+                  std::size_t size,
+                  PremultipliedColor<T> *result) const;
+  Color4d interpolate(double offset) const;
+  void bake();
+
+ private:
+  std::vector<Stop> stops_;
+  GradientSpread spread_;
+  bool linear_light_;
+  int resolution_;
+  std::vector<PremultipliedColor<T>> table_;
+};
+
+using Gradient4u = Gradient<std::uint8_t>;
+using Gradient4s = Gradient<std::uint16_t>;
+using Gradient4f = Gradient<float>;
+using Gradient4d = Gradient<double>;
+
+#pragma mark -
+
+namespace detail {
+
+// Wraps parameters into [0, 1], sending NaN to zero
+template <GradientSpread Spread>
+struct GradientSpreadFunction;
+
+template <>
+struct GradientSpreadFunction<GradientSpread::PAD> {
+  static Lanes apply(const Lanes& parameter) {
+    return min(max(parameter, Lanes(0)), Lanes(1));
+  }
+};
+
+template <>
+struct GradientSpreadFunction<GradientSpread::REPEAT> {
+  static Lanes apply(const Lanes& parameter) {
+    return min(max(parameter - floor(parameter), Lanes(0)), Lanes(1));
+  }
+};
+
+template <>
+struct GradientSpreadFunction<GradientSpread::REFLECT> {
+  static Lanes apply(const Lanes& parameter) {
+    const auto half = parameter * Lanes(0.5);
+    const auto period = (half - floor(half)) * Lanes(2);
+    return max(Lanes(1) - abs(Lanes(1) - period), Lanes(0));
+  }
+};
+
+}  // namespace detail
+
+template <class T>
+inline Gradient<T>::Gradient()
+    : spread_(GradientSpread::PAD),
+      linear_light_(),
+      resolution_(256) {
+  bake();
+}
+
+template <class T>
+inline Gradient<T>::Gradient(const std::vector<Stop>& stops,
+                             GradientSpread spread,
+                             bool linear_light,
+                             int resolution)
+    : spread_(spread),
+      linear_light_(linear_light),
+      resolution_(std::max(resolution, 2)) {
+  set(stops);
+}
+
+#pragma mark Mutators
+
+template <class T>
+inline void Gradient<T>::set(const std::vector<Stop>& stops) {
+  stops_ = stops;
+  std::stable_sort(stops_.begin(), stops_.end(),
+                   [](const Stop& a, const Stop& b) {
+                     return a.offset < b.offset;
+                   });
+  bake();
+}
+
+template <class T>
+inline void Gradient<T>::addStop(double offset, const Color4<T>& color) {
+  // Stops of equal offsets keep the order they were added in
+  const auto position = std::upper_bound(
+      stops_.begin(), stops_.end(), offset,
+      [](double offset, const Stop& stop) { return offset < stop.offset; });
+  stops_.emplace(position, offset, color);
+  bake();
+}
+
+template <class T>
+inline void Gradient<T>::reset() {
+  stops_.clear();
+  bake();
+}
+
+#pragma mark Properties
+
+template <class T>
+inline void Gradient<T>::set_linear_light(bool value) {
+  linear_light_ = value;
+  bake();
+}
+
+template <class T>
+inline void Gradient<T>::set_resolution(int value) {
+  resolution_ = std::max(value, 2);
+  bake();
+}
+
+#pragma mark Evaluation
+
+template <class T>
+inline PremultipliedColor<T> Gradient<T>::evaluate(float parameter) const {
+  PremultipliedColor<T> result;
+  fill(&parameter, 1, &result);
+  return result;
+}
+
+template <class T>
+inline void Gradient<T>::fill(const float *parameters,
+                              std::size_t size,
+                              PremultipliedColor<T> *result) const {
+  fillSpan([parameters, size](std::size_t i) {
+    if (i + 4 <= size) {
+      return detail::loadLanes(parameters + i);
+    }
+    float values[4]{};
+    std::copy(parameters + i, parameters + size, values);
+    return detail::loadLanes(static_cast<const float *>(values));
+  }, size, result);
+}
+
+template <class T>
+inline void Gradient<T>::fill(const float *parameters,
+                              const T *coverage,
+                              std::size_t size,
+                              PremultipliedColor<T> *result) const {
+  fill(parameters, size, result);
+  for (std::size_t i{}; i < size; ++i) {
+    auto& color = result[i];
+    color.r = detail::multiplyChannels(color.r, coverage[i]);
+    color.g = detail::multiplyChannels(color.g, coverage[i]);
+    color.b = detail::multiplyChannels(color.b, coverage[i]);
+    color.a = detail::multiplyChannels(color.a, coverage[i]);
+  }
+}
+
+template <class T>
+inline void Gradient<T>::fill(float start,
+                              float step,
+                              std::size_t size,
+                              PremultipliedColor<T> *result) const {
+  fillSpan([start, step](std::size_t i) {
+    const float offsets[]{0, 1, 2, 3};
+    return detail::Lanes(start) + detail::Lanes(step) * (
+        detail::Lanes(static_cast<float>(i)) +
+        detail::loadLanes(static_cast<const float *>(offsets)));
+  }, size, result);
+}
+
+template <class T>
+template <class Parameters>
+inline void Gradient<T>::fillSpan(Parameters parameters,
+                                  std::size_t size,
+                                  PremultipliedColor<T> *result) const {
+  switch (spread_) {
+    case GradientSpread::PAD:
+      fillSpread<GradientSpread::PAD>(parameters, size, result);
+      break;
+    case GradientSpread::REPEAT:
+      fillSpread<GradientSpread::REPEAT>(parameters, size, result);
+      break;
+    case GradientSpread::REFLECT:
+      fillSpread<GradientSpread::REFLECT>(parameters, size, result);
+      break;
+    default:
+      assert(false);
+      break;
+  }
+}
+
+template <class T>
+template <GradientSpread Spread, class Parameters>
+inline void Gradient<T>::fillSpread(Parameters parameters,
+                                    std::size_t size,
+                                    PremultipliedColor<T> *result) const {
+  using Function = detail::GradientSpreadFunction<Spread>;
+  const auto table = table_.data();
+  const detail::Lanes scale(resolution_ - 1);
+  std::int32_t indices[4];
+  std::size_t i{};
+  for (; i + 4 <= size; i += 4) {
+    detail::roundLanes(Function::apply(parameters(i)) * scale, indices);
+    result[i + 0] = table[indices[0]];
+    result[i + 1] = table[indices[1]];
+    result[i + 2] = table[indices[2]];
+    result[i + 3] = table[indices[3]];
+  }
+  if (i < size) {
+    detail::roundLanes(Function::apply(parameters(i)) * scale, indices);
+    for (std::size_t j{}; i + j < size; ++j) {
+      result[i + j] = table[indices[j]];
+    }
+  }
+}
+
+#pragma mark Baking
+
+template <class T>
+inline Color4d Gradient<T>::interpolate(double offset) const {
+  // Straight colors in the space of interpolation, premultiplied
+  const auto premultiply = [this](const Color4<T>& color) {
+    Color4d result(color);
+    if (linear_light_) {
+      result = decodeSRGB(result);
+    }
+    return Color4d(result.r * result.a, result.g * result.a,
+                   result.b * result.a, result.a);
+  };
+  const auto upper = std::upper_bound(
+      stops_.begin(), stops_.end(), offset,
+      [](double offset, const Stop& stop) { return offset < stop.offset; });
+  if (upper == stops_.begin()) {
+    return premultiply(upper->color);
+  } else if (upper == stops_.end()) {
+    return premultiply(stops_.back().color);
+  }
+  const auto lower = upper - 1;
+  return premultiply(lower->color).lerp(
+      premultiply(upper->color),
+      (offset - lower->offset) / (upper->offset - lower->offset));
+}
+
+template <class T>
+inline void Gradient<T>::bake() {
+  table_.assign(resolution_, PremultipliedColor<T>());
+  if (stops_.empty()) {
+    return;
+  }
+  for (int i{}; i < resolution_; ++i) {
+    auto color = interpolate(static_cast<double>(i) / (resolution_ - 1));
+    if (linear_light_ && color.a > 0) {
+      // Encode the straight color, and premultiply it again
+      color = encodeSRGB(Color4d(color.r / color.a, color.g / color.a,
+                                 color.b / color.a, color.a));
+      color.r *= color.a;
+      color.g *= color.a;
+      color.b *= color.a;
+    }
+    table_[i] = PremultipliedColor<T>(Depth<T>::convert(color.r),
+                                      Depth<T>::convert(color.g),
+                                      Depth<T>::convert(color.b),
+                                      Depth<T>::convert(color.a));
+  }
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Gradient;
+using graphics::Gradient4u;
+using graphics::Gradient4s;
+using graphics::Gradient4f;
+using graphics::Gradient4d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_GRADIENT_H_
@@ -0,0 +1,156 @@
+//
+//  takram/graphics/half.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_HALF_H_
+#define TAKRAM_GRAPHICS_HALF_H_
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+namespace takram {
+namespace graphics {
+
+// A binary16 floating-point number of IEEE 754 for channels of HDR buffers,
+// which takes half the memory of float. It only stores values, and converts
+// implicitly to and from float for arithmetic, as OpenEXR's half does.
+// Conversion from float rounds to the nearest even and overflows to infinity,
+// and conversion to float is exact. Both make NaN quiet.
+
+class Half final {
+ public:
+  Half() : bits_() {}
+  Half(float value);
+  static Half fromBits(std::uint16_t bits);
+
+  // Copy semantics
+  Half(const Half&) = default;
+  Half& operator=(const Half&) = default;
+
+  // Conversion
+  operator float() const;
+
+  // Properties
+  std::uint16_t bits() const { return bits_; }
+  void set_bits(std::uint16_t value) { bits_ = value; }
+
+ private:
+  std::uint16_t bits_;
+};
+
+// Stream
+std::ostream& operator<<(std::ostream& os, Half value);
+
+#pragma mark -
+
+namespace detail {
+
+inline std::uint32_t floatBits(float value) {
+  std::uint32_t result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+inline float bitsFloat(std::uint32_t bits) {
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+// Fabian Giesen's conversions between binary32 and binary16, which handle
+// subnormal numbers by letting the FPU round and renormalize them.
+inline std::uint16_t floatToHalf(float value) {
+  auto bits = floatBits(value);
+  const auto sign = bits & 0x80000000;
+  bits ^= sign;
+  std::uint32_t result;
+  if (bits >= 0x47800000) {
+    // Infinity and numbers that overflow, and NaN made quiet with the upper
+    // bits of its payload as F16C does
+    result = bits > 0x7f800000 ? 0x7e00 | ((bits >> 13) & 0x3ff) : 0x7c00;
+  } else if (bits < 0x38800000) {
+    // Subnormal numbers and zero, rounded by the addition of a half
+    result = floatBits(bitsFloat(bits) + 0.5f) - 0x3f000000;
+  } else {
+    // Normal numbers, rounded to the nearest even by the bias and the lowest
+    // bit of the mantissa to keep
+    const auto odd = (bits >> 13) & 1;
+    bits += (std::uint32_t(15 - 127) << 23) + 0xfff + odd;
+    result = bits >> 13;
+  }
+  return static_cast<std::uint16_t>(result | (sign >> 16));
+}
+
+inline float halfToFloat(std::uint16_t value) {
+  const std::uint32_t exponent_mask = 0x7c00 << 13;
+  auto bits = std::uint32_t(value & 0x7fff) << 13;
+  const auto exponent = bits & exponent_mask;
+  bits += std::uint32_t(127 - 15) << 23;
+  if (exponent == exponent_mask) {
+    // Infinity, and NaN made quiet
+    bits += std::uint32_t(128 - 16) << 23;
+    if (bits & 0x7fffff) {
+      bits |= 0x400000;
+    }
+  } else if (!exponent) {
+    // Subnormal numbers and zero, renormalized by a subtraction
+    bits = floatBits(bitsFloat(bits + (1 << 23)) - bitsFloat(113 << 23));
+  }
+  return bitsFloat(bits | (std::uint32_t(value & 0x8000) << 16));
+}
+
+}  // namespace detail
+
+inline Half::Half(float value) : bits_(detail::floatToHalf(value)) {}
+
+inline Half Half::fromBits(std::uint16_t bits) {
+  Half result;
+  result.bits_ = bits;
+  return result;
+}
+
+#pragma mark Conversion
+
+inline Half::operator float() const {
+  return detail::halfToFloat(bits_);
+}
+
+#pragma mark Stream
+
+inline std::ostream& operator<<(std::ostream& os, Half value) {
+  return os << static_cast<float>(value);
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Half;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_HALF_H_
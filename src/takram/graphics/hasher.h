@@ -0,0 +1,287 @@
+//
+//  takram/graphics/hasher.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_HASHER_H_
+#define TAKRAM_GRAPHICS_HASHER_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+template <class T, int D>
+class SharedShape;
+
+// Computes a 64-bit content hash of commands, paths and shapes in the manner
+// of wyhash, folding one 64-bit word at a time through a 128-bit multiply.
+// Only the values a command type uses contribute to the hash, and every value
+// is widened to double first, so that paths comparing equal hash equally
+// regardless of their value types. A positive tolerance quantizes values onto
+// a grid of that spacing before hashing, which makes geometry that differs by
+// rounding noise within a grid cell collide on purpose. The state is updated
+// incrementally, so a hash can be extended as commands are appended to a path
+// without visiting the earlier commands again. A path hashes its commands
+// alone, which makes the digest of a hasher fed a path command by command
+// equal to the hash of that path at every step. A shape folds in the number
+// of commands after each of its paths and the number of paths at last, so
+// that the same commands split into paths differently hash differently.
+
+class Hasher final {
+ public:
+  Hasher();
+  explicit Hasher(double tolerance, std::uint64_t seed = 0);
+
+  // Copy semantics
+  Hasher(const Hasher&) = default;
+  Hasher& operator=(const Hasher&) = default;
+
+  // Properties
+  double tolerance() const { return tolerance_; }
+  std::uint64_t digest() const;
+
+  // The word a value is hashed as, which two values share when they fall onto
+  // the same grid cell
+  std::uint64_t word(double value) const;
+
+  // Updating
+  Hasher& update(std::uint64_t word);
+  Hasher& update(double value);
+  template <class T>
+  Hasher& update(const Vec2<T>& point);
+  template <class T>
+  Hasher& update(const Command2<T>& command);
+  template <class T>
+  Hasher& update(const Path2<T>& path);
+  template <class T>
+  Hasher& update(const Shape2<T>& shape);
+  template <class T>
+  Hasher& update(const SharedShape<T, 2>& shape);
+  void reset();
+
+ private:
+  static std::uint64_t mix(std::uint64_t a, std::uint64_t b);
+
+ private:
+  static constexpr const std::uint64_t secret0_ = 0xa0761d6478bd642f;
+  static constexpr const std::uint64_t secret1_ = 0xe7037ed1a0b428db;
+  static constexpr const std::uint64_t secret2_ = 0x8ebc6af09c88c6e3;
+  static constexpr const std::uint64_t secret3_ = 0x589965cc75374cc3;
+
+  double tolerance_;
+  std::uint64_t seed_;
+  std::uint64_t state_;
+  std::uint64_t length_;
+};
+
+template <class T>
+std::uint64_t hash(const Path2<T>& path, double tolerance = 0.0);
+template <class T>
+std::uint64_t hash(const Shape2<T>& shape, double tolerance = 0.0);
+
+#pragma mark -
+
+inline Hasher::Hasher() : Hasher(0.0) {}
+
+inline Hasher::Hasher(double tolerance, std::uint64_t seed)
+    : tolerance_(tolerance),
+      seed_(seed),
+      state_(seed ^ secret0_),
+      length_() {
+  assert(tolerance >= 0.0);
+}
+
+inline void Hasher::reset() {
+  state_ = seed_ ^ secret0_;
+  length_ = 0;
+}
+
+inline std::uint64_t Hasher::digest() const {
+  return mix(state_ ^ secret2_, length_ ^ secret3_);
+}
+
+inline std::uint64_t Hasher::word(double value) const {
+  if (tolerance_ > 0.0) {
+    const auto grid = std::floor(value / tolerance_ + 0.5);
+    if (std::abs(grid) < std::numeric_limits<std::int64_t>::max()) {
+      return static_cast<std::uint64_t>(static_cast<std::int64_t>(grid));
+    }
+  }
+  if (value == 0.0) {
+    return std::uint64_t();  // Positive and negative zeros
+  }
+  std::uint64_t result;
+  static_assert(sizeof(result) == sizeof(value), "");
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+#pragma mark Updating
+
+inline Hasher& Hasher::update(std::uint64_t word) {
+  state_ = mix(word ^ secret1_, state_ ^ secret0_);
+  ++length_;
+  return *this;
+}
+
+inline Hasher& Hasher::update(double value) {
+  return update(word(value));
+}
+
+template <class T>
+inline Hasher& Hasher::update(const Vec2<T>& point) {
+  update(static_cast<double>(point.x));
+  return update(static_cast<double>(point.y));
+}
+
+template <class T>
+inline Hasher& Hasher::update(const Command2<T>& command) {
+  update(static_cast<std::uint64_t>(command.type()) + 1);
+  switch (command.type()) {
+    case CommandType::MOVE:
+    case CommandType::LINE:
+      return update(command.point());
+    case CommandType::QUADRATIC:
+      update(command.control());
+      return update(command.point());
+    case CommandType::CONIC:
+      update(command.control());
+      update(command.point());
+      return update(static_cast<double>(command.weight()));
+    case CommandType::CUBIC:
+      update(command.control1());
+      update(command.control2());
+      return update(command.point());
+    case CommandType::CLOSE:
+      return *this;
+    default:
+      assert(false);
+      break;
+  }
+  return *this;
+}
+
+template <class T>
+inline Hasher& Hasher::update(const Path2<T>& path) {
+  for (const auto& command : path) {
+    update(command);
+  }
+  return *this;
+}
+
+template <class T>
+inline Hasher& Hasher::update(const Shape2<T>& shape) {
+  for (const auto& path : shape.paths()) {
+    update(path);
+    update(static_cast<std::uint64_t>(path.size()));
+  }
+  return update(static_cast<std::uint64_t>(shape.paths().size()));
+}
+
+template <class T>
+inline Hasher& Hasher::update(const SharedShape<T, 2>& shape) {
+  for (std::size_t index{}; index < shape.size(); ++index) {
+    const auto first = shape.begin(index);
+    const auto last = shape.end(index);
+    for (auto itr = first; itr != last; ++itr) {
+      update(*itr);
+    }
+    update(static_cast<std::uint64_t>(std::distance(first, last)));
+  }
+  return update(static_cast<std::uint64_t>(shape.size()));
+}
+
+inline std::uint64_t Hasher::mix(std::uint64_t a, std::uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  const auto product = static_cast<unsigned __int128>(a) * b;
+  return static_cast<std::uint64_t>(product) ^
+         static_cast<std::uint64_t>(product >> 64);
+#else
+  const std::uint64_t a_low = a & 0xffffffff, a_high = a >> 32;
+  const std::uint64_t b_low = b & 0xffffffff, b_high = b >> 32;
+  const auto low_low = a_low * b_low;
+  const auto high_low = a_high * b_low;
+  const auto low_high = a_low * b_high;
+  const auto high_high = a_high * b_high;
+  const auto middle = (low_low >> 32) + (high_low & 0xffffffff) + low_high;
+  const auto low = (middle << 32) | (low_low & 0xffffffff);
+  const auto high = high_high + (high_low >> 32) + (middle >> 32);
+  return low ^ high;
+#endif  // defined(__SIZEOF_INT128__)
+}
+
+#pragma mark -
+
+template <class T>
+inline std::uint64_t hash(const Path2<T>& path, double tolerance) {
+  return Hasher(tolerance).update(path).digest();
+}
+
+template <class T>
+inline std::uint64_t hash(const Shape2<T>& shape, double tolerance) {
+  return Hasher(tolerance).update(shape).digest();
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Hasher;
+
+}  // namespace takram
+
+namespace std {
+
+template <class T>
+struct hash<takram::graphics::Path<T, 2>> {
+  std::size_t operator()(const takram::graphics::Path<T, 2>& path) const {
+    return static_cast<std::size_t>(takram::graphics::hash(path));
+  }
+};
+
+template <class T>
+struct hash<takram::graphics::Shape<T, 2>> {
+  std::size_t operator()(const takram::graphics::Shape<T, 2>& shape) const {
+    return static_cast<std::size_t>(takram::graphics::hash(shape));
+  }
+};
+
+}  // namespace std
+
+#endif  // TAKRAM_GRAPHICS_HASHER_H_
@@ -0,0 +1,465 @@
+//
+//  takram/graphics/histogram.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_HISTOGRAM_H_
+#define TAKRAM_GRAPHICS_HISTOGRAM_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "takram/graphics/channel.h"
+#include "takram/graphics/color.h"
+#include "takram/graphics/image_view.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/simd.h"
+
+namespace takram {
+namespace graphics {
+
+// Per-channel histograms of color buffers and images, along with the minimum,
+// maximum and mean of every channel, for auto exposure and quantization.
+// Integral channels are divided into bins over their whole range, and
+// floating-point channels over [0, 1], clamping values outside it and NaNs
+// into the first and last bins. The minimum and maximum skip NaNs while the
+// mean takes them in.
+//
+// Colors are split into as many chunks as there are threads, each of which
+// counts into bins of its own that are merged at the end, so that no thread
+// contends with another. Color4u and Color4f reduce the statistics of whole
+// pixels at once with SSE2 where available.
+
+namespace detail {
+
+struct HistogramPartial;
+
+}  // namespace detail
+
+template <class T, int C>
+class Histogram final {
+ public:
+  using Type = T;
+  static constexpr const int channels = C;
+
+ public:
+  Histogram();
+  Histogram(const Color<T, C> *colors, std::size_t size, int bins = 256);
+  explicit Histogram(const ImageView<const T, C>& image, int bins = 256);
+
+  // Copy semantics
+  Histogram(const Histogram&) = default;
+  Histogram& operator=(const Histogram&) = default;
+
+  // Mutators
+  void set(const Color<T, C> *colors, std::size_t size, int bins = 256);
+  void set(const ImageView<const T, C>& image, int bins = 256);
+  void reset();
+
+  // Attributes
+  bool empty() const { return !total_; }
+  int bins() const { return bins_; }
+  std::size_t total() const { return total_; }
+
+  // Element access
+  std::size_t count(Channel channel, int bin) const;
+  const std::size_t * counts(Channel channel) const;
+
+  // Statistics
+  double min(Channel channel) const { return min_[index(channel)]; }
+  double max(Channel channel) const { return max_[index(channel)]; }
+  double mean(Channel channel) const { return mean_[index(channel)]; }
+  int quantile(Channel channel, double fraction) const;
+
+ private:
+  static int index(Channel channel);
+  void merge(const std::vector<detail::HistogramPartial>& partials,
+             std::size_t size,
+             int bins);
+
+ private:
+  int bins_;
+  std::size_t total_;
+  std::vector<std::size_t> counts_;
+  double min_[C];
+  double max_[C];
+  double mean_[C];
+};
+
+using Histogram3u = Histogram<std::uint8_t, 3>;
+using Histogram4u = Histogram<std::uint8_t, 4>;
+using Histogram3f = Histogram<float, 3>;
+using Histogram4f = Histogram<float, 4>;
+
+#pragma mark -
+
+namespace detail {
+
+// The counts and statistics of the colors of a chunk
+struct HistogramPartial {
+  HistogramPartial(int channels, int bins);
+
+  std::vector<std::size_t> counts;
+  double min[4];
+  double max[4];
+  double sums[4];
+};
+
+inline HistogramPartial::HistogramPartial(int channels, int bins)
+    : counts(static_cast<std::size_t>(channels) * bins),
+      min(),
+      max(),
+      sums() {
+  std::fill(min, min + 4, std::numeric_limits<double>::infinity());
+  std::fill(max, max + 4, -std::numeric_limits<double>::infinity());
+}
+
+template <class T>
+inline int histogramBin(T value, int bins, std::true_type) {
+  return static_cast<int>((static_cast<std::uint64_t>(value) * bins) >>
+                          std::numeric_limits<T>::digits);
+}
+
+template <class T>
+inline int histogramBin(T value, int bins, std::false_type) {
+  const auto scaled = static_cast<float>(value) * bins;
+  if (!(scaled > 0)) {
+    return 0;
+  }
+  return static_cast<int>(std::min(scaled, static_cast<float>(bins - 1)));
+}
+
+template <class T, int C>
+inline void accumulateHistogram(const Color<T, C> *colors,
+                                std::size_t size,
+                                int bins,
+                                HistogramPartial *partial) {
+  // Statistics are taken in locals and written back once, since partials
+  // lie next to each other and would share cache lines between threads
+  const auto counts = partial->counts.data();
+  double minima[C];
+  double maxima[C];
+  double sums[C];
+  std::copy(partial->min, partial->min + C, minima);
+  std::copy(partial->max, partial->max + C, maxima);
+  std::copy(partial->sums, partial->sums + C, sums);
+  for (std::size_t i{}; i < size; ++i) {
+    for (int c{}; c < C; ++c) {
+      const auto value = colors[i].vector[c];
+      ++counts[c * bins + histogramBin(value, bins, std::is_integral<T>())];
+      const auto number = static_cast<double>(value);
+      minima[c] = number < minima[c] ? number : minima[c];
+      maxima[c] = number > maxima[c] ? number : maxima[c];
+      sums[c] += number;
+    }
+  }
+  std::copy(minima, minima + C, partial->min);
+  std::copy(maxima, maxima + C, partial->max);
+  std::copy(sums, sums + C, partial->sums);
+}
+
+#if TAKRAM_GRAPHICS_HAS_SSE2
+
+inline void accumulateHistogram(const Color4u *colors,
+                                std::size_t size,
+                                int bins,
+                                HistogramPartial *partial) {
+  const auto counts = partial->counts.data();
+  const auto zero = _mm_setzero_si128();
+  auto minimum = _mm_set1_epi8(-1);
+  auto maximum = zero;
+  const auto end = size & ~std::size_t(3);
+  for (std::size_t i{}; i < end;) {
+    // Every lane of the sums adds four values of a channel per step, which
+    // stays far below 2^32 over blocks of 2^20 pixels
+    const auto block = i + std::min<std::size_t>(end - i, 1 << 20);
+    auto sum = zero;
+    for (; i < block; i += 4) {
+      const auto bytes = reinterpret_cast<const std::uint8_t *>(colors + i);
+      for (int j{}; j < 16; ++j) {
+        ++counts[(j & 3) * bins + (bytes[j] * bins >> 8)];
+      }
+      const auto pixels = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(bytes));
+      minimum = _mm_min_epu8(minimum, pixels);
+      maximum = _mm_max_epu8(maximum, pixels);
+      const auto pairs = _mm_add_epi16(_mm_unpacklo_epi8(pixels, zero),
+                                       _mm_unpackhi_epi8(pixels, zero));
+      sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_unpacklo_epi16(pairs, zero),
+                                             _mm_unpackhi_epi16(pairs, zero)));
+    }
+    std::uint32_t sums[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums), sum);
+    for (int c{}; c < 4; ++c) {
+      partial->sums[c] += sums[c];
+    }
+  }
+  if (end) {
+    std::uint8_t minima[16];
+    std::uint8_t maxima[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(minima), minimum);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maxima), maximum);
+    for (int j{}; j < 16; ++j) {
+      auto& min = partial->min[j & 3];
+      auto& max = partial->max[j & 3];
+      min = std::min<double>(min, minima[j]);
+      max = std::max<double>(max, maxima[j]);
+    }
+  }
+  accumulateHistogram<std::uint8_t, 4>(colors + end, size - end, bins,
+                                       partial);
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+
+inline void accumulateHistogram(const Color4f *colors,
+                                std::size_t size,
+                                int bins,
+                                HistogramPartial *partial) {
+  const auto counts = partial->counts.data();
+  const Lanes scale(static_cast<float>(bins));
+  const Lanes zero(0.0f);
+  const Lanes last(static_cast<float>(bins - 1));
+  Lanes minimum(std::numeric_limits<float>::infinity());
+  Lanes maximum(-std::numeric_limits<float>::infinity());
+  for (std::size_t i{}; i < size;) {
+    // Sums of floats lose precision over many pixels, so that they are taken
+    // in blocks and added up in doubles
+    const auto block = i + std::min<std::size_t>(size - i, 0x100);
+    Lanes sum(0.0f);
+    for (; i < block; ++i) {
+      const auto values = loadLanes(colors[i].pointer());
+      minimum = min(values, minimum);
+      maximum = max(values, maximum);
+      sum = sum + values;
+      std::int32_t indices[4];
+      roundLanes(floor(min(max(values * scale, zero), last)), indices);
+      for (int c{}; c < 4; ++c) {
+        ++counts[c * bins + indices[c]];
+      }
+    }
+    float sums[4];
+    storeLanes(sum, sums);
+    for (int c{}; c < 4; ++c) {
+      partial->sums[c] += sums[c];
+    }
+  }
+  float minima[4];
+  float maxima[4];
+  storeLanes(minimum, minima);
+  storeLanes(maximum, maxima);
+  for (int c{}; c < 4; ++c) {
+    partial->min[c] = std::min<double>(partial->min[c], minima[c]);
+    partial->max[c] = std::max<double>(partial->max[c], maxima[c]);
+  }
+}
+
+// The number of chunks to split colors into, one for each thread as long as
+// every chunk has enough colors to be worth a thread
+inline std::size_t histogramChunks(std::size_t size) {
+  const std::size_t concurrency = std::thread::hardware_concurrency();
+  return std::max<std::size_t>(std::min<std::size_t>(
+      concurrency, (size + 0xffff) / 0x10000), 1);
+}
+
+}  // namespace detail
+
+#pragma mark -
+
+template <class T, int C>
+inline Histogram<T, C>::Histogram()
+    : bins_(),
+      total_(),
+      min_(),
+      max_(),
+      mean_() {}
+
+template <class T, int C>
+inline Histogram<T, C>::Histogram(const Color<T, C> *colors,
+                                  std::size_t size,
+                                  int bins)
+    : Histogram() {
+  set(colors, size, bins);
+}
+
+template <class T, int C>
+inline Histogram<T, C>::Histogram(const ImageView<const T, C>& image,
+                                  int bins)
+    : Histogram() {
+  set(image, bins);
+}
+
+#pragma mark Mutators
+
+template <class T, int C>
+inline void Histogram<T, C>::set(const Color<T, C> *colors,
+                                 std::size_t size,
+                                 int bins) {
+  assert(bins > 0);
+  const auto chunks = detail::histogramChunks(size);
+  std::vector<detail::HistogramPartial> partials(
+      chunks, detail::HistogramPartial(C, bins));
+  parallelFor(chunks, [&](std::size_t chunk) {
+    const auto begin = size * chunk / chunks;
+    const auto end = size * (chunk + 1) / chunks;
+    detail::accumulateHistogram(colors + begin, end - begin, bins,
+                                &partials[chunk]);
+  });
+  merge(partials, size, bins);
+}
+
+template <class T, int C>
+inline void Histogram<T, C>::set(const ImageView<const T, C>& image,
+                                 int bins) {
+  static_assert(sizeof(Color<T, C>) == sizeof(T) * C,
+                "Colors must be tightly packed");
+  assert(bins > 0);
+  const auto width = image.width();
+  const auto height = image.height();
+  const auto size = static_cast<std::size_t>(width) * height;
+  const auto chunks = std::min<std::size_t>(detail::histogramChunks(size),
+                                            std::max(height, 1));
+  std::vector<detail::HistogramPartial> partials(
+      chunks, detail::HistogramPartial(C, bins));
+  parallelFor(chunks, [&](std::size_t chunk) {
+    const auto begin = static_cast<int>(height * chunk / chunks);
+    const auto end = static_cast<int>(height * (chunk + 1) / chunks);
+    std::vector<Color<T, C>> colors;
+    for (auto y = begin; y < end; ++y) {
+      if (image.interleaved()) {
+        detail::accumulateHistogram(
+            reinterpret_cast<const Color<T, C> *>(image.row(y)), width, bins,
+            &partials[chunk]);
+        continue;
+      }
+      // Gather the pixels of planar rows
+      colors.resize(width);
+      for (int x{}; x < width; ++x) {
+        colors[x] = image.pixel(x, y);
+      }
+      detail::accumulateHistogram(colors.data(), width, bins,
+                                  &partials[chunk]);
+    }
+  });
+  merge(partials, size, bins);
+}
+
+template <class T, int C>
+inline void Histogram<T, C>::reset() {
+  bins_ = 0;
+  total_ = 0;
+  counts_.clear();
+  std::fill(min_, min_ + C, 0.0);
+  std::fill(max_, max_ + C, 0.0);
+  std::fill(mean_, mean_ + C, 0.0);
+}
+
+#pragma mark Element access
+
+template <class T, int C>
+inline std::size_t Histogram<T, C>::count(Channel channel, int bin) const {
+  assert(0 <= bin && bin < bins_);
+  return counts(channel)[bin];
+}
+
+template <class T, int C>
+inline const std::size_t * Histogram<T, C>::counts(Channel channel) const {
+  return counts_.data() + static_cast<std::size_t>(index(channel)) * bins_;
+}
+
+#pragma mark Statistics
+
+template <class T, int C>
+inline int Histogram<T, C>::quantile(Channel channel, double fraction) const {
+  assert(!empty());
+  // The first bin at which the cumulative count reaches the fraction
+  const auto target = std::min(std::max(fraction, 0.0), 1.0) * total_;
+  const auto values = counts(channel);
+  std::size_t cumulative{};
+  for (int bin{}; bin < bins_ - 1; ++bin) {
+    cumulative += values[bin];
+    if (cumulative && cumulative >= target) {
+      return bin;
+    }
+  }
+  return bins_ - 1;
+}
+
+template <class T, int C>
+inline void Histogram<T, C>::merge(
+    const std::vector<detail::HistogramPartial>& partials,
+    std::size_t size,
+    int bins) {
+  reset();
+  bins_ = bins;
+  total_ = size;
+  counts_.assign(static_cast<std::size_t>(C) * bins, 0);
+  for (const auto& partial : partials) {
+    std::transform(counts_.begin(), counts_.end(), partial.counts.begin(),
+                   counts_.begin(), std::plus<std::size_t>());
+  }
+  if (!size) {
+    return;
+  }
+  for (int c{}; c < C; ++c) {
+    double sum{};
+    min_[c] = std::numeric_limits<double>::infinity();
+    max_[c] = -std::numeric_limits<double>::infinity();
+    for (const auto& partial : partials) {
+      min_[c] = std::min(min_[c], partial.min[c]);
+      max_[c] = std::max(max_[c], partial.max[c]);
+      sum += partial.sums[c];
+    }
+    mean_[c] = sum / size;
+  }
+}
+
+template <class T, int C>
+inline int Histogram<T, C>::index(Channel channel) {
+  const auto result = static_cast<int>(channel);
+  assert(0 <= result && result < C);
+  return result;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Histogram;
+using graphics::Histogram3u;
+using graphics::Histogram4u;
+using graphics::Histogram3f;
+using graphics::Histogram4f;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_HISTOGRAM_H_
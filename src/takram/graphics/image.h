@@ -0,0 +1,315 @@
+//
+//  takram/graphics/image.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_IMAGE_H_
+#define TAKRAM_GRAPHICS_IMAGE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/half.h"
+#include "takram/graphics/image_layout.h"
+#include "takram/graphics/image_view.h"
+
+namespace takram {
+namespace graphics {
+
+// Owns the pixels of an image in interleaved or planar layout. Every row, and
+// every plane in planar layout, begins at an address aligned to the
+// alignment constant, and rows are padded to keep them so. Copies duplicate
+// the pixels, whereas moves transfer them and leave the source empty. Views
+// of the image or of its regions refer to its pixels without copying them,
+// and stay valid until the image holding the pixels is destroyed or
+// reallocated. Views of constant images only read the pixels.
+
+template <class T, int C>
+class Image final {
+ public:
+  using Type = T;
+  static constexpr const int channels = C;
+  static constexpr const std::size_t alignment = 64;
+
+ public:
+  Image() = default;
+  Image(int width,
+        int height,
+        ImageLayout layout = ImageLayout::INTERLEAVED);
+  Image(int width,
+        int height,
+        const Color<T, C>& color,
+        ImageLayout layout = ImageLayout::INTERLEAVED);
+  explicit Image(const ImageView<const T, C>& view,
+                 ImageLayout layout = ImageLayout::INTERLEAVED);
+
+  // Copy semantics
+  Image(const Image& other);
+  Image& operator=(const Image& other);
+
+  // Move semantics
+  Image(Image&& other) noexcept;
+  Image& operator=(Image&& other) noexcept;
+
+  // Mutators
+  void set(int width,
+           int height,
+           ImageLayout layout = ImageLayout::INTERLEAVED);
+  void reset();
+
+  // Attributes
+  bool empty() const { return view_.empty(); }
+  int width() const { return view_.width(); }
+  int height() const { return view_.height(); }
+  ImageLayout layout() const { return layout_; }
+  std::ptrdiff_t rowStride() const { return view_.rowStride(); }
+
+  // Views
+  ImageView<T, C> view() { return view_; }
+  ImageView<const T, C> view() const { return view_; }
+  ImageView<T, C> region(int x, int y, int width, int height);
+  ImageView<const T, C> region(int x, int y, int width, int height) const;
+  ImageView<T, 1> channel(int channel);
+  ImageView<const T, 1> channel(int channel) const;
+
+  // Element access
+  T * data() { return view_.data(); }
+  const T * data() const { return view_.data(); }
+  T * row(int y) { return view_.row(y); }
+  const T * row(int y) const { return view_.row(y); }
+  T& at(int x, int y, int channel = 0) { return view_.at(x, y, channel); }
+  const T& at(int x, int y, int channel = 0) const;
+  Color<T, C> pixel(int x, int y) const { return view_.pixel(x, y); }
+  void setPixel(int x, int y, const Color<T, C>& color);
+
+  // Operations
+  void fill(const Color<T, C>& color) { view_.fill(color); }
+
+ private:
+  static std::ptrdiff_t align(std::ptrdiff_t size);
+
+ private:
+  std::unique_ptr<unsigned char[]> buffer_;
+  ImageView<T, C> view_;
+  ImageLayout layout_ = ImageLayout::INTERLEAVED;
+};
+
+template <class T>
+using Image3 = Image<T, 3>;
+template <class T>
+using Image4 = Image<T, 4>;
+
+using Image3u = Image3<std::uint8_t>;
+using Image3s = Image3<std::uint16_t>;
+using Image3i = Image3<std::uint32_t>;
+using Image3h = Image3<Half>;
+using Image3f = Image3<float>;
+using Image3d = Image3<double>;
+
+using Image4u = Image4<std::uint8_t>;
+using Image4s = Image4<std::uint16_t>;
+using Image4i = Image4<std::uint32_t>;
+using Image4h = Image4<Half>;
+using Image4f = Image4<float>;
+using Image4d = Image4<double>;
+
+#pragma mark -
+
+template <class T, int C>
+inline Image<T, C>::Image(int width, int height, ImageLayout layout) {
+  set(width, height, layout);
+}
+
+template <class T, int C>
+inline Image<T, C>::Image(int width,
+                          int height,
+                          const Color<T, C>& color,
+                          ImageLayout layout) {
+  set(width, height, layout);
+  fill(color);
+}
+
+template <class T, int C>
+inline Image<T, C>::Image(const ImageView<const T, C>& view,
+                          ImageLayout layout) {
+  set(view.width(), view.height(), layout);
+  view_.copy(view);
+}
+
+#pragma mark Copy semantics
+
+template <class T, int C>
+inline Image<T, C>::Image(const Image& other) {
+  set(other.width(), other.height(), other.layout_);
+  view_.copy(other.view_);
+}
+
+template <class T, int C>
+inline Image<T, C>& Image<T, C>::operator=(const Image& other) {
+  if (&other != this) {
+    if (width() != other.width() || height() != other.height() ||
+        layout_ != other.layout_) {
+      set(other.width(), other.height(), other.layout_);
+    }
+    view_.copy(other.view_);
+  }
+  return *this;
+}
+
+#pragma mark Move semantics
+
+template <class T, int C>
+inline Image<T, C>::Image(Image&& other) noexcept
+    : buffer_(std::move(other.buffer_)),
+      view_(other.view_),
+      layout_(other.layout_) {
+  other.reset();
+}
+
+template <class T, int C>
+inline Image<T, C>& Image<T, C>::operator=(Image&& other) noexcept {
+  if (&other != this) {
+    buffer_ = std::move(other.buffer_);
+    view_ = other.view_;
+    layout_ = other.layout_;
+    other.reset();
+  }
+  return *this;
+}
+
+#pragma mark Mutators
+
+template <class T, int C>
+inline void Image<T, C>::set(int width, int height, ImageLayout layout) {
+  assert(width >= 0 && height >= 0);
+  static_assert(alignment % sizeof(T) == 0, "");
+  std::ptrdiff_t row_stride;
+  std::ptrdiff_t pixel_stride;
+  std::ptrdiff_t channel_stride;
+  std::ptrdiff_t size;
+  switch (layout) {
+    case ImageLayout::INTERLEAVED:
+      row_stride = align(width * C);
+      pixel_stride = C;
+      channel_stride = 1;
+      size = row_stride * height;
+      break;
+    case ImageLayout::PLANAR:
+      row_stride = align(width);
+      pixel_stride = 1;
+      channel_stride = align(row_stride * height);
+      size = channel_stride * C;
+      break;
+    default:
+      assert(false);
+      return;
+  }
+  buffer_.reset(new unsigned char[size * sizeof(T) + alignment]);
+  const auto address = reinterpret_cast<std::uintptr_t>(buffer_.get());
+  const auto offset = (alignment - address % alignment) % alignment;
+  view_ = ImageView<T, C>(reinterpret_cast<T *>(buffer_.get() + offset),
+                          width, height,
+                          row_stride, pixel_stride, channel_stride);
+  layout_ = layout;
+}
+
+template <class T, int C>
+inline void Image<T, C>::reset() {
+  buffer_.reset();
+  view_ = ImageView<T, C>();
+  layout_ = ImageLayout::INTERLEAVED;
+}
+
+template <class T, int C>
+inline std::ptrdiff_t Image<T, C>::align(std::ptrdiff_t size) {
+  const std::ptrdiff_t count = alignment / sizeof(T);
+  return (size + count - 1) / count * count;
+}
+
+#pragma mark Views
+
+template <class T, int C>
+inline ImageView<T, C> Image<T, C>::region(int x, int y,
+                                           int width,
+                                           int height) {
+  return view_.region(x, y, width, height);
+}
+
+template <class T, int C>
+inline ImageView<const T, C> Image<T, C>::region(int x, int y,
+                                                 int width,
+                                                 int height) const {
+  return view().region(x, y, width, height);
+}
+
+template <class T, int C>
+inline ImageView<T, 1> Image<T, C>::channel(int channel) {
+  return view_.channel(channel);
+}
+
+template <class T, int C>
+inline ImageView<const T, 1> Image<T, C>::channel(int channel) const {
+  return view().channel(channel);
+}
+
+#pragma mark Element access
+
+template <class T, int C>
+inline const T& Image<T, C>::at(int x, int y, int channel) const {
+  return view_.at(x, y, channel);
+}
+
+template <class T, int C>
+inline void Image<T, C>::setPixel(int x, int y, const Color<T, C>& color) {
+  view_.setPixel(x, y, color);
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Image;
+using graphics::Image3;
+using graphics::Image4;
+using graphics::Image3u;
+using graphics::Image3s;
+using graphics::Image3i;
+using graphics::Image3h;
+using graphics::Image3f;
+using graphics::Image3d;
+using graphics::Image4u;
+using graphics::Image4s;
+using graphics::Image4i;
+using graphics::Image4h;
+using graphics::Image4f;
+using graphics::Image4d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_IMAGE_H_
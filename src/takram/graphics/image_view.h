@@ -0,0 +1,366 @@
+//
+//  takram/graphics/image_view.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_IMAGE_VIEW_H_
+#define TAKRAM_GRAPHICS_IMAGE_VIEW_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if TAKRAM_HAS_OPENCV
+#include "opencv2/core/core.hpp"
+#endif  // TAKRAM_HAS_OPENCV
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/half.h"
+#include "takram/graphics/image_layout.h"
+
+namespace takram {
+namespace graphics {
+
+// Refers to pixels in memory owned by someone else. The channel at a pixel is
+// addressed by three strides measured in channel values: one between rows,
+// one between pixels in a row, and one between channels of a pixel. This
+// describes interleaved and planar layouts alike, and lets views of regions
+// and of single channels refer to the same memory without copying it. Views
+// are cheap to copy, and copies refer to the same pixels. Views of constant
+// values, such as ImageView<const float, 4>, refer to memory that they only
+// read, and views of mutable values convert to them implicitly.
+
+template <class T, int C>
+class ImageView final {
+ public:
+  using Type = T;
+  using Value = typename std::remove_const<T>::type;
+  static constexpr const int channels = C;
+
+ public:
+  ImageView();
+  ImageView(T *data,
+            int width,
+            int height,
+            ImageLayout layout = ImageLayout::INTERLEAVED);
+  ImageView(T *data,
+            int width,
+            int height,
+            std::ptrdiff_t row_stride,
+            std::ptrdiff_t pixel_stride = C,
+            std::ptrdiff_t channel_stride = 1);
+
+#if TAKRAM_HAS_OPENCV
+  explicit ImageView(cv::Mat& mat);
+  operator cv::Mat() const;
+#endif  // TAKRAM_HAS_OPENCV
+
+  // Implicit conversion
+  template <class U, class = typename std::enable_if<
+      std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+  ImageView(const ImageView<U, C>& other);
+
+  // Copy semantics
+  ImageView(const ImageView&) = default;
+  ImageView& operator=(const ImageView&) = default;
+
+  // Attributes
+  bool empty() const { return !width_ || !height_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  std::ptrdiff_t rowStride() const { return row_stride_; }
+  std::ptrdiff_t pixelStride() const { return pixel_stride_; }
+  std::ptrdiff_t channelStride() const { return channel_stride_; }
+  bool interleaved() const;
+  bool contiguous() const;
+
+  // Element access
+  T * data() { return data_; }
+  const T * data() const { return data_; }
+  T * row(int y);
+  const T * row(int y) const;
+  T& at(int x, int y, int channel = 0);
+  const T& at(int x, int y, int channel = 0) const;
+  Color<Value, C> pixel(int x, int y) const;
+  void setPixel(int x, int y, const Color<Value, C>& color);
+
+  // Views
+  ImageView region(int x, int y, int width, int height) const;
+  ImageView<T, 1> channel(int channel) const;
+
+  // Operations
+  void fill(const Color<Value, C>& color);
+  void copy(const ImageView<const Value, C>& other);
+
+ private:
+  template <class, int>
+  friend class ImageView;
+
+ private:
+  T *data_;
+  int width_;
+  int height_;
+  std::ptrdiff_t row_stride_;
+  std::ptrdiff_t pixel_stride_;
+  std::ptrdiff_t channel_stride_;
+};
+
+template <class T>
+using ImageView3 = ImageView<T, 3>;
+template <class T>
+using ImageView4 = ImageView<T, 4>;
+
+using ImageView3u = ImageView3<std::uint8_t>;
+using ImageView3s = ImageView3<std::uint16_t>;
+using ImageView3i = ImageView3<std::uint32_t>;
+using ImageView3h = ImageView3<Half>;
+using ImageView3f = ImageView3<float>;
+using ImageView3d = ImageView3<double>;
+
+using ImageView4u = ImageView4<std::uint8_t>;
+using ImageView4s = ImageView4<std::uint16_t>;
+using ImageView4i = ImageView4<std::uint32_t>;
+using ImageView4h = ImageView4<Half>;
+using ImageView4f = ImageView4<float>;
+using ImageView4d = ImageView4<double>;
+
+#pragma mark -
+
+template <class T, int C>
+inline ImageView<T, C>::ImageView()
+    : data_(),
+      width_(),
+      height_(),
+      row_stride_(),
+      pixel_stride_(C),
+      channel_stride_(1) {}
+
+template <class T, int C>
+inline ImageView<T, C>::ImageView(T *data,
+                                  int width,
+                                  int height,
+                                  ImageLayout layout)
+    : data_(data),
+      width_(width),
+      height_(height),
+      row_stride_(layout == ImageLayout::PLANAR ? width : width * C),
+      pixel_stride_(layout == ImageLayout::PLANAR ? 1 : C),
+      channel_stride_(layout == ImageLayout::PLANAR ?
+                      static_cast<std::ptrdiff_t>(width) * height : 1) {
+  assert(width >= 0 && height >= 0);
+}
+
+template <class T, int C>
+inline ImageView<T, C>::ImageView(T *data,
+                                  int width,
+                                  int height,
+                                  std::ptrdiff_t row_stride,
+                                  std::ptrdiff_t pixel_stride,
+                                  std::ptrdiff_t channel_stride)
+    : data_(data),
+      width_(width),
+      height_(height),
+      row_stride_(row_stride),
+      pixel_stride_(pixel_stride),
+      channel_stride_(channel_stride) {
+  assert(width >= 0 && height >= 0);
+}
+
+template <class T, int C>
+template <class U, class>
+inline ImageView<T, C>::ImageView(const ImageView<U, C>& other)
+    : data_(other.data_),
+      width_(other.width_),
+      height_(other.height_),
+      row_stride_(other.row_stride_),
+      pixel_stride_(other.pixel_stride_),
+      channel_stride_(other.channel_stride_) {}
+
+#if TAKRAM_HAS_OPENCV
+
+template <class T, int C>
+inline ImageView<T, C>::ImageView(cv::Mat& mat)
+    : data_(mat.ptr<T>()),
+      width_(mat.cols),
+      height_(mat.rows),
+      row_stride_(mat.step[0] / sizeof(T)),
+      pixel_stride_(C),
+      channel_stride_(1) {
+  assert(mat.dims == 2);
+  assert(mat.depth() == cv::DataType<T>::depth);
+  assert(mat.channels() == C);
+  assert(mat.step[0] % sizeof(T) == 0);
+}
+
+template <class T, int C>
+inline ImageView<T, C>::operator cv::Mat() const {
+  assert(interleaved());
+  return cv::Mat(height_, width_, CV_MAKETYPE(cv::DataType<T>::depth, C),
+                 data_, row_stride_ * sizeof(T));
+}
+
+#endif  // TAKRAM_HAS_OPENCV
+
+#pragma mark Attributes
+
+template <class T, int C>
+inline bool ImageView<T, C>::interleaved() const {
+  return pixel_stride_ == C && channel_stride_ == 1;
+}
+
+template <class T, int C>
+inline bool ImageView<T, C>::contiguous() const {
+  return interleaved() && row_stride_ == width_ * C;
+}
+
+#pragma mark Element access
+
+template <class T, int C>
+inline T * ImageView<T, C>::row(int y) {
+  assert(0 <= y && y < height_);
+  return data_ + y * row_stride_;
+}
+
+template <class T, int C>
+inline const T * ImageView<T, C>::row(int y) const {
+  assert(0 <= y && y < height_);
+  return data_ + y * row_stride_;
+}
+
+template <class T, int C>
+inline T& ImageView<T, C>::at(int x, int y, int channel) {
+  assert(0 <= x && x < width_);
+  assert(0 <= channel && channel < C);
+  return row(y)[x * pixel_stride_ + channel * channel_stride_];
+}
+
+template <class T, int C>
+inline const T& ImageView<T, C>::at(int x, int y, int channel) const {
+  assert(0 <= x && x < width_);
+  assert(0 <= channel && channel < C);
+  return row(y)[x * pixel_stride_ + channel * channel_stride_];
+}
+
+template <class T, int C>
+inline Color<typename ImageView<T, C>::Value, C> ImageView<T, C>::pixel(
+    int x, int y) const {
+  Color<Value, C> result;
+  for (int channel{}; channel < C; ++channel) {
+    result[channel] = at(x, y, channel);
+  }
+  return result;
+}
+
+template <class T, int C>
+inline void ImageView<T, C>::setPixel(int x, int y,
+                                      const Color<Value, C>& color) {
+  for (int channel{}; channel < C; ++channel) {
+    at(x, y, channel) = color[channel];
+  }
+}
+
+#pragma mark Views
+
+template <class T, int C>
+inline ImageView<T, C> ImageView<T, C>::region(int x, int y,
+                                               int width,
+                                               int height) const {
+  assert(0 <= x && 0 <= width && x + width <= width_);
+  assert(0 <= y && 0 <= height && y + height <= height_);
+  return ImageView(data_ + y * row_stride_ + x * pixel_stride_,
+                   width, height,
+                   row_stride_, pixel_stride_, channel_stride_);
+}
+
+template <class T, int C>
+inline ImageView<T, 1> ImageView<T, C>::channel(int channel) const {
+  assert(0 <= channel && channel < C);
+  return ImageView<T, 1>(data_ + channel * channel_stride_,
+                         width_, height_,
+                         row_stride_, pixel_stride_, channel_stride_);
+}
+
+#pragma mark Operations
+
+template <class T, int C>
+inline void ImageView<T, C>::fill(const Color<Value, C>& color) {
+  for (int y{}; y < height_; ++y) {
+    for (int x{}; x < width_; ++x) {
+      setPixel(x, y, color);
+    }
+  }
+}
+
+template <class T, int C>
+inline void ImageView<T, C>::copy(const ImageView<const Value, C>& other) {
+  assert(width_ == other.width_ && height_ == other.height_);
+  if (interleaved() && other.interleaved()) {
+    for (int y{}; y < height_; ++y) {
+      std::memcpy(row(y), other.row(y), sizeof(T) * width_ * C);
+    }
+  } else if (pixel_stride_ == 1 && other.pixel_stride_ == 1) {
+    for (int channel{}; channel < C; ++channel) {
+      for (int y{}; y < height_; ++y) {
+        std::memcpy(&at(0, y, channel), &other.at(0, y, channel),
+                    sizeof(T) * width_);
+      }
+    }
+  } else {
+    for (int y{}; y < height_; ++y) {
+      for (int x{}; x < width_; ++x) {
+        for (int channel{}; channel < C; ++channel) {
+          at(x, y, channel) = other.at(x, y, channel);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::ImageView;
+using graphics::ImageView3;
+using graphics::ImageView4;
+using graphics::ImageView3u;
+using graphics::ImageView3s;
+using graphics::ImageView3i;
+using graphics::ImageView3h;
+using graphics::ImageView3f;
+using graphics::ImageView3d;
+using graphics::ImageView4u;
+using graphics::ImageView4s;
+using graphics::ImageView4i;
+using graphics::ImageView4h;
+using graphics::ImageView4f;
+using graphics::ImageView4d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_IMAGE_VIEW_H_
@@ -0,0 +1,908 @@
+//
+//  takram/graphics/intersector2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_INTERSECTOR2_H_
+#define TAKRAM_GRAPHICS_INTERSECTOR2_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/monotone_segments.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment.h"
+#include "takram/math/promotion.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+// Declared only, because Shape2 relies on Boolean2, which relies on this class
+template <class T, int D>
+class Shape;
+
+template <class T, int D>
+class Intersector;
+
+template <class T>
+using Intersector2 = Intersector<T, 2>;
+
+// Finds the intersections between segments of any command type by Bezier
+// clipping: each curve is repeatedly clipped to the parameter range where its
+// convex hull lies within the fat line of the other, and split in half when
+// clipping stops making progress. Conics are clipped in homogeneous form, so
+// that parameters map linearly throughout. Intersections are refined by
+// Newton's method on the original segments.
+//
+// Paths and shapes are first decomposed into monotone pieces, and every piece
+// is only paired up with the pieces whose bounds overlap its own, found
+// through the bounding volume hierarchy of MonotoneSegments2, so that the cost
+// of a pass grows with the number of nearby pieces instead of all pairs. The
+// tolerance is relative to the magnitude of the coordinates unless given.
+
+template <class T>
+class Intersector<T, 2> final {
+ public:
+  using Type = T;
+  static constexpr const int dimensions = 2;
+
+  // Indices are those of segments in the order of segments() of the paths
+  // or shapes, and parameters are on those segments.
+  struct Intersection {
+    Vec2<math::Promote<T>> point;
+    std::size_t index1;
+    math::Promote<T> t1;
+    std::size_t index2;
+    math::Promote<T> t2;
+  };
+
+ public:
+  Intersector() : tolerance_() {}
+  explicit Intersector(math::Promote<T> tolerance) : tolerance_(tolerance) {}
+
+  // Copy semantics
+  Intersector(const Intersector&) = default;
+  Intersector& operator=(const Intersector&) = default;
+
+  // Properties
+  math::Promote<T> tolerance() const { return tolerance_; }
+  void set_tolerance(math::Promote<T> value) { tolerance_ = value; }
+
+  // Intersection
+  std::vector<Intersection> intersect(const Segment2<T>& a,
+                                      const Segment2<T>& b) const;
+  std::vector<Intersection> intersect(const Path2<T>& path) const;
+  std::vector<Intersection> intersect(const Path2<T>& a,
+                                      const Path2<T>& b) const;
+  std::vector<Intersection> intersect(const Shape<T, 2>& shape) const;
+  std::vector<Intersection> intersect(const Shape<T, 2>& a,
+                                      const Shape<T, 2>& b) const;
+
+ private:
+  using Real = math::Promote<T>;
+  using Piece = typename MonotoneSegments2<T>::Piece;
+
+  // Homogeneous control points of a segment, whose subdivision keeps the
+  // parameters of conics linear
+  struct Curve {
+    explicit Curve(const Segment2<T>& segment);
+    Curve subcurve(Real t1, Real t2) const;
+    void split(Real t, Curve *first, Curve *second) const;
+    Vec2<Real> point(int index) const;
+    Rect2<Real> bounds() const;
+    int degree;
+    Real x[4];
+    Real y[4];
+    Real w[4];
+  };
+
+  struct Pair {
+    const Segment2<T> *a;
+    const Segment2<T> *b;
+    Real range_a[2];
+    Real range_b[2];
+    Curve curve_a;
+    Curve curve_b;
+    Real tolerance;
+    std::size_t budget;
+    std::vector<std::pair<Real, Real>> *params;
+  };
+
+  // Narrow phase
+  void intersect(const Segment2<T>& a, Real a1, Real a2,
+                 const Segment2<T>& b, Real b1, Real b2,
+                 Real tolerance,
+                 std::vector<std::pair<Real, Real>> *params) const;
+  static void intersectLines(const Segment2<T>& a, Real a1, Real a2,
+                             const Segment2<T>& b, Real b1, Real b2,
+                             Real tolerance,
+                             std::vector<std::pair<Real, Real>> *params);
+  static bool overlap(const Segment2<T>& a, Real a1, Real a2,
+                      const Segment2<T>& b, Real b1, Real b2,
+                      Real tolerance,
+                      std::vector<std::pair<Real, Real>> *params);
+  static bool project(const Segment2<T>& segment, Real t1, Real t2,
+                      const Vec2<Real>& point,
+                      Real tolerance,
+                      Real *t);
+  static void clip(Pair *pair, Real a1, Real a2, Real b1, Real b2,
+                   unsigned int depth);
+  static bool clip(const Curve& curve,
+                   const Curve& other,
+                   Real tolerance,
+                   Real *t1,
+                   Real *t2);
+  static bool range(const Real *values, int degree, Real *t1, Real *t2);
+  static bool aligned(const Curve& a, const Curve& b, Real tolerance);
+  static void refine(const Segment2<T>& a, Real a1, Real a2,
+                     const Segment2<T>& b, Real b1, Real b2,
+                     Real *ta, Real *tb);
+  static void add(const Pair& pair, Real ta, Real tb);
+
+  // Broad phase
+  template <class Geometry>
+  void intersect(const Geometry& a,
+                 const Geometry& b,
+                 bool self,
+                 std::vector<Intersection> *intersections) const;
+  Real tolerance(const Rect2<Real>& bounds) const;
+  static std::vector<bool> successors(const MonotoneSegments2<T>& segments);
+
+ private:
+  Real tolerance_;
+};
+
+using Intersector2i = Intersector2<int>;
+using Intersector2f = Intersector2<float>;
+using Intersector2d = Intersector2<double>;
+
+#pragma mark -
+
+template <class T>
+inline std::vector<typename Intersector<T, 2>::Intersection>
+    Intersector<T, 2>::intersect(const Segment2<T>& a,
+                                 const Segment2<T>& b) const {
+  auto bounds = a.bounds();
+  bounds.include(b.bounds());
+  std::vector<std::pair<Real, Real>> params;
+  intersect(a, 0, 1, b, 0, 1, tolerance(bounds), &params);
+  std::vector<Intersection> result;
+  for (const auto& param : params) {
+    result.push_back({a.evaluateAt(param.first), 0, param.first,
+                      0, param.second});
+  }
+  return result;
+}
+
+template <class T>
+inline std::vector<typename Intersector<T, 2>::Intersection>
+    Intersector<T, 2>::intersect(const Path2<T>& path) const {
+  std::vector<Intersection> result;
+  intersect(path, path, true, &result);
+  return result;
+}
+
+template <class T>
+inline std::vector<typename Intersector<T, 2>::Intersection>
+    Intersector<T, 2>::intersect(const Path2<T>& a,
+                                 const Path2<T>& b) const {
+  std::vector<Intersection> result;
+  intersect(a, b, false, &result);
+  return result;
+}
+
+template <class T>
+inline std::vector<typename Intersector<T, 2>::Intersection>
+    Intersector<T, 2>::intersect(const Shape<T, 2>& shape) const {
+  std::vector<Intersection> result;
+  intersect(shape, shape, true, &result);
+  return result;
+}
+
+template <class T>
+inline std::vector<typename Intersector<T, 2>::Intersection>
+    Intersector<T, 2>::intersect(const Shape<T, 2>& a,
+                                 const Shape<T, 2>& b) const {
+  std::vector<Intersection> result;
+  intersect(a, b, false, &result);
+  return result;
+}
+
+#pragma mark Broad phase
+
+template <class T>
+template <class Geometry>
+inline void Intersector<T, 2>::intersect(
+    const Geometry& geometry_a,
+    const Geometry& geometry_b,
+    bool self,
+    std::vector<Intersection> *intersections) const {
+  assert(intersections);
+  const auto range_a = geometry_a.segments();
+  const auto range_b = geometry_b.segments();
+  const std::vector<Segment2<T>> sources_a(std::begin(range_a),
+                                           std::end(range_a));
+  const std::vector<Segment2<T>> sources_b(std::begin(range_b),
+                                           std::end(range_b));
+  const MonotoneSegments2<T> a(range_a);
+  const MonotoneSegments2<T> b(self ? MonotoneSegments2<T>() :
+                                      MonotoneSegments2<T>(range_b));
+  if (a.empty() || (!self && b.empty())) {
+    return;
+  }
+  auto bounds = a.bounds();
+  if (!self) {
+    bounds.include(b.bounds());
+  }
+  const auto tolerance = this->tolerance(bounds);
+
+  // A crossing at the joint of two pieces belongs to the piece that begins
+  // there, so that it is reported once.
+  const auto successors_a = successors(a);
+  const auto successors_b = self ? successors_a : successors(b);
+  const auto owns = [&](const Piece& piece, bool successor,
+                        const Vec2<Real>& point) {
+    const auto& end = piece.segment.point();
+    return !successor || std::abs(point.x - end.x) > 2 * tolerance ||
+                         std::abs(point.y - end.y) > 2 * tolerance;
+  };
+
+  // Look up the pieces that overlap every piece of the first operand within
+  // the tolerance, which are only those after it when intersecting itself.
+  const auto& other = self ? a : b;
+  std::vector<std::pair<Real, Real>> params;
+  for (std::size_t i{}; i < a.size(); ++i) {
+    const auto& first = a[i];
+    const Rect2<Real> bounds(
+        Vec2<Real>(first.bounds.minX() - tolerance,
+                   first.bounds.minY() - tolerance),
+        Vec2<Real>(first.bounds.maxX() + tolerance,
+                   first.bounds.maxY() + tolerance));
+    other.overlapping(bounds, [&](std::size_t j) {
+      if (self && j <= i) {
+        return;
+      }
+      const auto& second = other[j];
+
+      // Intersect the original segments within the ranges of the pieces,
+      // because the parameters of pieces of conics are not linear in them.
+      const auto& source_a = sources_a[first.index];
+      const auto& source_b = (self ? sources_a : sources_b)[second.index];
+      params.clear();
+      intersect(source_a, first.begin, first.end,
+                source_b, second.begin, second.end,
+                tolerance, &params);
+      for (const auto& param : params) {
+        const auto point = source_a.evaluateAt(param.first);
+        if (!owns(first, successors_a[i], point) ||
+            !owns(second, successors_b[j], point)) {
+          continue;
+        }
+        intersections->push_back({
+          point,
+          first.index, param.first,
+          second.index, param.second
+        });
+      }
+    });
+  }
+}
+
+template <class T>
+inline typename Intersector<T, 2>::Real Intersector<T, 2>::tolerance(
+    const Rect2<Real>& bounds) const {
+  if (tolerance_ > 0) {
+    return tolerance_;
+  }
+  const auto scale = std::max({
+    std::abs(bounds.minX()), std::abs(bounds.maxX()),
+    std::abs(bounds.minY()), std::abs(bounds.maxY()),
+    static_cast<Real>(1)
+  });
+  return scale / 16 * std::sqrt(std::numeric_limits<Real>::epsilon());
+}
+
+template <class T>
+inline std::vector<bool> Intersector<T, 2>::successors(
+    const MonotoneSegments2<T>& segments) {
+  // Whether each piece is followed by another one at its end point, either
+  // the next piece of the subpath or the first one when the subpath closes
+  std::vector<bool> result(segments.size());
+  std::size_t first{};
+  for (std::size_t i{}; i < segments.size(); ++i) {
+    const auto& piece = segments[i];
+    if (segments[first].subpath != piece.subpath) {
+      first = i;
+    }
+    const auto next = i + 1;
+    if (next < segments.size() &&
+        segments[next].subpath == piece.subpath &&
+        segments[next].segment.start() == piece.segment.point()) {
+      result[i] = true;
+    } else if (segments[first].segment.start() == piece.segment.point()) {
+      result[i] = true;
+    }
+  }
+  return result;
+}
+
+#pragma mark Narrow phase
+
+template <class T>
+inline void Intersector<T, 2>::intersect(
+    const Segment2<T>& a, Real a1, Real a2,
+    const Segment2<T>& b, Real b1, Real b2,
+    Real tolerance,
+    std::vector<std::pair<Real, Real>> *params) const {
+  assert(params);
+  if (a.type() == CommandType::LINE && b.type() == CommandType::LINE) {
+    intersectLines(a, a1, a2, b, b1, b2, tolerance, params);
+    return;
+  }
+  if (overlap(a, a1, a2, b, b1, b2, tolerance, params)) {
+    return;
+  }
+  Pair pair{&a, &b, {a1, a2}, {b1, b2}, Curve(a), Curve(b),
+            tolerance, 4096, params};
+  clip(&pair, a1, a2, b1, b2, 0);
+}
+
+template <class T>
+inline void Intersector<T, 2>::intersectLines(
+    const Segment2<T>& a, Real a1, Real a2,
+    const Segment2<T>& b, Real b1, Real b2,
+    Real tolerance,
+    std::vector<std::pair<Real, Real>> *params) {
+  assert(params);
+  const auto p = a.evaluateAt(a1);
+  const auto q = b.evaluateAt(b1);
+  const auto r = a.evaluateAt(a2) - p;
+  const auto s = b.evaluateAt(b2) - q;
+  const auto qp = q - p;
+  const auto rr = r.x * r.x + r.y * r.y;
+  const auto ss = s.x * s.x + s.y * s.y;
+  if (!rr || !ss) {
+    return;
+  }
+  const auto map = [&](Real t, Real u) {
+    params->emplace_back(a1 + (a2 - a1) * t, b1 + (b2 - b1) * u);
+  };
+  const auto denominator = r.cross(s);
+  const auto epsilon = std::numeric_limits<Real>::epsilon() * 16;
+  if (denominator * denominator <= epsilon * epsilon * rr * ss) {
+    // Collinear lines intersect at the ends of their overlap
+    const auto distance = qp.cross(r);
+    if (distance * distance > tolerance * tolerance * rr) {
+      return;
+    }
+    for (int i{}; i < 2; ++i) {
+      const auto e = (i ? q + s : q) - p;
+      const auto t = (e.x * r.x + e.y * r.y) / rr;
+      if (0 <= t && t <= 1) {
+        map(t, i);
+      }
+      const auto f = (i ? p + r : p) - q;
+      const auto u = (f.x * s.x + f.y * s.y) / ss;
+      if (0 < u && u < 1) {
+        map(i, u);
+      }
+    }
+    return;
+  }
+  const auto t = qp.cross(s) / denominator;
+  const auto u = qp.cross(r) / denominator;
+  const auto slack_t = tolerance / std::sqrt(rr);
+  const auto slack_u = tolerance / std::sqrt(ss);
+  if (t < -slack_t || t > 1 + slack_t || u < -slack_u || u > 1 + slack_u) {
+    return;
+  }
+  map(std::min<Real>(std::max<Real>(t, 0), 1),
+      std::min<Real>(std::max<Real>(u, 0), 1));
+}
+
+template <class T>
+inline bool Intersector<T, 2>::overlap(
+    const Segment2<T>& a, Real a1, Real a2,
+    const Segment2<T>& b, Real b1, Real b2,
+    Real tolerance,
+    std::vector<std::pair<Real, Real>> *params) {
+  assert(params);
+  // Curves that overlap cross everywhere along the overlap, which clipping
+  // cannot narrow down. It is reported by its ends instead, which are the end
+  // points of either curve that lie on the other, provided that the curves
+  // also meet in between every two of them. Those end points are exact
+  // crossings either way, into which clipping merges the ones it approaches.
+  std::pair<Real, Real> ends[4];
+  std::size_t count{};
+  const auto add = [&](Real ta, Real tb) {
+    const auto point = a.evaluateAt(ta);
+    for (std::size_t i{}; i < count; ++i) {
+      const auto other = a.evaluateAt(ends[i].first);
+      if (std::abs(point.x - other.x) <= 2 * tolerance &&
+          std::abs(point.y - other.y) <= 2 * tolerance) {
+        return;
+      }
+    }
+    ends[count++] = std::make_pair(ta, tb);
+  };
+  Real t{};
+  for (const auto ta : {a1, a2}) {
+    if (project(b, b1, b2, a.evaluateAt(ta), tolerance, &t)) {
+      add(ta, t);
+    }
+  }
+  for (const auto tb : {b1, b2}) {
+    if (project(a, a1, a2, b.evaluateAt(tb), tolerance, &t)) {
+      add(t, tb);
+    }
+  }
+  std::sort(ends, ends + count);
+  params->insert(std::end(*params), ends, ends + count);
+  if (count < 2) {
+    return false;
+  }
+  for (std::size_t i{1}; i < count; ++i) {
+    const auto t1 = ends[i - 1].first;
+    const auto t2 = ends[i].first;
+    for (const auto ta : {(2 * t1 + t2) / 3, (t1 + 2 * t2) / 3}) {
+      if (!project(b, b1, b2, a.evaluateAt(ta), tolerance, &t)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <class T>
+inline bool Intersector<T, 2>::project(const Segment2<T>& segment,
+                                       Real t1, Real t2,
+                                       const Vec2<Real>& point,
+                                       Real tolerance,
+                                       Real *t) {
+  assert(t);
+  // The nearest of the ends of the range and the parameters at which the
+  // segment reaches either coordinate of the point
+  Real candidates[8]{t1, t2};
+  unsigned int count{2};
+  count += segment.solveX(point.x, candidates + count);
+  count += segment.solveY(point.y, candidates + count);
+  auto nearest = std::numeric_limits<Real>::max();
+  for (unsigned int i{}; i < count; ++i) {
+    const auto candidate = candidates[i];
+    if (candidate < t1 || candidate > t2) {
+      continue;
+    }
+    const auto offset = segment.evaluateAt(candidate) - point;
+    const auto distance = std::max(std::abs(offset.x), std::abs(offset.y));
+    if (distance < nearest) {
+      nearest = distance;
+      *t = candidate;
+    }
+  }
+  return nearest <= tolerance;
+}
+
+template <class T>
+inline void Intersector<T, 2>::clip(Pair *pair,
+                                    Real a1, Real a2,
+                                    Real b1, Real b2,
+                                    unsigned int depth) {
+  assert(pair);
+  static const unsigned int max_depth = 48;
+  static const std::size_t max_params = 16;
+  const auto tolerance = pair->tolerance;
+  // Every iteration either shrinks one of the ranges by a fifth or splits,
+  // and the budget bounds the work on overlapping curves which do neither.
+  // Those cross everywhere along the overlap, of which only a few points are
+  // reported.
+  for (; pair->budget && pair->params->size() < max_params; --pair->budget) {
+    const auto curve_a = pair->curve_a.subcurve(a1, a2);
+    const auto curve_b = pair->curve_b.subcurve(b1, b2);
+    const auto ra = curve_a.bounds();
+    const auto rb = curve_b.bounds();
+    if (ra.maxX() + tolerance < rb.minX() ||
+        ra.minX() - tolerance > rb.maxX() ||
+        ra.maxY() + tolerance < rb.minY() ||
+        ra.minY() - tolerance > rb.maxY()) {
+      return;
+    }
+    const auto size_a = std::max(ra.maxX() - ra.minX(),
+                                 ra.maxY() - ra.minY());
+    const auto size_b = std::max(rb.maxX() - rb.minX(),
+                                 rb.maxY() - rb.minY());
+    const bool small_a = size_a <= tolerance;
+    const bool small_b = size_b <= tolerance;
+    if ((small_a && small_b) || depth >= max_depth) {
+      add(*pair, (a1 + a2) / 2, (b1 + b2) / 2);
+      return;
+    }
+
+    // Clip each curve against the fat line of the other in turn
+    Real shrink_a = 1;
+    Real shrink_b = 1;
+    Real t1;
+    Real t2;
+    if (!small_a) {
+      if (!clip(curve_a, curve_b, tolerance, &t1, &t2)) {
+        return;
+      }
+      shrink_a = t2 - t1;
+      const auto length = a2 - a1;
+      a2 = a1 + length * t2;
+      a1 = a1 + length * t1;
+    }
+    if (!small_b) {
+      if (!clip(curve_b, pair->curve_a.subcurve(a1, a2), tolerance,
+                &t1, &t2)) {
+        return;
+      }
+      shrink_b = t2 - t1;
+      const auto length = b2 - b1;
+      b2 = b1 + length * t2;
+      b1 = b1 + length * t1;
+    }
+
+    // Multiple intersections keep the ranges from shrinking, which are then
+    // separated by splitting the larger curve. So do curves that touch
+    // tangentially, which are one intersection once both lie along the same
+    // line within the tolerance.
+    if (shrink_a > 0.8 && shrink_b > 0.8) {
+      if (aligned(pair->curve_a.subcurve(a1, a2),
+                  pair->curve_b.subcurve(b1, b2), tolerance)) {
+        // The middle of the smaller range is projected onto the other curve
+        auto ta = (a1 + a2) / 2;
+        auto tb = (b1 + b2) / 2;
+        if (size_a <= size_b) {
+          project(*pair->b, b1, b2, pair->a->evaluateAt(ta), tolerance, &tb);
+        } else {
+          project(*pair->a, a1, a2, pair->b->evaluateAt(tb), tolerance, &ta);
+        }
+        add(*pair, ta, tb);
+        return;
+      }
+      if (!small_a && (small_b || size_a >= size_b)) {
+        const auto middle = (a1 + a2) / 2;
+        clip(pair, a1, middle, b1, b2, depth + 1);
+        clip(pair, middle, a2, b1, b2, depth + 1);
+      } else {
+        const auto middle = (b1 + b2) / 2;
+        clip(pair, a1, a2, b1, middle, depth + 1);
+        clip(pair, a1, a2, middle, b2, depth + 1);
+      }
+      return;
+    }
+  }
+}
+
+template <class T>
+inline bool Intersector<T, 2>::clip(const Curve& curve,
+                                    const Curve& other,
+                                    Real tolerance,
+                                    Real *t1,
+                                    Real *t2) {
+  assert(t1);
+  assert(t2);
+  // The fat line of the other curve is bounded by the distances of its
+  // control points from its chord, or from the line toward its farthest
+  // control point when the chord is degenerate. It is widened by a fraction
+  // of the tolerance, so that rounding does not clip away an intersection
+  // that lies at the end of a range.
+  const auto origin = other.point(0);
+  auto direction = other.point(other.degree) - origin;
+  Real length = std::hypot(direction.x, direction.y);
+  for (int i{1}; !length && i < other.degree; ++i) {
+    direction = other.point(i) - origin;
+    length = std::hypot(direction.x, direction.y);
+  }
+  *t1 = 0;
+  *t2 = 1;
+  if (!length) {
+    return true;
+  }
+  const Vec2<Real> normal(-direction.y / length, direction.x / length);
+  const auto distance = [&](const Vec2<Real>& point) {
+    const auto offset = point - origin;
+    return normal.x * offset.x + normal.y * offset.y;
+  };
+  Real min{};
+  Real max{};
+  for (int i{1}; i <= other.degree; ++i) {
+    const auto d = distance(other.point(i));
+    min = std::min(min, d);
+    max = std::max(max, d);
+  }
+  min -= tolerance / 4;
+  max += tolerance / 4;
+
+  // The curve lies within the fat line where both of the weighted distances
+  // below are non-negative, which is bounded by their convex hulls.
+  Real above[4];
+  Real below[4];
+  for (int i{}; i <= curve.degree; ++i) {
+    const auto d = distance(curve.point(i));
+    above[i] = curve.w[i] * (d - min);
+    below[i] = curve.w[i] * (max - d);
+  }
+  Real lower;
+  Real upper;
+  if (!range(above, curve.degree, t1, t2) ||
+      !range(below, curve.degree, &lower, &upper)) {
+    return false;
+  }
+  *t1 = std::max(*t1, lower);
+  *t2 = std::min(*t2, upper);
+  return *t1 <= *t2;
+}
+
+template <class T>
+inline bool Intersector<T, 2>::range(const Real *values,
+                                     int degree,
+                                     Real *t1,
+                                     Real *t2) {
+  assert(values);
+  assert(t1);
+  assert(t2);
+  // The part of the convex hull of the points (i / degree, values[i]) that is
+  // non-negative spans from the least to the greatest of the non-negative
+  // points and the crossings of the lines between them with zero.
+  *t1 = 1;
+  *t2 = 0;
+  for (int i{}; i <= degree; ++i) {
+    const Real ti = static_cast<Real>(i) / degree;
+    if (values[i] >= 0) {
+      *t1 = std::min(*t1, ti);
+      *t2 = std::max(*t2, ti);
+    }
+    for (int j{i + 1}; j <= degree; ++j) {
+      if ((values[i] < 0) == (values[j] < 0)) {
+        continue;
+      }
+      const Real tj = static_cast<Real>(j) / degree;
+      const auto t = ti + (tj - ti) * values[i] / (values[i] - values[j]);
+      *t1 = std::min(*t1, t);
+      *t2 = std::max(*t2, t);
+    }
+  }
+  return *t1 <= *t2;
+}
+
+template <class T>
+inline bool Intersector<T, 2>::aligned(const Curve& a,
+                                       const Curve& b,
+                                       Real tolerance) {
+  // Whether the control points of both curves lie within half the tolerance
+  // of the chord of the second one, which bounds the curves by their hulls
+  const auto origin = b.point(0);
+  const auto direction = b.point(b.degree) - origin;
+  const auto length = std::hypot(direction.x, direction.y);
+  if (!length) {
+    return false;
+  }
+  for (const auto *curve : {&a, &b}) {
+    for (int i{}; i <= curve->degree; ++i) {
+      const auto offset = curve->point(i) - origin;
+      if (std::abs(direction.cross(offset)) > tolerance / 2 * length) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <class T>
+inline void Intersector<T, 2>::refine(const Segment2<T>& a, Real a1, Real a2,
+                                      const Segment2<T>& b, Real b1, Real b2,
+                                      Real *ta, Real *tb) {
+  assert(ta);
+  assert(tb);
+  // Newton's method on a(ta) - b(tb) = 0 within the ranges
+  auto f = a.evaluateAt(*ta) - b.evaluateAt(*tb);
+  auto residual = f.x * f.x + f.y * f.y;
+  for (int i{}; i < 4 && residual > 0; ++i) {
+    const auto da = a.derivativeAt(*ta);
+    const auto db = b.derivativeAt(*tb);
+    const auto determinant = db.cross(da);
+    if (!determinant) {
+      break;
+    }
+    const auto next_a = std::min(std::max(
+        *ta + f.cross(db) / determinant, a1), a2);
+    const auto next_b = std::min(std::max(
+        *tb + f.cross(da) / determinant, b1), b2);
+    const auto next = a.evaluateAt(next_a) - b.evaluateAt(next_b);
+    const auto next_residual = next.x * next.x + next.y * next.y;
+    if (next_residual >= residual) {
+      break;
+    }
+    *ta = next_a;
+    *tb = next_b;
+    f = next;
+    residual = next_residual;
+  }
+}
+
+template <class T>
+inline void Intersector<T, 2>::add(const Pair& pair, Real ta, Real tb) {
+  const auto& a = *pair.a;
+  const auto& b = *pair.b;
+  refine(a, pair.range_a[0], pair.range_a[1],
+         b, pair.range_b[0], pair.range_b[1], &ta, &tb);
+  const auto tolerance = pair.tolerance;
+  const auto distance = [&](Real ta, Real tb) {
+    const auto offset = a.evaluateAt(ta) - b.evaluateAt(tb);
+    return std::max(std::abs(offset.x), std::abs(offset.y));
+  };
+  // Curves that touch tangentially stay within the tolerance over a stretch,
+  // which clipping splits into many leaves. Those between which the first
+  // curve stays on the other are one intersection, the closest of which is
+  // kept unless an end point of either curve is, where they meet exactly.
+  const auto end = [&](const std::pair<Real, Real>& param) {
+    return param.first == pair.range_a[0] || param.first == pair.range_a[1] ||
+           param.second == pair.range_b[0] || param.second == pair.range_b[1];
+  };
+  const auto joined = [&](Real ta1, Real ta2) {
+    Real t;
+    return project(b, pair.range_b[0], pair.range_b[1],
+                   a.evaluateAt((2 * ta1 + ta2) / 3), tolerance, &t) &&
+           project(b, pair.range_b[0], pair.range_b[1],
+                   a.evaluateAt((ta1 + 2 * ta2) / 3), tolerance, &t);
+  };
+  const auto point = a.evaluateAt(ta);
+  for (auto& param : *pair.params) {
+    const auto other = a.evaluateAt(param.first);
+    if ((std::abs(point.x - other.x) <= 2 * tolerance &&
+         std::abs(point.y - other.y) <= 2 * tolerance) ||
+        joined(ta, param.first)) {
+      if (!end(param) &&
+          distance(ta, tb) < distance(param.first, param.second)) {
+        param = std::make_pair(ta, tb);
+      }
+      return;
+    }
+  }
+  pair.params->emplace_back(ta, tb);
+}
+
+#pragma mark Curve
+
+template <class T>
+inline Intersector<T, 2>::Curve::Curve(const Segment2<T>& segment) {
+  const auto set = [this](int index, const Vec2<T>& point, Real weight) {
+    x[index] = point.x * weight;
+    y[index] = point.y * weight;
+    w[index] = weight;
+  };
+  set(0, segment.start(), 1);
+  switch (segment.type()) {
+    case CommandType::LINE:
+      degree = 1;
+      break;
+    case CommandType::QUADRATIC:
+      degree = 2;
+      set(1, segment.control(), 1);
+      break;
+    case CommandType::CONIC:
+      degree = 2;
+      set(1, segment.control(), segment.weight());
+      break;
+    case CommandType::CUBIC:
+      degree = 3;
+      set(1, segment.control1(), 1);
+      set(2, segment.control2(), 1);
+      break;
+    default:
+      assert(false);
+      degree = 1;
+      break;
+  }
+  set(degree, segment.point(), 1);
+}
+
+template <class T>
+inline typename Intersector<T, 2>::Curve
+    Intersector<T, 2>::Curve::subcurve(Real t1, Real t2) const {
+  Curve first(*this);
+  Curve second(*this);
+  if (t1 > 0) {
+    split(t1, &first, &second);
+  }
+  if (t2 < 1) {
+    const auto t = t1 < 1 ? (t2 - t1) / (1 - t1) : 0;
+    Curve remainder(second);
+    remainder.split(t, &second, &first);
+  }
+  return second;
+}
+
+template <class T>
+inline void Intersector<T, 2>::Curve::split(Real t,
+                                            Curve *first,
+                                            Curve *second) const {
+  assert(first);
+  assert(second);
+  // De Casteljau's algorithm on the homogeneous control points
+  Real points[3][4][4];
+  for (int i{}; i <= degree; ++i) {
+    points[0][0][i] = x[i];
+    points[1][0][i] = y[i];
+    points[2][0][i] = w[i];
+  }
+  for (int k{}; k < 3; ++k) {
+    for (int level{1}; level <= degree; ++level) {
+      for (int i{}; i <= degree - level; ++i) {
+        points[k][level][i] = points[k][level - 1][i] * (1 - t) +
+                              points[k][level - 1][i + 1] * t;
+      }
+    }
+  }
+  first->degree = second->degree = degree;
+  Real *first_values[]{first->x, first->y, first->w};
+  Real *second_values[]{second->x, second->y, second->w};
+  for (int k{}; k < 3; ++k) {
+    for (int i{}; i <= degree; ++i) {
+      first_values[k][i] = points[k][i][0];
+      second_values[k][i] = points[k][degree - i][i];
+    }
+  }
+}
+
+template <class T>
+inline Vec2<typename Intersector<T, 2>::Real>
+    Intersector<T, 2>::Curve::point(int index) const {
+  return Vec2<Real>(x[index] / w[index], y[index] / w[index]);
+}
+
+template <class T>
+inline Rect2<typename Intersector<T, 2>::Real>
+    Intersector<T, 2>::Curve::bounds() const {
+  Rect2<Real> result(point(0));
+  for (int i{1}; i <= degree; ++i) {
+    result.include(point(i));
+  }
+  return result;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Intersector;
+using graphics::Intersector2;
+using graphics::Intersector2i;
+using graphics::Intersector2f;
+using graphics::Intersector2d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_INTERSECTOR2_H_
@@ -0,0 +1,571 @@
+//
+//  takram/graphics/monotone_segments2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_MONOTONE_SEGMENTS2_H_
+#define TAKRAM_GRAPHICS_MONOTONE_SEGMENTS2_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "takram/graphics/fill_rule.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment.h"
+#include "takram/math/promotion.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+// Shape2 includes Boolean2, which builds on this class
+template <class T, int D>
+class Shape;
+
+template <class T, int D>
+class MonotoneSegments;
+
+template <class T>
+using MonotoneSegments2 = MonotoneSegments<T, 2>;
+
+// Decomposition of segments into pieces that are monotone in both x and y,
+// cut at the extrema of each curve. Every piece keeps its bounds, the index
+// of the segment it was cut from, the subpath of that segment and its
+// parameter range on that segment, so that queries can reject pieces by their
+// bounds and solve each remaining one for a single root. The bounds are kept
+// in a hierarchy of boxes split at the median of the longer side, so that a
+// query visits the pieces near it in logarithmic time instead of all of them.
+// Decompose once and reuse it for as many queries as the segments stay
+// unchanged.
+
+template <class T>
+class MonotoneSegments<T, 2> final {
+ public:
+  using Type = T;
+  static constexpr const int dimensions = 2;
+
+  struct Piece {
+    Segment2<T> segment;
+    Rect2<math::Promote<T>> bounds;
+    std::size_t index;
+    std::size_t subpath;
+    math::Promote<T> begin;
+    math::Promote<T> end;
+  };
+
+  using Iterator = typename std::vector<Piece>::const_iterator;
+  using ConstIterator = Iterator;
+
+ public:
+  MonotoneSegments() = default;
+  explicit MonotoneSegments(const Path2<T>& path);
+  explicit MonotoneSegments(const Shape<T, 2>& shape);
+  template <class Range>
+  explicit MonotoneSegments(const Range& segments);
+
+  // Copy semantics
+  MonotoneSegments(const MonotoneSegments&) = default;
+  MonotoneSegments& operator=(const MonotoneSegments&) = default;
+
+  // Mutators
+  void set(const Path2<T>& path);
+  void set(const Shape<T, 2>& shape);
+  template <class Range>
+  void set(const Range& segments);
+  void reset();
+
+  // Attributes
+  bool empty() const { return pieces_.empty(); }
+  std::size_t size() const { return pieces_.size(); }
+  const Rect2<math::Promote<T>>& bounds() const { return bounds_; }
+
+  // Queries, which expect every subpath to be closed
+  int winding(const Vec2<math::Promote<T>>& point) const;
+  bool contains(const Vec2<math::Promote<T>>& point,
+                FillRule rule = FillRule::NON_ZERO) const;
+
+  // Calls the function with every piece that a ray from the point toward +x,
+  // or toward -x if reversed, crosses and the sign of the crossing, in no
+  // particular order. The signs sum up to the winding number of the point,
+  // negated for the reversed ray.
+  template <class Function>
+  void crossings(const Vec2<math::Promote<T>>& point,
+                 bool reversed,
+                 Function function) const;
+
+  // Calls the function with the index of every piece whose bounds overlap or
+  // touch the given bounds, in no particular order
+  template <class Function>
+  void overlapping(const Rect2<math::Promote<T>>& bounds,
+                   Function function) const;
+
+  // Calls the function with the index of every piece whose bounds are nearer
+  // to the point than the distance that the function last returned, visiting
+  // nearer nodes first. The distance must not increase between calls.
+  template <class Function>
+  void nearest(const Vec2<math::Promote<T>>& point, Function function) const;
+
+  // Element access
+  const Piece& operator[](std::size_t index) const { return pieces_[index]; }
+  const Piece& at(std::size_t index) const { return pieces_.at(index); }
+
+  // Iterator
+  ConstIterator begin() const { return std::begin(pieces_); }
+  ConstIterator end() const { return std::end(pieces_); }
+
+ private:
+  using Real = math::Promote<T>;
+
+  // The corners of a node are the extremes of those of its pieces, rather
+  // than a rectangle, which could round off their maxima. Leaves are the
+  // nodes without children, whose first child is the root.
+  struct Node {
+    Vec2<Real> min;
+    Vec2<Real> max;
+    std::size_t first;
+    std::size_t last;
+    std::size_t child;
+  };
+
+  // Entries hold the corners of the pieces in the order of the leaves, so
+  // that visiting a leaf reads them contiguously and touches a piece only
+  // when its corners overlap.
+  struct Entry {
+    Vec2<Real> min;
+    Vec2<Real> max;
+    std::size_t index;
+  };
+
+  static constexpr const std::size_t leaf_size = 4;
+
+  void add(const Segment2<T>& segment,
+           std::size_t index,
+           std::size_t subpath);
+  void build(std::size_t node);
+  template <class Function>
+  void overlapping(const Vec2<Real>& min,
+                   const Vec2<Real>& max,
+                   Function function) const;
+  static bool overlaps(const Vec2<Real>& a1,
+                       const Vec2<Real>& a2,
+                       const Vec2<Real>& b1,
+                       const Vec2<Real>& b2);
+  static Real distance(const Vec2<Real>& min,
+                       const Vec2<Real>& max,
+                       const Vec2<Real>& point);
+  static int cross(const Segment2<T>& segment,
+                   const Vec2<Real>& point,
+                   bool reversed);
+
+ private:
+  std::vector<Piece> pieces_;
+  Rect2<Real> bounds_;
+  std::vector<Node> nodes_;
+  std::vector<Entry> entries_;
+};
+
+using MonotoneSegments2i = MonotoneSegments2<int>;
+using MonotoneSegments2f = MonotoneSegments2<float>;
+using MonotoneSegments2d = MonotoneSegments2<double>;
+
+#pragma mark -
+
+template <class T>
+inline MonotoneSegments<T, 2>::MonotoneSegments(const Path2<T>& path) {
+  set(path);
+}
+
+template <class T>
+inline MonotoneSegments<T, 2>::MonotoneSegments(const Shape<T, 2>& shape) {
+  set(shape);
+}
+
+template <class T>
+template <class Range>
+inline MonotoneSegments<T, 2>::MonotoneSegments(const Range& segments) {
+  set(segments);
+}
+
+#pragma mark Mutators
+
+template <class T>
+inline void MonotoneSegments<T, 2>::set(const Path2<T>& path) {
+  set(path.segments());
+}
+
+template <class T>
+inline void MonotoneSegments<T, 2>::set(const Shape<T, 2>& shape) {
+  set(shape.segments());
+}
+
+template <class T>
+template <class Range>
+inline void MonotoneSegments<T, 2>::set(const Range& segments) {
+  reset();
+  std::size_t index{};
+  for (auto itr = std::begin(segments); itr != std::end(segments); ++itr) {
+    add(*itr, index++, itr.subpath());
+  }
+  if (!pieces_.empty()) {
+    bounds_ = pieces_.front().bounds;
+    for (const auto& piece : pieces_) {
+      bounds_.include(piece.bounds);
+    }
+    entries_.reserve(pieces_.size());
+    for (std::size_t i{}; i < pieces_.size(); ++i) {
+      const auto& bounds = pieces_[i].bounds;
+      entries_.push_back({Vec2<Real>(bounds.minX(), bounds.minY()),
+                          Vec2<Real>(bounds.maxX(), bounds.maxY()), i});
+    }
+    nodes_.reserve(pieces_.size() / 2 + 1);
+    nodes_.push_back({Vec2<Real>(), Vec2<Real>(), 0, pieces_.size(), 0});
+    build(0);
+  }
+}
+
+template <class T>
+inline void MonotoneSegments<T, 2>::reset() {
+  pieces_.clear();
+  bounds_ = Rect2<Real>();
+  nodes_.clear();
+  entries_.clear();
+}
+
+template <class T>
+inline void MonotoneSegments<T, 2>::add(const Segment2<T>& segment,
+                                        std::size_t index,
+                                        std::size_t subpath) {
+  Real parameters[5];
+  unsigned int count{};
+  if (segment.type() != CommandType::LINE) {
+    count += segment.findExtremaX(parameters);
+    count += segment.findExtremaY(parameters + count);
+    std::sort(parameters, parameters + count);
+  }
+  parameters[count++] = 1;
+
+  // Pieces share their end points exactly, so that a query never finds a gap
+  // between them.
+  auto start = segment.start();
+  Real begin{};
+  for (unsigned int i{}; i < count; ++i) {
+    const auto end = parameters[i];
+    if (end <= begin) {
+      continue;
+    }
+    Piece piece;
+    if (begin == 0 && end == 1) {
+      piece.segment = segment;
+    } else {
+      piece.segment = segment.subsegment(begin, end);
+      piece.segment.start() = start;
+      if (end == 1) {
+        piece.segment.point() = segment.point();
+      }
+    }
+    piece.bounds = piece.segment.bounds();
+    piece.index = index;
+    piece.subpath = subpath;
+    piece.begin = begin;
+    piece.end = end;
+    start = piece.segment.point();
+    begin = end;
+    pieces_.emplace_back(piece);
+  }
+}
+
+template <class T>
+inline void MonotoneSegments<T, 2>::build(std::size_t node) {
+  const auto first = nodes_[node].first;
+  const auto last = nodes_[node].last;
+  auto min = entries_[first].min;
+  auto max = entries_[first].max;
+  for (auto i = first + 1; i < last; ++i) {
+    const auto& other = entries_[i];
+    min.x = std::min(min.x, other.min.x);
+    min.y = std::min(min.y, other.min.y);
+    max.x = std::max(max.x, other.max.x);
+    max.y = std::max(max.y, other.max.y);
+  }
+  nodes_[node].min = min;
+  nodes_[node].max = max;
+  if (last - first <= leaf_size) {
+    return;
+  }
+  // Split at the median of the centers along the longer side, which bounds
+  // the depth by the logarithm of the number of pieces
+  const auto middle = first + (last - first) / 2;
+  const bool horizontal = max.x - min.x >= max.y - min.y;
+  std::nth_element(std::begin(entries_) + first,
+                   std::begin(entries_) + middle,
+                   std::begin(entries_) + last,
+                   [horizontal](const Entry& a, const Entry& b) {
+    return horizontal ? a.min.x + a.max.x < b.min.x + b.max.x
+                      : a.min.y + a.max.y < b.min.y + b.max.y;
+  });
+  const auto child = nodes_.size();
+  nodes_[node].child = child;
+  nodes_.push_back({Vec2<Real>(), Vec2<Real>(), first, middle, 0});
+  nodes_.push_back({Vec2<Real>(), Vec2<Real>(), middle, last, 0});
+  build(child);
+  build(child + 1);
+}
+
+#pragma mark Queries
+
+template <class T>
+inline int MonotoneSegments<T, 2>::winding(const Vec2<Real>& point) const {
+  // Sum of the signed crossings of a ray from the point toward the nearer
+  // side of the bounds, which visits fewer pieces
+  if (empty()) {
+    return 0;
+  }
+  const auto& root = nodes_.front();
+  const bool reversed = point.x - root.min.x < root.max.x - point.x;
+  int result{};
+  crossings(point, reversed, [&result](const Piece&, int direction) {
+    result += direction;
+  });
+  return reversed ? -result : result;
+}
+
+template <class T>
+inline bool MonotoneSegments<T, 2>::contains(const Vec2<Real>& point,
+                                             FillRule rule) const {
+  const auto winding = this->winding(point);
+  switch (rule) {
+    case FillRule::NON_ZERO:
+      return winding != 0;
+    case FillRule::EVEN_ODD:
+      return winding % 2 != 0;
+    case FillRule::POSITIVE:
+      return winding > 0;
+    default:
+      assert(false);
+      break;
+  }
+  return false;
+}
+
+template <class T>
+template <class Function>
+inline void MonotoneSegments<T, 2>::crossings(const Vec2<Real>& point,
+                                              bool reversed,
+                                              Function function) const {
+  if (empty()) {
+    return;
+  }
+  // The ray ends at the extremes of the root, which are exact unlike those of
+  // a rectangle, so that it never falls short of the pieces at the edge.
+  const auto& root = nodes_.front();
+  const Vec2<Real> min(reversed ? root.min.x : point.x, point.y);
+  const Vec2<Real> max(reversed ? point.x : root.max.x, point.y);
+  overlapping(min, max, [&](std::size_t index) {
+    const auto& piece = pieces_[index];
+    const auto direction = cross(piece.segment, point, reversed);
+    if (direction) {
+      function(piece, direction);
+    }
+  });
+}
+
+template <class T>
+template <class Function>
+inline void MonotoneSegments<T, 2>::overlapping(const Rect2<Real>& bounds,
+                                                Function function) const {
+  overlapping(Vec2<Real>(bounds.minX(), bounds.minY()),
+              Vec2<Real>(bounds.maxX(), bounds.maxY()), function);
+}
+
+template <class T>
+template <class Function>
+inline void MonotoneSegments<T, 2>::overlapping(const Vec2<Real>& min,
+                                                const Vec2<Real>& max,
+                                                Function function) const {
+  if (nodes_.empty()) {
+    return;
+  }
+  // Children are pushed in pairs below their parent, so that the stack never
+  // holds more than one node per level besides the one being visited
+  std::size_t stack[2 * sizeof(std::size_t) * 8];
+  std::size_t size{};
+  stack[size++] = 0;
+  while (size) {
+    const auto& node = nodes_[stack[--size]];
+    if (!overlaps(node.min, node.max, min, max)) {
+      continue;
+    }
+    if (node.child) {
+      assert(size + 2 <= sizeof(stack) / sizeof(*stack));
+      stack[size++] = node.child + 1;
+      stack[size++] = node.child;
+      continue;
+    }
+    for (auto i = node.first; i < node.last; ++i) {
+      const auto& entry = entries_[i];
+      if (overlaps(entry.min, entry.max, min, max)) {
+        function(entry.index);
+      }
+    }
+  }
+}
+
+template <class T>
+template <class Function>
+inline void MonotoneSegments<T, 2>::nearest(const Vec2<Real>& point,
+                                            Function function) const {
+  if (nodes_.empty()) {
+    return;
+  }
+  // Children are pushed with their distances, the nearer one last, so that
+  // the nearest pieces are likely visited first and give a tight distance to
+  // prune the rest with. The distances are tested again when popped, since
+  // the limit may have shrunk in the meantime.
+  std::size_t stack[2 * sizeof(std::size_t) * 8];
+  Real distances[2 * sizeof(std::size_t) * 8];
+  std::size_t size{};
+  auto limit = std::numeric_limits<Real>::infinity();
+  stack[size] = 0;
+  distances[size++] = distance(nodes_.front().min, nodes_.front().max, point);
+  while (size) {
+    --size;
+    if (distances[size] >= limit) {
+      continue;
+    }
+    const auto& node = nodes_[stack[size]];
+    if (node.child) {
+      assert(size + 2 <= sizeof(stack) / sizeof(*stack));
+      const auto& first = nodes_[node.child];
+      const auto& second = nodes_[node.child + 1];
+      const auto d1 = distance(first.min, first.max, point);
+      const auto d2 = distance(second.min, second.max, point);
+      const bool swapped = d2 < d1;
+      stack[size] = node.child + !swapped;
+      distances[size++] = swapped ? d1 : d2;
+      stack[size] = node.child + swapped;
+      distances[size++] = swapped ? d2 : d1;
+      continue;
+    }
+    // Entries of a leaf are few, and sorted by their distances as well
+    assert(node.last - node.first <= leaf_size);
+    std::size_t indices[leaf_size];
+    Real nearest[leaf_size];
+    std::size_t count{};
+    for (auto i = node.first; i < node.last; ++i) {
+      const auto& entry = entries_[i];
+      const auto value = distance(entry.min, entry.max, point);
+      auto j = count++;
+      for (; j && nearest[j - 1] > value; --j) {
+        indices[j] = indices[j - 1];
+        nearest[j] = nearest[j - 1];
+      }
+      indices[j] = entry.index;
+      nearest[j] = value;
+    }
+    for (std::size_t i{}; i < count && nearest[i] < limit; ++i) {
+      limit = function(indices[i]);
+    }
+  }
+}
+
+template <class T>
+inline bool MonotoneSegments<T, 2>::overlaps(const Vec2<Real>& a1,
+                                             const Vec2<Real>& a2,
+                                             const Vec2<Real>& b1,
+                                             const Vec2<Real>& b2) {
+  return a1.x <= b2.x && b1.x <= a2.x && a1.y <= b2.y && b1.y <= a2.y;
+}
+
+template <class T>
+inline typename MonotoneSegments<T, 2>::Real MonotoneSegments<T, 2>::distance(
+    const Vec2<Real>& min,
+    const Vec2<Real>& max,
+    const Vec2<Real>& point) {
+  const auto dx = std::max<Real>({min.x - point.x, 0, point.x - max.x});
+  const auto dy = std::max<Real>({min.y - point.y, 0, point.y - max.y});
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+template <class T>
+inline int MonotoneSegments<T, 2>::cross(const Segment2<T>& segment,
+                                         const Vec2<Real>& point,
+                                         bool reversed) {
+  // The piece is monotone, so that it crosses the ray at most once. The
+  // control points of a cubic may overshoot its end points, which bound its
+  // ranges instead. The y-range is half-open, so that a ray passing through
+  // a vertex is counted once.
+  const Real y0 = segment.start().y;
+  const Real y1 = segment.point().y;
+  if (point.y < std::min(y0, y1) || point.y >= std::max(y0, y1)) {
+    return 0;
+  }
+  const int direction = y1 > y0 ? 1 : -1;
+  const Real x0 = segment.start().x;
+  const Real x1 = segment.point().x;
+  const auto near = reversed ? std::max(x0, x1) : std::min(x0, x1);
+  const auto far = reversed ? std::min(x0, x1) : std::max(x0, x1);
+  if (reversed ? point.x <= far : point.x >= far) {
+    return 0;
+  } else if (reversed ? point.x > near : point.x < near) {
+    return direction;
+  }
+  Real t;
+  Real roots[3];
+  if (segment.type() == CommandType::LINE) {
+    t = (point.y - y0) / (y1 - y0);
+  } else if (segment.solveY(point.y, roots)) {
+    t = roots[0];
+  } else {
+    // Bisection as a fallback for roots lost to rounding
+    Real lower{};
+    Real upper = 1;
+    for (int i{}; i < 48; ++i) {
+      t = (lower + upper) / 2;
+      ((segment.evaluateAt(t).y < point.y) == (y0 < y1) ? lower : upper) = t;
+    }
+  }
+  const auto x = segment.evaluateAt(t).x;
+  return (reversed ? x < point.x : x > point.x) ? direction : 0;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::MonotoneSegments;
+using graphics::MonotoneSegments2;
+using graphics::MonotoneSegments2i;
+using graphics::MonotoneSegments2f;
+using graphics::MonotoneSegments2d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_MONOTONE_SEGMENTS2_H_
@@ -0,0 +1,481 @@
+//
+//  takram/graphics/offsetter2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_OFFSETTER2_H_
+#define TAKRAM_GRAPHICS_OFFSETTER2_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include "takram/graphics/boolean.h"
+#include "takram/graphics/boolean_operation.h"
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/fill_rule.h"
+#include "takram/graphics/join_type.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment.h"
+#include "takram/math/promotion.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+template <class T, int D>
+class Offsetter;
+
+template <class T>
+using Offsetter2 = Offsetter<T, 2>;
+
+// Offsets the outlines of filled paths by a distance, outward for positive
+// distances and inward for negative ones. The paths are first normalized so
+// that outer boundaries wind counter-clockwise and holes clockwise, and every
+// path is then offset to its right independently of the others. The offset of
+// a segment keeps its type: control polygons are offset leg by leg, which is
+// exact for lines and circular arcs, and curves are subdivided until the
+// result is within the tolerance. Loops left by concave corners, tight curves
+// and collapsing holes wind negatively and are removed by a final union under
+// the positive fill rule.
+
+template <class T>
+class Offsetter<T, 2> final {
+ public:
+  using Type = T;
+  static constexpr const int dimensions = 2;
+
+ public:
+  Offsetter();
+  explicit Offsetter(math::Promote<T> distance,
+                     JoinType join = JoinType::MITER,
+                     math::Promote<T> tolerance = 0.25,
+                     math::Promote<T> miter_limit = 4);
+
+  // Copy semantics
+  Offsetter(const Offsetter&) = default;
+  Offsetter& operator=(const Offsetter&) = default;
+
+  // Properties
+  math::Promote<T> distance() const { return distance_; }
+  void set_distance(math::Promote<T> value) { distance_ = value; }
+  JoinType join() const { return join_; }
+  void set_join(JoinType value) { join_ = value; }
+  math::Promote<T> tolerance() const { return tolerance_; }
+  void set_tolerance(math::Promote<T> value) { tolerance_ = value; }
+  math::Promote<T> miter_limit() const { return miter_limit_; }
+  void set_miter_limit(math::Promote<T> value) { miter_limit_ = value; }
+
+  // Offsetting
+  std::list<Path2<T>> offset(const Path2<T>& path) const;
+  std::list<Path2<T>> offset(const std::list<Path2<T>>& paths) const;
+
+ private:
+  using Real = math::Promote<T>;
+
+  Path2<T> offsetContour(const Path2<T>& path) const;
+  void offsetSegment(const Segment2<T>& segment,
+                     unsigned int depth,
+                     Path2<T> *result) const;
+  void join(const Vec2<T>& vertex,
+            const Vec2<Real>& incoming,
+            const Vec2<Real>& outgoing,
+            Path2<T> *result) const;
+  void arc(const Vec2<Real>& center,
+           const Vec2<Real>& from,
+           const Vec2<Real>& to,
+           const Vec2<Real>& incoming,
+           Path2<T> *result) const;
+  Segment2<T> approximate(const Segment2<T>& segment) const;
+  bool accurate(const Segment2<T>& segment,
+                const Segment2<T>& approximation) const;
+  Vec2<T> offsetPoint(const Vec2<T>& point, const Vec2<Real>& normal) const;
+  static Vec2<Real> startTangent(const Segment2<T>& segment);
+  static Vec2<Real> endTangent(const Segment2<T>& segment);
+  static Vec2<Real> normalize(const Vec2<Real>& vector);
+  static Vec2<Real> normal(const Vec2<Real>& tangent);
+
+ private:
+  Real distance_;
+  JoinType join_;
+  Real tolerance_;
+  Real miter_limit_;
+};
+
+using Offsetter2i = Offsetter2<int>;
+using Offsetter2f = Offsetter2<float>;
+using Offsetter2d = Offsetter2<double>;
+
+#pragma mark -
+
+template <class T>
+inline Offsetter<T, 2>::Offsetter()
+    : distance_(),
+      join_(JoinType::MITER),
+      tolerance_(0.25),
+      miter_limit_(4) {}
+
+template <class T>
+inline Offsetter<T, 2>::Offsetter(math::Promote<T> distance,
+                                  JoinType join,
+                                  math::Promote<T> tolerance,
+                                  math::Promote<T> miter_limit)
+    : distance_(distance),
+      join_(join),
+      tolerance_(tolerance),
+      miter_limit_(miter_limit) {}
+
+#pragma mark Offsetting
+
+template <class T>
+inline std::list<Path2<T>> Offsetter<T, 2>::offset(
+    const Path2<T>& path) const {
+  return offset(std::list<Path2<T>>{path});
+}
+
+template <class T>
+inline std::list<Path2<T>> Offsetter<T, 2>::offset(
+    const std::list<Path2<T>>& paths) const {
+  const auto normalized = Boolean2<T>::apply(paths, std::list<Path2<T>>(),
+                                             BooleanOperation::UNION);
+  if (!distance_) {
+    return normalized;
+  }
+  const std::vector<Path2<T>> contours(std::begin(normalized),
+                                       std::end(normalized));
+  std::vector<Path2<T>> offsets(contours.size());
+  parallelFor(contours.size(), [&](std::size_t index) {
+    offsets[index] = offsetContour(contours[index]);
+  });
+  return Boolean2<T>::apply(
+      std::list<Path2<T>>(std::begin(offsets), std::end(offsets)),
+      std::list<Path2<T>>(),
+      BooleanOperation::UNION,
+      FillRule::POSITIVE);
+}
+
+template <class T>
+inline Path2<T> Offsetter<T, 2>::offsetContour(const Path2<T>& path) const {
+  std::vector<Segment2<T>> segments;
+  const auto& commands = path.commands();
+  if (commands.empty()) {
+    return Path2<T>();
+  }
+  const auto first = commands.front().point();
+  auto start = first;
+  for (auto itr = std::next(std::begin(commands));
+       itr != std::end(commands); ++itr) {
+    if (itr->type() == CommandType::CLOSE) {
+      break;
+    }
+    if (itr->type() != CommandType::MOVE) {
+      const Segment2<T> segment(start, *itr);
+      if (startTangent(segment) != Vec2<Real>()) {
+        segments.emplace_back(segment);
+      }
+    }
+    start = itr->point();
+  }
+  if (start != first) {
+    segments.emplace_back(start, Command2<T>(CommandType::LINE, first));
+  }
+  Path2<T> result;
+  if (segments.empty()) {
+    return result;
+  }
+  result.moveTo(offsetPoint(segments.front().start(),
+                            normal(startTangent(segments.front()))));
+  for (std::size_t i{}; i < segments.size(); ++i) {
+    const auto& segment = segments[i];
+    const auto& next = segments[(i + 1) % segments.size()];
+    offsetSegment(segment, 0, &result);
+    join(segment.point(), endTangent(segment), startTangent(next), &result);
+  }
+  result.close();
+  return result;
+}
+
+template <class T>
+inline void Offsetter<T, 2>::offsetSegment(const Segment2<T>& segment,
+                                           unsigned int depth,
+                                           Path2<T> *result) const {
+  assert(result);
+  static const unsigned int max_depth = 10;
+  const auto approximation = approximate(segment);
+  const auto chord = segment.point() - segment.start();
+  const auto offset = approximation.point() - approximation.start();
+  if (chord.x * offset.x + chord.y * offset.y < 0) {
+    // Where the radius of curvature is smaller than the distance the offset
+    // runs backward, forming a swallowtail whose branches nearly coincide.
+    // Treat the segment like a concave corner instead.
+    const auto middle = segment.evaluateAt(0.5);
+    result->lineTo(Vec2<T>(middle.x, middle.y));
+    result->lineTo(approximation.point());
+    return;
+  }
+  if (depth < max_depth && !accurate(segment, approximation)) {
+    const auto pair = segment.split(0.5);
+    offsetSegment(pair.first, depth + 1, result);
+    offsetSegment(pair.second, depth + 1, result);
+  } else {
+    // Path2 closes itself whenever a command reaches the first point
+    if (result->back().type() == CommandType::CLOSE) {
+      result->commands().pop_back();
+    }
+    result->commands().emplace_back(approximation.command());
+  }
+}
+
+template <class T>
+inline void Offsetter<T, 2>::join(const Vec2<T>& vertex,
+                                  const Vec2<Real>& incoming,
+                                  const Vec2<Real>& outgoing,
+                                  Path2<T> *result) const {
+  assert(result);
+  const auto from = normal(incoming);
+  const auto to = normal(outgoing);
+  const auto target = offsetPoint(vertex, to);
+  const auto turn = incoming.cross(outgoing);
+  const auto epsilon = std::sqrt(std::numeric_limits<Real>::epsilon());
+  if (std::abs(turn) <= epsilon && incoming.dot(outgoing) > 0) {
+    // Smooth vertex
+    if (result->back().point() != target) {
+      result->lineTo(target);
+    }
+    return;
+  }
+  if (turn * distance_ < 0) {
+    // The offsets overlap at concave corners. Passing through the vertex
+    // leaves a loop that winds negatively and is removed later.
+    result->lineTo(vertex);
+    result->lineTo(target);
+    return;
+  }
+  switch (join_) {
+    case JoinType::MITER: {
+      const auto k = 1 + from.dot(to);
+      if (k > epsilon) {
+        const auto miter = (from + to) / k;
+        const auto length = std::sqrt(miter.dot(miter));
+        if (length <= miter_limit_) {
+          result->lineTo(offsetPoint(vertex, miter));
+        }
+      }
+      result->lineTo(target);
+      break;
+    }
+    case JoinType::ROUND:
+      arc(Vec2<Real>(vertex.x, vertex.y), from, to, incoming, result);
+      break;
+    case JoinType::BEVEL:
+      result->lineTo(target);
+      break;
+    default:
+      assert(false);
+      break;
+  }
+}
+
+template <class T>
+inline void Offsetter<T, 2>::arc(const Vec2<Real>& center,
+                                 const Vec2<Real>& from,
+                                 const Vec2<Real>& to,
+                                 const Vec2<Real>& incoming,
+                                 Path2<T> *result) const {
+  assert(result);
+  const auto cosine = from.dot(to);
+  if (cosine < 0) {
+    // Split arcs wider than a right angle at their middle, which lies ahead
+    // of the incoming direction when the path turns back on itself.
+    auto middle = from + to;
+    if (middle.dot(middle) <= std::numeric_limits<Real>::epsilon()) {
+      middle = distance_ < 0 ? -incoming : incoming;
+    }
+    middle = normalize(middle);
+    arc(center, from, middle, incoming, result);
+    arc(center, middle, to, incoming, result);
+    return;
+  }
+  // A circular arc is a conic whose weight is the cosine of its half angle
+  const auto point = center + distance_ * to;
+  const auto control = center + distance_ * (from + to) / (1 + cosine);
+  result->conicTo(Vec2<T>(control.x, control.y),
+                  Vec2<T>(point.x, point.y),
+                  std::sqrt((1 + cosine) / 2));
+}
+
+template <class T>
+inline Segment2<T> Offsetter<T, 2>::approximate(
+    const Segment2<T>& segment) const {
+  // Offset each leg of the control polygon and place the interior control
+  // points at the intersections of adjacent offset legs.
+  std::vector<Vec2<T>> points{segment.start()};
+  switch (segment.type()) {
+    case CommandType::QUADRATIC:
+    case CommandType::CONIC:
+      points.emplace_back(segment.control());
+      break;
+    case CommandType::CUBIC:
+      points.emplace_back(segment.control1());
+      points.emplace_back(segment.control2());
+      break;
+    default:
+      break;
+  }
+  points.emplace_back(segment.point());
+  std::vector<Vec2<Real>> normals(points.size() - 1);
+  for (std::size_t i{}; i < normals.size(); ++i) {
+    normals[i] = normal(normalize(Vec2<Real>(points[i + 1].x - points[i].x,
+                                             points[i + 1].y - points[i].y)));
+  }
+  // Degenerate legs take the normals of their neighbors
+  for (std::size_t i = 1; i < normals.size(); ++i) {
+    if (normals[i] == Vec2<Real>()) {
+      normals[i] = normals[i - 1];
+    }
+  }
+  for (std::size_t i = normals.size() - 1; i > 0; --i) {
+    if (normals[i - 1] == Vec2<Real>()) {
+      normals[i - 1] = normals[i];
+    }
+  }
+  auto result = segment;
+  result.start() = offsetPoint(points.front(), normals.front());
+  result.point() = offsetPoint(points.back(), normals.back());
+  for (std::size_t i = 1; i + 1 < points.size(); ++i) {
+    const auto& a = normals[i - 1];
+    const auto& b = normals[i];
+    const auto cosine = a.dot(b);
+    const auto offset = cosine > 0 ? (a + b) / (1 + cosine)
+                                   : normalize(a + b);
+    const auto point = offsetPoint(points[i], offset);
+    if (segment.type() == CommandType::CUBIC) {
+      (i == 1 ? result.control1() : result.control2()) = point;
+    } else {
+      result.control() = point;
+    }
+  }
+  return result;
+}
+
+template <class T>
+inline bool Offsetter<T, 2>::accurate(
+    const Segment2<T>& segment,
+    const Segment2<T>& approximation) const {
+  if (segment.type() == CommandType::LINE) {
+    return true;
+  }
+  for (const Real t : {0.25, 0.5, 0.75}) {
+    const auto derivative = segment.derivativeAt(t);
+    if (derivative == Vec2<Real>()) {
+      return false;
+    }
+    const auto expected = segment.evaluateAt(t) +
+                          distance_ * normal(normalize(derivative));
+    const auto error = approximation.evaluateAt(t) - expected;
+    if (error.dot(error) > tolerance_ * tolerance_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class T>
+inline Vec2<T> Offsetter<T, 2>::offsetPoint(const Vec2<T>& point,
+                                            const Vec2<Real>& normal) const {
+  return Vec2<T>(point.x + distance_ * normal.x,
+                 point.y + distance_ * normal.y);
+}
+
+template <class T>
+inline Vec2<math::Promote<T>> Offsetter<T, 2>::startTangent(
+    const Segment2<T>& segment) {
+  // Direction of the first leg of the control polygon with nonzero length
+  std::vector<Vec2<T>> points;
+  switch (segment.type()) {
+    case CommandType::QUADRATIC:
+    case CommandType::CONIC:
+      points.emplace_back(segment.control());
+      break;
+    case CommandType::CUBIC:
+      points.emplace_back(segment.control1());
+      points.emplace_back(segment.control2());
+      break;
+    default:
+      break;
+  }
+  points.emplace_back(segment.point());
+  const auto& start = segment.start();
+  for (const auto& point : points) {
+    if (point != start) {
+      return normalize(Vec2<Real>(point.x - start.x, point.y - start.y));
+    }
+  }
+  return Vec2<Real>();
+}
+
+template <class T>
+inline Vec2<math::Promote<T>> Offsetter<T, 2>::endTangent(
+    const Segment2<T>& segment) {
+  return -startTangent(segment.reversed());
+}
+
+template <class T>
+inline Vec2<math::Promote<T>> Offsetter<T, 2>::normalize(
+    const Vec2<Real>& vector) {
+  const auto length = std::sqrt(vector.dot(vector));
+  if (!length) {
+    return Vec2<Real>();
+  }
+  return vector / length;
+}
+
+template <class T>
+inline Vec2<math::Promote<T>> Offsetter<T, 2>::normal(
+    const Vec2<Real>& tangent) {
+  // Right-hand normal, which points outward on counter-clockwise paths
+  return Vec2<Real>(tangent.y, -tangent.x);
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Offsetter;
+using graphics::Offsetter2;
+using graphics::Offsetter2i;
+using graphics::Offsetter2f;
+using graphics::Offsetter2d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_OFFSETTER2_H_
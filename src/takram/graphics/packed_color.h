@@ -0,0 +1,434 @@
+//
+//  takram/graphics/packed_color.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_PACKED_COLOR_H_
+#define TAKRAM_GRAPHICS_PACKED_COLOR_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+#include "takram/graphics/channel.h"
+#include "takram/graphics/channel_order.h"
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/simd.h"
+
+namespace takram {
+namespace graphics {
+
+// An 8-bit color packed in 32 bits, whose bytes are in the channel order in
+// memory regardless of the byte order of the platform, as the formats of
+// renderers and image codecs are defined. PackedColor<ChannelOrder::RGBA> has
+// the same layout as Color4u.
+//
+// PackedView accesses a buffer of packed colors in place, without copying or
+// reordering it, by colors or by the bytes of their channels. Buffers and
+// views are converted from one channel order to another by shuffling the
+// bytes of four colors at a time with SSE2 where available, and in place when
+// the source and destination are the same.
+
+template <ChannelOrder Order>
+class PackedColor final {
+ public:
+  static constexpr const ChannelOrder order = Order;
+
+ public:
+  PackedColor();
+  explicit PackedColor(std::uint32_t value);
+  PackedColor(std::uint8_t red,
+              std::uint8_t green,
+              std::uint8_t blue,
+              std::uint8_t alpha = Depth<std::uint8_t>::max);
+  explicit PackedColor(const Color4u& color);
+  template <ChannelOrder Other>
+  explicit PackedColor(const PackedColor<Other>& other);
+
+  // Copy semantics
+  PackedColor(const PackedColor&) = default;
+  PackedColor& operator=(const PackedColor&) = default;
+
+  // Conversion
+  Color4u color() const;
+
+  // Element access
+  std::uint8_t at(Channel channel) const;
+  void set(Channel channel, std::uint8_t value);
+
+  // Properties
+  std::uint8_t red() const { return at(Channel::RED); }
+  void set_red(std::uint8_t value) { set(Channel::RED, value); }
+  std::uint8_t green() const { return at(Channel::GREEN); }
+  void set_green(std::uint8_t value) { set(Channel::GREEN, value); }
+  std::uint8_t blue() const { return at(Channel::BLUE); }
+  void set_blue(std::uint8_t value) { set(Channel::BLUE, value); }
+  std::uint8_t alpha() const { return at(Channel::ALPHA); }
+  void set_alpha(std::uint8_t value) { set(Channel::ALPHA, value); }
+
+ public:
+  std::uint32_t value;
+};
+
+template <ChannelOrder Order>
+class PackedView final {
+ public:
+  static constexpr const ChannelOrder order = Order;
+
+ public:
+  PackedView();
+  PackedView(void *data, std::size_t size);
+
+  // Copy semantics
+  PackedView(const PackedView&) = default;
+  PackedView& operator=(const PackedView&) = default;
+
+  // Attributes
+  bool empty() const { return !size_; }
+  std::size_t size() const { return size_; }
+
+  // Pointer
+  std::uint8_t * data() const { return data_; }
+
+  // Element access
+  std::uint8_t& at(std::size_t index, Channel channel) const;
+  PackedColor<Order> packed(std::size_t index) const;
+  Color4u pixel(std::size_t index) const;
+  void setPixel(std::size_t index, const Color4u& color) const;
+
+  // Operations
+  void fill(const Color4u& color) const;
+  template <ChannelOrder Other>
+  void copy(const PackedView<Other>& other) const;
+
+ private:
+  std::uint8_t *data_;
+  std::size_t size_;
+};
+
+// Comparison
+template <ChannelOrder Order>
+bool operator==(const PackedColor<Order>& lhs, const PackedColor<Order>& rhs);
+template <ChannelOrder Order>
+bool operator!=(const PackedColor<Order>& lhs, const PackedColor<Order>& rhs);
+
+// Stream
+template <ChannelOrder Order>
+std::ostream& operator<<(std::ostream& os, const PackedColor<Order>& color);
+
+// Conversions between channel orders
+template <ChannelOrder From, ChannelOrder To>
+void convertOrder(const PackedColor<From> *colors,
+                  std::size_t size,
+                  PackedColor<To> *result);
+template <ChannelOrder To>
+void convertOrder(const Color4u *colors,
+                  std::size_t size,
+                  PackedColor<To> *result);
+template <ChannelOrder From>
+void convertOrder(const PackedColor<From> *colors,
+                  std::size_t size,
+                  Color4u *result);
+
+using PackedRGBA = PackedColor<ChannelOrder::RGBA>;
+using PackedBGRA = PackedColor<ChannelOrder::BGRA>;
+using PackedARGB = PackedColor<ChannelOrder::ARGB>;
+using PackedABGR = PackedColor<ChannelOrder::ABGR>;
+using PackedRGBAView = PackedView<ChannelOrder::RGBA>;
+using PackedBGRAView = PackedView<ChannelOrder::BGRA>;
+using PackedARGBView = PackedView<ChannelOrder::ARGB>;
+using PackedABGRView = PackedView<ChannelOrder::ABGR>;
+
+#pragma mark -
+
+namespace detail {
+
+// The byte of a channel in a packed color
+constexpr int channelOffset(ChannelOrder order, Channel channel) {
+  switch (order) {
+    case ChannelOrder::RGBA:
+      return static_cast<int>(channel);
+    case ChannelOrder::BGRA:
+      return channel == Channel::ALPHA ? 3 : 2 - static_cast<int>(channel);
+    case ChannelOrder::ARGB:
+      return channel == Channel::ALPHA ? 0 : 1 + static_cast<int>(channel);
+    case ChannelOrder::ABGR:
+      return channel == Channel::ALPHA ? 0 : 3 - static_cast<int>(channel);
+    default:
+      return 0;
+  }
+}
+
+// The bits of the channels that move by the same number of bytes from one
+// order to another, in the little-endian 32-bit integers they make
+constexpr std::uint32_t shuffleMask(ChannelOrder from,
+                                    ChannelOrder to,
+                                    int distance) {
+  std::uint32_t mask{};
+  for (int i{}; i < 4; ++i) {
+    const auto channel = static_cast<Channel>(i);
+    const auto offset = channelOffset(from, channel);
+    if (channelOffset(to, channel) - offset == distance) {
+      mask |= std::uint32_t(0xff) << (offset * 8);
+    }
+  }
+  return mask;
+}
+
+template <ChannelOrder From, ChannelOrder To>
+inline void shuffleChannels(const std::uint8_t *colors,
+                            std::size_t size,
+                            std::uint8_t *result) {
+  std::size_t i{};
+#if TAKRAM_GRAPHICS_HAS_SSE2
+  constexpr const std::uint32_t masks[7] = {
+    shuffleMask(From, To, -3), shuffleMask(From, To, -2),
+    shuffleMask(From, To, -1), shuffleMask(From, To, 0),
+    shuffleMask(From, To, 1), shuffleMask(From, To, 2),
+    shuffleMask(From, To, 3)
+  };
+  for (; i + 4 <= size; i += 4) {
+    const auto source = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(colors + i * 4));
+    auto shuffled = _mm_setzero_si128();
+    for (int distance = -3; distance <= 3; ++distance) {
+      const auto mask = masks[distance + 3];
+      if (!mask) {
+        continue;
+      }
+      const auto bytes = _mm_and_si128(source, _mm_set1_epi32(
+          static_cast<std::int32_t>(mask)));
+      shuffled = _mm_or_si128(shuffled, distance < 0 ?
+          _mm_srli_epi32(bytes, -distance * 8) :
+          _mm_slli_epi32(bytes, distance * 8));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i * 4), shuffled);
+  }
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+  for (; i < size; ++i) {
+    std::uint8_t source[4];
+    std::memcpy(source, colors + i * 4, sizeof(source));
+    const auto target = result + i * 4;
+    for (int j{}; j < 4; ++j) {
+      const auto channel = static_cast<Channel>(j);
+      target[channelOffset(To, channel)] = source[channelOffset(From, channel)];
+    }
+  }
+}
+
+}  // namespace detail
+
+#pragma mark -
+
+template <ChannelOrder Order>
+inline PackedColor<Order>::PackedColor() : value() {}
+
+template <ChannelOrder Order>
+inline PackedColor<Order>::PackedColor(std::uint32_t value) : value(value) {}
+
+template <ChannelOrder Order>
+inline PackedColor<Order>::PackedColor(std::uint8_t red,
+                                       std::uint8_t green,
+                                       std::uint8_t blue,
+                                       std::uint8_t alpha)
+    : value() {
+  set(Channel::RED, red);
+  set(Channel::GREEN, green);
+  set(Channel::BLUE, blue);
+  set(Channel::ALPHA, alpha);
+}
+
+template <ChannelOrder Order>
+inline PackedColor<Order>::PackedColor(const Color4u& color)
+    : PackedColor(color.r, color.g, color.b, color.a) {}
+
+template <ChannelOrder Order>
+template <ChannelOrder Other>
+inline PackedColor<Order>::PackedColor(const PackedColor<Other>& other)
+    : value() {
+  detail::shuffleChannels<Other, Order>(
+      reinterpret_cast<const std::uint8_t *>(&other.value), 1,
+      reinterpret_cast<std::uint8_t *>(&value));
+}
+
+#pragma mark Conversion
+
+template <ChannelOrder Order>
+inline Color4u PackedColor<Order>::color() const {
+  return Color4u(at(Channel::RED), at(Channel::GREEN), at(Channel::BLUE),
+                 at(Channel::ALPHA));
+}
+
+#pragma mark Element access
+
+template <ChannelOrder Order>
+inline std::uint8_t PackedColor<Order>::at(Channel channel) const {
+  std::uint8_t bytes[4];
+  std::memcpy(bytes, &value, sizeof(bytes));
+  return bytes[detail::channelOffset(Order, channel)];
+}
+
+template <ChannelOrder Order>
+inline void PackedColor<Order>::set(Channel channel, std::uint8_t value) {
+  std::uint8_t bytes[4];
+  std::memcpy(bytes, &this->value, sizeof(bytes));
+  bytes[detail::channelOffset(Order, channel)] = value;
+  std::memcpy(&this->value, bytes, sizeof(bytes));
+}
+
+#pragma mark Comparison
+
+template <ChannelOrder Order>
+inline bool operator==(const PackedColor<Order>& lhs,
+                       const PackedColor<Order>& rhs) {
+  return lhs.value == rhs.value;
+}
+
+template <ChannelOrder Order>
+inline bool operator!=(const PackedColor<Order>& lhs,
+                       const PackedColor<Order>& rhs) {
+  return !(lhs == rhs);
+}
+
+#pragma mark Stream
+
+template <ChannelOrder Order>
+inline std::ostream& operator<<(std::ostream& os,
+                                const PackedColor<Order>& color) {
+  return os << color.color();
+}
+
+#pragma mark -
+
+template <ChannelOrder Order>
+inline PackedView<Order>::PackedView() : data_(), size_() {}
+
+template <ChannelOrder Order>
+inline PackedView<Order>::PackedView(void *data, std::size_t size)
+    : data_(static_cast<std::uint8_t *>(data)),
+      size_(size) {}
+
+#pragma mark Element access
+
+template <ChannelOrder Order>
+inline std::uint8_t& PackedView<Order>::at(std::size_t index,
+                                           Channel channel) const {
+  assert(index < size_);
+  return data_[index * 4 + detail::channelOffset(Order, channel)];
+}
+
+template <ChannelOrder Order>
+inline PackedColor<Order> PackedView<Order>::packed(std::size_t index) const {
+  assert(index < size_);
+  PackedColor<Order> result;
+  std::memcpy(&result.value, data_ + index * 4, sizeof(result.value));
+  return result;
+}
+
+template <ChannelOrder Order>
+inline Color4u PackedView<Order>::pixel(std::size_t index) const {
+  return Color4u(at(index, Channel::RED), at(index, Channel::GREEN),
+                 at(index, Channel::BLUE), at(index, Channel::ALPHA));
+}
+
+template <ChannelOrder Order>
+inline void PackedView<Order>::setPixel(std::size_t index,
+                                        const Color4u& color) const {
+  at(index, Channel::RED) = color.r;
+  at(index, Channel::GREEN) = color.g;
+  at(index, Channel::BLUE) = color.b;
+  at(index, Channel::ALPHA) = color.a;
+}
+
+#pragma mark Operations
+
+template <ChannelOrder Order>
+inline void PackedView<Order>::fill(const Color4u& color) const {
+  const PackedColor<Order> packed(color);
+  for (std::size_t i{}; i < size_; ++i) {
+    std::memcpy(data_ + i * 4, &packed.value, sizeof(packed.value));
+  }
+}
+
+template <ChannelOrder Order>
+template <ChannelOrder Other>
+inline void PackedView<Order>::copy(const PackedView<Other>& other) const {
+  assert(other.size() == size_);
+  detail::shuffleChannels<Other, Order>(other.data(), size_, data_);
+}
+
+#pragma mark Conversions between channel orders
+
+template <ChannelOrder From, ChannelOrder To>
+inline void convertOrder(const PackedColor<From> *colors,
+                         std::size_t size,
+                         PackedColor<To> *result) {
+  detail::shuffleChannels<From, To>(
+      reinterpret_cast<const std::uint8_t *>(colors), size,
+      reinterpret_cast<std::uint8_t *>(result));
+}
+
+template <ChannelOrder To>
+inline void convertOrder(const Color4u *colors,
+                         std::size_t size,
+                         PackedColor<To> *result) {
+  static_assert(sizeof(Color4u) == 4, "Colors must be tightly packed");
+  detail::shuffleChannels<ChannelOrder::RGBA, To>(
+      reinterpret_cast<const std::uint8_t *>(colors), size,
+      reinterpret_cast<std::uint8_t *>(result));
+}
+
+template <ChannelOrder From>
+inline void convertOrder(const PackedColor<From> *colors,
+                         std::size_t size,
+                         Color4u *result) {
+  static_assert(sizeof(Color4u) == 4, "Colors must be tightly packed");
+  detail::shuffleChannels<From, ChannelOrder::RGBA>(
+      reinterpret_cast<const std::uint8_t *>(colors), size,
+      reinterpret_cast<std::uint8_t *>(result));
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::PackedColor;
+using graphics::PackedView;
+using graphics::PackedRGBA;
+using graphics::PackedBGRA;
+using graphics::PackedARGB;
+using graphics::PackedABGR;
+using graphics::PackedRGBAView;
+using graphics::PackedBGRAView;
+using graphics::PackedARGBView;
+using graphics::PackedABGRView;
+using graphics::convertOrder;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_PACKED_COLOR_H_
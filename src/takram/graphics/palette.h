@@ -0,0 +1,587 @@
+//
+//  takram/graphics/palette.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_PALETTE_H_
+#define TAKRAM_GRAPHICS_PALETTE_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/color_space.h"
+#include "takram/graphics/palette_method.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/srgb.h"
+
+namespace takram {
+namespace graphics {
+
+// Generates palettes of up to 256 colors for 8-bit color buffers, and maps
+// colors to their nearest palette entries for indexed exports.
+//
+// Colors are first counted into a histogram of 5 bits per channel and four
+// classes of alpha, built in parallel with a histogram per thread, and each
+// bin stands for the mean of its colors. Fully transparent colors fall into a
+// single bin regardless of their color channels.
+//
+// - Median cut repeatedly splits the box of bins with the largest squared
+//   error at the weighted median of its channel of the largest variance, and
+//   takes the weighted means of the boxes.
+// - K-means starts from the median cut and refines the means with Lloyd
+//   iterations in OKLab, with alpha as the fourth coordinate, assigning bins
+//   in parallel.
+//
+// PaletteMapper finds the nearest entries in RGBA by the Euclidean distance,
+// exactly, through a grid of 16 cells per channel that lists the entries that
+// can be nearest to any color in each cell. Fully transparent colors and
+// entries are all taken as transparent black.
+
+template <int C>
+std::vector<Color<std::uint8_t, C>> generatePalette(
+    const Color<std::uint8_t, C> *colors,
+    std::size_t size,
+    int count,
+    PaletteMethod method = PaletteMethod::K_MEANS,
+    int iterations = 8);
+
+template <int C>
+class PaletteMapper final {
+ public:
+  using Entry = Color<std::uint8_t, C>;
+  static constexpr const int channels = C;
+
+ public:
+  PaletteMapper() = default;
+  explicit PaletteMapper(const std::vector<Entry>& palette);
+
+  // Copy semantics
+  PaletteMapper(const PaletteMapper&) = default;
+  PaletteMapper& operator=(const PaletteMapper&) = default;
+
+  // Mutators
+  void set(const std::vector<Entry>& palette);
+  void reset();
+
+  // Attributes
+  bool empty() const { return palette_.empty(); }
+  const std::vector<Entry>& palette() const { return palette_; }
+
+  // Mapping
+  int nearest(const Entry& color) const;
+  void map(const Entry *colors, std::size_t size, std::uint8_t *result) const;
+  void map(const Entry *colors, std::size_t size, Entry *result) const;
+
+ private:
+  static constexpr const int cells = 16;
+  static constexpr const int alpha_cells = C == 4 ? cells : 1;
+
+  static std::size_t cell(const std::array<int, 4>& values);
+
+ private:
+  std::vector<Entry> palette_;
+  std::vector<std::array<int, 4>> entries_;
+  std::vector<std::uint32_t> offsets_;
+  std::vector<std::uint8_t> candidates_;
+};
+
+using PaletteMapper3u = PaletteMapper<3>;
+using PaletteMapper4u = PaletteMapper<4>;
+
+#pragma mark -
+
+namespace detail {
+
+// Channels of a color, with the alpha of Color3 being opaque and fully
+// transparent colors being transparent black
+inline std::array<int, 4> paletteValues(const Color3u& color) {
+  return {{color.r, color.g, color.b, 0xff}};
+}
+
+inline std::array<int, 4> paletteValues(const Color4u& color) {
+  if (!color.a) {
+    return {{0, 0, 0, 0}};
+  }
+  return {{color.r, color.g, color.b, color.a}};
+}
+
+inline Color3u paletteColor(const std::array<double, 4>& values, Color3u) {
+  const auto channel = [](double value) {
+    return static_cast<std::uint8_t>(
+        std::round(std::min(std::max(value, 0.0), 255.0)));
+  };
+  return Color3u(channel(values[0]), channel(values[1]), channel(values[2]));
+}
+
+inline Color4u paletteColor(const std::array<double, 4>& values, Color4u) {
+  return Color4u(paletteColor(values, Color3u()), static_cast<std::uint8_t>(
+      std::round(std::min(std::max(values[3], 0.0), 255.0))));
+}
+
+// A bin of the histogram, summing the channels of its colors
+struct PaletteBin {
+  std::uint32_t count;
+  std::uint32_t sums[4];
+};
+
+// The mean color of a bin weighted by its number of colors
+struct PaletteSample {
+  double weight;
+  std::array<double, 4> values;
+};
+
+inline std::size_t paletteBin(const std::array<int, 4>& values) {
+  const auto alpha = values[3];
+  const std::size_t alpha_class = !alpha ? 0 : alpha == 0xff ? 3 :
+                                  1 + (alpha >> 7);
+  return alpha_class << 15 | (values[0] >> 3) << 10 |
+         (values[1] >> 3) << 5 | (values[2] >> 3);
+}
+
+template <int C>
+inline std::vector<PaletteSample> paletteSamples(
+    const Color<std::uint8_t, C> *colors,
+    std::size_t size) {
+  const std::size_t bins = std::size_t(1) << 17;
+  // Every chunk counts fewer than 2^24 colors for the sums to fit in 32 bits
+  const std::size_t limit = std::size_t(1) << 24;
+  const std::size_t concurrency = std::thread::hardware_concurrency();
+  auto chunks = std::min(std::max<std::size_t>(concurrency, 1),
+                         (size + 0xffff) / 0x10000);
+  chunks = std::max({chunks, (size + limit - 1) / limit, std::size_t(1)});
+  std::vector<std::vector<PaletteBin>> histograms(chunks);
+  parallelFor(chunks, [&](std::size_t chunk) {
+    auto& histogram = histograms[chunk];
+    histogram.assign(bins, PaletteBin());
+    const auto end = size * (chunk + 1) / chunks;
+    for (auto i = size * chunk / chunks; i < end; ++i) {
+      const auto values = paletteValues(colors[i]);
+      auto& bin = histogram[paletteBin(values)];
+      ++bin.count;
+      bin.sums[0] += values[0];
+      bin.sums[1] += values[1];
+      bin.sums[2] += values[2];
+      bin.sums[3] += values[3];
+    }
+  });
+  std::vector<PaletteSample> samples;
+  for (std::size_t i{}; i < bins; ++i) {
+    std::uint64_t count{};
+    std::uint64_t sums[4]{};
+    for (const auto& histogram : histograms) {
+      const auto& bin = histogram[i];
+      count += bin.count;
+      for (int channel{}; channel < 4; ++channel) {
+        sums[channel] += bin.sums[channel];
+      }
+    }
+    if (count) {
+      PaletteSample sample;
+      sample.weight = count;
+      for (int channel{}; channel < 4; ++channel) {
+        sample.values[channel] = static_cast<double>(sums[channel]) / count;
+      }
+      samples.push_back(sample);
+    }
+  }
+  return samples;
+}
+
+// A range of samples, and the channel of the largest variance in them
+struct PaletteBox {
+  PaletteBox(std::vector<PaletteSample> *samples,
+             std::size_t begin,
+             std::size_t end);
+
+  std::size_t begin;
+  std::size_t end;
+  PaletteSample mean;
+  double error;
+  int channel;
+};
+
+inline PaletteBox::PaletteBox(std::vector<PaletteSample> *samples,
+                              std::size_t begin,
+                              std::size_t end)
+    : begin(begin),
+      end(end),
+      mean(),
+      error(),
+      channel() {
+  std::array<double, 4> squares{};
+  for (auto i = begin; i < end; ++i) {
+    const auto& sample = (*samples)[i];
+    mean.weight += sample.weight;
+    for (int c{}; c < 4; ++c) {
+      mean.values[c] += sample.weight * sample.values[c];
+      squares[c] += sample.weight * sample.values[c] * sample.values[c];
+    }
+  }
+  double variance{};
+  for (int c{}; c < 4; ++c) {
+    mean.values[c] /= mean.weight;
+    const auto squared = squares[c] - mean.weight * mean.values[c] *
+                                      mean.values[c];
+    error += squared;
+    if (squared > variance) {
+      variance = squared;
+      channel = c;
+    }
+  }
+}
+
+inline std::vector<PaletteSample> medianCut(
+    std::vector<PaletteSample> *samples,
+    std::size_t count) {
+  std::vector<PaletteBox> boxes;
+  if (!samples->empty()) {
+    boxes.emplace_back(samples, 0, samples->size());
+  }
+  while (boxes.size() < count) {
+    const auto box = std::max_element(
+        boxes.begin(), boxes.end(),
+        [](const PaletteBox& a, const PaletteBox& b) {
+          return a.error < b.error;
+        });
+    if (box == boxes.end() || box->end - box->begin < 2 ||
+        box->error <= 0) {
+      break;
+    }
+    const auto begin = samples->begin() + box->begin;
+    const auto end = samples->begin() + box->end;
+    const auto channel = box->channel;
+    std::sort(begin, end, [channel](const PaletteSample& a,
+                                    const PaletteSample& b) {
+      return a.values[channel] < b.values[channel];
+    });
+    // Split at the weighted median, leaving at least a sample on either side
+    auto split = box->begin + 1;
+    for (double weight{}; split < box->end - 1; ++split) {
+      weight += (*samples)[split - 1].weight;
+      if (weight * 2 >= box->mean.weight) {
+        break;
+      }
+    }
+    const auto last = box->end;
+    *box = PaletteBox(samples, box->begin, split);
+    boxes.emplace_back(samples, split, last);
+  }
+  std::vector<PaletteSample> result;
+  for (const auto& box : boxes) {
+    result.push_back(box.mean);
+  }
+  return result;
+}
+
+// Coordinates in OKLab and alpha, and back
+inline std::array<double, 4> paletteOKLab(const std::array<double, 4>& values) {
+  const auto lab = rgbToOKLab(decodeSRGB(Color3d(
+      values[0] / 0xff, values[1] / 0xff, values[2] / 0xff)));
+  return {{lab.r, lab.g, lab.b, values[3] / 0xff}};
+}
+
+inline std::array<double, 4> paletteRGB(const std::array<double, 4>& values) {
+  const auto rgb = oklabToRGB(Color3d(values[0], values[1], values[2]));
+  const auto channel = [](double value) {
+    return encodeSRGB(std::min(std::max(value, 0.0), 1.0)) * 0xff;
+  };
+  return {{channel(rgb.r), channel(rgb.g), channel(rgb.b), values[3] * 0xff}};
+}
+
+inline void kMeans(const std::vector<PaletteSample>& samples,
+                   int iterations,
+                   std::vector<PaletteSample> *means) {
+  const auto count = means->size();
+  std::vector<std::array<double, 4>> points;
+  for (const auto& sample : samples) {
+    points.push_back(paletteOKLab(sample.values));
+  }
+  std::vector<std::array<double, 4>> centers;
+  for (const auto& mean : *means) {
+    centers.push_back(paletteOKLab(mean.values));
+  }
+  std::vector<std::size_t> assignments(samples.size(), count);
+  const std::size_t chunks = std::max<std::size_t>(
+      std::min<std::size_t>(std::thread::hardware_concurrency(),
+                            samples.size() / 1024), 1);
+  using Sums = std::vector<std::array<double, 5>>;
+  std::vector<Sums> sums(chunks);
+  for (int iteration{}; iteration < iterations; ++iteration) {
+    std::vector<char> changes(chunks);
+    parallelFor(chunks, [&](std::size_t chunk) {
+      auto& partial = sums[chunk];
+      partial.assign(count, std::array<double, 5>());
+      const auto end = samples.size() * (chunk + 1) / chunks;
+      for (auto i = samples.size() * chunk / chunks; i < end; ++i) {
+        const auto& point = points[i];
+        auto nearest = count;
+        auto distance = std::numeric_limits<double>::infinity();
+        for (std::size_t j{}; j < count; ++j) {
+          const auto& center = centers[j];
+          double d{};
+          for (int c{}; c < 4; ++c) {
+            d += (point[c] - center[c]) * (point[c] - center[c]);
+          }
+          if (d < distance) {
+            distance = d;
+            nearest = j;
+          }
+        }
+        if (assignments[i] != nearest) {
+          assignments[i] = nearest;
+          changes[chunk] = true;
+        }
+        const auto weight = samples[i].weight;
+        auto& sum = partial[nearest];
+        for (int c{}; c < 4; ++c) {
+          sum[c] += weight * point[c];
+        }
+        sum[4] += weight;
+      }
+    });
+    if (std::find(changes.begin(), changes.end(), true) == changes.end()) {
+      break;
+    }
+    // Centers left without samples stay where they are
+    for (std::size_t j{}; j < count; ++j) {
+      std::array<double, 5> sum{};
+      for (const auto& partial : sums) {
+        for (int c{}; c < 5; ++c) {
+          sum[c] += partial[j][c];
+        }
+      }
+      if (sum[4] > 0) {
+        for (int c{}; c < 4; ++c) {
+          centers[j][c] = sum[c] / sum[4];
+        }
+      }
+    }
+  }
+  for (std::size_t j{}; j < count; ++j) {
+    (*means)[j].values = paletteRGB(centers[j]);
+  }
+}
+
+}  // namespace detail
+
+template <int C>
+inline std::vector<Color<std::uint8_t, C>> generatePalette(
+    const Color<std::uint8_t, C> *colors,
+    std::size_t size,
+    int count,
+    PaletteMethod method,
+    int iterations) {
+  using Entry = Color<std::uint8_t, C>;
+  count = std::min(std::max(count, 1), 0x100);
+  auto samples = detail::paletteSamples(colors, size);
+  auto means = detail::medianCut(&samples, count);
+  switch (method) {
+    case PaletteMethod::MEDIAN_CUT:
+      break;
+    case PaletteMethod::K_MEANS:
+      detail::kMeans(samples, iterations, &means);
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  std::vector<Entry> result;
+  for (const auto& mean : means) {
+    const auto color = detail::paletteColor(mean.values, Entry());
+    if (std::find(result.begin(), result.end(), color) == result.end()) {
+      result.push_back(color);
+    }
+  }
+  return result;
+}
+
+#pragma mark -
+
+template <int C>
+inline PaletteMapper<C>::PaletteMapper(const std::vector<Entry>& palette) {
+  set(palette);
+}
+
+#pragma mark Mutators
+
+template <int C>
+inline void PaletteMapper<C>::set(const std::vector<Entry>& palette) {
+  assert(palette.size() <= 0x100);
+  palette_ = palette;
+  entries_.clear();
+  for (const auto& color : palette_) {
+    entries_.push_back(detail::paletteValues(color));
+  }
+  // Each task lists the candidates of the cells sharing alpha and red
+  const std::size_t slabs = alpha_cells * cells;
+  std::vector<std::vector<std::uint8_t>> slab_candidates(slabs);
+  std::vector<std::vector<std::uint32_t>> slab_counts(slabs);
+  const auto size = cells;
+  parallelFor(slabs, [&](std::size_t slab) {
+    auto& candidates = slab_candidates[slab];
+    auto& counts = slab_counts[slab];
+    std::array<int, 4> lower;
+    std::array<int, 4> upper;
+    lower[3] = C == 4 ? static_cast<int>(slab / size) * 0x100 / size : 0xff;
+    upper[3] = C == 4 ? lower[3] + 0x100 / size - 1 : 0xff;
+    lower[0] = static_cast<int>(slab % size) * 0x100 / size;
+    upper[0] = lower[0] + 0x100 / size - 1;
+    std::vector<int> nearest(entries_.size());
+    for (int g{}; g < size; ++g) {
+      lower[1] = g * 0x100 / size;
+      upper[1] = lower[1] + 0x100 / size - 1;
+      for (int b{}; b < size; ++b) {
+        lower[2] = b * 0x100 / size;
+        upper[2] = lower[2] + 0x100 / size - 1;
+        // An entry can be nearest to a color in the cell only if its nearest
+        // distance to the cell is within the farthest distance of another
+        auto threshold = std::numeric_limits<int>::max();
+        for (std::size_t i{}; i < entries_.size(); ++i) {
+          const auto& entry = entries_[i];
+          int near{};
+          int far{};
+          for (int c{}; c < 4; ++c) {
+            const auto below = lower[c] - entry[c];
+            const auto above = entry[c] - upper[c];
+            const auto distance = std::max({below, above, 0});
+            const auto extent = std::max(std::abs(below), std::abs(above));
+            near += distance * distance;
+            far += extent * extent;
+          }
+          nearest[i] = near;
+          threshold = std::min(threshold, far);
+        }
+        std::uint32_t count{};
+        for (std::size_t i{}; i < entries_.size(); ++i) {
+          if (nearest[i] <= threshold) {
+            candidates.push_back(static_cast<std::uint8_t>(i));
+            ++count;
+          }
+        }
+        counts.push_back(count);
+      }
+    }
+  });
+  offsets_.assign(1, 0);
+  candidates_.clear();
+  for (std::size_t slab{}; slab < slabs; ++slab) {
+    for (const auto count : slab_counts[slab]) {
+      offsets_.push_back(offsets_.back() + count);
+    }
+    candidates_.insert(candidates_.end(), slab_candidates[slab].begin(),
+                       slab_candidates[slab].end());
+  }
+}
+
+template <int C>
+inline void PaletteMapper<C>::reset() {
+  palette_.clear();
+  entries_.clear();
+  offsets_.clear();
+  candidates_.clear();
+}
+
+#pragma mark Mapping
+
+template <int C>
+inline std::size_t PaletteMapper<C>::cell(const std::array<int, 4>& values) {
+  const int shift = 4;
+  const std::size_t alpha = C == 4 ? values[3] >> shift : 0;
+  return ((alpha * cells + (values[0] >> shift)) * cells +
+          (values[1] >> shift)) * cells + (values[2] >> shift);
+}
+
+template <int C>
+inline int PaletteMapper<C>::nearest(const Entry& color) const {
+  if (palette_.empty()) {
+    return -1;
+  }
+  const auto values = detail::paletteValues(color);
+  const auto index = cell(values);
+  auto result = -1;
+  auto distance = std::numeric_limits<int>::max();
+  for (auto i = offsets_[index]; i < offsets_[index + 1]; ++i) {
+    const auto candidate = candidates_[i];
+    const auto& entry = entries_[candidate];
+    int d{};
+    for (int c{}; c < 4; ++c) {
+      d += (values[c] - entry[c]) * (values[c] - entry[c]);
+    }
+    if (d < distance) {
+      distance = d;
+      result = candidate;
+    }
+  }
+  return result;
+}
+
+template <int C>
+inline void PaletteMapper<C>::map(const Entry *colors,
+                                  std::size_t size,
+                                  std::uint8_t *result) const {
+  assert(!palette_.empty());
+  const std::size_t chunk = 0x10000;
+  parallelFor((size + chunk - 1) / chunk, [&](std::size_t index) {
+    const auto end = std::min(size, (index + 1) * chunk);
+    for (auto i = index * chunk; i < end; ++i) {
+      result[i] = static_cast<std::uint8_t>(nearest(colors[i]));
+    }
+  });
+}
+
+template <int C>
+inline void PaletteMapper<C>::map(const Entry *colors,
+                                  std::size_t size,
+                                  Entry *result) const {
+  assert(!palette_.empty());
+  const std::size_t chunk = 0x10000;
+  parallelFor((size + chunk - 1) / chunk, [&](std::size_t index) {
+    const auto end = std::min(size, (index + 1) * chunk);
+    for (auto i = index * chunk; i < end; ++i) {
+      result[i] = palette_[nearest(colors[i])];
+    }
+  });
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::generatePalette;
+using graphics::PaletteMapper;
+using graphics::PaletteMapper3u;
+using graphics::PaletteMapper4u;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_PALETTE_H_
@@ -0,0 +1,78 @@
+//
+//  takram/graphics/parallel.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_PARALLEL_H_
+#define TAKRAM_GRAPHICS_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace takram {
+namespace graphics {
+
+// Invokes function for every index in [0, size) using as many threads as the
+// hardware supports. Indices are handed out one by one, so that uneven work
+// per index balances across threads. The function must be safe to call
+// concurrently for different indices.
+
+template <class Function>
+inline void parallelFor(std::size_t size, Function function) {
+  const std::size_t concurrency = std::thread::hardware_concurrency();
+  const auto count = std::min(std::max<std::size_t>(concurrency, 1), size);
+  if (count < 2) {
+    for (std::size_t index{}; index < size; ++index) {
+      function(index);
+    }
+    return;
+  }
+  std::atomic<std::size_t> next(0);
+  const auto work = [&]() {
+    for (auto index = next++; index < size; index = next++) {
+      function(index);
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(count - 1);
+  for (std::size_t i = 1; i < count; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_PARALLEL_H_
@@ -42,6 +42,7 @@
 #include "takram/graphics/command.h"
 #include "takram/graphics/conic.h"
 #include "takram/graphics/path_direction.h"
+#include "takram/graphics/segment_range.h"
 #include "takram/math/constants.h"
 #include "takram/math/promotion.h"
 #include "takram/math/rectangle.h"
@@ -122,6 +123,10 @@ class Path<T, 2> final {
   const std::list<Command2<T>>& commands() const { return commands_; }
   std::list<Command2<T>>& commands() { return commands_; }
 
+  // Segments
+  SegmentRange<T, ConstIterator> segments() const;
+  SegmentRange<T, Iterator> segments();
+
   // Direction
   PathDirection direction() const;
   Path& reverse();
@@ -159,28 +164,6 @@ class Path<T, 2> final {
   Rect2<U> calculateApproximateBounds() const;
   template <class U = math::Promote<T>>
   Rect2<U> calculatePreciseBounds() const;
-  template <class OutputIterator>
-  unsigned int findQuadraticExtrema(const Vec2<T>& p0,
-                                    const Vec2<T>& p1,
-                                    const Vec2<T>& p2,
-                                    OutputIterator result) const;
-  template <class OutputIterator>
-  unsigned int findCubicExtrema(const Vec2<T>& p0,
-                                const Vec2<T>& p1,
-                                const Vec2<T>& p2,
-                                const Vec2<T>& p3,
-                                OutputIterator result) const;
-  template <class U = math::Promote<T>>
-  Vec2<U> evaluateQuadraticAt(const Vec2<T>& p0,
-                              const Vec2<T>& p1,
-                              const Vec2<T>& p2,
-                              U t) const;
-  template <class U = math::Promote<T>>
-  Vec2<U> evaluateCubicAt(const Vec2<T>& p0,
-                          const Vec2<T>& p1,
-                          const Vec2<T>& p2,
-                          const Vec2<T>& p3,
-                          U t) const;
 
   // Conversion
   template <
@@ -307,141 +290,22 @@ inline Rect2<U> Path<T, 2>::calculatePreciseBounds() const {
     return Rect2<U>();
   }
   Rect2<U> result(commands_.front().point());
-  Vec2<U> extrema[4];
-  for (auto current = std::begin(commands_), previous = current++;
-       current != std::end(commands_); ++current, ++previous) {
-    switch (current->type()) {
-      case CommandType::CUBIC: {
-        result.include(current->point());
-        const auto count = findCubicExtrema(
-            previous->point(),
-            current->control1(),
-            current->control2(),
-            current->point(),
-            extrema);
-        for (int i{}; i < count; ++i) {
-          result.include(extrema[i]);
-        }
-        break;
-      }
-      case CommandType::CONIC: {
-        // TODO(shotamatsuda): Calculate conic extrema
-        result.include(current->control());
-        result.include(current->point());
-        break;
-      }
-      case CommandType::QUADRATIC: {
-        result.include(current->point());
-        const auto count = findQuadraticExtrema(
-            previous->point(),
-            current->control(),
-            current->point(),
-            extrema);
-        for (int i{}; i < count; ++i) {
-          result.include(extrema[i]);
-        }
-        break;
-      }
-      case CommandType::LINE:
-        result.include(current->point());
-        break;
-      case CommandType::MOVE:
-      case CommandType::CLOSE:
-        break;
-      default:
-        assert(false);
-        break;
+  math::Promote<T> parameters[4];
+  for (const auto& segment : segments()) {
+    result.include(segment.start());
+    result.include(segment.point());
+    if (segment.type() == CommandType::LINE) {
+      continue;
+    }
+    auto count = segment.findExtremaX(parameters);
+    count += segment.findExtremaY(parameters + count);
+    for (unsigned int i{}; i < count; ++i) {
+      result.include(segment.evaluateAt(parameters[i]));
     }
   }
   return std::move(result);
 }
 
-template <class T>
-template <class OutputIterator>
-inline unsigned int Path<T, 2>::findQuadraticExtrema(
-    const Vec2<T>& p0,
-    const Vec2<T>& p1,
-    const Vec2<T>& p2,
-    OutputIterator result) const {
-  const auto a = p0 - 2 * p1 + p2;
-  const auto b = p1 - p0;
-  math::Promote<T> x_root;
-  math::Promote<T> y_root;
-  const auto x_count = math::solveLinear(a.x, b.x, &x_root);
-  const auto y_count = math::solveLinear(a.y, b.y, &y_root);
-  unsigned int count{};
-  if(x_count > 0 && 0 < x_root && x_root < 1) {
-    *result++ = evaluateQuadraticAt(p0, p1, p2, x_root);
-    ++count;
-  }
-  if(y_count > 0 && 0 < y_root && y_root < 1) {
-    *result = evaluateQuadraticAt(p0, p1, p2, y_root);
-    ++count;
-  }
-  return count;
-}
-
-template <class T>
-template <class OutputIterator>
-inline unsigned int Path<T, 2>::findCubicExtrema(
-    const Vec2<T>& p0,
-    const Vec2<T>& p1,
-    const Vec2<T>& p2,
-    const Vec2<T>& p3,
-    OutputIterator result) const {
-  const auto a = 3 * p3 - 9 * p2 + 9 * p1 - 3 * p0;
-  const auto b = 6 * p0 - 12 * p1 + 6 * p2;
-  const auto c = 3 * p1 - 3 * p0;
-  math::Promote<T> x_roots[2];
-  math::Promote<T> y_roots[2];
-  const auto x_count = math::solveQuadratic(a.x, b.x, c.x, x_roots);
-  const auto y_count = math::solveQuadratic(a.y, b.y, c.y, y_roots);
-  unsigned int count{};
-  if(x_count > 0 && 0 < x_roots[0] && x_roots[0] < 1) {
-    *result++ = evaluateCubicAt(p0, p1, p2, p3, x_roots[0]);
-    ++count;
-  }
-  if(y_count > 0 && 0 < y_roots[0] && y_roots[0] < 1) {
-    *result++ = evaluateCubicAt(p0, p1, p2, p3, y_roots[0]);
-    ++count;
-  }
-  if(x_count > 1 && 0 < x_roots[1] && x_roots[1] < 1) {
-    *result++ = evaluateCubicAt(p0, p1, p2, p3, x_roots[1]);
-    ++count;
-  }
-  if(y_count > 1 && 0 < y_roots[1] && y_roots[1] < 1) {
-    *result = evaluateCubicAt(p0, p1, p2, p3, y_roots[1]);
-    ++count;
-  }
-  return count;
-}
-
-template <class T>
-template <class U>
-inline Vec2<U> Path<T, 2>::evaluateQuadraticAt(const Vec2<T>& p0,
-                                               const Vec2<T>& p1,
-                                               const Vec2<T>& p2,
-                                               U t) const {
-  const auto a = (1 - t) * (1 - t);
-  const auto b = 2 * (1 - t) * t;
-  const auto c = t * t;
-  return a * p0 + b * p1 + c * p2;
-}
-
-template <class T>
-template <class U>
-inline Vec2<U> Path<T, 2>::evaluateCubicAt(const Vec2<T>& p0,
-                                           const Vec2<T>& p1,
-                                           const Vec2<T>& p2,
-                                           const Vec2<T>& p3,
-                                           U t) const {
-  const auto a = (1 - t) * (1 - t) * (1 - t);
-  const auto b = 3 * (1 - t) * (1 - t) * t;
-  const auto c = 3 * (1 - t) * t * t;
-  const auto d = t * t * t;
-  return a * p0 + b * p1 + c * p2 + d * p3;
-}
-
 #pragma mark Adding commands
 
 template <class T>
@@ -647,23 +511,37 @@ inline Path2<T> Path<T, 2>::reversed() const {
   return std::move(Path(*this).reverse());
 }
 
+#pragma mark Segments
+
+template <class T>
+inline SegmentRange<T, typename Path<T, 2>::ConstIterator>
+    Path<T, 2>::segments() const {
+  return SegmentRange<T, ConstIterator>(std::begin(commands_),
+                                        std::end(commands_));
+}
+
+template <class T>
+inline SegmentRange<T, typename Path<T, 2>::Iterator> Path<T, 2>::segments() {
+  return SegmentRange<T, Iterator>(std::begin(commands_), std::end(commands_));
+}
+
 #pragma mark Conversion
 
 template <class T>
 inline bool Path<T, 2>::convertQuadraticsToCubics() {
   bool changed{};
-  for (auto current = std::begin(commands_), previous = current++;
-       current != std::end(commands_);) {
-    if (current->type() != CommandType::QUADRATIC) {
-      previous = current++;
+  const auto range = segments();
+  for (auto itr = std::begin(range); itr != std::end(range); ++itr) {
+    if (itr->type() != CommandType::QUADRATIC) {
       continue;
     }
-    const auto a = previous->point();
-    const auto b = current->control();
-    const auto c = current->point();
-    current->type() = CommandType::CUBIC;
-    current->control1() = a + (b - a) * 2 / 3;
-    current->control2() = c + (b - c) * 2 / 3;
+    auto& command = *itr.base();
+    const auto a = itr->start();
+    const auto b = itr->control();
+    const auto c = itr->point();
+    command.type() = CommandType::CUBIC;
+    command.control1() = a + (b - a) * 2 / 3;
+    command.control2() = c + (b - c) * 2 / 3;
     changed = true;
   }
   return changed;
@@ -691,23 +569,27 @@ inline bool Path<T, 2>::convertConicsToQuadratics(Method method,
                                                   Args&&... args) {
   assert(method);
   bool changed{};
-  for (auto current = std::begin(commands_), previous = current++;
-       current != std::end(commands_);) {
-    if (current->type() != CommandType::CONIC) {
-      previous = current++;
+  const auto range = segments();
+  for (auto itr = std::begin(range); itr != std::end(range); ++itr) {
+    if (itr->type() != CommandType::CONIC) {
       continue;
     }
-    const Conic2<T> conic(previous->point(),
-                          current->control(),
-                          current->point(),
-                          current->weight());
+    const Conic2<T> conic(itr->start(),
+                          itr->control(),
+                          itr->point(),
+                          itr->weight());
     const auto points = (conic.*method)(args...);
-    current = commands_.erase(current);
-    for (auto itr = std::begin(points); itr != std::end(points); ++itr) {
-      current = commands_.emplace(current, CommandType::QUADRATIC,
-                                  *itr, *(++itr));
-      previous = current++;
+    assert(points.size() >= 2 && points.size() % 2 == 0);
+
+    // Insert all but the last quadratic before the conic, and replace the
+    // conic itself with the last one so that the iterator stays valid.
+    auto& command = *itr.base();
+    auto point = std::begin(points);
+    for (; std::next(point, 2) != std::end(points); point += 2) {
+      commands_.emplace(itr.base(), CommandType::QUADRATIC,
+                        *point, *std::next(point));
     }
+    command = Command2<T>(CommandType::QUADRATIC, *point, *std::next(point));
     changed = true;
   }
   return changed;
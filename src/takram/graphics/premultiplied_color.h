@@ -0,0 +1,261 @@
+//
+//  takram/graphics/premultiplied_color.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_PREMULTIPLIED_COLOR_H_
+#define TAKRAM_GRAPHICS_PREMULTIPLIED_COLOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/image_view.h"
+#include "takram/math/enablers.h"
+
+namespace takram {
+namespace graphics {
+
+// A color whose red, green and blue channels are multiplied by its alpha,
+// which is the form compositing operates on. It has the same layout as
+// Color4, so that buffers of either can be reinterpreted as channel values.
+// Integer channels are multiplied and divided with rounding to the nearest,
+// using an exact division by 255 for 8-bit channels.
+
+template <class T>
+class PremultipliedColor final {
+ public:
+  using Type = T;
+  static constexpr const int channels = 4;
+
+ public:
+  PremultipliedColor();
+  PremultipliedColor(T red, T green, T blue, T alpha);
+  explicit PremultipliedColor(const Color4<T>& color);
+
+  // Copy semantics
+  PremultipliedColor(const PremultipliedColor&) = default;
+  PremultipliedColor& operator=(const PremultipliedColor&) = default;
+
+  // Conversion
+  Color4<T> color() const;
+
+  // Pointer
+  T * pointer() { return &r; }
+  const T * pointer() const { return &r; }
+
+ public:
+  T r;
+  T g;
+  T b;
+  T a;
+};
+
+// Comparison
+template <class T>
+bool operator==(const PremultipliedColor<T>& lhs,
+                const PremultipliedColor<T>& rhs);
+template <class T>
+bool operator!=(const PremultipliedColor<T>& lhs,
+                const PremultipliedColor<T>& rhs);
+
+// Stream
+template <class T>
+std::ostream& operator<<(std::ostream& os,
+                         const PremultipliedColor<T>& color);
+
+// Buffers, and images converted in place
+template <class T>
+void premultiply(const Color4<T> *colors,
+                 std::size_t size,
+                 PremultipliedColor<T> *result);
+template <class T>
+void unpremultiply(const PremultipliedColor<T> *colors,
+                   std::size_t size,
+                   Color4<T> *result);
+template <class T>
+void premultiply(ImageView<T, 4> image);
+template <class T>
+void unpremultiply(ImageView<T, 4> image);
+
+using PremultipliedColor4u = PremultipliedColor<std::uint8_t>;
+using PremultipliedColor4s = PremultipliedColor<std::uint16_t>;
+using PremultipliedColor4f = PremultipliedColor<float>;
+using PremultipliedColor4d = PremultipliedColor<double>;
+
+#pragma mark -
+
+namespace detail {
+
+// Divides by 255 rounding to the nearest, exactly for values up to 255 * 255
+inline std::uint32_t divide255(std::uint32_t value) {
+  value += 128;
+  return (value + (value >> 8)) >> 8;
+}
+
+// The product of two channel values, as a channel value
+template <class T>
+inline EnableIfFloating<T, T> multiplyChannels(T a, T b) {
+  return a * b;
+}
+
+template <class T>
+inline EnableIfIntegral<T, T> multiplyChannels(T a, T b) {
+  const std::uint64_t max = Depth<T>::max;
+  return static_cast<T>((static_cast<std::uint64_t>(a) * b + max / 2) / max);
+}
+
+inline std::uint8_t multiplyChannels(std::uint8_t a, std::uint8_t b) {
+  return static_cast<std::uint8_t>(divide255(a * b));
+}
+
+// The quotient of two channel values, as a channel value, saturated to the
+// maximum and zero when the divisor is zero
+template <class T>
+inline EnableIfFloating<T, T> divideChannels(T a, T b) {
+  return b ? a / b : T();
+}
+
+template <class T>
+inline EnableIfIntegral<T, T> divideChannels(T a, T b) {
+  if (!b) {
+    return T();
+  }
+  const std::uint64_t max = Depth<T>::max;
+  return static_cast<T>(std::min<std::uint64_t>(
+      (static_cast<std::uint64_t>(a) * max + b / 2) / b, max));
+}
+
+}  // namespace detail
+
+template <class T>
+inline PremultipliedColor<T>::PremultipliedColor() : r(), g(), b(), a() {}
+
+template <class T>
+inline PremultipliedColor<T>::PremultipliedColor(T red,
+                                                 T green,
+                                                 T blue,
+                                                 T alpha)
+    : r(red),
+      g(green),
+      b(blue),
+      a(alpha) {}
+
+template <class T>
+inline PremultipliedColor<T>::PremultipliedColor(const Color4<T>& color)
+    : r(detail::multiplyChannels(color.r, color.a)),
+      g(detail::multiplyChannels(color.g, color.a)),
+      b(detail::multiplyChannels(color.b, color.a)),
+      a(color.a) {}
+
+#pragma mark Conversion
+
+template <class T>
+inline Color4<T> PremultipliedColor<T>::color() const {
+  return Color4<T>(detail::divideChannels(r, a),
+                   detail::divideChannels(g, a),
+                   detail::divideChannels(b, a),
+                   a);
+}
+
+#pragma mark Comparison
+
+template <class T>
+inline bool operator==(const PremultipliedColor<T>& lhs,
+                       const PremultipliedColor<T>& rhs) {
+  return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b && lhs.a == rhs.a;
+}
+
+template <class T>
+inline bool operator!=(const PremultipliedColor<T>& lhs,
+                       const PremultipliedColor<T>& rhs) {
+  return !(lhs == rhs);
+}
+
+#pragma mark Stream
+
+template <class T>
+inline std::ostream& operator<<(std::ostream& os,
+                                const PremultipliedColor<T>& color) {
+  return os << Color4<T>(color.r, color.g, color.b, color.a);
+}
+
+#pragma mark Buffers
+
+template <class T>
+inline void premultiply(const Color4<T> *colors,
+                        std::size_t size,
+                        PremultipliedColor<T> *result) {
+  for (std::size_t i{}; i < size; ++i) {
+    result[i] = PremultipliedColor<T>(colors[i]);
+  }
+}
+
+template <class T>
+inline void unpremultiply(const PremultipliedColor<T> *colors,
+                          std::size_t size,
+                          Color4<T> *result) {
+  for (std::size_t i{}; i < size; ++i) {
+    result[i] = colors[i].color();
+  }
+}
+
+template <class T>
+inline void premultiply(ImageView<T, 4> image) {
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      const PremultipliedColor<T> color(image.pixel(x, y));
+      image.setPixel(x, y, Color4<T>(color.r, color.g, color.b, color.a));
+    }
+  }
+}
+
+template <class T>
+inline void unpremultiply(ImageView<T, 4> image) {
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      const auto pixel = image.pixel(x, y);
+      image.setPixel(x, y, PremultipliedColor<T>(
+          pixel.r, pixel.g, pixel.b, pixel.a).color());
+    }
+  }
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::PremultipliedColor;
+using graphics::PremultipliedColor4u;
+using graphics::PremultipliedColor4s;
+using graphics::PremultipliedColor4f;
+using graphics::PremultipliedColor4d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_PREMULTIPLIED_COLOR_H_
@@ -0,0 +1,387 @@
+//
+//  takram/graphics/projector2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_PROJECTOR2_H_
+#define TAKRAM_GRAPHICS_PROJECTOR2_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/monotone_segments.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/promotion.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+template <class T, int D>
+class Projector;
+
+template <class T>
+using Projector2 = Projector<T, 2>;
+
+// Finds the nearest points on the segments of a path or shape. Segments are
+// decomposed into monotone pieces once, and each query walks their hierarchy
+// of bounds nearest first, skipping the pieces whose bounds are farther than
+// the nearest point found so far. The remaining pieces are subdivided in the
+// same manner, and the projections onto the chords of nearly straight ones
+// are refined by Newton's method on the derivative of the squared distance.
+// Segments are kept in floating point, so that the bounds of subdivisions
+// of integral segments are not rounded.
+
+template <class T>
+class Projector<T, 2> final {
+ public:
+  using Type = T;
+  static constexpr const int dimensions = 2;
+
+  // The index is that of a segment in the order of segments(), and the
+  // parameter is on that segment. Projections onto nothing have an infinite
+  // distance.
+  struct Projection {
+    Vec2<math::Promote<T>> point;
+    std::size_t index;
+    math::Promote<T> t;
+    math::Promote<T> distance;
+  };
+
+ public:
+  Projector() = default;
+  explicit Projector(const Path2<T>& path);
+  explicit Projector(const Shape2<T>& shape);
+
+  // Copy semantics
+  Projector(const Projector&) = default;
+  Projector& operator=(const Projector&) = default;
+
+  // Mutators
+  void set(const Path2<T>& path);
+  void set(const Shape2<T>& shape);
+  void reset();
+
+  // Attributes
+  bool empty() const { return segments_.empty(); }
+
+  // Projection
+  Projection nearest(const Vec2<math::Promote<T>>& point) const;
+  std::vector<Projection> nearest(
+      const std::vector<Vec2<math::Promote<T>>>& points) const;
+  static Projection nearest(const Segment2<T>& segment,
+                            const Vec2<math::Promote<T>>& point);
+
+ private:
+  using Real = math::Promote<T>;
+
+  template <class Range>
+  void set(const Range& range);
+  static Segment2<Real> promote(const Segment2<T>& segment);
+  static void project(const Segment2<Real>& segment,
+                      Real t1, Real t2,
+                      const Vec2<Real>& point,
+                      Projection *projection,
+                      unsigned int depth = 0);
+  static void refine(const Segment2<Real>& segment,
+                     Real t1, Real t2,
+                     const Vec2<Real>& point,
+                     Projection *projection);
+  static bool flat(const Segment2<Real>& segment);
+  static Real distance(const Rect2<Real>& rect, const Vec2<Real>& point);
+
+ private:
+  std::vector<Segment2<Real>> segments_;
+  MonotoneSegments2<T> pieces_;
+};
+
+using Projector2i = Projector2<int>;
+using Projector2f = Projector2<float>;
+using Projector2d = Projector2<double>;
+
+#pragma mark -
+
+template <class T>
+inline Projector<T, 2>::Projector(const Path2<T>& path) {
+  set(path);
+}
+
+template <class T>
+inline Projector<T, 2>::Projector(const Shape2<T>& shape) {
+  set(shape);
+}
+
+#pragma mark Mutators
+
+template <class T>
+inline void Projector<T, 2>::set(const Path2<T>& path) {
+  set(path.segments());
+}
+
+template <class T>
+inline void Projector<T, 2>::set(const Shape2<T>& shape) {
+  set(shape.segments());
+}
+
+template <class T>
+template <class Range>
+inline void Projector<T, 2>::set(const Range& range) {
+  segments_.clear();
+  for (const auto& segment : range) {
+    segments_.emplace_back(promote(segment));
+  }
+  pieces_.set(range);
+}
+
+template <class T>
+inline void Projector<T, 2>::reset() {
+  segments_.clear();
+  pieces_.reset();
+}
+
+#pragma mark Projection
+
+template <class T>
+inline typename Projector<T, 2>::Projection Projector<T, 2>::nearest(
+    const Vec2<Real>& point) const {
+  Projection result{Vec2<Real>(), 0, 0, std::numeric_limits<Real>::max()};
+  if (pieces_.empty()) {
+    result.distance = std::numeric_limits<Real>::infinity();
+    return result;
+  }
+  // The pieces of integral segments have their points truncated, which moves
+  // them by less than a unit along each axis, so that their bounds can be
+  // nearer than the curves by up to the diagonal of a unit square.
+  static const Real slack = std::is_integral<T>::value ? std::sqrt(2) : 0;
+  pieces_.nearest(point, [&](std::size_t index) {
+    const auto& piece = pieces_[index];
+    Projection projection{result};
+    project(segments_[piece.index], piece.begin, piece.end, point,
+            &projection);
+    if (projection.distance < result.distance) {
+      result = projection;
+      result.index = piece.index;
+    }
+    return result.distance + slack;
+  });
+  return result;
+}
+
+template <class T>
+inline std::vector<typename Projector<T, 2>::Projection>
+    Projector<T, 2>::nearest(const std::vector<Vec2<Real>>& points) const {
+  std::vector<Projection> result(points.size());
+  parallelFor(points.size(), [&](std::size_t index) {
+    result[index] = nearest(points[index]);
+  });
+  return result;
+}
+
+template <class T>
+inline typename Projector<T, 2>::Projection Projector<T, 2>::nearest(
+    const Segment2<T>& segment,
+    const Vec2<Real>& point) {
+  Projection result{Vec2<Real>(), 0, 0, std::numeric_limits<Real>::max()};
+  project(promote(segment), 0, 1, point, &result);
+  return result;
+}
+
+template <class T>
+inline Segment2<typename Projector<T, 2>::Real> Projector<T, 2>::promote(
+    const Segment2<T>& segment) {
+  const auto convert = [](const Vec2<T>& point) {
+    return Vec2<Real>(point.x, point.y);
+  };
+  const Command2<Real> command(segment.type(),
+                               convert(segment.control1()),
+                               convert(segment.control2()),
+                               convert(segment.point()));
+  Segment2<Real> result(convert(segment.start()), command);
+  result.weight() = segment.weight();
+  return result;
+}
+
+template <class T>
+inline void Projector<T, 2>::project(const Segment2<Real>& segment,
+                                     Real t1, Real t2,
+                                     const Vec2<Real>& point,
+                                     Projection *projection,
+                                     unsigned int depth) {
+  assert(projection);
+  static const unsigned int max_depth = 24;
+  static const auto epsilon = std::sqrt(std::numeric_limits<Real>::epsilon());
+  if (segment.type() == CommandType::LINE) {
+    refine(segment, t1, t2, point, projection);
+    return;
+  }
+  // Branch and bound: the bounds of a piece limit how near it can be, and
+  // pieces are subdivided, nearer halves first, until that limit is no
+  // better than the nearest point found. Nearly straight pieces are refined
+  // on the way, which quickly gives a tight distance to prune with.
+  const auto subsegment = segment.subsegment(t1, t2);
+  const auto bound = distance(subsegment.bounds(), point);
+  if (bound >= projection->distance * (1 - epsilon)) {
+    return;
+  }
+  if (depth >= max_depth || flat(subsegment)) {
+    refine(segment, t1, t2, point, projection);
+    if (depth >= max_depth ||
+        bound >= projection->distance * (1 - epsilon)) {
+      return;
+    }
+  }
+  const auto middle = (t1 + t2) / 2;
+  const auto first = distance(segment.subsegment(t1, middle).bounds(), point);
+  const auto second = distance(segment.subsegment(middle, t2).bounds(), point);
+  if (first <= second) {
+    project(segment, t1, middle, point, projection, depth + 1);
+    project(segment, middle, t2, point, projection, depth + 1);
+  } else {
+    project(segment, middle, t2, point, projection, depth + 1);
+    project(segment, t1, middle, point, projection, depth + 1);
+  }
+}
+
+template <class T>
+inline void Projector<T, 2>::refine(const Segment2<Real>& segment,
+                                    Real t1, Real t2,
+                                    const Vec2<Real>& point,
+                                    Projection *projection) {
+  assert(projection);
+  const auto squared = [&](Real t) {
+    const auto offset = segment.evaluateAt(t) - point;
+    return offset.x * offset.x + offset.y * offset.y;
+  };
+
+  // Start from the projection onto the chord
+  const auto start = segment.evaluateAt(t1);
+  const auto chord = segment.evaluateAt(t2) - start;
+  const auto length = chord.x * chord.x + chord.y * chord.y;
+  Real t{t1};
+  if (length) {
+    const auto offset = point - start;
+    const auto s = std::min<Real>(std::max<Real>(
+        (offset.x * chord.x + offset.y * chord.y) / length, 0), 1);
+    t = t1 + (t2 - t1) * s;
+  }
+  auto best = squared(t);
+  if (segment.type() != CommandType::LINE) {
+    // Newton's method on the derivative of the squared distance, whose own
+    // derivative takes the second derivative of the curve from differences
+    // of the first.
+    const auto step = (t2 - t1) * 1e-4;
+    for (int i{}; i < 16; ++i) {
+      const auto offset = segment.evaluateAt(t) - point;
+      const auto d1 = segment.derivativeAt(t);
+      const auto d2 = (segment.derivativeAt(t + step) -
+                       segment.derivativeAt(t - step)) / (2 * step);
+      const auto f = offset.x * d1.x + offset.y * d1.y;
+      auto df = d1.x * d1.x + d1.y * d1.y + offset.x * d2.x + offset.y * d2.y;
+      if (df <= 0) {
+        df = d1.x * d1.x + d1.y * d1.y;
+      }
+      if (!df) {
+        break;
+      }
+      // Halve steps that overshoot
+      auto delta = -f / df;
+      auto next = t;
+      auto value = best;
+      for (int j{}; j < 16 && value >= best; ++j, delta /= 2) {
+        next = std::min(std::max(t + delta, t1), t2);
+        value = squared(next);
+      }
+      if (value >= best) {
+        break;
+      }
+      t = next;
+      best = value;
+    }
+  }
+  const auto distance = std::sqrt(best);
+  if (distance < projection->distance) {
+    projection->point = segment.evaluateAt(t);
+    projection->t = t;
+    projection->distance = distance;
+  }
+}
+
+template <class T>
+inline bool Projector<T, 2>::flat(const Segment2<Real>& segment) {
+  // Control points within a sixteenth of the chord from it, and between its
+  // ends along it, so that the curve does not turn back
+  if (segment.type() == CommandType::LINE) {
+    return true;
+  }
+  const auto& start = segment.start();
+  const auto chord = segment.point() - start;
+  const auto length = chord.x * chord.x + chord.y * chord.y;
+  const auto near = [&](const Vec2<Real>& point) {
+    const auto offset = point - start;
+    const auto along = chord.x * offset.x + chord.y * offset.y;
+    return (std::abs(chord.cross(offset)) <= length / 16 &&
+            0 <= along && along <= length);
+  };
+  if (!length || !near(segment.control1())) {
+    return false;
+  }
+  return segment.type() != CommandType::CUBIC || near(segment.control2());
+}
+
+template <class T>
+inline typename Projector<T, 2>::Real Projector<T, 2>::distance(
+    const Rect2<Real>& rect,
+    const Vec2<Real>& point) {
+  const auto dx = std::max<Real>({rect.minX() - point.x, 0,
+                                  point.x - rect.maxX()});
+  const auto dy = std::max<Real>({rect.minY() - point.y, 0,
+                                  point.y - rect.maxY()});
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Projector;
+using graphics::Projector2;
+using graphics::Projector2i;
+using graphics::Projector2f;
+using graphics::Projector2d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_PROJECTOR2_H_
@@ -0,0 +1,471 @@
+//
+//  takram/graphics/rect_clipper2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_RECT_CLIPPER2_H_
+#define TAKRAM_GRAPHICS_RECT_CLIPPER2_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <type_traits>
+#include <vector>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/promotion.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+template <class T, int D>
+class RectClipper;
+
+template <class T>
+using RectClipper2 = RectClipper<T, 2>;
+
+// Clips paths against an axis-aligned rectangle, one edge at a time. Curves
+// are split where they cross an edge rather than flattened. Closed paths are
+// clipped for filling: portions outside an edge are replaced by lines along
+// that edge, so that the winding inside the rectangle is preserved. Each
+// subpath of a closed path is clipped on its own, and those left are joined
+// back into one path. Open paths are clipped for stroking and may break into
+// several paths. Points on the edges of the rectangle are rounded to the
+// nearest integer for integral types.
+
+template <class T>
+class RectClipper<T, 2> final {
+ public:
+  using Type = T;
+  static constexpr const int dimensions = 2;
+
+ public:
+  RectClipper() = default;
+  explicit RectClipper(const Rect2<math::Promote<T>>& rect);
+
+  // Copy semantics
+  RectClipper(const RectClipper&) = default;
+  RectClipper& operator=(const RectClipper&) = default;
+
+  // Properties
+  const Rect2<math::Promote<T>>& rect() const { return rect_; }
+  Rect2<math::Promote<T>>& rect() { return rect_; }
+
+  // Clipping
+  Shape2<T> clip(const Path2<T>& path) const;
+  Shape2<T> clip(const Shape2<T>& shape) const;
+
+  // Tiling
+  static std::vector<Shape2<T>> clip(
+      const Shape2<T>& shape,
+      const std::vector<Rect2<math::Promote<T>>>& rects);
+  static std::vector<Shape2<T>> tile(
+      const Shape2<T>& shape,
+      const Rect2<math::Promote<T>>& area,
+      int columns,
+      int rows);
+
+ private:
+  using Real = math::Promote<T>;
+
+  struct Edge {
+    template <class U>
+    bool contains(const Vec2<U>& point) const;
+    Vec2<T> project(const Vec2<T>& point) const;
+    int axis;
+    Real value;
+    bool greater;
+  };
+
+  void clip(const Path2<T>& path,
+            const Rect2<Real>& bounds,
+            std::list<Path2<T>> *result) const;
+  static bool clipClosed(const Path2<T>& path,
+                         const Edge& edge,
+                         Path2<T> *result);
+  static void clipOpen(const Path2<T>& path,
+                       const Edge& edge,
+                       std::list<Path2<T>> *result);
+  static Segment2<T> piece(const Segment2<T>& segment,
+                           const Edge& edge,
+                           Real t1,
+                           Real t2);
+  static unsigned int solve(const Segment2<T>& segment,
+                            const Edge& edge,
+                            Real *roots);
+  static T demote(Real value);
+
+ private:
+  Rect2<Real> rect_;
+};
+
+using RectClipper2i = RectClipper2<int>;
+using RectClipper2f = RectClipper2<float>;
+using RectClipper2d = RectClipper2<double>;
+
+#pragma mark -
+
+template <class T>
+inline RectClipper<T, 2>::RectClipper(const Rect2<math::Promote<T>>& rect)
+    : rect_(rect) {}
+
+#pragma mark Clipping
+
+template <class T>
+inline Shape2<T> RectClipper<T, 2>::clip(const Path2<T>& path) const {
+  Shape2<T> result;
+  clip(path, path.bounds(), &result.paths());
+  return result;
+}
+
+template <class T>
+inline Shape2<T> RectClipper<T, 2>::clip(const Shape2<T>& shape) const {
+  Shape2<T> result;
+  for (const auto& path : shape.paths()) {
+    clip(path, path.bounds(), &result.paths());
+  }
+  return result;
+}
+
+template <class T>
+inline void RectClipper<T, 2>::clip(const Path2<T>& path,
+                                    const Rect2<Real>& bounds,
+                                    std::list<Path2<T>> *result) const {
+  assert(result);
+  if (path.empty() ||
+      bounds.maxX() < rect_.minX() || bounds.minX() > rect_.maxX() ||
+      bounds.maxY() < rect_.minY() || bounds.minY() > rect_.maxY()) {
+    return;
+  }
+  if (bounds.minX() >= rect_.minX() && bounds.maxX() <= rect_.maxX() &&
+      bounds.minY() >= rect_.minY() && bounds.maxY() <= rect_.maxY()) {
+    result->emplace_back(path);
+    return;
+  }
+  const Edge edges[] = {
+    {0, rect_.minX(), true},
+    {0, rect_.maxX(), false},
+    {1, rect_.minY(), true},
+    {1, rect_.maxY(), false}
+  };
+  if (path.closed()) {
+    const auto& commands = path.commands();
+    Path2<T> clipped;
+    Path2<T> current;
+    Path2<T> next;
+    for (auto itr = std::begin(commands); itr != std::end(commands);) {
+      const auto end = std::find_if(
+          std::next(itr), std::end(commands), [](const Command2<T>& command) {
+            return command.type() == CommandType::MOVE;
+          });
+      current.commands().assign(itr, end);
+      itr = end;
+      bool inside = true;
+      for (const auto& edge : edges) {
+        if (!clipClosed(current, edge, &next)) {
+          inside = false;
+          break;
+        }
+        current.commands().swap(next.commands());
+      }
+      if (inside) {
+        clipped.commands().splice(std::end(clipped.commands()),
+                                  current.commands());
+      }
+    }
+    if (!clipped.empty()) {
+      result->emplace_back();
+      result->back().commands().swap(clipped.commands());
+    }
+  } else {
+    std::list<Path2<T>> current{path};
+    std::list<Path2<T>> next;
+    for (const auto& edge : edges) {
+      for (const auto& part : current) {
+        clipOpen(part, edge, &next);
+      }
+      current.swap(next);
+      next.clear();
+    }
+    result->splice(std::end(*result), current);
+  }
+}
+
+template <class T>
+inline bool RectClipper<T, 2>::clipClosed(const Path2<T>& path,
+                                          const Edge& edge,
+                                          Path2<T> *result) {
+  assert(result);
+  const auto& commands = path.commands();
+  if (commands.empty()) {
+    return false;
+  }
+  // The control polygon contains the curves, which is enough to accept or
+  // reject the whole path without solving anything.
+  const auto bounds = path.bounds();
+  const auto min = edge.axis ? bounds.minY() : bounds.minX();
+  const auto max = edge.axis ? bounds.maxY() : bounds.maxX();
+  if (edge.greater ? min >= edge.value : max <= edge.value) {
+    *result = path;
+    return true;
+  }
+  if (edge.greater ? max <= edge.value : min >= edge.value) {
+    return false;
+  }
+  std::list<Command2<T>> output;
+  const auto first = commands.front().point();
+  output.emplace_back(CommandType::MOVE, edge.project(first));
+  bool inside{};
+  bool along{};  // Whether the last command is a line along the edge
+  const auto process = [&](const Segment2<T>& segment) {
+    Real roots[3];
+    const auto count = solve(segment, edge, roots);
+    Real t1{};
+    for (unsigned int i{}; i <= count; ++i) {
+      const Real t2 = i < count ? roots[i] : 1;
+      const auto part = piece(segment, edge, t1, t2);
+      if (edge.contains(segment.evaluateAt((t1 + t2) / 2))) {
+        output.emplace_back(part.command());
+        inside = true;
+        along = false;
+      } else {
+        // Collinear lines along the edge are merged into one, since they
+        // make no difference to the winding inside.
+        const auto point = edge.project(part.point());
+        if (output.back().point() != point) {
+          if (along) {
+            output.back().point() = point;
+          } else {
+            output.emplace_back(CommandType::LINE, point);
+            along = true;
+          }
+        }
+      }
+      t1 = t2;
+    }
+  };
+  auto start = first;
+  for (auto itr = std::next(std::begin(commands));
+       itr != std::end(commands); ++itr) {
+    if (itr->type() == CommandType::CLOSE) {
+      break;
+    }
+    process(Segment2<T>(start, *itr));
+    start = itr->point();
+  }
+  if (start != first) {
+    process(Segment2<T>(start, Command2<T>(CommandType::LINE, first)));
+  }
+  if (!inside) {
+    return false;
+  }
+  output.emplace_back(CommandType::CLOSE);
+  result->commands().swap(output);
+  return true;
+}
+
+template <class T>
+inline void RectClipper<T, 2>::clipOpen(const Path2<T>& path,
+                                        const Edge& edge,
+                                        std::list<Path2<T>> *result) {
+  assert(result);
+  const auto& commands = path.commands();
+  if (commands.empty()) {
+    return;
+  }
+  const auto bounds = path.bounds();
+  const auto min = edge.axis ? bounds.minY() : bounds.minX();
+  const auto max = edge.axis ? bounds.maxY() : bounds.maxX();
+  if (edge.greater ? min >= edge.value : max <= edge.value) {
+    result->emplace_back(path);
+    return;
+  }
+  if (edge.greater ? max < edge.value : min > edge.value) {
+    return;
+  }
+  std::list<Command2<T>> output;
+  const auto flush = [&]() {
+    if (output.size() > 1) {
+      result->emplace_back();
+      result->back().commands().swap(output);
+    }
+    output.clear();
+  };
+  const auto first = commands.front().point();
+  if (edge.contains(first)) {
+    output.emplace_back(CommandType::MOVE, first);
+  }
+  auto start = first;
+  for (auto itr = std::next(std::begin(commands));
+       itr != std::end(commands); ++itr) {
+    const Segment2<T> segment(start, *itr);
+    Real roots[3];
+    const auto count = solve(segment, edge, roots);
+    Real t1{};
+    for (unsigned int i{}; i <= count; ++i) {
+      const Real t2 = i < count ? roots[i] : 1;
+      const auto part = piece(segment, edge, t1, t2);
+      if (edge.contains(segment.evaluateAt((t1 + t2) / 2))) {
+        if (output.empty()) {
+          output.emplace_back(CommandType::MOVE, part.start());
+        }
+        output.emplace_back(part.command());
+      } else {
+        flush();
+      }
+      t1 = t2;
+    }
+    start = itr->point();
+  }
+  flush();
+}
+
+template <class T>
+inline Segment2<T> RectClipper<T, 2>::piece(const Segment2<T>& segment,
+                                            const Edge& edge,
+                                            Real t1,
+                                            Real t2) {
+  // Snap the end points at crossings exactly onto the edge, so that adjacent
+  // pieces and the lines inserted along the edge meet without gaps.
+  auto result = segment.subsegment(t1, t2);
+  if (t1 > 0) {
+    (edge.axis ? result.start().y : result.start().x) = demote(edge.value);
+  }
+  if (t2 < 1) {
+    (edge.axis ? result.point().y : result.point().x) = demote(edge.value);
+  }
+  return result;
+}
+
+template <class T>
+inline unsigned int RectClipper<T, 2>::solve(const Segment2<T>& segment,
+                                             const Edge& edge,
+                                             Real *roots) {
+  if (edge.axis) {
+    return segment.solveY(edge.value, roots);
+  }
+  return segment.solveX(edge.value, roots);
+}
+
+template <class T>
+inline T RectClipper<T, 2>::demote(Real value) {
+  // Round rather than truncate, which would move the points on an edge of
+  // the rectangle off it by up to a unit toward zero
+  if (std::is_integral<T>::value) {
+    return static_cast<T>(std::round(value));
+  }
+  return static_cast<T>(value);
+}
+
+#pragma mark Tiling
+
+template <class T>
+inline std::vector<Shape2<T>> RectClipper<T, 2>::clip(
+    const Shape2<T>& shape,
+    const std::vector<Rect2<math::Promote<T>>>& rects) {
+  // Bounds are computed once and shared by every tile, so that each tile
+  // only touches the paths that overlap it.
+  std::vector<const Path2<T> *> paths;
+  std::vector<Rect2<Real>> bounds;
+  paths.reserve(shape.size());
+  bounds.reserve(shape.size());
+  for (const auto& path : shape.paths()) {
+    paths.emplace_back(&path);
+    bounds.emplace_back(path.bounds());
+  }
+  std::vector<Shape2<T>> result(rects.size());
+  parallelFor(rects.size(), [&](std::size_t index) {
+    const RectClipper clipper(rects[index]);
+    auto& output = result[index].paths();
+    for (std::size_t i{}; i < paths.size(); ++i) {
+      clipper.clip(*paths[i], bounds[i], &output);
+    }
+  });
+  return result;
+}
+
+template <class T>
+inline std::vector<Shape2<T>> RectClipper<T, 2>::tile(
+    const Shape2<T>& shape,
+    const Rect2<math::Promote<T>>& area,
+    int columns,
+    int rows) {
+  assert(columns > 0);
+  assert(rows > 0);
+  const auto width = (area.maxX() - area.minX()) / columns;
+  const auto height = (area.maxY() - area.minY()) / rows;
+  std::vector<Rect2<Real>> rects;
+  rects.reserve(columns * rows);
+  for (int row{}; row < rows; ++row) {
+    for (int column{}; column < columns; ++column) {
+      const Vec2<Real> min(area.minX() + width * column,
+                           area.minY() + height * row);
+      rects.emplace_back(min, Vec2<Real>(min.x + width, min.y + height));
+    }
+  }
+  return clip(shape, rects);
+}
+
+#pragma mark Edge
+
+template <class T>
+template <class U>
+inline bool RectClipper<T, 2>::Edge::contains(const Vec2<U>& point) const {
+  const Real coordinate = axis ? point.y : point.x;
+  return greater ? coordinate >= value : coordinate <= value;
+}
+
+template <class T>
+inline Vec2<T> RectClipper<T, 2>::Edge::project(const Vec2<T>& point) const {
+  if (contains(point)) {
+    return point;
+  }
+  const auto coordinate = demote(value);
+  return axis ? Vec2<T>(point.x, coordinate) : Vec2<T>(coordinate, point.y);
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::RectClipper;
+using graphics::RectClipper2;
+using graphics::RectClipper2i;
+using graphics::RectClipper2f;
+using graphics::RectClipper2d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_RECT_CLIPPER2_H_
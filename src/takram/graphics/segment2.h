@@ -0,0 +1,574 @@
+//
+//  takram/graphics/segment2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_SEGMENT2_H_
+#define TAKRAM_GRAPHICS_SEGMENT2_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/math/promotion.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/roots.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+template <class T, int D>
+class Segment;
+
+template <class T>
+using Segment2 = Segment<T, 2>;
+
+// A segment is a drawing command together with the point it starts from,
+// which is all that is needed to evaluate, split and solve a single curve.
+
+template <class T>
+class Segment<T, 2> final {
+ public:
+  using Type = T;
+  static constexpr const int dimensions = 2;
+
+ public:
+  Segment();
+  Segment(const Vec2<T>& start, const Command2<T>& command);
+
+  // Copy semantics
+  Segment(const Segment&) = default;
+  Segment& operator=(const Segment&) = default;
+
+  // Properties
+  const CommandType& type() const { return command_.type(); }
+  CommandType& type() { return command_.type(); }
+  const Vec2<T>& start() const { return start_; }
+  Vec2<T>& start() { return start_; }
+  const Vec2<T>& control() const { return command_.control(); }
+  Vec2<T>& control() { return command_.control(); }
+  const Vec2<T>& control1() const { return command_.control1(); }
+  Vec2<T>& control1() { return command_.control1(); }
+  const Vec2<T>& control2() const { return command_.control2(); }
+  Vec2<T>& control2() { return command_.control2(); }
+  const math::Promote<T>& weight() const { return command_.weight(); }
+  math::Promote<T>& weight() { return command_.weight(); }
+  const Vec2<T>& point() const { return command_.point(); }
+  Vec2<T>& point() { return command_.point(); }
+  const Command2<T>& command() const { return command_; }
+  Command2<T>& command() { return command_; }
+
+  // Attributes
+  Rect2<math::Promote<T>> bounds() const;
+
+  // Evaluation
+  Vec2<math::Promote<T>> evaluateAt(math::Promote<T> t) const;
+  Vec2<math::Promote<T>> derivativeAt(math::Promote<T> t) const;
+
+  // Direction
+  Segment& reverse();
+  Segment reversed() const;
+
+  // Subdivision
+  std::pair<Segment, Segment> split(math::Promote<T> t) const;
+  Segment subsegment(math::Promote<T> t1, math::Promote<T> t2) const;
+
+  // Roots
+  template <class OutputIterator>
+  unsigned int solveX(math::Promote<T> x, OutputIterator result) const;
+  template <class OutputIterator>
+  unsigned int solveY(math::Promote<T> y, OutputIterator result) const;
+
+  // Extrema
+  template <class OutputIterator>
+  unsigned int findExtremaX(OutputIterator result) const;
+  template <class OutputIterator>
+  unsigned int findExtremaY(OutputIterator result) const;
+
+ private:
+  using Real = math::Promote<T>;
+
+  template <class OutputIterator>
+  unsigned int solve(int axis, Real value, OutputIterator result) const;
+  template <class OutputIterator>
+  unsigned int findExtrema(int axis, OutputIterator result) const;
+  template <class OutputIterator>
+  static unsigned int output(Real *roots, int count, OutputIterator result);
+  static bool negligible(Real coefficient, std::initializer_list<Real> terms);
+  static Real coordinate(const Vec2<T>& point, int axis);
+  static Vec2<Real> promote(const Vec2<T>& point);
+  static Vec2<T> demote(const Vec2<Real>& point);
+
+ private:
+  Vec2<T> start_;
+  Command2<T> command_;
+};
+
+// Comparison
+template <class T, class U>
+bool operator==(const Segment2<T>& lhs, const Segment2<U>& rhs);
+template <class T, class U>
+bool operator!=(const Segment2<T>& lhs, const Segment2<U>& rhs);
+
+using Segment2i = Segment2<int>;
+using Segment2f = Segment2<float>;
+using Segment2d = Segment2<double>;
+
+#pragma mark -
+
+template <class T>
+inline Segment<T, 2>::Segment() : command_(CommandType::LINE) {}
+
+template <class T>
+inline Segment<T, 2>::Segment(const Vec2<T>& start,
+                              const Command2<T>& command)
+    : start_(start),
+      command_(command) {}
+
+#pragma mark Comparison
+
+template <class T, class U>
+inline bool operator==(const Segment2<T>& lhs, const Segment2<U>& rhs) {
+  return lhs.start() == rhs.start() && lhs.command() == rhs.command();
+}
+
+template <class T, class U>
+inline bool operator!=(const Segment2<T>& lhs, const Segment2<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+#pragma mark Attributes
+
+template <class T>
+inline Rect2<math::Promote<T>> Segment<T, 2>::bounds() const {
+  Rect2<Real> result(promote(start_));
+  switch (type()) {
+    case CommandType::CUBIC:
+      result.include(promote(control2()));
+      // Pass through
+    case CommandType::CONIC:
+    case CommandType::QUADRATIC:
+      result.include(promote(control()));
+      // Pass through
+    case CommandType::LINE:
+      result.include(promote(point()));
+      break;
+    case CommandType::MOVE:
+    case CommandType::CLOSE:
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  return result;
+}
+
+#pragma mark Evaluation
+
+template <class T>
+inline Vec2<math::Promote<T>> Segment<T, 2>::evaluateAt(Real t) const {
+  const auto p0 = promote(start_);
+  const auto u = 1 - t;
+  switch (type()) {
+    case CommandType::LINE:
+      return p0 * u + promote(point()) * t;
+    case CommandType::QUADRATIC:
+      return (p0 * (u * u) +
+              promote(control()) * (2 * u * t) +
+              promote(point()) * (t * t));
+    case CommandType::CONIC: {
+      const Real w = weight();
+      const auto a = u * u;
+      const auto b = 2 * w * u * t;
+      const auto c = t * t;
+      return ((p0 * a + promote(control()) * b + promote(point()) * c) /
+              (a + b + c));
+    }
+    case CommandType::CUBIC:
+      return (p0 * (u * u * u) +
+              promote(control1()) * (3 * u * u * t) +
+              promote(control2()) * (3 * u * t * t) +
+              promote(point()) * (t * t * t));
+    case CommandType::MOVE:
+    case CommandType::CLOSE:
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  return p0;
+}
+
+template <class T>
+inline Vec2<math::Promote<T>> Segment<T, 2>::derivativeAt(Real t) const {
+  const auto p0 = promote(start_);
+  const auto u = 1 - t;
+  switch (type()) {
+    case CommandType::LINE:
+      return promote(point()) - p0;
+    case CommandType::QUADRATIC: {
+      const auto p1 = promote(control());
+      return ((p1 - p0) * u + (promote(point()) - p1) * t) * 2;
+    }
+    case CommandType::CONIC: {
+      const Real w = weight();
+      const auto p1 = promote(control());
+      const auto p2 = promote(point());
+      const auto n = p0 * (u * u) + p1 * (2 * w * u * t) + p2 * (t * t);
+      const auto d = u * u + 2 * w * u * t + t * t;
+      const auto dn = (p0 * -u + p1 * (w * (1 - 2 * t)) + p2 * t) * 2;
+      const auto dd = 2 * (-u + w * (1 - 2 * t) + t);
+      return (dn * d - n * dd) / (d * d);
+    }
+    case CommandType::CUBIC: {
+      const auto p1 = promote(control1());
+      const auto p2 = promote(control2());
+      return ((p1 - p0) * (u * u) +
+              (p2 - p1) * (2 * u * t) +
+              (promote(point()) - p2) * (t * t)) * 3;
+    }
+    case CommandType::MOVE:
+    case CommandType::CLOSE:
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  return Vec2<Real>();
+}
+
+#pragma mark Direction
+
+template <class T>
+inline Segment2<T>& Segment<T, 2>::reverse() {
+  if (type() == CommandType::CUBIC) {
+    std::swap(control1(), control2());
+  }
+  std::swap(start_, point());
+  return *this;
+}
+
+template <class T>
+inline Segment2<T> Segment<T, 2>::reversed() const {
+  return Segment(*this).reverse();
+}
+
+#pragma mark Subdivision
+
+template <class T>
+inline std::pair<Segment2<T>, Segment2<T>> Segment<T, 2>::split(Real t) const {
+  const auto p0 = promote(start_);
+  const auto p3 = promote(point());
+  switch (type()) {
+    case CommandType::LINE: {
+      const auto m = demote(p0 + (p3 - p0) * t);
+      return std::make_pair(Segment(start_, Command2<T>(type(), m)),
+                            Segment(m, command_));
+    }
+    case CommandType::QUADRATIC: {
+      const auto p1 = promote(control());
+      const auto a = p0 + (p1 - p0) * t;
+      const auto b = p1 + (p3 - p1) * t;
+      const auto m = demote(a + (b - a) * t);
+      return std::make_pair(
+          Segment(start_, Command2<T>(type(), demote(a), m)),
+          Segment(m, Command2<T>(type(), demote(b), point())));
+    }
+    case CommandType::CONIC: {
+      // Split in homogeneous coordinates and renormalize the weights so that
+      // both halves have unit weights at their end points.
+      const Real w = weight();
+      const auto h1 = promote(control()) * w;
+      const auto aw = 1 + (w - 1) * t;
+      const auto bw = w + (1 - w) * t;
+      const auto mw = aw + (bw - aw) * t;
+      const auto a = p0 + (h1 - p0) * t;
+      const auto b = h1 + (p3 - h1) * t;
+      const auto m = demote((a + (b - a) * t) / mw);
+      const auto root = std::sqrt(mw);
+      return std::make_pair(
+          Segment(start_, Command2<T>(type(), demote(a / aw), m, aw / root)),
+          Segment(m, Command2<T>(type(), demote(b / bw), point(), bw / root)));
+    }
+    case CommandType::CUBIC: {
+      const auto p1 = promote(control1());
+      const auto p2 = promote(control2());
+      const auto ab = p0 + (p1 - p0) * t;
+      const auto bc = p1 + (p2 - p1) * t;
+      const auto cd = p2 + (p3 - p2) * t;
+      const auto abc = ab + (bc - ab) * t;
+      const auto bcd = bc + (cd - bc) * t;
+      const auto m = demote(abc + (bcd - abc) * t);
+      return std::make_pair(
+          Segment(start_, Command2<T>(type(), demote(ab), demote(abc), m)),
+          Segment(m, Command2<T>(type(), demote(bcd), demote(cd), point())));
+    }
+    case CommandType::MOVE:
+    case CommandType::CLOSE:
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  return std::make_pair(*this, *this);
+}
+
+template <class T>
+inline Segment2<T> Segment<T, 2>::subsegment(Real t1, Real t2) const {
+  if (t1 <= 0) {
+    return t2 >= 1 ? *this : split(t2).first;
+  }
+  if (t2 >= 1) {
+    return split(t1).second;
+  }
+  if (type() == CommandType::CONIC) {
+    // Renormalizing the weights of a split conic changes its parameterization,
+    // so take the blossom of the homogeneous curve at the original parameters.
+    const Real w = weight();
+    const auto blossom = [&](Real u, Real v, Real *weight) {
+      const auto a = (1 - u) * (1 - v);
+      const auto b = ((1 - u) * v + u * (1 - v)) * w;
+      const auto c = u * v;
+      *weight = a + b + c;
+      return (promote(start_) * a + promote(control()) * b +
+              promote(point()) * c) / *weight;
+    };
+    Real w1;
+    Real w2;
+    Real w3;
+    const auto p1 = blossom(t1, t1, &w1);
+    const auto p2 = blossom(t1, t2, &w2);
+    const auto p3 = blossom(t2, t2, &w3);
+    return Segment(demote(p1), Command2<T>(type(), demote(p2), demote(p3),
+                                           w2 / std::sqrt(w1 * w3)));
+  }
+  return split(t1).second.split((t2 - t1) / (1 - t1)).first;
+}
+
+#pragma mark Roots
+
+template <class T>
+template <class OutputIterator>
+inline unsigned int Segment<T, 2>::solveX(Real x,
+                                          OutputIterator result) const {
+  return solve(0, x, result);
+}
+
+template <class T>
+template <class OutputIterator>
+inline unsigned int Segment<T, 2>::solveY(Real y,
+                                          OutputIterator result) const {
+  return solve(1, y, result);
+}
+
+template <class T>
+template <class OutputIterator>
+inline unsigned int Segment<T, 2>::solve(int axis,
+                                         Real value,
+                                         OutputIterator result) const {
+  // Coordinates relative to the value so that the roots of the polynomial in
+  // Bernstein form are the parameters at which the curve crosses it.
+  const auto p0 = coordinate(start_, axis) - value;
+  const auto p3 = coordinate(point(), axis) - value;
+  Real roots[3];
+  int count{};
+  switch (type()) {
+    case CommandType::LINE:
+      count = math::solveLinear(p3 - p0, p0, roots);
+      break;
+    case CommandType::QUADRATIC:
+    case CommandType::CONIC: {
+      const auto p1 = coordinate(control(), axis) - value;
+      const Real w = type() == CommandType::CONIC ? weight() : 1;
+      const auto a = p0 - 2 * w * p1 + p3;
+      const auto b = 2 * (w * p1 - p0);
+      if (!negligible(a, {p0, w * p1, p3})) {
+        count = math::solveQuadratic(a, b, p0, roots);
+      } else {
+        count = math::solveLinear(b, p0, roots);
+      }
+      break;
+    }
+    case CommandType::CUBIC: {
+      const auto p1 = coordinate(control1(), axis) - value;
+      const auto p2 = coordinate(control2(), axis) - value;
+      const auto a = p3 - p0 + 3 * (p1 - p2);
+      const auto b = 3 * (p0 - 2 * p1 + p2);
+      const auto c = 3 * (p1 - p0);
+      if (!negligible(a, {p0, p1, p2, p3})) {
+        count = math::solveCubic(a, b, c, p0, roots);
+      } else if (!negligible(b, {p0, p1, p2})) {
+        count = math::solveQuadratic(b, c, p0, roots);
+      } else {
+        count = math::solveLinear(c, p0, roots);
+      }
+      break;
+    }
+    case CommandType::MOVE:
+    case CommandType::CLOSE:
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  return output(roots, count, result);
+}
+
+#pragma mark Extrema
+
+template <class T>
+template <class OutputIterator>
+inline unsigned int Segment<T, 2>::findExtremaX(OutputIterator result) const {
+  return findExtrema(0, result);
+}
+
+template <class T>
+template <class OutputIterator>
+inline unsigned int Segment<T, 2>::findExtremaY(OutputIterator result) const {
+  return findExtrema(1, result);
+}
+
+template <class T>
+template <class OutputIterator>
+inline unsigned int Segment<T, 2>::findExtrema(int axis,
+                                               OutputIterator result) const {
+  const auto p0 = coordinate(start_, axis);
+  const auto p3 = coordinate(point(), axis);
+  Real roots[2];
+  int count{};
+  switch (type()) {
+    case CommandType::QUADRATIC: {
+      const auto p1 = coordinate(control(), axis);
+      count = math::solveLinear(p0 - 2 * p1 + p3, p1 - p0, roots);
+      break;
+    }
+    case CommandType::CONIC: {
+      // Based on Skia's SkGeometry
+      const Real w = weight();
+      const auto p20 = p3 - p0;
+      const auto p10 = coordinate(control(), axis) - p0;
+      const auto a = w * p20 - p20;
+      const auto b = p20 - 2 * w * p10;
+      if (!negligible(a, {p20})) {
+        count = math::solveQuadratic(a, b, w * p10, roots);
+      } else {
+        count = math::solveLinear(b, w * p10, roots);
+      }
+      break;
+    }
+    case CommandType::CUBIC: {
+      const auto p1 = coordinate(control1(), axis);
+      const auto p2 = coordinate(control2(), axis);
+      const auto p20 = p3 - p0;
+      const auto a = p3 - p0 + 3 * (p1 - p2);
+      const auto b = 2 * (p0 - 2 * p1 + p2);
+      const auto c = p1 - p0;
+      if (!negligible(a, {c, p2 - p0, p20})) {
+        count = math::solveQuadratic(a, b, c, roots);
+      } else {
+        count = math::solveLinear(b, c, roots);
+      }
+      break;
+    }
+    case CommandType::MOVE:
+    case CommandType::LINE:
+    case CommandType::CLOSE:
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  return output(roots, count, result);
+}
+
+template <class T>
+template <class OutputIterator>
+inline unsigned int Segment<T, 2>::output(Real *roots,
+                                          int count,
+                                          OutputIterator result) {
+  // Sorted roots strictly inside the unit interval without duplicates
+  std::sort(roots, roots + count);
+  unsigned int size{};
+  for (int i{}; i < count; ++i) {
+    if (roots[i] <= 0 || roots[i] >= 1 || (i && roots[i] == roots[i - 1])) {
+      continue;
+    }
+    *result++ = roots[i];
+    ++size;
+  }
+  return size;
+}
+
+template <class T>
+inline bool Segment<T, 2>::negligible(Real coefficient,
+                                      std::initializer_list<Real> terms) {
+  // A leading coefficient that cancelled down to rounding noise of the terms
+  // it was computed from is treated as zero. Within the unit interval its
+  // contribution is no larger than that noise, while keeping it would make
+  // the solver chase a spurious root far outside the interval.
+  Real scale{};
+  for (const auto term : terms) {
+    scale = std::max(scale, std::abs(term));
+  }
+  const auto epsilon = std::numeric_limits<Real>::epsilon();
+  return std::abs(coefficient) <= 64 * epsilon * scale;
+}
+
+template <class T>
+inline math::Promote<T> Segment<T, 2>::coordinate(const Vec2<T>& point,
+                                                  int axis) {
+  return axis ? point.y : point.x;
+}
+
+template <class T>
+inline Vec2<math::Promote<T>> Segment<T, 2>::promote(const Vec2<T>& point) {
+  return Vec2<Real>(point.x, point.y);
+}
+
+template <class T>
+inline Vec2<T> Segment<T, 2>::demote(const Vec2<Real>& point) {
+  return Vec2<T>(point.x, point.y);
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::Segment;
+using graphics::Segment2;
+using graphics::Segment2i;
+using graphics::Segment2f;
+using graphics::Segment2d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_SEGMENT2_H_
@@ -0,0 +1,214 @@
+//
+//  takram/graphics/segment_range.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_SEGMENT_RANGE_H_
+#define TAKRAM_GRAPHICS_SEGMENT_RANGE_H_
+
+#include <cstddef>
+#include <iterator>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/segment.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+// Iterates over the segments of a sequence of commands, recovering the start
+// point of each drawing command on the fly. Move commands begin subpaths and
+// yield nothing, and close commands yield the line back to the first point of
+// their subpath unless it has zero length. The first command always acts as a
+// move, as Path2 treats it. The command a segment came from is accessible
+// through base(), which allows algorithms to modify commands in place while
+// iterating, as long as the end point of the current command is kept.
+
+template <class T, class CommandIterator>
+class SegmentIterator final {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = Segment2<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const Segment2<T> *;
+  using reference = const Segment2<T>&;
+
+ public:
+  SegmentIterator();
+  SegmentIterator(CommandIterator current, CommandIterator end);
+
+  // Copy semantics
+  SegmentIterator(const SegmentIterator&) = default;
+  SegmentIterator& operator=(const SegmentIterator&) = default;
+
+  // Properties
+  const CommandIterator& base() const { return current_; }
+  std::size_t subpath() const { return subpath_; }
+  bool closing() const { return current_->type() == CommandType::CLOSE; }
+
+  // Element access
+  reference operator*() const { return segment_; }
+  pointer operator->() const { return &segment_; }
+
+  // Iteration
+  SegmentIterator& operator++();
+  SegmentIterator operator++(int);
+
+  // Comparison
+  bool operator==(const SegmentIterator& other) const;
+  bool operator!=(const SegmentIterator& other) const;
+
+ private:
+  void satisfy();
+
+ private:
+  CommandIterator current_;
+  CommandIterator end_;
+  Vec2<T> first_;
+  Vec2<T> point_;
+  Segment2<T> segment_;
+  std::size_t subpath_;
+  bool started_;
+};
+
+template <class T, class CommandIterator>
+class SegmentRange final {
+ public:
+  using Type = T;
+  using Iterator = SegmentIterator<T, CommandIterator>;
+  using ConstIterator = Iterator;
+
+ public:
+  SegmentRange() = default;
+  SegmentRange(CommandIterator begin, CommandIterator end);
+
+  // Copy semantics
+  SegmentRange(const SegmentRange&) = default;
+  SegmentRange& operator=(const SegmentRange&) = default;
+
+  // Attributes
+  bool empty() const { return begin() == end(); }
+
+  // Iterator
+  Iterator begin() const { return Iterator(begin_, end_); }
+  Iterator end() const { return Iterator(end_, end_); }
+
+ private:
+  CommandIterator begin_;
+  CommandIterator end_;
+};
+
+#pragma mark -
+
+template <class T, class CommandIterator>
+inline SegmentIterator<T, CommandIterator>::SegmentIterator()
+    : subpath_(),
+      started_() {}
+
+template <class T, class CommandIterator>
+inline SegmentIterator<T, CommandIterator>::SegmentIterator(
+    CommandIterator current,
+    CommandIterator end)
+    : current_(current),
+      end_(end),
+      subpath_(),
+      started_() {
+  satisfy();
+}
+
+#pragma mark Iteration
+
+template <class T, class CommandIterator>
+inline SegmentIterator<T, CommandIterator>&
+    SegmentIterator<T, CommandIterator>::operator++() {
+  point_ = closing() ? first_ : current_->point();
+  ++current_;
+  satisfy();
+  return *this;
+}
+
+template <class T, class CommandIterator>
+inline SegmentIterator<T, CommandIterator>
+    SegmentIterator<T, CommandIterator>::operator++(int) {
+  const auto result = *this;
+  operator++();
+  return result;
+}
+
+template <class T, class CommandIterator>
+inline void SegmentIterator<T, CommandIterator>::satisfy() {
+  for (; current_ != end_; ++current_) {
+    const auto type = current_->type();
+    if (type == CommandType::MOVE || !started_) {
+      if (started_) {
+        ++subpath_;
+      }
+      first_ = point_ = current_->point();
+      started_ = true;
+    } else if (type == CommandType::CLOSE) {
+      if (point_ != first_) {
+        segment_ = Segment2<T>(point_, Command2<T>(CommandType::LINE, first_));
+        return;
+      }
+    } else {
+      segment_ = Segment2<T>(point_, *current_);
+      return;
+    }
+  }
+}
+
+#pragma mark Comparison
+
+template <class T, class CommandIterator>
+inline bool SegmentIterator<T, CommandIterator>::operator==(
+    const SegmentIterator& other) const {
+  return current_ == other.current_;
+}
+
+template <class T, class CommandIterator>
+inline bool SegmentIterator<T, CommandIterator>::operator!=(
+    const SegmentIterator& other) const {
+  return !(*this == other);
+}
+
+#pragma mark -
+
+template <class T, class CommandIterator>
+inline SegmentRange<T, CommandIterator>::SegmentRange(CommandIterator begin,
+                                                      CommandIterator end)
+    : begin_(begin),
+      end_(end) {}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::SegmentIterator;
+using graphics::SegmentRange;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_SEGMENT_RANGE_H_
@@ -0,0 +1,616 @@
+//
+//  takram/graphics/segment_views.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_SEGMENT_VIEWS_H_
+#define TAKRAM_GRAPHICS_SEGMENT_VIEWS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <type_traits>
+#include <utility>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment.h"
+#include "takram/math/promotion.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+// Lazy views over ranges of segments, such as Path2::segments() and
+// Shape2::segments(). Views are composed with operator| and evaluated one
+// segment at a time while iterating, so that a pipeline like
+//
+//   path.segments() | transformed(f) | flattened(0.25) | clipped(rect)
+//
+// makes a single pass over the commands without building intermediate paths.
+// Every view is driven by a stage that turns each input segment into zero or
+// more output segments on demand.
+
+template <class Range, class Stage>
+class SegmentView;
+
+// Tag for the adaptors that operator| accepts
+struct SegmentAdaptor {};
+
+template <class Range, class Stage>
+class SegmentViewIterator final {
+ public:
+  using BaseIterator = decltype(std::begin(std::declval<const Range&>()));
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename Stage::Segment;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+  using reference = const value_type&;
+
+ public:
+  SegmentViewIterator() = default;
+  SegmentViewIterator(BaseIterator current,
+                      BaseIterator end,
+                      const Stage& stage);
+
+  // Copy semantics
+  SegmentViewIterator(const SegmentViewIterator&) = default;
+  SegmentViewIterator& operator=(const SegmentViewIterator&) = default;
+
+  // Properties
+  const BaseIterator& base() const { return current_; }
+  std::size_t subpath() const { return current_.subpath(); }
+
+  // Element access
+  reference operator*() const { return segment_; }
+  pointer operator->() const { return &segment_; }
+
+  // Iteration
+  SegmentViewIterator& operator++();
+  SegmentViewIterator operator++(int);
+
+  // Comparison
+  bool operator==(const SegmentViewIterator& other) const;
+  bool operator!=(const SegmentViewIterator& other) const;
+
+ private:
+  void satisfy();
+
+ private:
+  BaseIterator current_;
+  BaseIterator end_;
+  Stage stage_;
+  value_type segment_;
+  std::size_t index_;
+};
+
+template <class Range, class Stage>
+class SegmentView final {
+ public:
+  using Iterator = SegmentViewIterator<Range, Stage>;
+  using ConstIterator = Iterator;
+
+ public:
+  SegmentView(const Range& range, const Stage& stage);
+
+  // Copy semantics
+  SegmentView(const SegmentView&) = default;
+  SegmentView& operator=(const SegmentView&) = default;
+
+  // Iterator
+  Iterator begin() const;
+  Iterator end() const;
+
+ private:
+  Range range_;
+  Stage stage_;
+};
+
+template <class Range>
+using SegmentType = std::decay_t<
+    decltype(*std::begin(std::declval<const Range&>()))>;
+
+template <
+  class Range, class Adaptor,
+  std::enable_if_t<std::is_base_of<SegmentAdaptor, Adaptor>::value> *& = enabler
+>
+SegmentView<Range, typename Adaptor::template Stage<
+    typename SegmentType<Range>::Type>>
+operator|(const Range& range, const Adaptor& adaptor);
+
+#pragma mark Stages
+
+// Applies a function to every point of each segment. Affine functions map
+// curves exactly; the weights of conics are kept.
+template <class T, class Function>
+class TransformStage final {
+ public:
+  using Segment = Segment2<T>;
+
+  explicit TransformStage(const Function& function)
+      : function_(function),
+        pending_() {}
+  void reset(const Segment2<T>& segment);
+  bool next(Segment2<T> *segment);
+
+ private:
+  Function function_;
+  Segment2<T> segment_;
+  bool pending_;
+};
+
+// Keeps the segments that satisfy a predicate
+template <class T, class Predicate>
+class FilterStage final {
+ public:
+  using Segment = Segment2<T>;
+
+  explicit FilterStage(const Predicate& predicate)
+      : predicate_(predicate),
+        pending_() {}
+  void reset(const Segment2<T>& segment);
+  bool next(Segment2<T> *segment);
+
+ private:
+  Predicate predicate_;
+  Segment2<T> segment_;
+  bool pending_;
+};
+
+// Approximates curves with lines whose distance from the curve is within the
+// tolerance, evaluating one line at a time
+template <class T>
+class FlattenStage final {
+ public:
+  using Segment = Segment2<T>;
+
+  explicit FlattenStage(math::Promote<T> tolerance)
+      : tolerance_(tolerance),
+        count_(),
+        index_() {}
+  void reset(const Segment2<T>& segment);
+  bool next(Segment2<T> *segment);
+
+ private:
+  math::Promote<T> tolerance_;
+  Segment2<T> segment_;
+  Vec2<T> start_;
+  unsigned int count_;
+  unsigned int index_;
+};
+
+// Keeps the portions of segments inside a rectangle, splitting curves where
+// they cross its edges. Suitable for stroking; use RectClipper for filling.
+template <class T>
+class ClipStage final {
+ public:
+  using Segment = Segment2<T>;
+
+  explicit ClipStage(const Rect2<math::Promote<T>>& rect)
+      : rect_(rect),
+        count_(),
+        index_() {}
+  void reset(const Segment2<T>& segment);
+  bool next(Segment2<T> *segment);
+
+ private:
+  Rect2<math::Promote<T>> rect_;
+  Segment2<T> segment_;
+  math::Promote<T> parameters_[14];
+  unsigned int count_;
+  unsigned int index_;
+};
+
+#pragma mark Adaptors
+
+template <class Function>
+struct TransformAdaptor : public SegmentAdaptor {
+  explicit TransformAdaptor(const Function& function) : function(function) {}
+  template <class T>
+  using Stage = TransformStage<T, Function>;
+  template <class T>
+  Stage<T> stage() const { return Stage<T>(function); }
+  Function function;
+};
+
+template <class Predicate>
+struct FilterAdaptor : public SegmentAdaptor {
+  explicit FilterAdaptor(const Predicate& predicate) : predicate(predicate) {}
+  template <class T>
+  using Stage = FilterStage<T, Predicate>;
+  template <class T>
+  Stage<T> stage() const { return Stage<T>(predicate); }
+  Predicate predicate;
+};
+
+template <class Real>
+struct FlattenAdaptor : public SegmentAdaptor {
+  explicit FlattenAdaptor(Real tolerance) : tolerance(tolerance) {}
+  template <class T>
+  using Stage = FlattenStage<T>;
+  template <class T>
+  Stage<T> stage() const { return Stage<T>(tolerance); }
+  Real tolerance;
+};
+
+template <class Real>
+struct ClipAdaptor : public SegmentAdaptor {
+  explicit ClipAdaptor(const Rect2<Real>& rect) : rect(rect) {}
+  template <class T>
+  using Stage = ClipStage<T>;
+  template <class T>
+  Stage<T> stage() const { return Stage<T>(rect); }
+  Rect2<Real> rect;
+};
+
+// Returns an adaptor that applies a function taking and returning points
+template <class Function>
+TransformAdaptor<Function> transformed(const Function& function);
+
+// Returns an adaptor that keeps the segments satisfying a predicate
+template <class Predicate>
+FilterAdaptor<Predicate> filtered(const Predicate& predicate);
+
+// Returns an adaptor that keeps the segments of the given type
+struct CommandTypePredicate {
+  template <class T>
+  bool operator()(const Segment2<T>& segment) const {
+    return segment.type() == type;
+  }
+  CommandType type;
+};
+
+FilterAdaptor<CommandTypePredicate> filtered(CommandType type);
+
+// Returns an adaptor that approximates curves with lines
+template <class Real>
+FlattenAdaptor<Real> flattened(Real tolerance);
+
+// Returns an adaptor that clips segments to a rectangle
+template <class Real>
+ClipAdaptor<Real> clipped(const Rect2<Real>& rect);
+
+// Collects a range of segments into paths, beginning a new path wherever a
+// subpath begins or a segment does not start at the end of the previous one
+template <class Range>
+std::list<Path2<typename SegmentType<Range>::Type>> makePaths(
+    const Range& range);
+
+#pragma mark -
+
+template <class Range, class Stage>
+inline SegmentViewIterator<Range, Stage>::SegmentViewIterator(
+    BaseIterator current,
+    BaseIterator end,
+    const Stage& stage)
+    : current_(current),
+      end_(end),
+      stage_(stage),
+      index_() {
+  if (current_ != end_) {
+    stage_.reset(*current_);
+    satisfy();
+  }
+}
+
+template <class Range, class Stage>
+inline SegmentViewIterator<Range, Stage>&
+    SegmentViewIterator<Range, Stage>::operator++() {
+  ++index_;
+  satisfy();
+  return *this;
+}
+
+template <class Range, class Stage>
+inline SegmentViewIterator<Range, Stage>
+    SegmentViewIterator<Range, Stage>::operator++(int) {
+  const auto result = *this;
+  operator++();
+  return result;
+}
+
+template <class Range, class Stage>
+inline void SegmentViewIterator<Range, Stage>::satisfy() {
+  // Pull the next output of the stage, advancing the base range whenever the
+  // stage runs out of outputs for the current segment.
+  while (current_ != end_) {
+    if (stage_.next(&segment_)) {
+      return;
+    }
+    index_ = 0;
+    if (++current_ != end_) {
+      stage_.reset(*current_);
+    }
+  }
+}
+
+template <class Range, class Stage>
+inline bool SegmentViewIterator<Range, Stage>::operator==(
+    const SegmentViewIterator& other) const {
+  return current_ == other.current_ && index_ == other.index_;
+}
+
+template <class Range, class Stage>
+inline bool SegmentViewIterator<Range, Stage>::operator!=(
+    const SegmentViewIterator& other) const {
+  return !(*this == other);
+}
+
+template <class Range, class Stage>
+inline SegmentView<Range, Stage>::SegmentView(const Range& range,
+                                              const Stage& stage)
+    : range_(range),
+      stage_(stage) {}
+
+template <class Range, class Stage>
+inline typename SegmentView<Range, Stage>::Iterator
+    SegmentView<Range, Stage>::begin() const {
+  return Iterator(std::begin(range_), std::end(range_), stage_);
+}
+
+template <class Range, class Stage>
+inline typename SegmentView<Range, Stage>::Iterator
+    SegmentView<Range, Stage>::end() const {
+  return Iterator(std::end(range_), std::end(range_), stage_);
+}
+
+template <
+  class Range, class Adaptor,
+  std::enable_if_t<std::is_base_of<SegmentAdaptor, Adaptor>::value> *&
+>
+inline SegmentView<Range, typename Adaptor::template Stage<
+    typename SegmentType<Range>::Type>>
+operator|(const Range& range, const Adaptor& adaptor) {
+  using T = typename SegmentType<Range>::Type;
+  return SegmentView<Range, typename Adaptor::template Stage<T>>(
+      range, adaptor.template stage<T>());
+}
+
+#pragma mark Stages
+
+template <class T, class Function>
+inline void TransformStage<T, Function>::reset(const Segment2<T>& segment) {
+  segment_ = segment;
+  segment_.start() = function_(segment.start());
+  switch (segment.type()) {
+    case CommandType::CUBIC:
+      segment_.control2() = function_(segment.control2());
+      // Pass through
+    case CommandType::CONIC:
+    case CommandType::QUADRATIC:
+      segment_.control1() = function_(segment.control1());
+      // Pass through
+    default:
+      segment_.point() = function_(segment.point());
+      break;
+  }
+  pending_ = true;
+}
+
+template <class T, class Function>
+inline bool TransformStage<T, Function>::next(Segment2<T> *segment) {
+  if (!pending_) {
+    return false;
+  }
+  *segment = segment_;
+  pending_ = false;
+  return true;
+}
+
+template <class T, class Predicate>
+inline void FilterStage<T, Predicate>::reset(const Segment2<T>& segment) {
+  segment_ = segment;
+  pending_ = predicate_(segment);
+}
+
+template <class T, class Predicate>
+inline bool FilterStage<T, Predicate>::next(Segment2<T> *segment) {
+  if (!pending_) {
+    return false;
+  }
+  *segment = segment_;
+  pending_ = false;
+  return true;
+}
+
+template <class T>
+inline void FlattenStage<T>::reset(const Segment2<T>& segment) {
+  segment_ = segment;
+  start_ = segment.start();
+  index_ = 0;
+  if (segment.type() == CommandType::LINE) {
+    count_ = 1;
+    return;
+  }
+  // The deviation of a quadratic from its chord is bounded by a quarter of
+  // the second difference of its control points, and that of a cubic by
+  // three quarters of the larger one. Chords of n pieces reduce it by n^2.
+  // Conics are bounded as quadratics, scaled by weights greater than one.
+  const auto& p0 = segment.start();
+  const auto& p3 = segment.point();
+  math::Promote<T> deviation;
+  if (segment.type() == CommandType::CUBIC) {
+    const auto& p1 = segment.control1();
+    const auto& p2 = segment.control2();
+    const auto ax = p0.x - 2 * p1.x + p2.x;
+    const auto ay = p0.y - 2 * p1.y + p2.y;
+    const auto bx = p1.x - 2 * p2.x + p3.x;
+    const auto by = p1.y - 2 * p2.y + p3.y;
+    deviation = 0.75 * std::sqrt(std::max(ax * ax + ay * ay,
+                                          bx * bx + by * by));
+  } else {
+    const auto& p1 = segment.control();
+    const auto ax = p0.x - 2 * p1.x + p3.x;
+    const auto ay = p0.y - 2 * p1.y + p3.y;
+    deviation = 0.25 * std::sqrt(ax * ax + ay * ay);
+    if (segment.type() == CommandType::CONIC && segment.weight() > 1) {
+      deviation *= segment.weight();
+    }
+  }
+  count_ = 1;
+  if (tolerance_ > 0 && deviation > tolerance_) {
+    count_ = static_cast<unsigned int>(std::ceil(std::sqrt(
+        deviation / tolerance_)));
+  }
+}
+
+template <class T>
+inline bool FlattenStage<T>::next(Segment2<T> *segment) {
+  if (index_ == count_) {
+    return false;
+  }
+  Vec2<T> point;
+  if (++index_ == count_) {
+    point = segment_.point();
+  } else {
+    const auto evaluated = segment_.evaluateAt(
+        static_cast<math::Promote<T>>(index_) / count_);
+    point = Vec2<T>(evaluated.x, evaluated.y);
+  }
+  *segment = Segment2<T>(start_, Command2<T>(CommandType::LINE, point));
+  start_ = point;
+  return true;
+}
+
+template <class T>
+inline void ClipStage<T>::reset(const Segment2<T>& segment) {
+  segment_ = segment;
+  index_ = 0;
+  count_ = 0;
+  const auto bounds = segment.bounds();
+  if (bounds.maxX() < rect_.minX() || bounds.minX() > rect_.maxX() ||
+      bounds.maxY() < rect_.minY() || bounds.minY() > rect_.maxY()) {
+    return;
+  }
+  parameters_[count_++] = 0;
+  if (bounds.minX() < rect_.minX() || bounds.maxX() > rect_.maxX() ||
+      bounds.minY() < rect_.minY() || bounds.maxY() > rect_.maxY()) {
+    count_ += segment.solveX(rect_.minX(), parameters_ + count_);
+    count_ += segment.solveX(rect_.maxX(), parameters_ + count_);
+    count_ += segment.solveY(rect_.minY(), parameters_ + count_);
+    count_ += segment.solveY(rect_.maxY(), parameters_ + count_);
+    std::sort(parameters_ + 1, parameters_ + count_);
+  }
+  parameters_[count_++] = 1;
+}
+
+template <class T>
+inline bool ClipStage<T>::next(Segment2<T> *segment) {
+  // Yield the pieces between consecutive crossings whose middle is inside
+  for (; index_ + 1 < count_; ++index_) {
+    const auto t1 = parameters_[index_];
+    const auto t2 = parameters_[index_ + 1];
+    if (t2 <= t1) {
+      continue;
+    }
+    const auto middle = segment_.evaluateAt((t1 + t2) / 2);
+    if (middle.x < rect_.minX() || middle.x > rect_.maxX() ||
+        middle.y < rect_.minY() || middle.y > rect_.maxY()) {
+      continue;
+    }
+    ++index_;
+    if (t1 == 0 && t2 == 1) {
+      *segment = segment_;
+    } else {
+      *segment = segment_.subsegment(t1, t2);
+    }
+    return true;
+  }
+  return false;
+}
+
+#pragma mark Adaptors
+
+template <class Function>
+inline TransformAdaptor<Function> transformed(const Function& function) {
+  return TransformAdaptor<Function>(function);
+}
+
+template <class Predicate>
+inline FilterAdaptor<Predicate> filtered(const Predicate& predicate) {
+  return FilterAdaptor<Predicate>(predicate);
+}
+
+inline FilterAdaptor<CommandTypePredicate> filtered(CommandType type) {
+  return FilterAdaptor<CommandTypePredicate>(CommandTypePredicate{type});
+}
+
+template <class Real>
+inline FlattenAdaptor<Real> flattened(Real tolerance) {
+  return FlattenAdaptor<Real>(tolerance);
+}
+
+template <class Real>
+inline ClipAdaptor<Real> clipped(const Rect2<Real>& rect) {
+  return ClipAdaptor<Real>(rect);
+}
+
+#pragma mark Collecting
+
+template <class Range>
+inline std::list<Path2<typename SegmentType<Range>::Type>> makePaths(
+    const Range& range) {
+  using T = typename SegmentType<Range>::Type;
+  std::list<Path2<T>> result;
+  std::size_t subpath{};
+  Vec2<T> point;
+  bool open{};
+  for (auto itr = std::begin(range); itr != std::end(range); ++itr) {
+    const auto& segment = *itr;
+    if (!open || itr.subpath() != subpath || segment.start() != point) {
+      result.emplace_back();
+      result.back().commands().emplace_back(CommandType::MOVE,
+                                            segment.start());
+      subpath = itr.subpath();
+    }
+    auto& commands = result.back().commands();
+    commands.emplace_back(segment.command());
+    point = segment.point();
+    open = point != commands.front().point();
+    if (!open) {
+      commands.emplace_back(CommandType::CLOSE);
+    }
+  }
+  return result;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::SegmentView;
+using graphics::transformed;
+using graphics::filtered;
+using graphics::flattened;
+using graphics::clipped;
+using graphics::makePaths;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_SEGMENT_VIEWS_H_
@@ -31,9 +31,15 @@
 #include <cstddef>
 #include <list>
 #include <iterator>
+#include <vector>
 
 #include "takram/algorithm/leaf_iterator_iterator.h"
+#include "takram/graphics/boolean.h"
+#include "takram/graphics/boolean_operation.h"
+#include "takram/graphics/join_type.h"
+#include "takram/graphics/offsetter.h"
 #include "takram/graphics/path.h"
+#include "takram/graphics/segment_range.h"
 #include "takram/math/promotion.h"
 #include "takram/math/rectangle.h"
 #include "takram/math/vector.h"
@@ -100,12 +106,30 @@ class Shape<T, 2> final {
   const std::list<Path2<T>>& paths() const { return paths_; }
   std::list<Path2<T>>& paths() { return paths_; }
 
+  // Segments across all the paths, each of which begins a subpath
+  SegmentRange<T, ConstIterator> segments() const;
+
   // Conversion
   bool convertQuadraticsToCubics();
   bool convertConicsToQuadratics();
   bool convertConicsToQuadratics(math::Promote<T> tolerance);
   bool removeDuplicates(math::Promote<T> threshold);
 
+  // Boolean operations
+  Shape united(const Shape& other) const;
+  Shape intersected(const Shape& other) const;
+  Shape subtracted(const Shape& other) const;
+  Shape excluded(const Shape& other) const;
+  Shape combined(const Shape& other, BooleanOperation operation) const;
+  static Shape united(const std::vector<Shape>& shapes);
+
+  // Offsetting
+  Shape offset(math::Promote<T> distance,
+               JoinType join = JoinType::MITER) const;
+  Shape offset(math::Promote<T> distance,
+               JoinType join,
+               math::Promote<T> tolerance) const;
+
   // Element access
   Path2<T>& operator[](int index) { return at(index); }
   const Path2<T>& operator[](int index) const { return at(index); }
@@ -288,6 +312,14 @@ inline void Shape<T, 2>::cubicTo(const Vec2<T>& control1,
   paths_.back().cubicTo(control1, control2, point);
 }
 
+#pragma mark Segments
+
+template <class T>
+inline SegmentRange<T, typename Shape<T, 2>::ConstIterator>
+    Shape<T, 2>::segments() const {
+  return SegmentRange<T, ConstIterator>(begin(), end());
+}
+
 #pragma mark Conversion
 
 template <class T>
@@ -334,6 +366,59 @@ inline bool Shape<T, 2>::removeDuplicates(math::Promote<T> threshold) {
   return changed;
 }
 
+#pragma mark Boolean operations
+
+template <class T>
+inline Shape2<T> Shape<T, 2>::united(const Shape& other) const {
+  return combined(other, BooleanOperation::UNION);
+}
+
+template <class T>
+inline Shape2<T> Shape<T, 2>::intersected(const Shape& other) const {
+  return combined(other, BooleanOperation::INTERSECTION);
+}
+
+template <class T>
+inline Shape2<T> Shape<T, 2>::subtracted(const Shape& other) const {
+  return combined(other, BooleanOperation::DIFFERENCE);
+}
+
+template <class T>
+inline Shape2<T> Shape<T, 2>::excluded(const Shape& other) const {
+  return combined(other, BooleanOperation::XOR);
+}
+
+template <class T>
+inline Shape2<T> Shape<T, 2>::combined(const Shape& other,
+                                       BooleanOperation operation) const {
+  return Shape(Boolean2<T>::apply(paths_, other.paths_, operation));
+}
+
+template <class T>
+inline Shape2<T> Shape<T, 2>::united(const std::vector<Shape>& shapes) {
+  std::vector<std::list<Path2<T>>> operands;
+  operands.reserve(shapes.size());
+  for (const auto& shape : shapes) {
+    operands.emplace_back(shape.paths_);
+  }
+  return Shape(Boolean2<T>::unite(operands));
+}
+
+#pragma mark Offsetting
+
+template <class T>
+inline Shape2<T> Shape<T, 2>::offset(math::Promote<T> distance,
+                                     JoinType join) const {
+  return Shape(Offsetter2<T>(distance, join).offset(paths_));
+}
+
+template <class T>
+inline Shape2<T> Shape<T, 2>::offset(math::Promote<T> distance,
+                                     JoinType join,
+                                     math::Promote<T> tolerance) const {
+  return Shape(Offsetter2<T>(distance, join, tolerance).offset(paths_));
+}
+
 #pragma mark Element access
 
 template <class T>
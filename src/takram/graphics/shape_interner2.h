@@ -0,0 +1,360 @@
+//
+//  takram/graphics/shape_interner2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_SHAPE_INTERNER2_H_
+#define TAKRAM_GRAPHICS_SHAPE_INTERNER2_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/hasher.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/shape.h"
+#include "takram/graphics/shared_shape.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+template <class T, int D>
+class ShapeInterner;
+
+template <class T>
+using ShapeInterner2 = ShapeInterner<T, 2>;
+
+// Deduplicates repeated geometry by mapping every shape to a single shared
+// instance of it. Shapes are looked up by their content hash, quantized to
+// the tolerance when it is positive, in which case shapes whose values all
+// fall onto the same grid cells intern to the first of them. The table is
+// split into shards that are locked independently, so that threads interning
+// different shapes rarely contend. Entries stay alive until the interner is
+// cleared, even after every other copy of them has gone.
+
+template <class T>
+class ShapeInterner<T, 2> final {
+ public:
+  using Type = T;
+  static constexpr const int dimensions = 2;
+
+  // Bytes saved counts the command storage that each hit would have
+  // duplicated otherwise.
+  struct Statistics {
+    std::size_t lookups;
+    std::size_t hits;
+    std::size_t entries;
+    std::size_t bytes_saved;
+
+    double hitRate() const {
+      return lookups ? static_cast<double>(hits) / lookups : 0.0;
+    }
+  };
+
+ public:
+  explicit ShapeInterner(double tolerance = 0.0, std::size_t shards = 16);
+
+  // Disallow copy semantics
+  ShapeInterner(const ShapeInterner&) = delete;
+  ShapeInterner& operator=(const ShapeInterner&) = delete;
+
+  // Mutators
+  void clear();
+
+  // Attributes
+  double tolerance() const { return tolerance_; }
+  std::size_t size() const;
+  Statistics statistics() const;
+
+  // Interning
+  SharedShape2<T> intern(const Path2<T>& path);
+  SharedShape2<T> intern(const Shape2<T>& shape);
+  SharedShape2<T> intern(const SharedShape2<T>& shape);
+
+ private:
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_multimap<std::uint64_t, SharedShape2<T>> entries;
+  };
+
+  template <class Geometry>
+  SharedShape2<T> intern(const Geometry& shape, std::uint64_t hash);
+  template <class Geometry>
+  const SharedShape2<T> * find(const Shard& shard,
+                               const Geometry& shape,
+                               std::uint64_t hash) const;
+
+  // Equivalence under the tolerance
+  bool equivalent(const SharedShape2<T>& shape1,
+                  const Shape2<T>& shape2) const;
+  bool equivalent(const SharedShape2<T>& shape1,
+                  const SharedShape2<T>& shape2) const;
+  template <class Iterator1, class Iterator2>
+  bool equivalent(Iterator1 first1, Iterator1 last1,
+                  Iterator2 first2, Iterator2 last2) const;
+  bool equivalent(const Command2<T>& command1,
+                  const Command2<T>& command2) const;
+  bool equivalent(const Vec2<T>& point1, const Vec2<T>& point2) const;
+
+ private:
+  double tolerance_;
+  Hasher hasher_;
+  std::vector<Shard> shards_;
+  std::atomic<std::size_t> lookups_;
+  std::atomic<std::size_t> hits_;
+  std::atomic<std::size_t> bytes_saved_;
+};
+
+using ShapeInterner2i = ShapeInterner2<int>;
+using ShapeInterner2f = ShapeInterner2<float>;
+using ShapeInterner2d = ShapeInterner2<double>;
+
+#pragma mark -
+
+template <class T>
+inline ShapeInterner<T, 2>::ShapeInterner(double tolerance,
+                                          std::size_t shards)
+    : tolerance_(tolerance),
+      hasher_(tolerance),
+      shards_(shards),
+      lookups_(),
+      hits_(),
+      bytes_saved_() {
+  assert(shards > 0);
+}
+
+#pragma mark Mutators
+
+template <class T>
+inline void ShapeInterner<T, 2>::clear() {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.clear();
+  }
+  lookups_ = 0;
+  hits_ = 0;
+  bytes_saved_ = 0;
+}
+
+#pragma mark Attributes
+
+template <class T>
+inline std::size_t ShapeInterner<T, 2>::size() const {
+  std::size_t result{};
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    result += shard.entries.size();
+  }
+  return result;
+}
+
+template <class T>
+inline typename ShapeInterner<T, 2>::Statistics
+    ShapeInterner<T, 2>::statistics() const {
+  Statistics result;
+  result.lookups = lookups_;
+  result.hits = hits_;
+  result.entries = size();
+  result.bytes_saved = bytes_saved_;
+  return result;
+}
+
+#pragma mark Interning
+
+template <class T>
+inline SharedShape2<T> ShapeInterner<T, 2>::intern(const Path2<T>& path) {
+  return intern(Shape2<T>(path));
+}
+
+template <class T>
+inline SharedShape2<T> ShapeInterner<T, 2>::intern(const Shape2<T>& shape) {
+  return intern(shape, Hasher(hasher_).update(shape).digest());
+}
+
+template <class T>
+inline SharedShape2<T> ShapeInterner<T, 2>::intern(
+    const SharedShape2<T>& shape) {
+  if (tolerance_ > 0.0) {
+    return intern(shape, Hasher(hasher_).update(shape).digest());
+  }
+  return intern(shape, shape.hash());
+}
+
+template <class T>
+template <class Geometry>
+inline SharedShape2<T> ShapeInterner<T, 2>::intern(const Geometry& shape,
+                                                   std::uint64_t hash) {
+  ++lookups_;
+  auto& shard = shards_[hash % shards_.size()];
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto found = find(shard, shape, hash);
+    if (found) {
+      ++hits_;
+      bytes_saved_ += found->commands().size() * sizeof(Command2<T>);
+      return *found;
+    }
+  }
+  // Build the shared shape outside the lock, and look it up again in case
+  // another thread has interned the same shape meanwhile.
+  const SharedShape2<T> result(shape);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  const auto found = find(shard, shape, hash);
+  if (found) {
+    ++hits_;
+    bytes_saved_ += found->commands().size() * sizeof(Command2<T>);
+    return *found;
+  }
+  shard.entries.emplace(hash, result);
+  return result;
+}
+
+template <class T>
+template <class Geometry>
+inline const SharedShape2<T> * ShapeInterner<T, 2>::find(
+    const Shard& shard,
+    const Geometry& shape,
+    std::uint64_t hash) const {
+  const auto range = shard.entries.equal_range(hash);
+  for (auto itr = range.first; itr != range.second; ++itr) {
+    if (equivalent(itr->second, shape)) {
+      return &itr->second;
+    }
+  }
+  return nullptr;
+}
+
+#pragma mark Equivalence under the tolerance
+
+template <class T>
+inline bool ShapeInterner<T, 2>::equivalent(
+    const SharedShape2<T>& shape1,
+    const Shape2<T>& shape2) const {
+  if (shape1.size() != shape2.size()) {
+    return false;
+  }
+  std::size_t index{};
+  for (const auto& path : shape2.paths()) {
+    if (!equivalent(shape1.begin(index), shape1.end(index),
+                    path.begin(), path.end())) {
+      return false;
+    }
+    ++index;
+  }
+  return true;
+}
+
+template <class T>
+inline bool ShapeInterner<T, 2>::equivalent(
+    const SharedShape2<T>& shape1,
+    const SharedShape2<T>& shape2) const {
+  if (shape1.shares(shape2)) {
+    return true;
+  }
+  if (shape1.size() != shape2.size()) {
+    return false;
+  }
+  for (std::size_t index{}; index < shape1.size(); ++index) {
+    if (!equivalent(shape1.begin(index), shape1.end(index),
+                    shape2.begin(index), shape2.end(index))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class T>
+template <class Iterator1, class Iterator2>
+inline bool ShapeInterner<T, 2>::equivalent(Iterator1 first1,
+                                            Iterator1 last1,
+                                            Iterator2 first2,
+                                            Iterator2 last2) const {
+  for (; first1 != last1 && first2 != last2; ++first1, ++first2) {
+    if (!equivalent(*first1, *first2)) {
+      return false;
+    }
+  }
+  return first1 == last1 && first2 == last2;
+}
+
+template <class T>
+inline bool ShapeInterner<T, 2>::equivalent(
+    const Command2<T>& command1,
+    const Command2<T>& command2) const {
+  if (command1.type() != command2.type()) {
+    return false;
+  }
+  switch (command1.type()) {
+    case CommandType::MOVE:
+    case CommandType::LINE:
+      return equivalent(command1.point(), command2.point());
+    case CommandType::QUADRATIC:
+      return (equivalent(command1.control(), command2.control()) &&
+              equivalent(command1.point(), command2.point()));
+    case CommandType::CONIC:
+      return (equivalent(command1.control(), command2.control()) &&
+              equivalent(command1.point(), command2.point()) &&
+              hasher_.word(command1.weight()) ==
+              hasher_.word(command2.weight()));
+    case CommandType::CUBIC:
+      return (equivalent(command1.control1(), command2.control1()) &&
+              equivalent(command1.control2(), command2.control2()) &&
+              equivalent(command1.point(), command2.point()));
+    case CommandType::CLOSE:
+      return true;
+    default:
+      assert(false);
+      break;
+  }
+  return false;
+}
+
+template <class T>
+inline bool ShapeInterner<T, 2>::equivalent(const Vec2<T>& point1,
+                                            const Vec2<T>& point2) const {
+  return (hasher_.word(point1.x) == hasher_.word(point2.x) &&
+          hasher_.word(point1.y) == hasher_.word(point2.y));
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::ShapeInterner;
+using graphics::ShapeInterner2;
+using graphics::ShapeInterner2i;
+using graphics::ShapeInterner2f;
+using graphics::ShapeInterner2d;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_SHAPE_INTERNER2_H_
@@ -0,0 +1,308 @@
+//
+//  takram/graphics/shared_shape2.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_SHARED_SHAPE2_H_
+#define TAKRAM_GRAPHICS_SHARED_SHAPE2_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/hasher.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment_range.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/promotion.h"
+#include "takram/math/rectangle.h"
+
+namespace takram {
+namespace graphics {
+
+template <class T, int D>
+class SharedShape;
+
+template <class T>
+using SharedShape2 = SharedShape<T, 2>;
+
+// An immutable shape whose commands are stored contiguously in a single
+// reference-counted block, together with the offsets at which its paths begin,
+// its bounds and its content hash. Copies share the block, so they are as
+// cheap as copying a shared pointer, and since the block is never modified
+// after construction, any number of threads may read the same shape
+// concurrently. Assigning a new shape replaces the block of that instance
+// only, which leaves the others holding the previous one untouched. Equality
+// compares the hashes before the commands.
+
+template <class T>
+class SharedShape<T, 2> final {
+ public:
+  using Type = T;
+  using ConstIterator = typename std::vector<Command2<T>>::const_iterator;
+  using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
+  static constexpr const int dimensions = 2;
+
+ public:
+  SharedShape();
+  explicit SharedShape(const Path2<T>& path);
+  explicit SharedShape(const Shape2<T>& shape);
+
+  // Copy semantics
+  SharedShape(const SharedShape&) = default;
+  SharedShape& operator=(const SharedShape&) = default;
+
+  // Mutators
+  void set(const Path2<T>& path);
+  void set(const Shape2<T>& shape);
+  void reset();
+
+  // Attributes
+  bool empty() const { return storage_->offsets.size() < 2; }
+  std::size_t size() const { return storage_->offsets.size() - 1; }
+  const Rect2<math::Promote<T>>& bounds(bool precise = false) const;
+  std::uint64_t hash() const { return storage_->hash; }
+  bool shares(const SharedShape& other) const;
+
+  // Commands across all the paths, and the segments they describe
+  const std::vector<Command2<T>>& commands() const;
+  SegmentRange<T, ConstIterator> segments() const;
+
+  // Paths
+  ConstIterator begin(std::size_t index) const;
+  ConstIterator end(std::size_t index) const;
+  Path2<T> path(std::size_t index) const;
+
+  // Conversion
+  Shape2<T> shape() const;
+
+  // Iterator
+  ConstIterator begin() const { return std::begin(commands()); }
+  ConstIterator end() const { return std::end(commands()); }
+  ConstReverseIterator rbegin() const { return std::rbegin(commands()); }
+  ConstReverseIterator rend() const { return std::rend(commands()); }
+
+ private:
+  struct Storage final {
+    std::vector<Command2<T>> commands;
+    std::vector<std::size_t> offsets;
+    Rect2<math::Promote<T>> bounds;
+    Rect2<math::Promote<T>> precise_bounds;
+    std::uint64_t hash;
+  };
+
+  static const std::shared_ptr<const Storage>& emptyStorage();
+
+ private:
+  std::shared_ptr<const Storage> storage_;
+};
+
+// Comparison
+template <class T, class U>
+bool operator==(const SharedShape2<T>& lhs, const SharedShape2<U>& rhs);
+template <class T, class U>
+bool operator!=(const SharedShape2<T>& lhs, const SharedShape2<U>& rhs);
+
+using SharedShape2i = SharedShape2<int>;
+using SharedShape2f = SharedShape2<float>;
+using SharedShape2d = SharedShape2<double>;
+
+#pragma mark -
+
+template <class T>
+inline SharedShape<T, 2>::SharedShape() : storage_(emptyStorage()) {}
+
+template <class T>
+inline SharedShape<T, 2>::SharedShape(const Path2<T>& path) {
+  set(path);
+}
+
+template <class T>
+inline SharedShape<T, 2>::SharedShape(const Shape2<T>& shape) {
+  set(shape);
+}
+
+template <class T>
+inline const std::shared_ptr<const typename SharedShape<T, 2>::Storage>&
+    SharedShape<T, 2>::emptyStorage() {
+  static const std::shared_ptr<const Storage> storage = []() {
+    const auto storage = std::make_shared<Storage>();
+    storage->offsets.emplace_back();
+    storage->hash = Hasher().update(Shape2<T>()).digest();
+    return storage;
+  }();
+  return storage;
+}
+
+#pragma mark Mutators
+
+template <class T>
+inline void SharedShape<T, 2>::set(const Path2<T>& path) {
+  set(Shape2<T>(path));
+}
+
+template <class T>
+inline void SharedShape<T, 2>::set(const Shape2<T>& shape) {
+  const auto storage = std::make_shared<Storage>();
+  std::size_t size{};
+  for (const auto& path : shape.paths()) {
+    size += path.size();
+  }
+  storage->commands.reserve(size);
+  storage->offsets.reserve(shape.size() + 1);
+  storage->offsets.emplace_back();
+  for (const auto& path : shape.paths()) {
+    storage->commands.insert(storage->commands.end(),
+                             std::begin(path), std::end(path));
+    storage->offsets.emplace_back(storage->commands.size());
+  }
+  storage->bounds = shape.bounds();
+  storage->precise_bounds = shape.bounds(true);
+  storage->hash = Hasher().update(shape).digest();
+  storage_ = storage;
+}
+
+template <class T>
+inline void SharedShape<T, 2>::reset() {
+  storage_ = emptyStorage();
+}
+
+#pragma mark Comparison
+
+template <class T, class U>
+inline bool operator==(const SharedShape2<T>& lhs,
+                       const SharedShape2<U>& rhs) {
+  if (static_cast<const void *>(&lhs.commands()) == &rhs.commands()) {
+    return true;  // Sharing the same storage
+  }
+  if (lhs.hash() != rhs.hash() || lhs.size() != rhs.size() ||
+      lhs.commands().size() != rhs.commands().size()) {
+    return false;
+  }
+  for (std::size_t index{}; index < lhs.size(); ++index) {
+    if (std::distance(lhs.begin(index), lhs.end(index)) !=
+        std::distance(rhs.begin(index), rhs.end(index))) {
+      return false;
+    }
+  }
+  return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class T, class U>
+inline bool operator!=(const SharedShape2<T>& lhs,
+                       const SharedShape2<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+#pragma mark Attributes
+
+template <class T>
+inline const Rect2<math::Promote<T>>&
+    SharedShape<T, 2>::bounds(bool precise) const {
+  return precise ? storage_->precise_bounds : storage_->bounds;
+}
+
+template <class T>
+inline bool SharedShape<T, 2>::shares(const SharedShape& other) const {
+  return storage_ == other.storage_;
+}
+
+#pragma mark Commands
+
+template <class T>
+inline const std::vector<Command2<T>>& SharedShape<T, 2>::commands() const {
+  return storage_->commands;
+}
+
+template <class T>
+inline SegmentRange<T, typename SharedShape<T, 2>::ConstIterator>
+    SharedShape<T, 2>::segments() const {
+  return SegmentRange<T, ConstIterator>(begin(), end());
+}
+
+#pragma mark Paths
+
+template <class T>
+inline typename SharedShape<T, 2>::ConstIterator
+    SharedShape<T, 2>::begin(std::size_t index) const {
+  assert(index < size());
+  return begin() + storage_->offsets[index];
+}
+
+template <class T>
+inline typename SharedShape<T, 2>::ConstIterator
+    SharedShape<T, 2>::end(std::size_t index) const {
+  assert(index < size());
+  return begin() + storage_->offsets[index + 1];
+}
+
+template <class T>
+inline Path2<T> SharedShape<T, 2>::path(std::size_t index) const {
+  return Path2<T>(std::list<Command2<T>>(begin(index), end(index)));
+}
+
+#pragma mark Conversion
+
+template <class T>
+inline Shape2<T> SharedShape<T, 2>::shape() const {
+  Shape2<T> result;
+  for (std::size_t index{}; index < size(); ++index) {
+    result.paths().emplace_back(path(index));
+  }
+  return result;
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::SharedShape;
+using graphics::SharedShape2;
+using graphics::SharedShape2i;
+using graphics::SharedShape2f;
+using graphics::SharedShape2d;
+
+}  // namespace takram
+
+namespace std {
+
+template <class T>
+struct hash<takram::graphics::SharedShape<T, 2>> {
+  std::size_t operator()(
+      const takram::graphics::SharedShape<T, 2>& shape) const {
+    return static_cast<std::size_t>(shape.hash());
+  }
+};
+
+}  // namespace std
+
+#endif  // TAKRAM_GRAPHICS_SHARED_SHAPE2_H_
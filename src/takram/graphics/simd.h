@@ -0,0 +1,291 @@
+//
+//  takram/graphics/simd.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_SIMD_H_
+#define TAKRAM_GRAPHICS_SIMD_H_
+
+// SSE2 is part of every x86-64 target, so kernels written against it need no
+// runtime dispatch. NEON is likewise part of every AArch64 target. Other
+// targets fall back to scalar loops, which compilers are free to vectorize on
+// their own.
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TAKRAM_GRAPHICS_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// F16C is not, and kernels use it only where the target enables it at compile
+// time. MSVC has no macro of its own for it, but every target of AVX2 has it.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define TAKRAM_GRAPHICS_HAS_F16C 1
+#include <immintrin.h>
+#endif
+
+// AVX2 widens some kernels to eight lanes. Those kernels are compiled for it
+// through TAKRAM_GRAPHICS_TARGET_AVX2 whatever the target, and hasAVX2()
+// selects them at runtime unless the target enables AVX2 already.
+#if defined(__AVX2__)
+#define TAKRAM_GRAPHICS_HAS_AVX2 1
+#define TAKRAM_GRAPHICS_TARGET_AVX2
+#include <immintrin.h>
+#elif TAKRAM_GRAPHICS_HAS_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#define TAKRAM_GRAPHICS_HAS_AVX2 1
+#define TAKRAM_GRAPHICS_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif TAKRAM_GRAPHICS_HAS_SSE2 && defined(_MSC_VER)
+#define TAKRAM_GRAPHICS_HAS_AVX2 1
+#define TAKRAM_GRAPHICS_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+// ARMv7 has no vector division, which kernels need to match the scalar
+// conversions, so only AArch64 takes NEON.
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define TAKRAM_GRAPHICS_HAS_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace takram {
+namespace graphics {
+namespace detail {
+
+#if TAKRAM_GRAPHICS_HAS_AVX2
+
+// Whether both the processor and the operating system support AVX2, which is
+// checked only the first time
+inline bool hasAVX2() {
+#if defined(__AVX2__)
+  return true;
+#elif defined(_MSC_VER)
+  static const bool result = []() {
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+      return false;
+    }
+    // OSXSAVE and AVX, and the operating system saving the upper halves of
+    // the registers
+    __cpuid(info, 1);
+    if ((info[2] & 0x18000000) != 0x18000000 || (_xgetbv(0) & 0x6) != 0x6) {
+      return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & 0x20) != 0;
+  }();
+  return result;
+#else
+  static const bool result = []() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return result;
+#endif
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_AVX2
+
+// Four float lanes, on which kernels are written once for both SSE2 and scalar
+// targets. Comparisons yield masks in the same lanes for select().
+struct Lanes {
+#if TAKRAM_GRAPHICS_HAS_SSE2
+  Lanes() = default;
+  Lanes(__m128 value) : value(value) {}
+  explicit Lanes(float value) : value(_mm_set1_ps(value)) {}
+
+  __m128 value;
+#else
+  Lanes() = default;
+  explicit Lanes(float value) : value{value, value, value, value} {}
+
+  float value[4];
+#endif
+};
+
+#if TAKRAM_GRAPHICS_HAS_SSE2
+
+inline Lanes operator+(const Lanes& a, const Lanes& b) {
+  return _mm_add_ps(a.value, b.value);
+}
+
+inline Lanes operator-(const Lanes& a, const Lanes& b) {
+  return _mm_sub_ps(a.value, b.value);
+}
+
+inline Lanes operator*(const Lanes& a, const Lanes& b) {
+  return _mm_mul_ps(a.value, b.value);
+}
+
+inline Lanes operator/(const Lanes& a, const Lanes& b) {
+  return _mm_div_ps(a.value, b.value);
+}
+
+inline Lanes min(const Lanes& a, const Lanes& b) {
+  return _mm_min_ps(a.value, b.value);
+}
+
+inline Lanes max(const Lanes& a, const Lanes& b) {
+  return _mm_max_ps(a.value, b.value);
+}
+
+inline Lanes sqrt(const Lanes& a) {
+  return _mm_sqrt_ps(a.value);
+}
+
+inline Lanes lessEqual(const Lanes& a, const Lanes& b) {
+  return _mm_cmple_ps(a.value, b.value);
+}
+
+inline Lanes select(const Lanes& mask,
+                    const Lanes& a,
+                    const Lanes& b) {
+  return _mm_or_ps(_mm_and_ps(mask.value, a.value),
+                   _mm_andnot_ps(mask.value, b.value));
+}
+
+inline Lanes abs(const Lanes& a) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.value);
+}
+
+// Truncation through integers, which leaves values beyond 2^23 as they are
+// since they have no fraction
+inline Lanes floor(const Lanes& a) {
+  const auto truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.value));
+  const auto floored = _mm_sub_ps(truncated, _mm_and_ps(
+      _mm_cmpgt_ps(truncated, a.value), _mm_set1_ps(1.0f)));
+  return select(_mm_cmplt_ps(abs(a).value, _mm_set1_ps(8388608.0f)),
+                floored, a);
+}
+
+inline Lanes loadLanes(const float *values) {
+  return _mm_loadu_ps(values);
+}
+
+inline void storeLanes(const Lanes& lanes, float *values) {
+  _mm_storeu_ps(values, lanes.value);
+}
+
+// Rounds to the nearest integers, ties to even
+inline void roundLanes(const Lanes& lanes, std::int32_t *values) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(values),
+                   _mm_cvtps_epi32(lanes.value));
+}
+
+#else  // TAKRAM_GRAPHICS_HAS_SSE2
+
+template <class Function>
+inline Lanes mapLanes(const Lanes& a,
+                      const Lanes& b,
+                      Function function) {
+  Lanes result;
+  for (int i{}; i < 4; ++i) {
+    result.value[i] = function(a.value[i], b.value[i]);
+  }
+  return result;
+}
+
+inline Lanes operator+(const Lanes& a, const Lanes& b) {
+  return mapLanes(a, b, [](float a, float b) { return a + b; });
+}
+
+inline Lanes operator-(const Lanes& a, const Lanes& b) {
+  return mapLanes(a, b, [](float a, float b) { return a - b; });
+}
+
+inline Lanes operator*(const Lanes& a, const Lanes& b) {
+  return mapLanes(a, b, [](float a, float b) { return a * b; });
+}
+
+inline Lanes operator/(const Lanes& a, const Lanes& b) {
+  return mapLanes(a, b, [](float a, float b) { return a / b; });
+}
+
+inline Lanes min(const Lanes& a, const Lanes& b) {
+  return mapLanes(a, b, [](float a, float b) { return a < b ? a : b; });
+}
+
+inline Lanes max(const Lanes& a, const Lanes& b) {
+  return mapLanes(a, b, [](float a, float b) { return a > b ? a : b; });
+}
+
+inline Lanes sqrt(const Lanes& a) {
+  return mapLanes(a, a, [](float a, float) { return std::sqrt(a); });
+}
+
+inline Lanes abs(const Lanes& a) {
+  return mapLanes(a, a, [](float a, float) { return std::abs(a); });
+}
+
+inline Lanes floor(const Lanes& a) {
+  return mapLanes(a, a, [](float a, float) { return std::floor(a); });
+}
+
+inline Lanes lessEqual(const Lanes& a, const Lanes& b) {
+  return mapLanes(a, b, [](float a, float b) { return a <= b ? 1.f : 0.f; });
+}
+
+inline Lanes select(const Lanes& mask,
+                    const Lanes& a,
+                    const Lanes& b) {
+  Lanes result;
+  for (int i{}; i < 4; ++i) {
+    result.value[i] = mask.value[i] ? a.value[i] : b.value[i];
+  }
+  return result;
+}
+
+inline Lanes loadLanes(const float *values) {
+  Lanes result{};
+  std::copy(values, values + 4, result.value);
+  return result;
+}
+
+inline void storeLanes(const Lanes& lanes, float *values) {
+  std::copy(lanes.value, lanes.value + 4, values);
+}
+
+inline void roundLanes(const Lanes& lanes, std::int32_t *values) {
+  for (int i{}; i < 4; ++i) {
+    values[i] = static_cast<std::int32_t>(std::nearbyint(lanes.value[i]));
+  }
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+
+}  // namespace detail
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_SIMD_H_
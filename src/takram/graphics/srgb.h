@@ -0,0 +1,412 @@
+//
+//  takram/graphics/srgb.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_SRGB_H_
+#define TAKRAM_GRAPHICS_SRGB_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/image_view.h"
+#include "takram/graphics/simd.h"
+#include "takram/math/enablers.h"
+
+namespace takram {
+namespace graphics {
+
+// Decodes sRGB-encoded values to linear light and encodes them back, with
+// the piecewise transfer function of IEC 61966-2-1. Single values and colors
+// are converted by the exact formula in their own precision, leaving alpha
+// as it is. Buffers and images are converted by faster approximations:
+//
+// - Decoding 8-bit values looks them up in a table of 256 floats, which is
+//   exact to float precision.
+// - Decoding floats evaluates a polynomial in the eighth root of the value,
+//   whose relative error is below 1e-6.
+// - Encoding floats evaluates another polynomial in the eighth root, whose
+//   absolute error is below 1e-6.
+// - Encoding floats to 8-bit values corrects the rounded polynomial against a
+//   table of the thresholds between codes, which yields the same code as
+//   rounding the exact encoding.
+//
+// The polynomials run four values at a time with SSE2 where available. Values
+// outside [0, 1] are clamped.
+
+template <class T>
+EnableIfFloating<T, T> decodeSRGB(T value);
+template <class T>
+EnableIfFloating<T, T> encodeSRGB(T value);
+template <class T>
+EnableIfFloating<T, Color3<T>> decodeSRGB(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color3<T>> encodeSRGB(const Color3<T>& color);
+template <class T>
+EnableIfFloating<T, Color4<T>> decodeSRGB(const Color4<T>& color);
+template <class T>
+EnableIfFloating<T, Color4<T>> encodeSRGB(const Color4<T>& color);
+
+// Buffers of channel values
+void decodeSRGB(const std::uint8_t *values, std::size_t size, float *result);
+void decodeSRGB(const float *values, std::size_t size, float *result);
+void encodeSRGB(const float *values, std::size_t size, float *result);
+void encodeSRGB(const float *values, std::size_t size, std::uint8_t *result);
+
+// Images, of which the fourth channel is alpha and only converted in depth
+template <class T, class U, int C>
+void decodeSRGB(const ImageView<U, C>& image, ImageView<T, C> result);
+template <class T, class U, int C>
+void encodeSRGB(const ImageView<U, C>& image, ImageView<T, C> result);
+
+#pragma mark -
+
+namespace detail {
+
+struct SRGBTables {
+  float decode[256];
+
+  // The smallest float of which the exact encoding rounds to each code
+  float thresholds[257];
+};
+
+inline const SRGBTables& srgbTables() {
+  static const SRGBTables tables = []() {
+    SRGBTables tables;
+    for (int code{}; code < 256; ++code) {
+      tables.decode[code] = decodeSRGB(code / 255.0);
+    }
+    tables.thresholds[0] = -std::numeric_limits<float>::infinity();
+    tables.thresholds[256] = std::numeric_limits<float>::infinity();
+    for (int code = 1; code < 256; ++code) {
+      const auto threshold = decodeSRGB((code - 0.5) / 255.0);
+      auto value = static_cast<float>(threshold);
+      if (value < threshold) {
+        value = std::nextafter(value, 1.0f);
+      }
+      tables.thresholds[code] = value;
+    }
+    return tables;
+  }();
+  return tables;
+}
+
+// Coefficients of the polynomials in the eighth root, from the constant term,
+// fitted to minimize the relative error of decoding and the absolute error of
+// encoding
+inline const float * srgbDecodeCoefficients() {
+  static const float coefficients[] = {
+    -0.010748216f, 0.0731805861f, -0.234845713f, 1.09313416f, 0.0792792141f
+  };
+  return coefficients;
+}
+
+inline const float * srgbEncodeCoefficients() {
+  static const float coefficients[] = {
+    -0.0582148768f, 0.0329002067f, -0.162825152f,
+    0.909054637f, 0.313188255f, -0.0341031626f
+  };
+  return coefficients;
+}
+
+// Clamps to [0, 1], taking NaNs as zero as the SSE2 kernels do
+inline float clampSRGB(float value) {
+  return value > 0.0f ? std::min(value, 1.0f) : 0.0f;
+}
+
+inline float decodeSRGBFast(float value) {
+  value = clampSRGB(value);
+  if (value <= 0.04045f) {
+    return value * (1.0f / 12.92f);
+  }
+  const auto base = (value + 0.055f) * (1.0f / 1.055f);
+  const auto root = std::sqrt(std::sqrt(std::sqrt(base)));
+  const auto c = srgbDecodeCoefficients();
+  return base * base *
+      ((((c[4] * root + c[3]) * root + c[2]) * root + c[1]) * root + c[0]);
+}
+
+inline float encodeSRGBFast(float value) {
+  value = clampSRGB(value);
+  if (value <= 0.0031308f) {
+    return value * 12.92f;
+  }
+  const auto root = std::sqrt(std::sqrt(std::sqrt(value)));
+  const auto c = srgbEncodeCoefficients();
+  return (((((c[5] * root + c[4]) * root + c[3]) * root + c[2]) * root +
+           c[1]) * root + c[0]);
+}
+
+// Moves a code rounded from an approximate encoding to the one whose
+// thresholds enclose the value
+inline std::uint8_t correctSRGBCode(float value,
+                                    int code,
+                                    const SRGBTables& tables) {
+  while (value < tables.thresholds[code]) {
+    --code;
+  }
+  while (value >= tables.thresholds[code + 1]) {
+    ++code;
+  }
+  return static_cast<std::uint8_t>(code);
+}
+
+#if TAKRAM_GRAPHICS_HAS_SSE2
+
+inline __m128 clampSRGB(__m128 value) {
+  return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+inline __m128 selectSRGB(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+inline __m128 decodeSRGBFast(__m128 value) {
+  value = clampSRGB(value);
+  const auto linear = _mm_mul_ps(value, _mm_set1_ps(1.0f / 12.92f));
+  const auto base = _mm_mul_ps(_mm_add_ps(value, _mm_set1_ps(0.055f)),
+                               _mm_set1_ps(1.0f / 1.055f));
+  const auto root = _mm_sqrt_ps(_mm_sqrt_ps(_mm_sqrt_ps(base)));
+  const auto c = srgbDecodeCoefficients();
+  auto result = _mm_set1_ps(c[4]);
+  for (int i = 3; i >= 0; --i) {
+    result = _mm_add_ps(_mm_mul_ps(result, root), _mm_set1_ps(c[i]));
+  }
+  result = _mm_mul_ps(_mm_mul_ps(base, base), result);
+  return selectSRGB(_mm_cmple_ps(value, _mm_set1_ps(0.04045f)),
+                    linear, result);
+}
+
+inline __m128 encodeSRGBFast(__m128 value) {
+  value = clampSRGB(value);
+  const auto linear = _mm_mul_ps(value, _mm_set1_ps(12.92f));
+  const auto root = _mm_sqrt_ps(_mm_sqrt_ps(_mm_sqrt_ps(value)));
+  const auto c = srgbEncodeCoefficients();
+  auto result = _mm_set1_ps(c[5]);
+  for (int i = 4; i >= 0; --i) {
+    result = _mm_add_ps(_mm_mul_ps(result, root), _mm_set1_ps(c[i]));
+  }
+  return selectSRGB(_mm_cmple_ps(value, _mm_set1_ps(0.0031308f)),
+                    linear, result);
+}
+
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+
+// Applies a conversion of buffers to the color channels of an image, a row
+// at a time, gathering channels into a row of their own unless the image is
+// interleaved. Alpha is only converted in depth.
+template <class T, class U, int C, class Function>
+inline void convertSRGB(const ImageView<U, C>& image,
+                        ImageView<T, C> result,
+                        Function function) {
+  assert(image.width() == result.width());
+  assert(image.height() == result.height());
+  const auto width = image.width();
+  if (image.interleaved() && result.interleaved()) {
+    for (int y{}; y < image.height(); ++y) {
+      function(image.row(y), width * C, result.row(y));
+      for (int channel = 3; channel < C; ++channel) {
+        for (int x{}; x < width; ++x) {
+          result.at(x, y, channel) = Depth<T>::convert(
+              image.at(x, y, channel));
+        }
+      }
+    }
+    return;
+  }
+  std::vector<typename std::remove_const<U>::type> values(width);
+  std::vector<T> converted(width);
+  for (int y{}; y < image.height(); ++y) {
+    for (int channel{}; channel < C; ++channel) {
+      if (channel >= 3) {
+        for (int x{}; x < width; ++x) {
+          result.at(x, y, channel) = Depth<T>::convert(
+              image.at(x, y, channel));
+        }
+        continue;
+      }
+      for (int x{}; x < width; ++x) {
+        values[x] = image.at(x, y, channel);
+      }
+      function(values.data(), values.size(), converted.data());
+      for (int x{}; x < width; ++x) {
+        result.at(x, y, channel) = converted[x];
+      }
+    }
+  }
+}
+
+}  // namespace detail
+
+#pragma mark Single values
+
+template <class T>
+inline EnableIfFloating<T, T> decodeSRGB(T value) {
+  if (value <= T(0.04045)) {
+    return value / T(12.92);
+  }
+  return std::pow((value + T(0.055)) / T(1.055), T(2.4));
+}
+
+template <class T>
+inline EnableIfFloating<T, T> encodeSRGB(T value) {
+  if (value <= T(0.0031308)) {
+    return value * T(12.92);
+  }
+  return T(1.055) * std::pow(value, T(1) / T(2.4)) - T(0.055);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> decodeSRGB(const Color3<T>& color) {
+  return Color3<T>(decodeSRGB(color.r),
+                   decodeSRGB(color.g),
+                   decodeSRGB(color.b));
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> encodeSRGB(const Color3<T>& color) {
+  return Color3<T>(encodeSRGB(color.r),
+                   encodeSRGB(color.g),
+                   encodeSRGB(color.b));
+}
+
+template <class T>
+inline EnableIfFloating<T, Color4<T>> decodeSRGB(const Color4<T>& color) {
+  return Color4<T>(decodeSRGB(color.r),
+                   decodeSRGB(color.g),
+                   decodeSRGB(color.b),
+                   color.a);
+}
+
+template <class T>
+inline EnableIfFloating<T, Color4<T>> encodeSRGB(const Color4<T>& color) {
+  return Color4<T>(encodeSRGB(color.r),
+                   encodeSRGB(color.g),
+                   encodeSRGB(color.b),
+                   color.a);
+}
+
+#pragma mark Buffers
+
+inline void decodeSRGB(const std::uint8_t *values,
+                       std::size_t size,
+                       float *result) {
+  const auto& tables = detail::srgbTables();
+  for (std::size_t i{}; i < size; ++i) {
+    result[i] = tables.decode[values[i]];
+  }
+}
+
+inline void decodeSRGB(const float *values, std::size_t size, float *result) {
+  std::size_t i{};
+#if TAKRAM_GRAPHICS_HAS_SSE2
+  for (; i + 4 <= size; i += 4) {
+    _mm_storeu_ps(result + i, detail::decodeSRGBFast(_mm_loadu_ps(values + i)));
+  }
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+  for (; i < size; ++i) {
+    result[i] = detail::decodeSRGBFast(values[i]);
+  }
+}
+
+inline void encodeSRGB(const float *values, std::size_t size, float *result) {
+  std::size_t i{};
+#if TAKRAM_GRAPHICS_HAS_SSE2
+  for (; i + 4 <= size; i += 4) {
+    _mm_storeu_ps(result + i, detail::encodeSRGBFast(_mm_loadu_ps(values + i)));
+  }
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+  for (; i < size; ++i) {
+    result[i] = detail::encodeSRGBFast(values[i]);
+  }
+}
+
+inline void encodeSRGB(const float *values,
+                       std::size_t size,
+                       std::uint8_t *result) {
+  const auto& tables = detail::srgbTables();
+  std::size_t i{};
+#if TAKRAM_GRAPHICS_HAS_SSE2
+  const auto max = _mm_set1_ps(Depth<std::uint8_t>::max);
+  const auto half = _mm_set1_ps(0.5f);
+  for (; i + 4 <= size; i += 4) {
+    const auto value = _mm_loadu_ps(values + i);
+    const auto encoded = detail::encodeSRGBFast(value);
+    std::int32_t codes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(codes), _mm_cvttps_epi32(
+        _mm_add_ps(_mm_mul_ps(encoded, max), half)));
+    float clamped[4];
+    _mm_storeu_ps(clamped, detail::clampSRGB(value));
+    for (int j{}; j < 4; ++j) {
+      result[i + j] = detail::correctSRGBCode(clamped[j], codes[j], tables);
+    }
+  }
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+  for (; i < size; ++i) {
+    const auto value = detail::clampSRGB(values[i]);
+    const auto encoded = detail::encodeSRGBFast(value);
+    const auto code = static_cast<int>(encoded * 255.0f + 0.5f);
+    result[i] = detail::correctSRGBCode(value, code, tables);
+  }
+}
+
+#pragma mark Images
+
+template <class T, class U, int C>
+inline void decodeSRGB(const ImageView<U, C>& image, ImageView<T, C> result) {
+  detail::convertSRGB(image, result, [](const U *values,
+                                        std::size_t size,
+                                        T *result) {
+    decodeSRGB(values, size, result);
+  });
+}
+
+template <class T, class U, int C>
+inline void encodeSRGB(const ImageView<U, C>& image, ImageView<T, C> result) {
+  detail::convertSRGB(image, result, [](const U *values,
+                                        std::size_t size,
+                                        T *result) {
+    encodeSRGB(values, size, result);
+  });
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::decodeSRGB;
+using graphics::encodeSRGB;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_SRGB_H_
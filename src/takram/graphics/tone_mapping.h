@@ -0,0 +1,343 @@
+//
+//  takram/graphics/tone_mapping.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_TONE_MAPPING_H_
+#define TAKRAM_GRAPHICS_TONE_MAPPING_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/image_view.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/simd.h"
+#include "takram/graphics/srgb.h"
+#include "takram/graphics/tone_map_operator.h"
+#include "takram/math/enablers.h"
+
+namespace takram {
+namespace graphics {
+
+// Maps linear colors of high dynamic range to the display range, after
+// scaling them by an exposure. The operators apply to every color channel on
+// its own:
+//
+// - Reinhard maps x to x / (1 + x), which approaches white asymptotically.
+// - ACES evaluates the rational fit by Narkowicz of the reference rendering
+//   transform of ACES, which has a toe and a shoulder and reaches white.
+// - Filmic evaluates the curve by Hable used in Uncharted 2, normalized to
+//   reach white at a linear value of 11.2.
+//
+// Single values and colors are mapped to linear values in [0, 1], leaving
+// alpha as it is. Buffers and images of floats are mapped, encoded to sRGB
+// and converted in depth in a single pass over their pixels, which runs on
+// four channels at once with SSE2 where available. Buffers are split into
+// chunks and images into rows, which run in parallel. Encoding to 8 bits
+// yields the same codes as encodeSRGB, and alpha is only converted in depth.
+// Negative values and NaNs are taken as zero.
+
+template <class T>
+EnableIfFloating<T, T> toneMap(T value, ToneMapOperator op);
+template <class T>
+EnableIfFloating<T, Color3<T>> toneMap(const Color3<T>& color,
+                                       ToneMapOperator op,
+                                       T exposure = 1);
+template <class T>
+EnableIfFloating<T, Color4<T>> toneMap(const Color4<T>& color,
+                                       ToneMapOperator op,
+                                       T exposure = 1);
+
+// Buffers and images, encoded to sRGB
+template <class T, int C>
+void toneMapSRGB(const Color<float, C> *colors,
+                 std::size_t size,
+                 Color<T, C> *result,
+                 ToneMapOperator op = ToneMapOperator::ACES,
+                 float exposure = 1);
+template <class T, class U, int C>
+void toneMapSRGB(const ImageView<U, C>& image,
+                 ImageView<T, C> result,
+                 ToneMapOperator op = ToneMapOperator::ACES,
+                 float exposure = 1);
+
+#pragma mark -
+
+namespace detail {
+
+// The operators, written once for single values and lanes
+struct ReinhardToneMap {
+  template <class V>
+  V operator()(const V& x) const {
+    return x / (V(1.0) + x);
+  }
+};
+
+struct ACESToneMap {
+  template <class V>
+  V operator()(const V& x) const {
+    return (x * (V(2.51) * x + V(0.03))) /
+           (x * (V(2.43) * x + V(0.59)) + V(0.14));
+  }
+};
+
+struct FilmicToneMap {
+  // Hable's curve with its shoulder, linear, angle and toe strengths and its
+  // toe numerator and denominator of 0.15, 0.5, 0.1, 0.2, 0.02 and 0.3
+  template <class V>
+  static V curve(const V& x) {
+    return (x * (V(0.15) * x + V(0.05)) + V(0.004)) /
+           (x * (V(0.15) * x + V(0.5)) + V(0.06)) - V(0.02 / 0.3);
+  }
+
+  template <class V>
+  V operator()(const V& x) const {
+    return curve(x) * V(1.0 / curve(11.2));
+  }
+};
+
+// Linear values beyond the largest half make no difference to any operator
+// and keep them from dividing infinities
+inline float toneMapLimit() {
+  return 65504.0f;
+}
+
+template <class T, class Operator>
+inline T toneMapValue(T value, Operator op) {
+  const auto limit = static_cast<T>(toneMapLimit());
+  value = value > 0 ? (value < limit ? value : limit) : 0;
+  return std::min(op(value), T(1));
+}
+
+inline Lanes encodeSRGBLanes(const Lanes& lanes) {
+#if TAKRAM_GRAPHICS_HAS_SSE2
+  return encodeSRGBFast(lanes.value);
+#else
+  Lanes result;
+  for (int i{}; i < 4; ++i) {
+    result.value[i] = encodeSRGBFast(lanes.value[i]);
+  }
+  return result;
+#endif  // TAKRAM_GRAPHICS_HAS_SSE2
+}
+
+inline Lanes loadToneMapped(const Color3f& color) {
+  const float values[4]{color.r, color.g, color.b};
+  return loadLanes(values);
+}
+
+inline Lanes loadToneMapped(const Color4f& color) {
+  return loadLanes(color.pointer());
+}
+
+inline float toneMapAlpha(float alpha) {
+  return alpha > 0 ? (alpha < 1 ? alpha : 1) : 0;
+}
+
+// Stores the color channels of a pixel from their mapped linear values and
+// their encodings, and converts alpha in depth
+template <int C>
+inline void storeToneMapped(const float *linear,
+                            const float *encoded,
+                            const Color<float, C>& color,
+                            const SRGBTables& tables,
+                            Color<std::uint8_t, C> *result) {
+  for (int channel{}; channel < 3; ++channel) {
+    const auto code = static_cast<int>(encoded[channel] * 255.0f + 0.5f);
+    result->vector[channel] = correctSRGBCode(linear[channel], code, tables);
+  }
+  for (int channel = 3; channel < C; ++channel) {
+    result->vector[channel] = Depth<std::uint8_t>::convert(
+        toneMapAlpha(color.vector[channel]));
+  }
+}
+
+template <class T, int C>
+inline void storeToneMapped(const float *,
+                            const float *encoded,
+                            const Color<float, C>& color,
+                            const SRGBTables&,
+                            Color<T, C> *result) {
+  for (int channel{}; channel < 3; ++channel) {
+    result->vector[channel] = Depth<T>::convert(encoded[channel]);
+  }
+  for (int channel = 3; channel < C; ++channel) {
+    result->vector[channel] = Depth<T>::convert(
+        toneMapAlpha(color.vector[channel]));
+  }
+}
+
+template <class T, int C, class Operator>
+inline void toneMapPixels(const Color<float, C> *colors,
+                          std::size_t size,
+                          Color<T, C> *result,
+                          float exposure,
+                          Operator op) {
+  const auto& tables = srgbTables();
+  const Lanes scale(exposure);
+  const Lanes zero(0.0f);
+  const Lanes one(1.0f);
+  const Lanes limit(toneMapLimit());
+  for (std::size_t i{}; i < size; ++i) {
+    // The maximum takes NaNs as zero, being the second operand
+    const auto value = min(max(loadToneMapped(colors[i]) * scale, zero),
+                           limit);
+    const auto linear = min(op(value), one);
+    const auto encoded = min(max(encodeSRGBLanes(linear), zero), one);
+    float linears[4];
+    float encodings[4];
+    storeLanes(linear, linears);
+    storeLanes(encoded, encodings);
+    storeToneMapped(linears, encodings, colors[i], tables, result + i);
+  }
+}
+
+template <class T, int C>
+inline void toneMapSpan(const Color<float, C> *colors,
+                        std::size_t size,
+                        Color<T, C> *result,
+                        ToneMapOperator op,
+                        float exposure) {
+  switch (op) {
+    case ToneMapOperator::REINHARD:
+      toneMapPixels(colors, size, result, exposure, ReinhardToneMap());
+      break;
+    case ToneMapOperator::ACES:
+      toneMapPixels(colors, size, result, exposure, ACESToneMap());
+      break;
+    case ToneMapOperator::FILMIC:
+      toneMapPixels(colors, size, result, exposure, FilmicToneMap());
+      break;
+    default:
+      assert(false);
+      break;
+  }
+}
+
+}  // namespace detail
+
+#pragma mark Single values
+
+template <class T>
+inline EnableIfFloating<T, T> toneMap(T value, ToneMapOperator op) {
+  switch (op) {
+    case ToneMapOperator::REINHARD:
+      return detail::toneMapValue(value, detail::ReinhardToneMap());
+    case ToneMapOperator::ACES:
+      return detail::toneMapValue(value, detail::ACESToneMap());
+    case ToneMapOperator::FILMIC:
+      return detail::toneMapValue(value, detail::FilmicToneMap());
+    default:
+      assert(false);
+      break;
+  }
+  return value;
+}
+
+template <class T>
+inline EnableIfFloating<T, Color3<T>> toneMap(const Color3<T>& color,
+                                              ToneMapOperator op,
+                                              T exposure) {
+  return Color3<T>(toneMap(color.r * exposure, op),
+                   toneMap(color.g * exposure, op),
+                   toneMap(color.b * exposure, op));
+}
+
+template <class T>
+inline EnableIfFloating<T, Color4<T>> toneMap(const Color4<T>& color,
+                                              ToneMapOperator op,
+                                              T exposure) {
+  return Color4<T>(toneMap(color.r * exposure, op),
+                   toneMap(color.g * exposure, op),
+                   toneMap(color.b * exposure, op),
+                   color.a);
+}
+
+#pragma mark Buffers
+
+template <class T, int C>
+inline void toneMapSRGB(const Color<float, C> *colors,
+                        std::size_t size,
+                        Color<T, C> *result,
+                        ToneMapOperator op,
+                        float exposure) {
+  static_assert(C == 3 || C == 4, "Colors must have 3 or 4 channels");
+  const std::size_t chunk = 0x4000;
+  parallelFor((size + chunk - 1) / chunk, [&](std::size_t index) {
+    const auto begin = index * chunk;
+    detail::toneMapSpan(colors + begin, std::min(chunk, size - begin),
+                        result + begin, op, exposure);
+  });
+}
+
+#pragma mark Images
+
+template <class T, class U, int C>
+inline void toneMapSRGB(const ImageView<U, C>& image,
+                        ImageView<T, C> result,
+                        ToneMapOperator op,
+                        float exposure) {
+  static_assert(std::is_same<typename std::remove_const<U>::type,
+                             float>::value,
+                "Images to tone map must have floats");
+  static_assert(sizeof(Color<float, C>) == sizeof(float) * C,
+                "Colors must be tightly packed");
+  static_assert(sizeof(Color<T, C>) == sizeof(T) * C,
+                "Colors must be tightly packed");
+  assert(image.width() == result.width());
+  assert(image.height() == result.height());
+  parallelFor(image.height(), [&](std::size_t index) {
+    const auto y = static_cast<int>(index);
+    if (image.interleaved() && result.interleaved()) {
+      detail::toneMapSpan(
+          reinterpret_cast<const Color<float, C> *>(image.row(y)),
+          image.width(), reinterpret_cast<Color<T, C> *>(result.row(y)),
+          op, exposure);
+      return;
+    }
+    for (int x{}; x < image.width(); ++x) {
+      const auto color = image.pixel(x, y);
+      Color<T, C> mapped;
+      detail::toneMapSpan(&color, 1, &mapped, op, exposure);
+      result.setPixel(x, y, mapped);
+    }
+  });
+}
+
+}  // namespace graphics
+
+namespace gfx = graphics;
+
+using graphics::toneMap;
+using graphics::toneMapSRGB;
+
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_TONE_MAPPING_H_
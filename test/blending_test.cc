@@ -0,0 +1,314 @@
+//
+//  takram/graphics/blending_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/blend_mode.h"
+#include "takram/graphics/blending.h"
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+#include "takram/graphics/premultiplied_color.h"
+
+#include "color_helpers.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+const BlendMode modes[] = {
+  BlendMode::NORMAL,
+  BlendMode::MULTIPLY,
+  BlendMode::SCREEN,
+  BlendMode::OVERLAY,
+  BlendMode::DARKEN,
+  BlendMode::LIGHTEN,
+  BlendMode::COLOR_DODGE,
+  BlendMode::COLOR_BURN,
+  BlendMode::HARD_LIGHT,
+  BlendMode::SOFT_LIGHT,
+  BlendMode::DIFFERENCE,
+  BlendMode::EXCLUSION
+};
+
+// The blend functions straight from the specification
+double blendFunction(BlendMode mode, double b, double s) {
+  switch (mode) {
+    case BlendMode::NORMAL: return s;
+    case BlendMode::MULTIPLY: return b * s;
+    case BlendMode::SCREEN: return b + s - b * s;
+    case BlendMode::OVERLAY: return blendFunction(BlendMode::HARD_LIGHT, s, b);
+    case BlendMode::DARKEN: return std::min(b, s);
+    case BlendMode::LIGHTEN: return std::max(b, s);
+    case BlendMode::COLOR_DODGE:
+      if (b == 0) return 0;
+      if (s == 1) return 1;
+      return std::min(1.0, b / (1 - s));
+    case BlendMode::COLOR_BURN:
+      if (b == 1) return 1;
+      if (s == 0) return 0;
+      return 1 - std::min(1.0, (1 - b) / s);
+    case BlendMode::HARD_LIGHT:
+      if (s <= 0.5) return blendFunction(BlendMode::MULTIPLY, b, 2 * s);
+      return blendFunction(BlendMode::SCREEN, b, 2 * s - 1);
+    case BlendMode::SOFT_LIGHT: {
+      if (s <= 0.5) return b - (1 - 2 * s) * b * (1 - b);
+      const auto d = b <= 0.25 ? ((16 * b - 12) * b + 4) * b : std::sqrt(b);
+      return b + (2 * s - 1) * (d - b);
+    }
+    case BlendMode::DIFFERENCE: return std::abs(b - s);
+    case BlendMode::EXCLUSION: return b + s - 2 * b * s;
+    default:
+      return NAN;
+  }
+}
+
+// Blends straight colors in double, and returns the premultiplied result
+void blendReference(BlendMode mode,
+                    const Color4d& source,
+                    const Color4d& backdrop,
+                    double *result) {
+  const auto as = source.a;
+  const auto ab = backdrop.a;
+  for (int i{}; i < 3; ++i) {
+    const auto s = source.vector[i];
+    const auto b = backdrop.vector[i];
+    result[i] = as * (1 - ab) * s + ab * (1 - as) * b +
+                as * ab * blendFunction(mode, b, s);
+  }
+  result[3] = as + ab - as * ab;
+}
+
+// Random colors, some of whose alpha and red channels are at the extremes
+std::vector<Color4u> makeSampleColors(std::size_t size, unsigned seed) {
+  auto result = makeColors<std::uint8_t, 4>(size, seed);
+  for (std::size_t i{}; i < size; ++i) {
+    auto& color = result[i];
+    if (i % 7 == 0) {
+      color.a = i % 14 ? 0 : 255;
+    }
+    if (i % 11 == 0) {
+      color.r = i % 22 ? 0 : 255;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(BlendingTest, BlendsOpaqueColors) {
+  const Color4f backdrop(0.5f, 0.25f, 1.0f);
+  const Color4f source(0.5f, 0.5f, 0.0f);
+  EXPECT_EQ(blend(source, backdrop, BlendMode::NORMAL), source);
+  EXPECT_EQ(blend(source, backdrop, BlendMode::MULTIPLY),
+            Color4f(0.25f, 0.125f, 0.0f));
+  EXPECT_EQ(blend(source, backdrop, BlendMode::SCREEN),
+            Color4f(0.75f, 0.625f, 1.0f));
+  EXPECT_EQ(blend(source, backdrop, BlendMode::DARKEN),
+            Color4f(0.5f, 0.25f, 0.0f));
+  EXPECT_EQ(blend(source, backdrop, BlendMode::LIGHTEN),
+            Color4f(0.5f, 0.5f, 1.0f));
+  EXPECT_EQ(blend(source, backdrop, BlendMode::DIFFERENCE),
+            Color4f(0.0f, 0.25f, 1.0f));
+  EXPECT_EQ(blend(Color4u(255, 0, 128), Color4u(0, 0, 255),
+                  BlendMode::COLOR_DODGE),
+            Color4u(0, 0, 255));
+}
+
+TEST(BlendingTest, BlendsTransparentColors) {
+  const Color4f color(0.2f, 0.4f, 0.6f, 0.8f);
+  const Color4f transparent(1.0f, 1.0f, 1.0f, 0.0f);
+  for (const auto mode : modes) {
+    const auto over = blend(transparent, color, mode);
+    const auto under = blend(color, transparent, mode);
+    for (int i{}; i < 4; ++i) {
+      EXPECT_NEAR(over.vector[i], color.vector[i], 1e-6) << mode;
+      EXPECT_NEAR(under.vector[i], color.vector[i], 1e-6) << mode;
+    }
+    EXPECT_EQ(blend(transparent, transparent, mode), Color4f(0, 0)) << mode;
+  }
+}
+
+TEST(BlendingTest, BlendsFloats) {
+  const auto source = makeSampleColors(1001, 1);
+  const auto backdrop = makeSampleColors(1001, 2);
+  for (const auto mode : modes) {
+    std::vector<Color4f> s(source.begin(), source.end());
+    std::vector<Color4f> result(backdrop.begin(), backdrop.end());
+    blend(s.data(), result.data(), result.size(), mode);
+    for (std::size_t i{}; i < source.size(); ++i) {
+      double expected[4];
+      blendReference(mode, source[i], backdrop[i], expected);
+      for (int j{}; j < 3; ++j) {
+        const auto value = expected[3] ? expected[j] / expected[3] : 0.0;
+        ASSERT_NEAR(result[i].vector[j], value, 1e-5) << mode;
+      }
+      ASSERT_NEAR(result[i].a, expected[3], 1e-6) << mode;
+    }
+  }
+}
+
+TEST(BlendingTest, BlendsBytes) {
+  const auto source = makeSampleColors(1001, 3);
+  const auto backdrop = makeSampleColors(1001, 4);
+  for (const auto mode : modes) {
+    auto result = backdrop;
+    blend(source.data(), result.data(), result.size(), mode);
+    for (std::size_t i{}; i < source.size(); ++i) {
+      double expected[4];
+      blendReference(mode, source[i], backdrop[i], expected);
+      for (int j{}; j < 3; ++j) {
+        const auto value = expected[3] ? expected[j] / expected[3] : 0.0;
+        ASSERT_NEAR(result[i].vector[j], value * 255, 0.5 + 1e-3) << mode;
+      }
+      ASSERT_NEAR(result[i].a, expected[3] * 255, 0.5 + 1e-3) << mode;
+      ASSERT_EQ(result[i], blend(source[i], backdrop[i], mode)) << mode;
+    }
+  }
+}
+
+TEST(BlendingTest, RoundsBytesAsDepth) {
+  // Halves between codes, and the floats next to them
+  std::vector<float> values{-1.0f, 0.0f, 1.0f, 2.0f};
+  for (int code{}; code < 255; ++code) {
+    const auto half = (code + 0.5f) / 255;
+    values.push_back(half);
+    values.push_back(std::nextafter(half, 0.0f));
+    values.push_back(std::nextafter(half, 1.0f));
+  }
+  values.resize((values.size() + 3) / 4 * 4, 0.5f);
+  for (std::size_t i{}; i < values.size(); i += 4) {
+    std::uint8_t codes[4];
+    detail::storeLanes(detail::loadLanes(values.data() + i), codes);
+    for (int j{}; j < 4; ++j) {
+      const auto value = std::min(std::max(values[i + j], 0.0f), 1.0f);
+      ASSERT_EQ(codes[j], Depth<std::uint8_t>::convert(value))
+          << values[i + j];
+    }
+  }
+}
+
+TEST(BlendingTest, BlendsPremultipliedColors) {
+  const auto source = makeSampleColors(1001, 5);
+  const auto backdrop = makeSampleColors(1001, 6);
+  for (const auto mode : modes) {
+    std::vector<PremultipliedColor4f> s;
+    std::vector<PremultipliedColor4f> result;
+    for (std::size_t i{}; i < source.size(); ++i) {
+      s.emplace_back(Color4f(source[i]));
+      result.emplace_back(Color4f(backdrop[i]));
+    }
+    blend(s.data(), result.data(), result.size(), mode);
+    for (std::size_t i{}; i < source.size(); ++i) {
+      double expected[4];
+      blendReference(mode, source[i], backdrop[i], expected);
+      ASSERT_NEAR(result[i].r, expected[0], 1e-5) << mode;
+      ASSERT_NEAR(result[i].g, expected[1], 1e-5) << mode;
+      ASSERT_NEAR(result[i].b, expected[2], 1e-5) << mode;
+      ASSERT_NEAR(result[i].a, expected[3], 1e-6) << mode;
+    }
+  }
+}
+
+TEST(BlendingTest, BlendsOtherDepths) {
+  const auto source = makeSampleColors(101, 7);
+  const auto backdrop = makeSampleColors(101, 8);
+  for (const auto mode : modes) {
+    std::vector<Color4s> s(source.begin(), source.end());
+    std::vector<Color4s> result(backdrop.begin(), backdrop.end());
+    blend(s.data(), result.data(), result.size(), mode);
+    for (std::size_t i{}; i < source.size(); ++i) {
+      double expected[4];
+      blendReference(mode, source[i], backdrop[i], expected);
+      const auto value = expected[3] ? expected[0] / expected[3] : 0.0;
+      ASSERT_NEAR(result[i].r, value * 65535, 2) << mode;
+    }
+  }
+}
+
+TEST(BlendingTest, BlendsImages) {
+  Image4f source(7, 3);
+  Image4f destination(7, 3, ImageLayout::PLANAR);
+  Image4f expected(7, 3);
+  for (int y{}; y < source.height(); ++y) {
+    for (int x{}; x < source.width(); ++x) {
+      source.setPixel(x, y, Color4f(x / 7.0f, y / 3.0f, 0.5f, x / 8.0f));
+      destination.setPixel(x, y, Color4f(0.0f, 0.25f, 0.75f, 1.0f));
+      expected.setPixel(x, y, destination.pixel(x, y));
+    }
+  }
+  blend(source.view(), destination.view(), BlendMode::OVERLAY);
+  blend(source.view(), expected.view(), BlendMode::OVERLAY);
+  for (int y{}; y < source.height(); ++y) {
+    for (int x{}; x < source.width(); ++x) {
+      const auto s = source.pixel(x, y);
+      const auto d = Color4f(0.0f, 0.25f, 0.75f, 1.0f);
+      const auto result = blend(PremultipliedColor4f(s.r, s.g, s.b, s.a),
+                                PremultipliedColor4f(d.r, d.g, d.b, d.a),
+                                BlendMode::OVERLAY);
+      const auto pixel = destination.pixel(x, y);
+      ASSERT_EQ(pixel, Color4f(result.r, result.g, result.b, result.a));
+      ASSERT_EQ(pixel, expected.pixel(x, y));
+    }
+  }
+}
+
+// Run with --gtest_also_run_disabled_tests to measure every mode
+TEST(BlendingTest, DISABLED_Benchmark) {
+  using Clock = std::chrono::steady_clock;
+  const std::size_t size = 3840 * 2160;
+  const auto source = makeSampleColors(size, 9);
+  const auto backdrop = makeSampleColors(size, 10);
+  const std::vector<Color4f> source_floats(source.begin(), source.end());
+  const std::vector<Color4f> backdrop_floats(backdrop.begin(), backdrop.end());
+  for (const auto mode : modes) {
+    auto bytes = backdrop;
+    auto start = Clock::now();
+    blend(source.data(), bytes.data(), size, mode);
+    const std::chrono::duration<double, std::milli> bytes_time =
+        Clock::now() - start;
+    auto floats = backdrop_floats;
+    start = Clock::now();
+    blend(source_floats.data(), floats.data(), size, mode);
+    const std::chrono::duration<double, std::milli> floats_time =
+        Clock::now() - start;
+    std::cout << mode << ": " << bytes_time.count() << " ms (Color4u), "
+              << floats_time.count() << " ms (Color4f)" << std::endl;
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
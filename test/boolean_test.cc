@@ -0,0 +1,227 @@
+//
+//  test/boolean_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <list>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/boolean.h"
+#include "takram/graphics/boolean_operation.h"
+#include "takram/graphics/fill_rule.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/vector.h"
+
+#include "shape_helpers.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+Shape2d makeCircle(double x, double y, double radius) {
+  const auto weight = std::sqrt(2.0) / 2;
+  Shape2d shape;
+  shape.moveTo(x + radius, y);
+  shape.conicTo(x + radius, y + radius, x, y + radius, weight);
+  shape.conicTo(x - radius, y + radius, x - radius, y, weight);
+  shape.conicTo(x - radius, y - radius, x, y - radius, weight);
+  shape.conicTo(x + radius, y - radius, x + radius, y, weight);
+  shape.close();
+  return shape;
+}
+
+}  // namespace
+
+TEST(BooleanTest, Unites) {
+  const auto a = makeRectangle(0, 0, 2, 2);
+  const auto b = makeRectangle(1, 1, 2, 2);
+  const auto shape = a.united(b);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 7, 1e-9);
+  const auto bounds = shape.bounds();
+  EXPECT_DOUBLE_EQ(bounds.minX(), 0);
+  EXPECT_DOUBLE_EQ(bounds.minY(), 0);
+  EXPECT_DOUBLE_EQ(bounds.maxX(), 3);
+  EXPECT_DOUBLE_EQ(bounds.maxY(), 3);
+}
+
+TEST(BooleanTest, DissolvesSharedEdges) {
+  const auto a = makeRectangle(0, 0, 1, 1);
+  const auto b = makeRectangle(1, 0, 1, 1);
+  const auto shape = a.united(b);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 2, 1e-9);
+  // The shared edge disappears, leaving collinear lines of the outline
+  EXPECT_EQ(shape.front().size(), 8);
+}
+
+TEST(BooleanTest, Intersects) {
+  const auto a = makeRectangle(0, 0, 2, 2);
+  const auto b = makeRectangle(1, 1, 2, 2);
+  const auto shape = a.intersected(b);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 1, 1e-9);
+  EXPECT_TRUE(a.intersected(makeRectangle(3, 3, 1, 1)).empty());
+}
+
+TEST(BooleanTest, Subtracts) {
+  const auto a = makeRectangle(0, 0, 3, 3);
+  const auto b = makeRectangle(1, 1, 1, 1);
+  const auto shape = a.subtracted(b);
+  ASSERT_EQ(shape.size(), 2);
+  EXPECT_NEAR(calculateArea(shape), 8, 1e-9);
+  EXPECT_TRUE(b.subtracted(a).empty());
+}
+
+TEST(BooleanTest, Excludes) {
+  const auto a = makeRectangle(0, 0, 2, 2);
+  const auto b = makeRectangle(1, 1, 2, 2);
+  const auto shape = a.excluded(b);
+  ASSERT_EQ(shape.size(), 2);
+  EXPECT_NEAR(calculateArea(shape), 6, 1e-9);
+}
+
+TEST(BooleanTest, ResolvesSelfOverlaps) {
+  // A figure eight and a doubly wound square
+  Shape2d shape;
+  shape.moveTo(0, 0);
+  shape.lineTo(2, 2);
+  shape.lineTo(2, 0);
+  shape.lineTo(0, 2);
+  shape.close();
+  auto result = shape.united(Shape2d());
+  EXPECT_EQ(result.size(), 2);
+  EXPECT_NEAR(std::abs(calculateArea(result)), 2, 1e-9);
+  auto square = makeRectangle(0, 0, 1, 1);
+  square.paths().emplace_back(square.front());
+  result = square.united(Shape2d());
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_NEAR(calculateArea(result), 1, 1e-9);
+}
+
+TEST(BooleanTest, AppliesFillRules) {
+  // A square inside another wound in the same direction
+  auto shape = makeRectangle(0, 0, 3, 3);
+  shape.paths().emplace_back(makeRectangle(1, 1, 1, 1).front());
+  const auto& paths = shape.paths();
+  const std::list<Path2d> empty;
+  Shape2d result(Boolean2d::apply(paths, empty, BooleanOperation::UNION));
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_NEAR(calculateArea(result), 9, 1e-9);
+  result = Shape2d(Boolean2d::apply(paths, empty, BooleanOperation::UNION,
+                                    FillRule::EVEN_ODD));
+  ASSERT_EQ(result.size(), 2);
+  EXPECT_NEAR(calculateArea(result), 8, 1e-9);
+  shape.back() = makeRectangle(1, 2, 1, -1).front();
+  result = Shape2d(Boolean2d::apply(paths, empty, BooleanOperation::UNION,
+                                    FillRule::POSITIVE));
+  ASSERT_EQ(result.size(), 2);
+  EXPECT_NEAR(calculateArea(result), 8, 1e-9);
+}
+
+TEST(BooleanTest, CombinesCurves) {
+  const auto a = makeCircle(0, 0, 1);
+  const auto b = makeCircle(1, 0, 1);
+  const auto pi = std::acos(-1.0);
+  const auto lens = 2 * std::acos(0.5) - std::sqrt(3.0) / 2;
+  auto shape = a.united(b);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 2 * pi - lens, 1e-4);
+  shape = a.intersected(b);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), lens, 1e-4);
+  shape = a.subtracted(b);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), pi - lens, 1e-4);
+}
+
+TEST(BooleanTest, UnitesInBatch) {
+  std::vector<Shape2d> shapes;
+  for (int i{}; i < 5; ++i) {
+    shapes.emplace_back(makeRectangle(i, 0, 2, 1));
+  }
+  const auto shape = Shape2d::united(shapes);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 6, 1e-9);
+}
+
+TEST(BooleanTest, UnitesTangentShapes) {
+  // Squares that touch a circle at a joint of its segments, along an edge
+  // and at a corner
+  const auto circle = makeCircle(5.25, 1.75, 4.75);
+  const auto area = std::acos(-1.0) * 4.75 * 4.75;
+  auto shape = circle.united(makeRectangle(10, 1.5, 0.5, 3.5));
+  EXPECT_NEAR(calculateArea(shape), area + 1.75, 1e-3);
+  shape = circle.united(makeRectangle(5.25, -4, 2, 1));
+  EXPECT_NEAR(calculateArea(shape), area + 2, 1e-3);
+  shape = circle.united(makeRectangle(10, 1.75, 1, 1));
+  EXPECT_NEAR(calculateArea(shape), area + 1, 1e-3);
+}
+
+TEST(BooleanTest, UnitesManyShapes) {
+  // Grids of adjacent squares, one of which is offset by half a square
+  const int size = 20;
+  Shape2d a;
+  Shape2d b;
+  for (int i{}; i < size; ++i) {
+    for (int j{}; j < size; ++j) {
+      a.paths().emplace_back(makeRectangle(i, j, 1, 1).front());
+      b.paths().emplace_back(makeRectangle(i + 0.5, j + 0.5, 1, 1).front());
+    }
+  }
+  const auto shape = a.united(b);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape),
+              2 * size * size - (size - 0.5) * (size - 0.5), 1e-9);
+}
+
+TEST(BooleanTest, DISABLED_Benchmark) {
+  // Grids of circles, each of which crosses four of the other grid
+  using Clock = std::chrono::steady_clock;
+  for (const int size : {16, 50, 112}) {
+    Shape2d a;
+    Shape2d b;
+    for (int i{}; i < size; ++i) {
+      for (int j{}; j < size; ++j) {
+        a.paths().emplace_back(makeCircle(i, j, 0.4).front());
+        b.paths().emplace_back(makeCircle(i + 0.5, j + 0.5, 0.4).front());
+      }
+    }
+    const auto start = Clock::now();
+    const auto shape = a.united(b);
+    const std::chrono::duration<double, std::milli> time = Clock::now() - start;
+    std::cout << 8 * size * size << " segments: " << time.count() << " ms"
+              << std::endl;
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,66 @@
+//
+//  test/color_helpers.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_TEST_COLOR_HELPERS_H_
+#define TAKRAM_GRAPHICS_TEST_COLOR_HELPERS_H_
+
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "takram/graphics/color.h"
+
+namespace takram {
+namespace graphics {
+
+// Colors whose channels are uniformly distributed over the range of integral
+// types, or over [0, 1] for floating-point types, drawn in the order of the
+// channels
+template <class T, int C>
+inline std::vector<Color<T, C>> makeColors(std::size_t size, unsigned seed) {
+  using Distribution = std::conditional_t<
+      std::is_integral<T>::value,
+      std::uniform_int_distribution<int>,
+      std::uniform_real_distribution<T>>;
+  std::mt19937 engine(seed);
+  Distribution distribution(0, std::is_integral<T>::value ?
+                                   std::numeric_limits<T>::max() : 1);
+  std::vector<Color<T, C>> result(size);
+  for (auto& color : result) {
+    for (int i{}; i < C; ++i) {
+      color.vector[i] = static_cast<T>(distribution(engine));
+    }
+  }
+  return result;
+}
+
+}  // namespace graphics
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_TEST_COLOR_HELPERS_H_
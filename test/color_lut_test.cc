@@ -0,0 +1,204 @@
+//
+//  takram/graphics/color_lut_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/color_lut.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+void expectNear(const Color3f& actual, const Color3f& expected, float error) {
+  EXPECT_NEAR(actual.r, expected.r, error);
+  EXPECT_NEAR(actual.g, expected.g, error);
+  EXPECT_NEAR(actual.b, expected.b, error);
+}
+
+// Tetrahedral interpolation by the six cases of the order of the fractions
+Color3f interpolate(const ColorLUT& lut, const Color3f& color) {
+  const auto last = lut.size() - 1;
+  double position[3];
+  int cell[3];
+  double f[3];
+  for (int i{}; i < 3; ++i) {
+    position[i] = std::min(std::max<double>(color.vector[i], 0), 1.0) * last;
+    cell[i] = std::min(static_cast<int>(position[i]), last - 1);
+    f[i] = position[i] - cell[i];
+  }
+  const auto c = [&](int r, int g, int b) {
+    return lut.entry(cell[0] + r, cell[1] + g, cell[2] + b);
+  };
+  const auto sum = [](const Color3f& a, double wa, const Color3f& b, double wb,
+                      const Color3f& c, double wc, const Color3f& d,
+                      double wd) {
+    Color3f result;
+    for (int i{}; i < 3; ++i) {
+      result.vector[i] = a.vector[i] * wa + b.vector[i] * wb +
+                         c.vector[i] * wc + d.vector[i] * wd;
+    }
+    return result;
+  };
+  const auto r = f[0];
+  const auto g = f[1];
+  const auto b = f[2];
+  if (r > g) {
+    if (g > b) {
+      return sum(c(0, 0, 0), 1 - r, c(1, 0, 0), r - g,
+                 c(1, 1, 0), g - b, c(1, 1, 1), b);
+    } else if (r > b) {
+      return sum(c(0, 0, 0), 1 - r, c(1, 0, 0), r - b,
+                 c(1, 0, 1), b - g, c(1, 1, 1), g);
+    }
+    return sum(c(0, 0, 0), 1 - b, c(0, 0, 1), b - r,
+               c(1, 0, 1), r - g, c(1, 1, 1), g);
+  }
+  if (b > g) {
+    return sum(c(0, 0, 0), 1 - b, c(0, 0, 1), b - g,
+               c(0, 1, 1), g - r, c(1, 1, 1), r);
+  } else if (b > r) {
+    return sum(c(0, 0, 0), 1 - g, c(0, 1, 0), g - b,
+               c(0, 1, 1), b - r, c(1, 1, 1), r);
+  }
+  return sum(c(0, 0, 0), 1 - g, c(0, 1, 0), g - r,
+             c(1, 1, 0), r - b, c(1, 1, 1), b);
+}
+
+}  // namespace
+
+TEST(ColorLUTTest, InterpolatesTetrahedra) {
+  std::mt19937 engine(1);
+  std::uniform_real_distribution<float> distribution(-0.2f, 1.2f);
+  const ColorLUT lut(9, [](const Color3f& color) {
+    return Color3f(std::sin(color.r * 3 + color.b),
+                   color.g * color.g - color.r,
+                   std::sqrt(color.b + color.g * 0.5f));
+  });
+  for (int i{}; i < 1000; ++i) {
+    const Color3f color(distribution(engine), distribution(engine),
+                        distribution(engine));
+    expectNear(lut.apply(color), interpolate(lut, color), 1e-6f);
+  }
+  EXPECT_EQ(lut.apply(Color3f(0.5f, 0.25f, 1.0f)), lut.entry(4, 2, 8));
+  EXPECT_EQ(lut.apply(Color3f(NAN, 0.0f, 0.0f)), lut.entry(0, 0, 0));
+}
+
+TEST(ColorLUTTest, ReproducesAffineFunctions) {
+  const auto function = [](const Color3f& color) {
+    return Color3f(0.8f * color.r + 0.1f * color.g + 0.05f,
+                   0.2f * color.b + 0.7f * color.g,
+                   0.3f * color.r + 0.3f * color.g + 0.3f * color.b);
+  };
+  const ColorLUT identity(2);
+  const ColorLUT lut(17, function);
+  for (float r{}; r <= 1; r += 0.0625f / 3) {
+    for (float g{}; g <= 1; g += 0.125f / 3) {
+      for (float b{}; b <= 1; b += 0.25f / 3) {
+        const Color3f color(r, g, b);
+        expectNear(identity.apply(color), color, 1e-6f);
+        expectNear(lut.apply(color), function(color), 1e-6f);
+      }
+    }
+  }
+  expectNear(identity.apply(Color3f(-1.0f, 0.5f, 2.0f)),
+             Color3f(0.0f, 0.5f, 1.0f), 1e-6f);
+}
+
+TEST(ColorLUTTest, LoadsCubeFiles) {
+  std::istringstream stream(
+      "# Created by hand\n"
+      "TITLE \"Swap\"\n"
+      "LUT_3D_SIZE 2\n"
+      "DOMAIN_MIN 0 0 0\n"
+      "DOMAIN_MAX 2 2 2\n"
+      "\n"
+      "0 0 0\n1 0 0\n0 1 0\n1 1 0\n"
+      "0 0 1\n1 0 1\n0 1 1\n1 1 1\n");
+  ColorLUT lut;
+  ASSERT_TRUE(lut.load(stream));
+  EXPECT_EQ(lut.size(), 2);
+  EXPECT_EQ(lut.domain_max(), Color3f(2.0f, 2.0f, 2.0f));
+  EXPECT_EQ(lut.entry(1, 0, 0), Color3f(1.0f, 0.0f, 0.0f));
+  EXPECT_EQ(lut.entry(0, 1, 1), Color3f(0.0f, 1.0f, 1.0f));
+  expectNear(lut.apply(Color3f(1.0f, 0.5f, 2.0f)),
+             Color3f(0.5f, 0.25f, 1.0f), 1e-6f);
+
+  // Entries missing, and a size after entries
+  std::istringstream missing("LUT_3D_SIZE 2\n0 0 0\n1 0 0\n");
+  EXPECT_FALSE(lut.load(missing));
+  std::istringstream late("0 0 0\nLUT_3D_SIZE 2\n");
+  EXPECT_FALSE(lut.load(late));
+  EXPECT_EQ(lut.size(), 2);
+  EXPECT_FALSE(lut.load("nonexistent.cube"));
+}
+
+TEST(ColorLUTTest, AppliesToBuffersAndImages) {
+  const ColorLUT lut(33, [](const Color3f& color) {
+    return Color3f(color.b, 1 - color.g, color.r * color.r);
+  });
+  Image4u image(37, 11);
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      image.setPixel(x, y, Color4u(x * 7, y * 23, x * y, x + y));
+    }
+  }
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    Image4u result(image.width(), image.height(), layout);
+    lut.apply(image.view(), result.view());
+    for (int y{}; y < image.height(); ++y) {
+      for (int x{}; x < image.width(); ++x) {
+        const auto pixel = image.pixel(x, y);
+        const auto mapped = lut.apply(Color3f(Color3u(pixel)));
+        EXPECT_EQ(result.pixel(x, y), Color4u(Color3u(mapped), pixel.a));
+      }
+    }
+  }
+
+  std::vector<Color3f> colors;
+  for (int i{}; i < 50000; ++i) {
+    colors.emplace_back(i % 7 / 6.0f, i % 11 / 10.0f, i % 13 / 12.0f);
+  }
+  std::vector<Color3f> result(colors.size());
+  lut.apply(colors.data(), colors.size(), result.data());
+  for (std::size_t i{}; i < colors.size(); ++i) {
+    ASSERT_EQ(result[i], lut.apply(colors[i]));
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
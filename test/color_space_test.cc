@@ -0,0 +1,218 @@
+//
+//  takram/graphics/color_space_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/color_space.h"
+
+#include "color_helpers.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+template <class T>
+void expectNear(const Color3<T>& actual,
+                const Color3<T>& expected,
+                double tolerance) {
+  EXPECT_NEAR(actual.r, expected.r, tolerance);
+  EXPECT_NEAR(actual.g, expected.g, tolerance);
+  EXPECT_NEAR(actual.b, expected.b, tolerance);
+}
+
+// Random colors after achromatic ones and a primary one
+std::vector<Color3d> makeSampleColors(std::size_t size, unsigned seed) {
+  auto result = makeColors<double, 3>(size, seed);
+  const Color3d colors[]{Color3d(0, 0, 0), Color3d(1, 1, 1),
+                         Color3d(0.5, 0.5, 0.5), Color3d(1, 0, 0)};
+  std::copy(std::begin(colors), std::end(colors), std::begin(result));
+  return result;
+}
+
+}  // namespace
+
+TEST(ColorSpaceTest, ConvertsHSV) {
+  expectNear(rgbToHSV(Color3d(1, 0, 0)), Color3d(0, 1, 1), 1e-12);
+  expectNear(rgbToHSV(Color3d(0, 0.5, 0)), Color3d(120, 1, 0.5), 1e-12);
+  expectNear(rgbToHSV(Color3d(0.5, 0, 1)), Color3d(270, 1, 1), 1e-12);
+  expectNear(rgbToHSV(Color3d(1, 0, 0.5)), Color3d(330, 1, 1), 1e-12);
+  expectNear(rgbToHSV(Color3d(0.5, 0.5, 0.5)), Color3d(0, 0, 0.5), 1e-12);
+  expectNear(hsvToRGB(Color3d(60, 0.5, 1)), Color3d(1, 1, 0.5), 1e-12);
+  expectNear(hsvToRGB(Color3d(-120, 1, 1)), Color3d(0, 0, 1), 1e-12);
+  for (const auto& color : makeSampleColors(1000, 1)) {
+    expectNear(hsvToRGB(rgbToHSV(color)), color, 1e-12);
+  }
+}
+
+TEST(ColorSpaceTest, ConvertsHSL) {
+  expectNear(rgbToHSL(Color3d(1, 0, 0)), Color3d(0, 1, 0.5), 1e-12);
+  expectNear(rgbToHSL(Color3d(1, 1, 1)), Color3d(0, 0, 1), 1e-12);
+  expectNear(rgbToHSL(Color3d(0.75, 0.75, 0.25)), Color3d(60, 0.5, 0.5),
+             1e-12);
+  expectNear(hslToRGB(Color3d(240, 1, 0.25)), Color3d(0, 0, 0.5), 1e-12);
+  for (const auto& color : makeSampleColors(1000, 2)) {
+    expectNear(hslToRGB(rgbToHSL(color)), color, 1e-12);
+  }
+}
+
+TEST(ColorSpaceTest, ConvertsLab) {
+  expectNear(rgbToXYZ(Color3d(1, 1, 1)), Color3d(0.95047, 1, 1.08883), 1e-6);
+  expectNear(rgbToLab(Color3d(1, 1, 1)), Color3d(100, 0, 0), 1e-4);
+  expectNear(rgbToLab(Color3d(1, 0, 0)), Color3d(53.2408, 80.0925, 67.2032),
+             1e-3);
+  expectNear(rgbToLab(Color3d(0, 0, 1)), Color3d(32.2970, 79.1875, -107.8602),
+             1e-3);
+  expectNear(labToLCh(Color3d(50, 0, -10)), Color3d(50, 10, 270), 1e-12);
+  expectNear(lchToLab(Color3d(50, 10, 90)), Color3d(50, 0, 10), 1e-12);
+  for (const auto& color : makeSampleColors(1000, 3)) {
+    expectNear(xyzToRGB(rgbToXYZ(color)), color, 1e-6);
+    expectNear(labToXYZ(xyzToLab(color)), color, 1e-12);
+    expectNear(lchToLab(labToLCh(color)), color, 1e-12);
+  }
+}
+
+TEST(ColorSpaceTest, ConvertsOKLab) {
+  expectNear(rgbToOKLab(Color3d(1, 1, 1)), Color3d(1, 0, 0), 1e-4);
+  expectNear(rgbToOKLab(Color3d(1, 0, 0)), Color3d(0.62796, 0.22486, 0.12585),
+             1e-4);
+  for (const auto& color : makeSampleColors(1000, 4)) {
+    expectNear(oklabToRGB(rgbToOKLab(color)), color, 1e-6);
+  }
+}
+
+TEST(ColorSpaceTest, ConvertsSpans) {
+  const auto colors = makeSampleColors(1003, 5);
+  std::vector<Color4f> source;
+  for (std::size_t i{}; i < colors.size(); ++i) {
+    source.emplace_back(Color3f(colors[i]), i / 1003.0f);
+  }
+  auto lab = source;
+  rgbToLab(lab.data(), lab.size(), lab.data());
+  auto oklab = source;
+  rgbToOKLab(oklab.data(), oklab.size(), oklab.data());
+  auto hsv = source;
+  rgbToHSV(hsv.data(), hsv.size(), hsv.data());
+  auto hsl = source;
+  rgbToHSL(hsl.data(), hsl.size(), hsl.data());
+  auto lch = lab;
+  labToLCh(lch.data(), lch.size(), lch.data());
+  std::vector<Color3f> xyz(colors.begin(), colors.end());
+  rgbToXYZ(xyz.data(), xyz.size(), xyz.data());
+  for (std::size_t i{}; i < colors.size(); ++i) {
+    const auto& color = colors[i];
+    expectNear(Color3d(Color3f(lab[i])), rgbToLab(color), 1e-3);
+    expectNear(Color3d(Color3f(oklab[i])), rgbToOKLab(color), 1e-5);
+    expectNear(Color3d(Color3f(hsv[i])), rgbToHSV(color), 1e-4);
+    expectNear(Color3d(Color3f(hsl[i])), rgbToHSL(color), 1e-4);
+    expectNear(Color3d(xyz[i]), rgbToXYZ(color), 1e-6);
+    const auto expected = labToLCh(Color3d(Color3f(lab[i])));
+    EXPECT_NEAR(lch[i].g, expected.g, 1e-4);
+    const auto hue = std::abs(lch[i].b - expected.b);
+    EXPECT_LT(std::min(hue, 360 - hue), 1e-3);
+    ASSERT_EQ(lab[i].a, source[i].a);
+    ASSERT_EQ(oklab[i].a, source[i].a);
+    ASSERT_EQ(hsl[i].a, source[i].a);
+    ASSERT_EQ(lch[i].a, source[i].a);
+  }
+  lchToLab(lch.data(), lch.size(), lch.data());
+  for (std::size_t i{}; i < colors.size(); ++i) {
+    expectNear(Color3d(Color3f(lch[i])), Color3d(Color3f(lab[i])), 1e-4);
+  }
+  labToRGB(lab.data(), lab.size(), lab.data());
+  oklabToRGB(oklab.data(), oklab.size(), oklab.data());
+  hsvToRGB(hsv.data(), hsv.size(), hsv.data());
+  hslToRGB(hsl.data(), hsl.size(), hsl.data());
+  for (std::size_t i{}; i < colors.size(); ++i) {
+    expectNear(Color3d(Color3f(lab[i])), colors[i], 1e-5);
+    expectNear(Color3d(Color3f(oklab[i])), colors[i], 1e-5);
+    expectNear(Color3d(Color3f(hsv[i])), colors[i], 1e-5);
+    expectNear(Color3d(Color3f(hsl[i])), colors[i], 1e-5);
+  }
+  std::vector<Color3d> doubles(colors);
+  rgbToOKLab(doubles.data(), doubles.size(), doubles.data());
+  for (std::size_t i{}; i < colors.size(); ++i) {
+    ASSERT_EQ(doubles[i], rgbToOKLab(colors[i]));
+  }
+}
+
+TEST(ColorSpaceTest, TakesFastCubeRoots) {
+  std::vector<float> values;
+  for (float value = 1e-30f; value < 1e30f; value *= 1.01f) {
+    values.push_back(value);
+    values.push_back(-value);
+  }
+  values.push_back(0);
+  values.resize((values.size() + 3) / 4 * 4);
+  const auto epsilon = std::numeric_limits<float>::epsilon();
+  for (std::size_t i{}; i < values.size(); i += 4) {
+    float roots[4];
+    detail::storeLanes(detail::cubeRoot(detail::loadLanes(&values[i])),
+                       static_cast<float *>(roots));
+    for (int j{}; j < 4; ++j) {
+      const auto expected = std::cbrt(static_cast<double>(values[i + j]));
+      ASSERT_NEAR(roots[j], expected, std::abs(expected) * 2 * epsilon);
+      ASSERT_NEAR(detail::fastCubeRoot(values[i + j]), expected,
+                  std::abs(expected) * 2 * epsilon);
+    }
+  }
+}
+
+TEST(ColorSpaceTest, InterpolatesPerceptually) {
+  const Color3d red(1, 0, 0);
+  const Color3d blue(0, 0, 1);
+  expectNear(lerpLab(red, blue, 0), red, 1e-6);
+  expectNear(lerpLab(red, blue, 1), blue, 1e-6);
+  expectNear(lerpOKLab(red, blue, 0), red, 1e-6);
+  expectNear(lerpOKLab(red, blue, 1), blue, 1e-6);
+  expectNear(lerpLCh(red, blue, 1), blue, 1e-6);
+
+  // The midpoint lies halfway in lightness, unlike that of RGB
+  const auto middle = rgbToOKLab(lerpOKLab(red, blue, 0.5));
+  EXPECT_NEAR(middle.r, (rgbToOKLab(red).r + rgbToOKLab(blue).r) / 2, 1e-6);
+
+  // Hue takes the shorter arc, and follows chromatic colors from gray
+  const auto hue1 = labToLCh(rgbToLab(red)).b;
+  const auto hue2 = labToLCh(rgbToLab(blue)).b;
+  const auto hue = labToLCh(rgbToLab(lerpLCh(red, blue, 0.5))).b;
+  EXPECT_NEAR(hue, std::fmod((hue1 + 360 + hue2) / 2, 360), 1e-4);
+  const Color3d gray(0.5, 0.5, 0.5);
+  EXPECT_NEAR(labToLCh(rgbToLab(lerpLCh(gray, red, 0.5))).b, hue1, 1e-4);
+
+  const auto color = lerpOKLab(Color4d(red, 0), Color4d(blue, 1), 0.25);
+  EXPECT_EQ(color.a, 0.25);
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,222 @@
+//
+//  takram/graphics/compositing_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/composite_operation.h"
+#include "takram/graphics/compositing.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+#include "takram/graphics/premultiplied_color.h"
+
+#include "color_helpers.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+const CompositeOperation operations[] = {
+  CompositeOperation::CLEAR,
+  CompositeOperation::SOURCE,
+  CompositeOperation::DESTINATION,
+  CompositeOperation::SOURCE_OVER,
+  CompositeOperation::DESTINATION_OVER,
+  CompositeOperation::SOURCE_IN,
+  CompositeOperation::DESTINATION_IN,
+  CompositeOperation::SOURCE_OUT,
+  CompositeOperation::DESTINATION_OUT,
+  CompositeOperation::SOURCE_ATOP,
+  CompositeOperation::DESTINATION_ATOP,
+  CompositeOperation::XOR,
+  CompositeOperation::PLUS
+};
+
+// The Porter-Duff factors of the source and destination, straight from the
+// definitions of the operators
+void factors(CompositeOperation operation,
+             double source_alpha,
+             double destination_alpha,
+             double *source,
+             double *destination) {
+  const auto sa = source_alpha;
+  const auto da = destination_alpha;
+  switch (operation) {
+    case CompositeOperation::CLEAR: *source = 0; *destination = 0; break;
+    case CompositeOperation::SOURCE: *source = 1; *destination = 0; break;
+    case CompositeOperation::DESTINATION: *source = 0; *destination = 1; break;
+    case CompositeOperation::SOURCE_OVER:
+      *source = 1; *destination = 1 - sa; break;
+    case CompositeOperation::DESTINATION_OVER:
+      *source = 1 - da; *destination = 1; break;
+    case CompositeOperation::SOURCE_IN: *source = da; *destination = 0; break;
+    case CompositeOperation::DESTINATION_IN:
+      *source = 0; *destination = sa; break;
+    case CompositeOperation::SOURCE_OUT:
+      *source = 1 - da; *destination = 0; break;
+    case CompositeOperation::DESTINATION_OUT:
+      *source = 0; *destination = 1 - sa; break;
+    case CompositeOperation::SOURCE_ATOP:
+      *source = da; *destination = 1 - sa; break;
+    case CompositeOperation::DESTINATION_ATOP:
+      *source = 1 - da; *destination = sa; break;
+    case CompositeOperation::XOR:
+      *source = 1 - da; *destination = 1 - sa; break;
+    case CompositeOperation::PLUS: *source = 1; *destination = 1; break;
+    default:
+      FAIL();
+  }
+}
+
+// Random colors, every fifth of which is transparent or opaque
+template <class T>
+std::vector<PremultipliedColor<T>> makePremultipliedColors(std::size_t size,
+                                                           unsigned seed) {
+  auto colors = makeColors<std::uint8_t, 4>(size, seed);
+  std::vector<PremultipliedColor<T>> result;
+  for (std::size_t i{}; i < size; ++i) {
+    auto& color = colors[i];
+    if (i % 5 == 0) {
+      color.a = i % 10 ? 0 : 255;
+    }
+    result.emplace_back(Color4<T>(color));
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(CompositingTest, Premultiplies) {
+  const PremultipliedColor4u color(Color4u(255, 128, 0, 128));
+  EXPECT_EQ(color, PremultipliedColor4u(128, 64, 0, 128));
+  EXPECT_EQ(color.color(), Color4u(255, 128, 0, 128));
+  EXPECT_EQ(PremultipliedColor4u(Color4u(10, 20, 30, 0)).color(), Color4u());
+  for (int value{}; value < 256; ++value) {
+    for (int alpha{}; alpha < 256; ++alpha) {
+      const PremultipliedColor4u color(Color4u(value, 0, 0, alpha));
+      ASSERT_EQ(color.r, std::round(value * alpha / 255.0));
+    }
+  }
+  const PremultipliedColor4f straight(Color4f(1.0f, 0.5f, 0.0f, 0.5f));
+  EXPECT_EQ(straight, PremultipliedColor4f(0.5f, 0.25f, 0.0f, 0.5f));
+  EXPECT_EQ(straight.color(), Color4f(1.0f, 0.5f, 0.0f, 0.5f));
+
+  std::vector<Color4u> colors{Color4u(255, 128, 0, 128), Color4u(1, 2, 3, 4)};
+  std::vector<PremultipliedColor4u> premultiplied(colors.size());
+  premultiply(colors.data(), colors.size(), premultiplied.data());
+  EXPECT_EQ(premultiplied.front(), color);
+  unpremultiply(premultiplied.data(), premultiplied.size(), colors.data());
+  EXPECT_EQ(colors.front(), Color4u(255, 128, 0, 128));
+}
+
+TEST(CompositingTest, CompositesBytesExactly) {
+  const auto source = makePremultipliedColors<std::uint8_t>(1001, 1);
+  const auto destination = makePremultipliedColors<std::uint8_t>(1001, 2);
+  for (const auto operation : operations) {
+    auto result = destination;
+    composite(source.data(), result.data(), result.size(), operation);
+    for (std::size_t i{}; i < source.size(); ++i) {
+      const auto& s = source[i];
+      const auto& d = destination[i];
+      double fs;
+      double fd;
+      factors(operation, s.a / 255.0, d.a / 255.0, &fs, &fd);
+      const auto expected = [&](int source, int destination) {
+        // Sums of integer products are exact in double
+        const auto sum = std::round(source * fs * 255.0) +
+                         std::round(destination * fd * 255.0);
+        return std::min(std::round(sum / 255.0), 255.0);
+      };
+      ASSERT_EQ(result[i].r, expected(s.r, d.r)) << operation;
+      ASSERT_EQ(result[i].g, expected(s.g, d.g)) << operation;
+      ASSERT_EQ(result[i].b, expected(s.b, d.b)) << operation;
+      ASSERT_EQ(result[i].a, expected(s.a, d.a)) << operation;
+      ASSERT_EQ(result[i], composite(s, d, operation)) << operation;
+    }
+  }
+}
+
+TEST(CompositingTest, CompositesFloats) {
+  const auto source = makePremultipliedColors<float>(1001, 3);
+  const auto destination = makePremultipliedColors<float>(1001, 4);
+  for (const auto operation : operations) {
+    auto result = destination;
+    composite(source.data(), result.data(), result.size(), operation);
+    for (std::size_t i{}; i < source.size(); ++i) {
+      const auto& s = source[i];
+      const auto& d = destination[i];
+      double fs;
+      double fd;
+      factors(operation, s.a, d.a, &fs, &fd);
+      const auto expected = [&](double source, double destination) {
+        return std::min(source * fs + destination * fd, 1.0);
+      };
+      ASSERT_NEAR(result[i].r, expected(s.r, d.r), 1e-6) << operation;
+      ASSERT_NEAR(result[i].g, expected(s.g, d.g), 1e-6) << operation;
+      ASSERT_NEAR(result[i].b, expected(s.b, d.b), 1e-6) << operation;
+      ASSERT_NEAR(result[i].a, expected(s.a, d.a), 1e-6) << operation;
+    }
+  }
+}
+
+TEST(CompositingTest, CompositesImages) {
+  Image4u source(7, 3);
+  Image4u destination(7, 3, ImageLayout::PLANAR);
+  for (int y{}; y < source.height(); ++y) {
+    for (int x{}; x < source.width(); ++x) {
+      source.setPixel(x, y, Color4u(x * 10, y * 10, 0, x * 36));
+      destination.setPixel(x, y, Color4u(0, 100, 200, 255));
+    }
+  }
+  auto interleaved = Image4u(destination.view());
+  composite(source.view(), destination.view(),
+            CompositeOperation::SOURCE_OVER);
+  composite(source.view(), interleaved.view(),
+            CompositeOperation::SOURCE_OVER);
+  for (int y{}; y < source.height(); ++y) {
+    for (int x{}; x < source.width(); ++x) {
+      const auto s = source.pixel(x, y);
+      const auto expected = composite(
+          PremultipliedColor4u(s.r, s.g, s.b, s.a),
+          PremultipliedColor4u(0, 100, 200, 255),
+          CompositeOperation::SOURCE_OVER);
+      const auto pixel = destination.pixel(x, y);
+      EXPECT_EQ(PremultipliedColor4u(pixel.r, pixel.g, pixel.b, pixel.a),
+                expected);
+      EXPECT_EQ(interleaved.pixel(x, y), pixel);
+    }
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
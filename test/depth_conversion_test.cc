@@ -0,0 +1,182 @@
+//
+//  takram/graphics/depth_conversion_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/depth_conversion.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+template <class T, class U>
+void expectIdentical(const std::vector<U>& values) {
+  // Odd sizes leave remainders after the blocks
+  for (const auto size : {values.size(), values.size() - 7}) {
+    std::vector<T> result(size);
+    convertDepth(values.data(), size, result.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(result[i], Depth<T>::convert(values[i])) << values[i];
+    }
+  }
+}
+
+template <class T>
+std::vector<T> makeIntegers() {
+  std::vector<T> result;
+  for (std::uint32_t value{}; value <= Depth<T>::max; ++value) {
+    result.emplace_back(value);
+  }
+  return result;
+}
+
+// Values around every multiple of the reciprocal of max and the halfway
+// points between them, where rounding is the most fragile
+template <class T>
+std::vector<T> makeFloats(std::uint32_t max) {
+  std::vector<T> result;
+  for (std::uint32_t step{}; step <= max * 2; ++step) {
+    const T value = step / (max * 2.0);
+    result.emplace_back(value);
+    result.emplace_back(std::nextafter(value, T(0)));
+    result.emplace_back(std::nextafter(value, T(1)));
+  }
+  std::mt19937 engine;
+  std::uniform_real_distribution<T> distribution;
+  for (int i{}; i < 1000; ++i) {
+    result.emplace_back(distribution(engine));
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(DepthConversionTest, ConvertsIntegersToFloats) {
+  expectIdentical<float>(makeIntegers<std::uint8_t>());
+  expectIdentical<double>(makeIntegers<std::uint8_t>());
+  expectIdentical<float>(makeIntegers<std::uint16_t>());
+  expectIdentical<double>(makeIntegers<std::uint16_t>());
+}
+
+TEST(DepthConversionTest, ConvertsFloatsToIntegers) {
+  expectIdentical<std::uint8_t>(makeFloats<float>(0xff));
+  expectIdentical<std::uint8_t>(makeFloats<double>(0xff));
+  expectIdentical<std::uint16_t>(makeFloats<float>(0xffff));
+  expectIdentical<std::uint16_t>(makeFloats<double>(0xffff));
+}
+
+TEST(DepthConversionTest, ConvertsIntegers) {
+  expectIdentical<std::uint16_t>(makeIntegers<std::uint8_t>());
+  expectIdentical<std::uint32_t>(makeIntegers<std::uint8_t>());
+  expectIdentical<std::uint8_t>(makeIntegers<std::uint16_t>());
+}
+
+TEST(DepthConversionTest, SaturatesFloats) {
+  const float values[] = {
+    2.0f, -1.0f, 1.5f, std::numeric_limits<float>::infinity(),
+    -std::numeric_limits<float>::infinity(),
+    std::numeric_limits<float>::quiet_NaN(), 0.5f
+  };
+  const std::uint8_t codes[] = {0xff, 0, 0xff, 0xff, 0, 0, 0x80};
+  const std::uint16_t wide_codes[] = {0xffff, 0, 0xffff, 0xffff, 0, 0, 0x8000};
+
+  // A size that leaves a remainder after blocks of every width, which must
+  // saturate as the blocks do
+  std::vector<float> buffer;
+  for (int i{}; i < 75; ++i) {
+    buffer.push_back(values[i % 7]);
+  }
+  std::vector<std::uint8_t> result(buffer.size());
+  convertDepth(buffer.data(), buffer.size(), result.data());
+  std::vector<std::uint16_t> wide(buffer.size());
+  convertDepth(buffer.data(), buffer.size(), wide.data());
+  for (std::size_t i{}; i < buffer.size(); ++i) {
+    ASSERT_EQ(result[i], codes[i % 7]) << i;
+    ASSERT_EQ(wide[i], wide_codes[i % 7]) << i;
+  }
+  Image3f image(5, 5, ImageLayout::PLANAR);
+  Image3u bytes(5, 5);
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      image.setPixel(x, y, Color3f(buffer.data() + (y * 5 + x) * 3));
+    }
+  }
+  convertDepth(image.view(), bytes.view());
+  for (int i{}; i < 75; ++i) {
+    ASSERT_EQ(bytes.at(i / 3 % 5, i / 15, i % 3), codes[i % 7]) << i;
+  }
+}
+
+TEST(DepthConversionTest, ConvertsColors) {
+  std::vector<Color4u> colors;
+  for (int i{}; i < 101; ++i) {
+    colors.emplace_back(i, i * 2, 255 - i, i + 100);
+  }
+  std::vector<Color4f> result(colors.size());
+  convertDepth(colors.data(), colors.size(), result.data());
+  std::vector<Color4u> back(colors.size());
+  convertDepth(result.data(), result.size(), back.data());
+  for (std::size_t i{}; i < colors.size(); ++i) {
+    EXPECT_EQ(result[i], Color4f(colors[i]));
+    EXPECT_EQ(back[i], colors[i]);
+  }
+}
+
+TEST(DepthConversionTest, ConvertsImages) {
+  Image4u image(37, 5);
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      image.setPixel(x, y, Color4u(x, y, x * y, 255 - x));
+    }
+  }
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    Image4f result(image.width(), image.height(), layout);
+    convertDepth(image.view(), result.view());
+    Image4u back(image.width(), image.height());
+    convertDepth(result.view(), back.view());
+    for (int y{}; y < image.height(); ++y) {
+      for (int x{}; x < image.width(); ++x) {
+        ASSERT_EQ(result.pixel(x, y), Color4f(image.pixel(x, y)));
+        ASSERT_EQ(back.pixel(x, y), image.pixel(x, y));
+      }
+    }
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
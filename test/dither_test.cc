@@ -0,0 +1,164 @@
+//
+//  takram/graphics/dither_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/depth.h"
+#include "takram/graphics/dither.h"
+#include "takram/graphics/dither_method.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+// Floyd-Steinberg dithering of a single thread over a full buffer of errors,
+// summing errors in the same order as the implementation does
+template <class T, int C>
+Image<T, C> ditherSerially(const Image<float, C>& image) {
+  const auto width = image.width();
+  const auto height = image.height();
+  const float scale = Depth<T>::max;
+  Image<T, C> result(width, height);
+  std::vector<float> errors((height + 1) * (width + 2) * C);
+  const auto error = [&](int x, int y, int channel) -> float& {
+    return errors[(y * (width + 2) + x + 1) * C + channel];
+  };
+  for (int y{}; y < height; ++y) {
+    for (int channel{}; channel < C; ++channel) {
+      auto right = 0.0f;
+      for (int x{}; x < width; ++x) {
+        const auto diffused = error(x, y, channel) + right;
+        const auto value = std::min(std::max(
+            image.at(x, y, channel), 0.0f), 1.0f) * scale + diffused;
+        const auto code = std::min(std::max(
+            std::floor(value + 0.5f), 0.0f), scale);
+        result.at(x, y, channel) = static_cast<T>(code);
+        const auto residue = value - code;
+        right = residue * (7.0f / 16.0f);
+        error(x + 1, y + 1, channel) += residue * (1.0f / 16.0f);
+        error(x, y + 1, channel) += residue * (5.0f / 16.0f);
+        error(x - 1, y + 1, channel) += residue * (3.0f / 16.0f);
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(DitherTest, PreservesMeansOfFlatImages) {
+  Image4f image(64, 64);
+  Image4u result(image.width(), image.height());
+  const auto pixels = image.width() * image.height();
+  for (const auto fraction : {0.25f, 0.5f, 0.75f}) {
+    const auto value = (100 + fraction) / 255;
+    image.view().fill(Color4f(value, value));
+    for (const auto method : {DitherMethod::BAYER,
+                              DitherMethod::BLUE_NOISE,
+                              DitherMethod::FLOYD_STEINBERG}) {
+      ditherDepth(image.view(), result.view(), method);
+      int raised{};
+      for (int y{}; y < result.height(); ++y) {
+        for (int x{}; x < result.width(); ++x) {
+          for (int channel{}; channel < 4; ++channel) {
+            const auto code = result.at(x, y, channel);
+            ASSERT_TRUE(code == 100 || code == 101) << method;
+            raised += code - 100;
+          }
+        }
+      }
+      if (method == DitherMethod::FLOYD_STEINBERG) {
+        // Errors at the right and bottom edges are lost
+        EXPECT_NEAR(raised, pixels * 4 * fraction, pixels * 4 / 100) << method;
+      } else {
+        EXPECT_EQ(raised, pixels * 4 * fraction) << method;
+      }
+    }
+  }
+}
+
+TEST(DitherTest, StaysWithinOneCode) {
+  Image4f image(67, 29);
+  std::mt19937 engine(1);
+  std::uniform_real_distribution<float> distribution(-0.1f, 1.1f);
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      for (int channel{}; channel < 4; ++channel) {
+        image.at(x, y, channel) = distribution(engine);
+      }
+    }
+  }
+  for (const auto method : {DitherMethod::BAYER, DitherMethod::BLUE_NOISE}) {
+    for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+      Image4s result(image.width(), image.height(), layout);
+      ditherDepth(image.view(), result.view(), method);
+      for (int y{}; y < image.height(); ++y) {
+        for (int x{}; x < image.width(); ++x) {
+          for (int channel{}; channel < 4; ++channel) {
+            const auto value = std::min(std::max(
+                image.at(x, y, channel), 0.0f), 1.0f) * 65535;
+            ASSERT_LT(std::abs(result.at(x, y, channel) - value), 1.0f);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(DitherTest, PipelinesFloydSteinberg) {
+  Image3f image(317, 211);
+  std::mt19937 engine(2);
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      const auto base = static_cast<float>(x) / image.width();
+      for (int channel{}; channel < 3; ++channel) {
+        image.at(x, y, channel) = base + distribution(engine) / 255;
+      }
+    }
+  }
+  const auto expected = ditherSerially<std::uint8_t>(image);
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    Image3u result(image.width(), image.height(), layout);
+    ditherDepth(image.view(), result.view(), DitherMethod::FLOYD_STEINBERG);
+    for (int y{}; y < image.height(); ++y) {
+      for (int x{}; x < image.width(); ++x) {
+        ASSERT_EQ(result.pixel(x, y), expected.pixel(x, y));
+      }
+    }
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,124 @@
+//
+//  takram/graphics/fixed_point_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/fixed_point.h"
+
+#include "color_helpers.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+std::uint32_t pack(const Color4u& color) {
+  return color.r | color.g << 8 | color.b << 16 |
+         static_cast<std::uint32_t>(color.a) << 24;
+}
+
+}  // namespace
+
+TEST(FixedPointTest, RoundsExactly) {
+  for (int a{}; a < 0x100; ++a) {
+    for (int b{}; b < 0x100; ++b) {
+      const Color4u x(a, a, a, a);
+      const Color4u y(b, b, b, b);
+      const auto product = std::lround(a * b / 255.0);
+      ASSERT_EQ(multiplyFixed(x, y).r, product);
+      ASSERT_EQ(scaleFixed(x, b).a, product);
+      ASSERT_EQ(scalePacked(pack(x), b), pack(Color4u(product, product,
+                                                       product, product)));
+      for (const auto weight : {0, 1, 64, 127, 128, 129, 255, 256}) {
+        const auto lerp = std::floor((a * (256 - weight) + b * weight) /
+                                     256.0 + 0.5);
+        ASSERT_EQ(lerpFixed(x, y, weight).g, lerp);
+        ASSERT_EQ(lerpPacked(pack(x), pack(y), weight),
+                  pack(Color4u(lerp, lerp, lerp, lerp)));
+      }
+    }
+  }
+}
+
+TEST(FixedPointTest, MakesWeights) {
+  EXPECT_EQ(fixedWeight(0.0f), 0);
+  EXPECT_EQ(fixedWeight(0.5f), 128);
+  EXPECT_EQ(fixedWeight(1.0f), 256);
+  EXPECT_EQ(fixedWeight(-1.0f), 0);
+  EXPECT_EQ(fixedWeight(2.0f), 256);
+  EXPECT_EQ(fixedWeight(std::nanf("")), 0);
+  const Color4u a(10, 20, 30, 40);
+  const Color4u b(250, 240, 230, 220);
+  EXPECT_EQ(lerpFixed(a, b, fixedWeight(0.0f)), a);
+  EXPECT_EQ(lerpFixed(a, b, fixedWeight(1.0f)), b);
+  EXPECT_EQ(lerpFixed(a, b, fixedWeight(0.5f)), Color4u(130, 130, 130, 130));
+}
+
+TEST(FixedPointTest, OperatesOnSpans) {
+  // Sizes covering blocks of SIMD and packed integers, and the remainders
+  for (const std::size_t size : {1, 3, 4, 5, 7, 16, 21, 67}) {
+    const auto a4 = makeColors<std::uint8_t, 4>(size, 1);
+    const auto b4 = makeColors<std::uint8_t, 4>(size, 2);
+    std::vector<Color4u> result4(size);
+    lerpFixed(a4.data(), b4.data(), size, 77, result4.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(result4[i], lerpFixed(a4[i], b4[i], 77));
+    }
+    scaleFixed(a4.data(), size, 191, result4.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(result4[i], scaleFixed(a4[i], 191));
+    }
+    multiplyFixed(a4.data(), b4.data(), size, result4.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(result4[i], multiplyFixed(a4[i], b4[i]));
+    }
+
+    const auto a3 = makeColors<std::uint8_t, 3>(size, 3);
+    const auto b3 = makeColors<std::uint8_t, 3>(size, 4);
+    std::vector<Color3u> result3(size);
+    lerpFixed(a3.data(), b3.data(), size, 200, result3.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(result3[i], lerpFixed(a3[i], b3[i], 200));
+    }
+    scaleFixed(a3.data(), size, 3, result3.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(result3[i], scaleFixed(a3[i], 3));
+    }
+    multiplyFixed(a3.data(), b3.data(), size, result3.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(result3[i], multiplyFixed(a3[i], b3[i]));
+    }
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
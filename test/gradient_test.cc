@@ -0,0 +1,149 @@
+//
+//  takram/graphics/gradient_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/gradient.h"
+#include "takram/graphics/gradient_spread.h"
+#include "takram/graphics/premultiplied_color.h"
+#include "takram/graphics/srgb.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+void expectNear(const PremultipliedColor4f& actual,
+                const PremultipliedColor4f& expected,
+                double tolerance) {
+  EXPECT_NEAR(actual.r, expected.r, tolerance);
+  EXPECT_NEAR(actual.g, expected.g, tolerance);
+  EXPECT_NEAR(actual.b, expected.b, tolerance);
+  EXPECT_NEAR(actual.a, expected.a, tolerance);
+}
+
+}  // namespace
+
+TEST(GradientTest, Interpolates) {
+  Gradient4f gradient({{0, Color4f(0.0f, 1.0f)}, {1, Color4f(1, 1)}});
+  EXPECT_EQ(gradient.table().size(), 256);
+  EXPECT_EQ(gradient.evaluate(0), PremultipliedColor4f(0, 0, 0, 1));
+  EXPECT_EQ(gradient.evaluate(1), PremultipliedColor4f(1, 1, 1, 1));
+  expectNear(gradient.evaluate(0.25), PremultipliedColor4f(0.25, 0.25, 0.25, 1),
+             0.5 / 255);
+
+  // Stops are sorted, and those of equal offsets make hard edges
+  gradient.reset();
+  EXPECT_EQ(gradient.evaluate(0.5), PremultipliedColor4f());
+  gradient.addStop(0.5, Color4f(0, 0, 1));
+  gradient.addStop(0.5, Color4f(0, 1, 0));
+  gradient.addStop(0, Color4f(1, 0, 0));
+  EXPECT_EQ(gradient.stops().front().offset, 0);
+  expectNear(gradient.evaluate(0.49), PremultipliedColor4f(0.02, 0, 0.98, 1),
+             1.0 / 255);
+  EXPECT_EQ(gradient.evaluate(0.51), PremultipliedColor4f(0, 1, 0, 1));
+  EXPECT_EQ(gradient.evaluate(1), PremultipliedColor4f(0, 1, 0, 1));
+  expectNear(gradient.evaluate(0.25), PremultipliedColor4f(0.5, 0, 0.5, 1),
+             1.0 / 255);
+}
+
+TEST(GradientTest, InterpolatesPremultiplied) {
+  // Transparent white fades to red without turning pink
+  Gradient4f gradient({{0, Color4f(1, 1, 1, 0)}, {1, Color4f(1, 0, 0, 1)}});
+  const auto color = gradient.evaluate(0.5);
+  EXPECT_NEAR(color.a, 0.5, 1.0 / 255);
+  EXPECT_NEAR(color.r, color.a, 1e-6);
+  EXPECT_EQ(color.g, 0);
+  EXPECT_EQ(color.b, 0);
+}
+
+TEST(GradientTest, InterpolatesInLinearLight) {
+  Gradient4f gradient({{0, Color4f(1, 0, 0)}, {1, Color4f(0, 1, 0)}},
+                      GradientSpread::PAD, true, 1025);
+  const auto expected = encodeSRGB(0.5);
+  expectNear(gradient.evaluate(0.5),
+             PremultipliedColor4f(expected, expected, 0, 1), 1e-6);
+  gradient.set_linear_light(false);
+  expectNear(gradient.evaluate(0.5), PremultipliedColor4f(0.5, 0.5, 0, 1),
+             1e-6);
+}
+
+TEST(GradientTest, Spreads) {
+  Gradient4f gradient({{0, Color4f(0.0f, 1.0f)}, {1, Color4f(1, 1)}});
+  const auto at = [&](float parameter) { return gradient.evaluate(parameter); };
+  EXPECT_EQ(at(-1), at(0));
+  EXPECT_EQ(at(2), at(1));
+  EXPECT_EQ(at(std::numeric_limits<float>::quiet_NaN()), at(0));
+  gradient.set_spread(GradientSpread::REPEAT);
+  EXPECT_EQ(at(1.25), at(0.25));
+  EXPECT_EQ(at(-0.75), at(0.25));
+  EXPECT_EQ(at(-3), at(0));
+  EXPECT_EQ(at(1e10), at(0));
+  EXPECT_EQ(at(std::numeric_limits<float>::quiet_NaN()), at(0));
+  gradient.set_spread(GradientSpread::REFLECT);
+  EXPECT_EQ(at(1.25), at(0.75));
+  EXPECT_EQ(at(-0.25), at(0.25));
+  EXPECT_EQ(at(2.25), at(0.25));
+  EXPECT_EQ(at(-1), at(1));
+  EXPECT_EQ(at(std::numeric_limits<float>::quiet_NaN()), at(0));
+}
+
+TEST(GradientTest, FillsSpans) {
+  Gradient4u gradient({{0, Color4u(255, 0, 0)},
+                       {0.5, Color4u(0, 255, 0, 128)},
+                       {1, Color4u(0, 0, 255)}},
+                      GradientSpread::REFLECT);
+  const std::size_t size = 103;
+  std::vector<float> parameters(size);
+  std::vector<std::uint8_t> coverage(size);
+  for (std::size_t i{}; i < size; ++i) {
+    parameters[i] = -1.0f + i * 0.03f;
+    coverage[i] = i * 2;
+  }
+  std::vector<PremultipliedColor4u> affine(size);
+  gradient.fill(-1.0f, 0.03f, size, affine.data());
+  std::vector<PremultipliedColor4u> colors(size);
+  gradient.fill(parameters.data(), size, colors.data());
+  std::vector<PremultipliedColor4u> covered(size);
+  gradient.fill(parameters.data(), coverage.data(), size, covered.data());
+  for (std::size_t i{}; i < size; ++i) {
+    const auto color = gradient.evaluate(parameters[i]);
+    ASSERT_EQ(colors[i], color);
+    ASSERT_EQ(affine[i], color);
+    ASSERT_EQ(covered[i].r, std::round(color.r * coverage[i] / 255.0));
+    ASSERT_EQ(covered[i].a, std::round(color.a * coverage[i] / 255.0));
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,116 @@
+//
+//  takram/graphics/half_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/depth.h"
+#include "takram/graphics/depth_conversion.h"
+#include "takram/graphics/half.h"
+
+namespace takram {
+namespace graphics {
+
+TEST(HalfTest, ConvertsEveryHalfExactly) {
+  for (std::uint32_t bits{}; bits < 0x10000; ++bits) {
+    const auto half = Half::fromBits(static_cast<std::uint16_t>(bits));
+    const float value = half;
+    if (std::isnan(value)) {
+      // NaN is made quiet
+      ASSERT_EQ(Half(value).bits(), bits | 0x200);
+    } else {
+      ASSERT_EQ(Half(value).bits(), bits);
+    }
+  }
+  EXPECT_EQ(static_cast<float>(Half::fromBits(0x3c00)), 1.0f);
+  EXPECT_EQ(static_cast<float>(Half::fromBits(0x7bff)), 65504.0f);
+  EXPECT_EQ(static_cast<float>(Half::fromBits(0x0001)), std::ldexp(1.0f, -24));
+  EXPECT_EQ(static_cast<float>(Half::fromBits(0xfc00)),
+            -std::numeric_limits<float>::infinity());
+}
+
+TEST(HalfTest, RoundsToNearestEven) {
+  // The midpoints between adjacent halves of either sign, which are exact in
+  // float, and the floats just around them
+  for (std::uint16_t bits{}; bits < 0x7bff; ++bits) {
+    for (const std::uint16_t sign : {0x0000, 0x8000}) {
+      const float lower = Half::fromBits(bits | sign);
+      const float upper = Half::fromBits((bits + 1) | sign);
+      const auto middle = (lower + upper) / 2;
+      const auto even = bits % 2 ? bits + 1 : bits;
+      ASSERT_EQ(Half(middle).bits(), even | sign);
+      ASSERT_EQ(Half(std::nextafter(middle, lower)).bits(), bits | sign);
+      ASSERT_EQ(Half(std::nextafter(middle, upper)).bits(), (bits + 1) | sign);
+    }
+  }
+  EXPECT_EQ(Half(65520.0f).bits(), 0x7c00);
+  EXPECT_EQ(Half(std::nextafter(65520.0f, 0.0f)).bits(), 0x7bff);
+  EXPECT_EQ(Half(1e6f).bits(), 0x7c00);
+  EXPECT_EQ(Half(-1e6f).bits(), 0xfc00);
+  EXPECT_EQ(Half(1e-10f).bits(), 0x0000);
+  EXPECT_EQ(Half(-0.0f).bits(), 0x8000);
+}
+
+TEST(HalfTest, ConvertsDepths) {
+  EXPECT_EQ(Depth<std::uint8_t>::convert(Half(0.5f)), 128);
+  EXPECT_EQ(Depth<std::uint16_t>::convert(Half(1.0f)), 0xffff);
+  EXPECT_EQ(Depth<Half>::convert(std::uint8_t(0xff)), 1.0f);
+  EXPECT_EQ(Depth<Half>::convert(0.25), 0.25f);
+  EXPECT_EQ(Depth<float>::convert(Half(0.75f)), 0.75f);
+  EXPECT_EQ(Depth<Half>::clamp(Half(2.0f)), 1.0f);
+  EXPECT_EQ(Color4h(Color4u(0xff, 0, 0xff)), Color4h(1.0f, 0.0f, 1.0f));
+
+  // Buffers of sizes covering blocks and their remainders, with values
+  // rounding to every half in a range and the special values
+  std::vector<float> values;
+  for (auto value = -2.0f; value < 2.0f; value += 1.0f / 3000) {
+    values.emplace_back(value);
+  }
+  for (const auto value : {std::numeric_limits<float>::infinity(),
+                           std::numeric_limits<float>::quiet_NaN(),
+                           1e-7f, 65519.0f, 65520.0f}) {
+    values.emplace_back(value);
+  }
+  for (const std::size_t size : {values.size(), std::size_t(7)}) {
+    std::vector<Half> halves(size);
+    convertDepth(values.data(), size, halves.data());
+    std::vector<float> floats(size);
+    convertDepth(halves.data(), size, floats.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(halves[i].bits(), Half(values[i]).bits()) << values[i];
+      ASSERT_EQ(Half(floats[i]).bits(), halves[i].bits());
+    }
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,120 @@
+//
+//  takram/graphics/hasher_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstdint>
+#include <unordered_set>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/hasher.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/shape.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+template <class T>
+Path2<T> makePath(double offset) {
+  Path2<T> path;
+  path.moveTo(0.0 + offset, 0.0);
+  path.lineTo(4.0 + offset, 0.0);
+  path.quadraticTo(5.0 + offset, 1.0, 4.0 + offset, 2.0);
+  path.conicTo(2.0 + offset, 4.0, 0.0 + offset, 2.0, 0.5);
+  path.cubicTo(-1.0 + offset, 1.5, -1.0 + offset, 0.5, 0.0 + offset, 0.0);
+  path.close();
+  return path;
+}
+
+}  // namespace
+
+TEST(HasherTest, HashesEqualPathsEqually) {
+  const auto path = makePath<double>(0.0);
+  EXPECT_EQ(hash(path), hash(makePath<double>(0.0)));
+  EXPECT_EQ(hash(path), hash(makePath<float>(0.0)));
+  EXPECT_NE(hash(path), hash(makePath<double>(1e-9)));
+  auto other = path;
+  other.back().point() = Vec2d(1.0, 1.0);  // Unused by close commands
+  EXPECT_EQ(hash(path), hash(other));
+  other.front().point().x = -0.0;
+  EXPECT_EQ(hash(path), hash(other));
+  other.front().point().y = 1.0;
+  EXPECT_NE(hash(path), hash(other));
+}
+
+TEST(HasherTest, QuantizesToTolerance) {
+  const auto path = makePath<double>(0.0);
+  EXPECT_EQ(hash(path, 1e-6), hash(makePath<double>(1e-9), 1e-6));
+  EXPECT_NE(hash(path, 1e-6), hash(makePath<double>(1e-3), 1e-6));
+  EXPECT_NE(hash(path), hash(path, 1e-6));
+}
+
+TEST(HasherTest, UpdatesIncrementally) {
+  const auto path = makePath<double>(0.0);
+  Hasher hasher;
+  Path2d partial;
+  for (const auto& command : path) {
+    hasher.update(command);
+    partial.commands().emplace_back(command);
+    EXPECT_EQ(hasher.digest(), hash(partial));
+  }
+  hasher.reset();
+  EXPECT_EQ(hasher.update(path).digest(), hash(path));
+}
+
+TEST(HasherTest, HashesShapes) {
+  Shape2d shape1;
+  shape1.paths().emplace_back(makePath<double>(0.0));
+  shape1.paths().emplace_back(makePath<double>(8.0));
+  auto shape2 = shape1;
+  EXPECT_EQ(hash(shape1), hash(shape2));
+  shape2.paths().reverse();
+  EXPECT_NE(hash(shape1), hash(shape2));
+
+  // Boundaries between paths contribute to the hash
+  Shape2d shape3;
+  shape3.paths().emplace_back();
+  for (const auto& path : shape1.paths()) {
+    for (const auto& command : path) {
+      shape3.paths().back().commands().emplace_back(command);
+    }
+  }
+  EXPECT_NE(hash(shape1), hash(shape3));
+}
+
+TEST(HasherTest, KeysUnorderedContainers) {
+  std::unordered_set<Path2d> paths;
+  for (int i{}; i < 100; ++i) {
+    paths.emplace(makePath<double>(i % 10));
+  }
+  EXPECT_EQ(paths.size(), 10);
+  EXPECT_EQ(paths.count(makePath<double>(3.0)), 1);
+  EXPECT_EQ(paths.count(makePath<double>(10.0)), 0);
+}
+
+}  // namespace graphics
+}  // namespace takram
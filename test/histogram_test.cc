@@ -0,0 +1,171 @@
+//
+//  takram/graphics/histogram_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/channel.h"
+#include "takram/graphics/color.h"
+#include "takram/graphics/histogram.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+const Channel channels[] = {
+  Channel::RED,
+  Channel::GREEN,
+  Channel::BLUE,
+  Channel::ALPHA
+};
+
+template <class T>
+std::vector<Color<T, 4>> makeColors(std::size_t size) {
+  std::mt19937 engine(1);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<Color<T, 4>> result;
+  for (std::size_t i{}; i < size; ++i) {
+    const Color4u color(distribution(engine), distribution(engine) / 2,
+                        distribution(engine) / 4 + 64, distribution(engine));
+    result.emplace_back(color);
+  }
+  return result;
+}
+
+// Counts and statistics of a channel taken one color after another
+template <class T, int C>
+void expectChannel(const Histogram<T, C>& histogram,
+                   const std::vector<Color<T, C>>& colors,
+                   Channel channel) {
+  const auto c = static_cast<int>(channel);
+  std::vector<std::size_t> counts(histogram.bins());
+  double min = std::numeric_limits<double>::infinity();
+  double max = -min;
+  double sum{};
+  for (const auto& color : colors) {
+    const double value = color.vector[c];
+    const auto normalized = std::is_integral<T>::value ?
+        value / (std::numeric_limits<T>::max() + 1.0) : value;
+    const auto bin = static_cast<int>(std::floor(normalized *
+                                                 histogram.bins()));
+    ++counts[std::min(std::max(bin, 0), histogram.bins() - 1)];
+    min = std::min(min, value);
+    max = std::max(max, value);
+    sum += value;
+  }
+  for (int bin{}; bin < histogram.bins(); ++bin) {
+    ASSERT_EQ(histogram.count(channel, bin), counts[bin]) << channel;
+  }
+  EXPECT_EQ(histogram.min(channel), min) << channel;
+  EXPECT_EQ(histogram.max(channel), max) << channel;
+  EXPECT_NEAR(histogram.mean(channel), sum / colors.size(), 1e-5) << channel;
+}
+
+}  // namespace
+
+TEST(HistogramTest, CountsBuffers) {
+  // Sizes that leave pixels out of whole vectors, across chunks
+  for (const auto size : {std::size_t(1), std::size_t(7),
+                          std::size_t(300001)}) {
+    const auto colors = makeColors<std::uint8_t>(size);
+    for (const auto bins : {256, 10}) {
+      const Histogram4u histogram(colors.data(), colors.size(), bins);
+      EXPECT_EQ(histogram.total(), size);
+      for (const auto channel : channels) {
+        expectChannel(histogram, colors, channel);
+      }
+    }
+    auto floats = makeColors<float>(size);
+    floats.front().r = -0.5f;
+    floats.back().b = 2.0f;
+    const Histogram4f histogram(floats.data(), floats.size(), 64);
+    for (const auto channel : channels) {
+      expectChannel(histogram, floats, channel);
+    }
+    const Histogram<std::uint16_t, 3> wide(
+        std::vector<Color3s>(size, Color3s(0, 40000, 65535)).data(), size, 4);
+    EXPECT_EQ(wide.count(Channel::RED, 0), size);
+    EXPECT_EQ(wide.count(Channel::GREEN, 2), size);
+    EXPECT_EQ(wide.count(Channel::BLUE, 3), size);
+    EXPECT_EQ(wide.max(Channel::BLUE), 65535);
+  }
+}
+
+TEST(HistogramTest, HandlesNaNsAndEmptyBuffers) {
+  std::vector<Color4f> colors(5, Color4f(0.5f, 0.25f, 1.0f, 1.0f));
+  colors[2].r = std::numeric_limits<float>::quiet_NaN();
+  colors[3].r = 0.75f;
+  const Histogram4f histogram(colors.data(), colors.size(), 4);
+  EXPECT_EQ(histogram.count(Channel::RED, 0), 1);
+  EXPECT_EQ(histogram.count(Channel::RED, 2), 3);
+  EXPECT_EQ(histogram.count(Channel::RED, 3), 1);
+  EXPECT_EQ(histogram.count(Channel::BLUE, 3), 5);
+  EXPECT_EQ(histogram.min(Channel::RED), 0.5);
+  EXPECT_EQ(histogram.max(Channel::RED), 0.75);
+  EXPECT_TRUE(std::isnan(histogram.mean(Channel::RED)));
+  EXPECT_EQ(histogram.mean(Channel::GREEN), 0.25);
+  EXPECT_EQ(histogram.quantile(Channel::RED, 0.0), 0);
+  EXPECT_EQ(histogram.quantile(Channel::RED, 0.5), 2);
+  EXPECT_EQ(histogram.quantile(Channel::RED, 1.0), 3);
+  EXPECT_EQ(histogram.quantile(Channel::GREEN, 1.0), 1);
+
+  const Histogram4u empty(static_cast<const Color4u *>(nullptr), 0);
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty.bins(), 256);
+  EXPECT_EQ(empty.count(Channel::ALPHA, 255), 0);
+  EXPECT_EQ(empty.mean(Channel::ALPHA), 0);
+}
+
+TEST(HistogramTest, CountsImages) {
+  const auto colors = makeColors<std::uint8_t>(301 * 257);
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    Image4u image(301, 257, layout);
+    for (int y{}; y < image.height(); ++y) {
+      for (int x{}; x < image.width(); ++x) {
+        image.setPixel(x, y, colors[y * image.width() + x]);
+      }
+    }
+    const Histogram4u histogram(image.view(), 32);
+    EXPECT_EQ(histogram.total(), colors.size());
+    for (const auto channel : channels) {
+      expectChannel(histogram, colors, channel);
+    }
+  }
+  const Histogram3u histogram(Image3u(0, 0).view());
+  EXPECT_TRUE(histogram.empty());
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,184 @@
+//
+//  takram/graphics/image_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+#include "takram/graphics/image_view.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+Color4u makeColor(int x, int y) {
+  return Color4u(x, y, x + y, 255 - x);
+}
+
+template <class T, int C>
+void fillPattern(ImageView<T, C> view) {
+  for (int y{}; y < view.height(); ++y) {
+    for (int x{}; x < view.width(); ++x) {
+      view.setPixel(x, y, makeColor(x, y));
+    }
+  }
+}
+
+}  // namespace
+
+TEST(ImageTest, AlignsRows) {
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    const Image4u image(13, 7, layout);
+    EXPECT_EQ(image.width(), 13);
+    EXPECT_EQ(image.height(), 7);
+    EXPECT_EQ(image.layout(), layout);
+    EXPECT_EQ(image.rowStride() % Image4u::alignment, 0);
+    for (int y{}; y < image.height(); ++y) {
+      const auto address = reinterpret_cast<std::uintptr_t>(image.row(y));
+      EXPECT_EQ(address % Image4u::alignment, 0);
+    }
+    for (int channel{}; layout == ImageLayout::PLANAR && channel < 4;
+         ++channel) {
+      const auto address = reinterpret_cast<std::uintptr_t>(
+          &image.at(0, 0, channel));
+      EXPECT_EQ(address % Image4u::alignment, 0);
+    }
+  }
+  const Image4f image(5, 3);
+  EXPECT_EQ(image.rowStride(), 32);
+  EXPECT_FALSE(image.view().contiguous());
+}
+
+TEST(ImageTest, AccessesPixels) {
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    Image4u image(9, 5, layout);
+    fillPattern(image.view());
+    for (int y{}; y < image.height(); ++y) {
+      for (int x{}; x < image.width(); ++x) {
+        ASSERT_EQ(image.pixel(x, y), makeColor(x, y));
+        ASSERT_EQ(image.at(x, y, 2), x + y);
+      }
+    }
+    EXPECT_EQ(image.view().interleaved(),
+              layout == ImageLayout::INTERLEAVED);
+  }
+  const Image4u image(3, 2, Color4u(1, 2, 3, 4), ImageLayout::PLANAR);
+  EXPECT_EQ(image.pixel(2, 1), Color4u(1, 2, 3, 4));
+}
+
+TEST(ImageTest, CopiesAndMoves) {
+  Image4u image(9, 5);
+  fillPattern(image.view());
+  Image4u copy(image);
+  EXPECT_NE(copy.data(), image.data());
+  copy.setPixel(0, 0, Color4u());
+  EXPECT_EQ(image.pixel(0, 0), makeColor(0, 0));
+
+  // Conversion between layouts
+  const Image4u planar(image.view(), ImageLayout::PLANAR);
+  const Image4u interleaved(planar.view());
+  EXPECT_EQ(planar.pixel(8, 4), makeColor(8, 4));
+  EXPECT_EQ(interleaved.pixel(8, 4), makeColor(8, 4));
+
+  const auto data = image.data();
+  const auto moved = std::move(image);
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_TRUE(image.empty());
+
+  // Vectors move images when they grow, rather than copying them
+  static_assert(std::is_nothrow_move_constructible<Image4u>::value, "");
+  static_assert(std::is_nothrow_move_assignable<Image4u>::value, "");
+  std::vector<Image4u> images;
+  images.emplace_back(9, 5);
+  const auto front = images.front().data();
+  images.resize(images.capacity() + 1);
+  EXPECT_EQ(images.front().data(), front);
+}
+
+TEST(ImageTest, ViewsRegionsAndChannels) {
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    Image4u image(16, 16, layout);
+    fillPattern(image.view());
+    auto region = image.region(3, 4, 5, 6);
+    EXPECT_EQ(region.width(), 5);
+    EXPECT_EQ(region.height(), 6);
+    EXPECT_EQ(region.pixel(0, 0), makeColor(3, 4));
+    EXPECT_EQ(region.region(1, 1, 2, 2).pixel(1, 1), makeColor(5, 6));
+    region.fill(Color4u());
+    EXPECT_EQ(image.pixel(7, 9), Color4u());
+    EXPECT_EQ(image.pixel(8, 9), makeColor(8, 9));
+
+    const auto channel = image.channel(3);
+    EXPECT_EQ(channel.at(2, 1), 253);
+    EXPECT_EQ(&channel.at(2, 1), &image.at(2, 1, 3));
+
+    // Constant images only give views of constant values
+    const auto& constant = image;
+    static_assert(std::is_same<decltype(constant.view()),
+                               ImageView<const std::uint8_t, 4>>::value, "");
+    static_assert(std::is_same<decltype(constant.region(0, 0, 1, 1)),
+                               ImageView<const std::uint8_t, 4>>::value, "");
+    static_assert(std::is_same<decltype(constant.channel(0)),
+                               ImageView<const std::uint8_t, 1>>::value, "");
+    EXPECT_EQ(constant.region(8, 9, 2, 2).pixel(1, 1), makeColor(9, 10));
+    EXPECT_EQ(&constant.channel(3).at(2, 1), &image.at(2, 1, 3));
+  }
+}
+
+TEST(ImageTest, WrapsExternalMemory) {
+  // Rows of three pixels padded to four, stored bottom up
+  std::vector<std::uint8_t> memory(4 * 4 * 2);
+  ImageView4u view(memory.data() + 4 * 4, 3, 2, -4 * 4);
+  fillPattern(view);
+  EXPECT_EQ(memory[0], 0);
+  EXPECT_EQ(memory[1], 1);
+  EXPECT_EQ(memory[4 * 4 + 4], 1);
+  EXPECT_EQ(memory[12], 0);  // Padding
+
+  const Image4u image(view);
+  EXPECT_EQ(image.pixel(2, 1), makeColor(2, 1));
+  EXPECT_EQ(image.row(1)[4 * 2], 2);
+
+  // Memory that is only read
+  const std::vector<std::uint8_t>& constant = memory;
+  const ImageView<const std::uint8_t, 4> read(constant.data() + 4 * 4, 3, 2,
+                                              -4 * 4);
+  EXPECT_EQ(read.pixel(2, 1), makeColor(2, 1));
+  Image4u copy(3, 2);
+  copy.view().copy(read);
+  EXPECT_EQ(copy.pixel(1, 1), makeColor(1, 1));
+  EXPECT_EQ(Image4u(read, ImageLayout::PLANAR).pixel(2, 0), makeColor(2, 0));
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,294 @@
+//
+//  takram/graphics/intersector_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/intersector.h"
+#include "takram/graphics/segment.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+void circle(Shape2d *shape, double x, double y, double radius) {
+  const auto w = std::sqrt(0.5);
+  shape->moveTo(x + radius, y);
+  shape->conicTo(x + radius, y + radius, x, y + radius, w);
+  shape->conicTo(x - radius, y + radius, x - radius, y, w);
+  shape->conicTo(x - radius, y - radius, x, y - radius, w);
+  shape->conicTo(x + radius, y - radius, x + radius, y, w);
+  shape->close();
+}
+
+void expectCoincident(const Segment2d& a, const Segment2d& b,
+                      const std::vector<Intersector2d::Intersection>& result) {
+  for (const auto& intersection : result) {
+    const auto p = a.evaluateAt(intersection.t1);
+    const auto q = b.evaluateAt(intersection.t2);
+    EXPECT_NEAR(p.x, q.x, 1e-9);
+    EXPECT_NEAR(p.y, q.y, 1e-9);
+    EXPECT_NEAR(p.x, intersection.point.x, 1e-9);
+    EXPECT_NEAR(p.y, intersection.point.y, 1e-9);
+  }
+}
+
+// Horizontal lines spanning the whole width, crossed one by one by the steps
+// of a diagonal, so that every piece overlaps every line in x
+void stairs(Shape2d *lines, Shape2d *diagonal, std::size_t size) {
+  for (std::size_t i{}; i < size; ++i) {
+    lines->moveTo(0.0, i + 0.5);
+    lines->lineTo(static_cast<double>(size), i + 0.5);
+  }
+  diagonal->moveTo(0.0, 0.0);
+  for (std::size_t i{}; i < size; ++i) {
+    diagonal->lineTo(i + 1.0, i + 1.0);
+  }
+}
+
+}  // namespace
+
+TEST(IntersectorTest, IntersectsAllTypes) {
+  const auto w = std::sqrt(0.5);
+  const std::vector<Segment2d> segments{
+    Segment2d(Vec2d(-1.0, -0.5), Command2d(
+        CommandType::LINE, Vec2d(2.0, 1.5))),
+    Segment2d(Vec2d(-0.5, 1.0), Command2d(
+        CommandType::QUADRATIC, Vec2d(0.5, -1.0), Vec2d(1.5, 1.0))),
+    Segment2d(Vec2d(1.0, 0.0), Command2d(
+        CommandType::CONIC, Vec2d(1.0, 1.0), Vec2d(0.0, 1.0), w)),
+    Segment2d(Vec2d(0.0, 1.5), Command2d(
+        CommandType::CUBIC, Vec2d(0.5, -1.5), Vec2d(1.0, 2.5),
+        Vec2d(1.5, -0.5))),
+  };
+  // Intersections counted by sampling both curves densely
+  const auto count = [](const Segment2d& a, const Segment2d& b) {
+    const int samples = 4096;
+    int result{};
+    for (int i{}; i < samples; ++i) {
+      const auto p1 = a.evaluateAt(static_cast<double>(i) / samples);
+      const auto p2 = a.evaluateAt(static_cast<double>(i + 1) / samples);
+      for (int j{}; j < samples; ++j) {
+        const auto q1 = b.evaluateAt(static_cast<double>(j) / samples);
+        const auto q2 = b.evaluateAt(static_cast<double>(j + 1) / samples);
+        const auto r = p2 - p1;
+        const auto s = q2 - q1;
+        const auto d = r.cross(s);
+        if (!d) {
+          continue;
+        }
+        const auto t = (q1 - p1).cross(s) / d;
+        const auto u = (q1 - p1).cross(r) / d;
+        if (0 <= t && t < 1 && 0 <= u && u < 1) {
+          ++result;
+        }
+      }
+    }
+    return result;
+  };
+  const Intersector2d intersector;
+  for (const auto& a : segments) {
+    for (const auto& b : segments) {
+      if (&a == &b) {
+        continue;
+      }
+      const auto result = intersector.intersect(a, b);
+      EXPECT_EQ(result.size(), count(a, b));
+      expectCoincident(a, b, result);
+    }
+  }
+}
+
+TEST(IntersectorTest, IntersectsAtEndPoints) {
+  const Segment2d a(Vec2d(0.0, 0.0), Command2d(
+      CommandType::CUBIC, Vec2d(1.0, 2.0), Vec2d(2.0, -2.0), Vec2d(3.0, 0.0)));
+  const Segment2d b(Vec2d(0.0, 0.0), Command2d(
+      CommandType::CUBIC, Vec2d(1.0, -2.0), Vec2d(2.0, 2.0), Vec2d(3.0, 0.0)));
+  auto result = Intersector2d().intersect(a, b);
+  ASSERT_EQ(result.size(), 3);
+  std::sort(std::begin(result), std::end(result),
+            [](const Intersector2d::Intersection& lhs,
+               const Intersector2d::Intersection& rhs) {
+    return lhs.t1 < rhs.t1;
+  });
+  EXPECT_NEAR(result[0].t1, 0, 1e-9);
+  EXPECT_NEAR(result[1].t1, 0.5, 1e-9);
+  EXPECT_NEAR(result[2].t1, 1, 1e-9);
+  expectCoincident(a, b, result);
+}
+
+TEST(IntersectorTest, IntersectsOverlaps) {
+  // Arcs of the same circle that overlap between 45 and 90 degrees meet at
+  // the ends of the overlap only
+  const auto w = std::sqrt(0.5);
+  const Segment2d a(Vec2d(1.0, 0.0), Command2d(
+      CommandType::CONIC, Vec2d(1.0, 1.0), Vec2d(0.0, 1.0), w));
+  const Segment2d b(Vec2d(w, w), Command2d(
+      CommandType::CONIC, Vec2d(0.0, 2 * w), Vec2d(-w, w), w));
+  auto result = Intersector2d().intersect(a, b);
+  ASSERT_EQ(result.size(), 2);
+  std::sort(std::begin(result), std::end(result),
+            [](const Intersector2d::Intersection& lhs,
+               const Intersector2d::Intersection& rhs) {
+    return lhs.t1 < rhs.t1;
+  });
+  EXPECT_NEAR(result[0].point.x, w, 1e-9);
+  EXPECT_NEAR(result[0].point.y, w, 1e-9);
+  EXPECT_NEAR(result[1].point.x, 0, 1e-9);
+  EXPECT_NEAR(result[1].point.y, 1, 1e-9);
+  EXPECT_NEAR(result[1].t1, 1, 1e-9);
+  expectCoincident(a, b, result);
+}
+
+TEST(IntersectorTest, IntersectsTangents) {
+  // A parabola that touches a line is reported once at the point of contact
+  const Segment2d a(Vec2d(-2.0, 0.0), Command2d(
+      CommandType::LINE, Vec2d(2.0, 0.0)));
+  const Segment2d b(Vec2d(-1.0, 1.0), Command2d(
+      CommandType::QUADRATIC, Vec2d(0.0, -1.0), Vec2d(1.0, 1.0)));
+  const auto result = Intersector2d().intersect(a, b);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_NEAR(result[0].point.x, 0, 1e-3);
+  EXPECT_NEAR(result[0].point.y, 0, 1e-9);
+}
+
+TEST(IntersectorTest, IntersectsTangentsAtJoints) {
+  // A line that touches a circle where two of its segments join is reported
+  // once at the joint
+  Shape2d a;
+  Shape2d b;
+  circle(&a, 5.25, 1.75, 4.75);
+  b.moveTo(10.0, 1.5);
+  b.lineTo(10.0, 5.0);
+  const auto result = Intersector2d().intersect(a, b);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_NEAR(result[0].point.x, 10, 1e-9);
+  EXPECT_NEAR(result[0].point.y, 1.75, 1e-9);
+}
+
+TEST(IntersectorTest, IntersectsShapes) {
+  Shape2d a;
+  Shape2d b;
+  circle(&a, 0, 0, 1);
+  circle(&b, 1, 0, 1);
+  const auto result = Intersector2d().intersect(a, b);
+  ASSERT_EQ(result.size(), 2);
+  for (const auto& intersection : result) {
+    EXPECT_NEAR(intersection.point.x, 0.5, 1e-9);
+    EXPECT_NEAR(std::abs(intersection.point.y), std::sqrt(0.75), 1e-9);
+  }
+  // Crossings at the joints of segments are reported once
+  Shape2d c;
+  c.moveTo(0.5, 0.0);
+  c.lineTo(2.0, 0.0);
+  const auto joint = Intersector2d().intersect(a, c);
+  ASSERT_EQ(joint.size(), 1);
+  EXPECT_EQ(joint[0].index1, 0);
+  EXPECT_NEAR(joint[0].t1, 0, 1e-9);
+  EXPECT_NEAR(joint[0].t2, 1.0 / 3, 1e-9);
+  // Paths intersect in the same way
+  EXPECT_EQ(Intersector2d().intersect(a.paths().front(),
+                                      b.paths().front()).size(), 2);
+}
+
+TEST(IntersectorTest, IntersectsSelf) {
+  Shape2d shape;
+  circle(&shape, 0, 0, 1);
+  EXPECT_TRUE(Intersector2d().intersect(shape).empty());
+  shape.moveTo(2.0, 0.0);
+  shape.lineTo(4.0, 2.0);
+  shape.lineTo(4.0, 0.0);
+  shape.lineTo(2.0, 2.0);
+  shape.close();
+  auto result = Intersector2d().intersect(shape);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_NEAR(result[0].point.x, 3, 1e-9);
+  EXPECT_NEAR(result[0].point.y, 1, 1e-9);
+  EXPECT_EQ(result[0].index1, 4);
+  EXPECT_EQ(result[0].index2, 6);
+
+  // A cubic with a loop
+  Shape2d loop;
+  loop.moveTo(0.0, 0.0);
+  loop.cubicTo(3.0, 2.0, -1.0, 2.0, 2.0, 0.0);
+  result = Intersector2d().intersect(loop);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_EQ(result[0].index1, 0);
+  EXPECT_EQ(result[0].index2, 0);
+  EXPECT_NE(result[0].t1, result[0].t2);
+}
+
+TEST(IntersectorTest, IntersectsManyPieces) {
+  const std::size_t size = 2000;
+  Shape2d lines;
+  Shape2d diagonal;
+  stairs(&lines, &diagonal, size);
+  auto result = Intersector2d().intersect(lines, diagonal);
+  ASSERT_EQ(result.size(), size);
+  std::sort(std::begin(result), std::end(result),
+            [](const Intersector2d::Intersection& a,
+               const Intersector2d::Intersection& b) {
+    return a.index1 < b.index1;
+  });
+  for (std::size_t i{}; i < size; ++i) {
+    ASSERT_EQ(result[i].index1, i);
+    ASSERT_EQ(result[i].index2, i);
+    EXPECT_NEAR(result[i].point.x, i + 0.5, 1e-9);
+    EXPECT_NEAR(result[i].point.y, i + 0.5, 1e-9);
+  }
+  for (const auto& path : diagonal.paths()) {
+    lines.paths().emplace_back(path);
+  }
+  EXPECT_EQ(Intersector2d().intersect(lines).size(), size);
+}
+
+TEST(IntersectorTest, DISABLED_Benchmark) {
+  using Clock = std::chrono::steady_clock;
+  for (const std::size_t size : {2000, 5000, 20000, 100000}) {
+    Shape2d lines;
+    Shape2d diagonal;
+    stairs(&lines, &diagonal, size);
+    const auto start = Clock::now();
+    const auto result = Intersector2d().intersect(lines, diagonal);
+    const std::chrono::duration<double, std::milli> time = Clock::now() - start;
+    std::cout << result.size() << " crossings: " << time.count() << " ms"
+              << std::endl;
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,252 @@
+//
+//  takram/graphics/monotone_segments_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/fill_rule.h"
+#include "takram/graphics/monotone_segments.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+bool monotone(const Segment2d& segment) {
+  const auto start = segment.evaluateAt(0);
+  const auto end = segment.evaluateAt(1);
+  auto previous = start;
+  for (int i{1}; i <= 64; ++i) {
+    const auto point = segment.evaluateAt(i / 64.0);
+    if ((point.x - previous.x) * (end.x - start.x) < -1e-12 ||
+        (point.y - previous.y) * (end.y - start.y) < -1e-12) {
+      return false;
+    }
+    previous = point;
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(MonotoneSegmentsTest, Decomposes) {
+  Path2d path;
+  path.moveTo(0.0, 0.0);
+  path.cubicTo(4.0, 3.0, -1.0, 3.0, 3.0, 0.0);
+  path.conicTo(1.5, -2.0, 0.0, 0.0, 2.0);
+  const MonotoneSegments2d segments(path);
+  ASSERT_GT(segments.size(), 3);
+  const auto source = path.segments();
+  auto itr = std::begin(source);
+  for (std::size_t i{}; i < segments.size(); ++i) {
+    const auto& piece = segments[i];
+    EXPECT_TRUE(monotone(piece.segment));
+    EXPECT_LT(piece.begin, piece.end);
+    if (i && piece.index != segments[i - 1].index) {
+      ++itr;
+    }
+    const auto start = itr->evaluateAt(piece.begin);
+    const auto end = itr->evaluateAt(piece.end);
+    EXPECT_NEAR(piece.segment.start().x, start.x, 1e-12);
+    EXPECT_NEAR(piece.segment.start().y, start.y, 1e-12);
+    EXPECT_NEAR(piece.segment.point().x, end.x, 1e-12);
+    EXPECT_NEAR(piece.segment.point().y, end.y, 1e-12);
+    if (i) {
+      EXPECT_EQ(piece.segment.start(), segments[i - 1].segment.point());
+    }
+  }
+  EXPECT_EQ(segments[segments.size() - 1].index, 1);
+  EXPECT_NEAR(segments.bounds().minY(), -4.0 / 3, 1e-12);
+  EXPECT_NEAR(segments.bounds().maxY(), 2.25, 1e-12);
+}
+
+TEST(MonotoneSegmentsTest, Winds) {
+  Shape2d shape;
+  const auto w = std::sqrt(0.5);
+  shape.moveTo(2.0, 0.0);
+  shape.conicTo(2.0, 2.0, 0.0, 2.0, w);
+  shape.conicTo(-2.0, 2.0, -2.0, 0.0, w);
+  shape.conicTo(-2.0, -2.0, 0.0, -2.0, w);
+  shape.conicTo(2.0, -2.0, 2.0, 0.0, w);
+  shape.moveTo(1.0, 0.0);
+  shape.conicTo(1.0, 1.0, 0.0, 1.0, w);
+  shape.conicTo(-1.0, 1.0, -1.0, 0.0, w);
+  shape.conicTo(-1.0, -1.0, 0.0, -1.0, w);
+  shape.conicTo(1.0, -1.0, 1.0, 0.0, w);
+  const MonotoneSegments2d segments(shape);
+  for (int i{}; i < 64; ++i) {
+    const auto angle = i * 0.1;
+    for (const auto radius : {0.5, 1.5, 2.5}) {
+      const Vec2d point(radius * std::cos(angle), radius * std::sin(angle));
+      const int expected = radius < 1 ? 2 : (radius < 2 ? 1 : 0);
+      EXPECT_EQ(segments.winding(point), expected);
+      EXPECT_EQ(segments.contains(point, FillRule::EVEN_ODD), expected == 1);
+    }
+  }
+  // Rays through vertices
+  EXPECT_EQ(segments.winding(Vec2d(0.0, 0.0)), 2);
+  EXPECT_EQ(segments.winding(Vec2d(-1.5, 0.0)), 1);
+  EXPECT_EQ(segments.winding(Vec2d(0.0, 1.5)), 1);
+  // A ray that reaches the edge at the far right after rounding
+  Shape2d rectangle;
+  rectangle.moveTo(-1.0, 0.0);
+  rectangle.lineTo(2.0, 0.0);
+  rectangle.lineTo(2.0, 3.0);
+  rectangle.lineTo(-1.0, 3.0);
+  rectangle.close();
+  EXPECT_EQ(MonotoneSegments2d(rectangle).winding(
+      Vec2d(-0.223584392, 0.316987298)), 1);
+}
+
+TEST(MonotoneSegmentsTest, FindsCrossings) {
+  // Rays toward either side from inside nested squares wound the same way
+  Shape2d shape;
+  for (const auto size : {1.0, 2.0}) {
+    shape.moveTo(-size, -size);
+    shape.lineTo(size, -size);
+    shape.lineTo(size, size);
+    shape.lineTo(-size, size);
+    shape.close();
+  }
+  const MonotoneSegments2d segments(shape);
+  for (const bool reversed : {false, true}) {
+    std::vector<std::size_t> indices;
+    int sum{};
+    segments.crossings(Vec2d(0.5, 0.5), reversed,
+                       [&](const MonotoneSegments2d::Piece& piece,
+                           int direction) {
+      indices.emplace_back(piece.index);
+      sum += direction;
+    });
+    std::sort(std::begin(indices), std::end(indices));
+    const std::vector<std::size_t> expected{reversed ? 3u : 1u,
+                                            reversed ? 7u : 5u};
+    EXPECT_EQ(indices, expected);
+    EXPECT_EQ(sum, reversed ? -2 : 2);
+  }
+}
+
+TEST(MonotoneSegmentsTest, FindsOverlappingPieces) {
+  std::mt19937 engine(3);
+  std::uniform_real_distribution<double> distribution(0, 100);
+  Shape2d shape;
+  for (int i{}; i < 200; ++i) {
+    shape.moveTo(distribution(engine), distribution(engine));
+    shape.quadraticTo(distribution(engine), distribution(engine),
+                      distribution(engine), distribution(engine));
+    shape.lineTo(distribution(engine), distribution(engine));
+    shape.close();
+  }
+  const MonotoneSegments2d segments(shape);
+  for (int i{}; i < 100; ++i) {
+    const Rect2d bounds(Vec2d(distribution(engine), distribution(engine)),
+                        Vec2d(distribution(engine), distribution(engine)));
+    std::vector<std::size_t> expected;
+    for (std::size_t j{}; j < segments.size(); ++j) {
+      const auto& other = segments[j].bounds;
+      if (other.minX() <= bounds.maxX() && bounds.minX() <= other.maxX() &&
+          other.minY() <= bounds.maxY() && bounds.minY() <= other.maxY()) {
+        expected.emplace_back(j);
+      }
+    }
+    std::vector<std::size_t> found;
+    segments.overlapping(bounds, [&](std::size_t index) {
+      found.emplace_back(index);
+    });
+    std::sort(std::begin(found), std::end(found));
+    ASSERT_EQ(found, expected);
+  }
+  // Touching bounds overlap
+  for (std::size_t i{}; i < segments.size(); ++i) {
+    const auto& bounds = segments[i].bounds;
+    const Vec2d corner(bounds.maxX(), bounds.maxY());
+    bool found{};
+    segments.overlapping(Rect2d(corner, corner), [&](std::size_t index) {
+      found = found || index == i;
+    });
+    ASSERT_TRUE(found);
+  }
+}
+
+TEST(MonotoneSegmentsTest, FindsNearestPieces) {
+  std::mt19937 engine(4);
+  std::uniform_real_distribution<double> distribution(0, 100);
+  Shape2d shape;
+  for (int i{}; i < 200; ++i) {
+    shape.moveTo(distribution(engine), distribution(engine));
+    shape.quadraticTo(distribution(engine), distribution(engine),
+                      distribution(engine), distribution(engine));
+    shape.lineTo(distribution(engine), distribution(engine));
+    shape.close();
+  }
+  const MonotoneSegments2d segments(shape);
+  const auto distance = [&](std::size_t index, const Vec2d& point) {
+    const auto& bounds = segments[index].bounds;
+    const auto dx = std::max({bounds.minX() - point.x, 0.0,
+                              point.x - bounds.maxX()});
+    const auto dy = std::max({bounds.minY() - point.y, 0.0,
+                              point.y - bounds.maxY()});
+    return std::hypot(dx, dy);
+  };
+  for (int i{}; i < 100; ++i) {
+    const Vec2d point(distribution(engine) * 1.5 - 25,
+                      distribution(engine) * 1.5 - 25);
+    auto expected = std::numeric_limits<double>::infinity();
+    for (std::size_t j{}; j < segments.size(); ++j) {
+      expected = std::min(expected, distance(j, point));
+    }
+    auto nearest = std::numeric_limits<double>::infinity();
+    std::size_t visited{};
+    segments.nearest(point, [&](std::size_t index) {
+      ++visited;
+      nearest = std::min(nearest, distance(index, point));
+      return nearest;
+    });
+    ASSERT_EQ(nearest, expected);
+    ASSERT_LT(visited, segments.size());
+  }
+  // Every piece is visited when the distance never shrinks
+  std::size_t visited{};
+  segments.nearest(Vec2d(50.0, 50.0), [&](std::size_t) {
+    ++visited;
+    return std::numeric_limits<double>::infinity();
+  });
+  ASSERT_EQ(visited, segments.size());
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,165 @@
+//
+//  test/offsetter_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/join_type.h"
+#include "takram/graphics/offsetter.h"
+#include "takram/graphics/segment.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/vector.h"
+
+#include "shape_helpers.h"
+
+namespace takram {
+namespace graphics {
+
+TEST(OffsetterTest, Joins) {
+  const auto square = makeRectangle(0, 0, 2, 2);
+  auto shape = square.offset(0.5, JoinType::MITER);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 9, 1e-9);
+  const auto bounds = shape.bounds();
+  EXPECT_DOUBLE_EQ(bounds.minX(), -0.5);
+  EXPECT_DOUBLE_EQ(bounds.minY(), -0.5);
+  EXPECT_DOUBLE_EQ(bounds.maxX(), 2.5);
+  EXPECT_DOUBLE_EQ(bounds.maxY(), 2.5);
+  shape = square.offset(0.5, JoinType::BEVEL);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 8.5, 1e-9);
+  shape = square.offset(0.5, JoinType::ROUND);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 8 + std::acos(-1.0) / 4, 1e-4);
+}
+
+TEST(OffsetterTest, Insets) {
+  const auto square = makeRectangle(0, 0, 2, 2);
+  const auto shape = square.offset(-0.5);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), 1, 1e-9);
+  EXPECT_TRUE(square.offset(-1.5).empty());
+}
+
+TEST(OffsetterTest, IgnoresOrientation) {
+  Shape2d shape;
+  shape.moveTo(0, 0);
+  shape.lineTo(0, 2);
+  shape.lineTo(2, 2);
+  shape.lineTo(2, 0);
+  shape.close();
+  EXPECT_NEAR(calculateArea(shape.offset(0.5)), 9, 1e-9);
+}
+
+TEST(OffsetterTest, ResolvesConcaveCorners) {
+  const auto shape = makeRectangle(0, 0, 2, 1).united(
+      makeRectangle(0, 0, 1, 2));
+  const auto outset = shape.offset(0.25);
+  ASSERT_EQ(outset.size(), 1);
+  EXPECT_NEAR(calculateArea(outset), 5.25, 1e-9);
+  const auto inset = shape.offset(-0.25);
+  ASSERT_EQ(inset.size(), 1);
+  EXPECT_NEAR(calculateArea(inset), 1.5 * 0.5 * 2 - 0.25, 1e-9);
+}
+
+TEST(OffsetterTest, ShrinksHoles) {
+  auto shape = makeRectangle(0, 0, 4, 4);
+  shape.moveTo(1, 1);
+  shape.lineTo(1, 3);
+  shape.lineTo(3, 3);
+  shape.lineTo(3, 1);
+  shape.close();
+  auto result = shape.offset(0.5);
+  ASSERT_EQ(result.size(), 2);
+  EXPECT_NEAR(calculateArea(result), 25 - 1, 1e-9);
+  result = shape.offset(1.5);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_NEAR(calculateArea(result), 49, 1e-9);
+}
+
+TEST(OffsetterTest, KeepsArcs) {
+  const auto weight = std::sqrt(2.0) / 2;
+  Shape2d circle;
+  circle.moveTo(1, 0);
+  circle.conicTo(1, 1, 0, 1, weight);
+  circle.conicTo(-1, 1, -1, 0, weight);
+  circle.conicTo(-1, -1, 0, -1, weight);
+  circle.conicTo(1, -1, 1, 0, weight);
+  circle.close();
+  const auto pi = std::acos(-1.0);
+  auto shape = circle.offset(0.5, JoinType::MITER, 1e-6);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), pi * 1.5 * 1.5, 1e-4);
+  for (const auto& command : shape.front()) {
+    EXPECT_NE(command.type(), CommandType::LINE);
+  }
+  shape = circle.offset(-0.5, JoinType::MITER, 1e-6);
+  ASSERT_EQ(shape.size(), 1);
+  EXPECT_NEAR(calculateArea(shape), pi * 0.5 * 0.5, 1e-4);
+}
+
+TEST(OffsetterTest, ApproximatesCubics) {
+  Shape2d shape;
+  shape.moveTo(0, 0);
+  shape.cubicTo(1, -1, 2, 1, 3, 0);
+  shape.lineTo(3, 2);
+  shape.lineTo(0, 2);
+  shape.close();
+  const Offsetter2d offsetter(0.25, JoinType::ROUND, 1e-4);
+  const Shape2d result(offsetter.offset(shape.paths()));
+  ASSERT_EQ(result.size(), 1);
+  // Every point on the outline lies at the distance from the original
+  for (const auto& path : result.paths()) {
+    auto start = path.front().point();
+    for (const auto& command : path) {
+      if (command.type() == CommandType::MOVE ||
+          command.type() == CommandType::CLOSE) {
+        continue;
+      }
+      const Segment2d segment(start, command);
+      const auto point = segment.evaluateAt(0.5);
+      auto distance = std::numeric_limits<double>::max();
+      for (int i{}; i <= 1000; ++i) {
+        const Segment2d cubic(Vec2d(0.0, 0.0), Command2d(
+            CommandType::CUBIC, Vec2d(1.0, -1.0), Vec2d(2.0, 1.0),
+            Vec2d(3.0, 0.0)));
+        const auto offset = cubic.evaluateAt(i / 1000.0) - point;
+        distance = std::min(distance, std::sqrt(offset.dot(offset)));
+      }
+      if (point.y < 0.5 && point.x > 0 && point.x < 3) {
+        EXPECT_NEAR(distance, 0.25, 1e-3);
+      }
+      start = command.point();
+    }
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
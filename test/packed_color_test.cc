@@ -0,0 +1,133 @@
+//
+//  takram/graphics/packed_color_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/channel.h"
+#include "takram/graphics/channel_order.h"
+#include "takram/graphics/color.h"
+#include "takram/graphics/packed_color.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+std::vector<Color4u> makeColors(std::size_t size) {
+  std::vector<Color4u> result;
+  for (std::size_t i{}; i < size; ++i) {
+    result.emplace_back(i * 4, i * 4 + 1, i * 4 + 2, i * 4 + 3);
+  }
+  return result;
+}
+
+template <ChannelOrder From, ChannelOrder To>
+void expectConversions() {
+  // Sizes covering blocks of four colors and the remainders
+  for (const std::size_t size : {1, 3, 4, 7, 8, 13}) {
+    const auto colors = makeColors(size);
+    std::vector<PackedColor<From>> source(size);
+    convertOrder(colors.data(), size, source.data());
+    std::vector<PackedColor<To>> result(size);
+    convertOrder(source.data(), size, result.data());
+    std::vector<Color4u> unpacked(size);
+    convertOrder(result.data(), size, unpacked.data());
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(source[i], PackedColor<From>(colors[i])) << From;
+      ASSERT_EQ(result[i], PackedColor<To>(colors[i])) << From << To;
+      ASSERT_EQ(result[i], PackedColor<To>(source[i])) << From << To;
+      ASSERT_EQ(unpacked[i], colors[i]) << From << To;
+    }
+
+    // In place
+    PackedView<From> view(source.data(), size);
+    PackedView<To> swizzled(source.data(), size);
+    swizzled.copy(view);
+    for (std::size_t i{}; i < size; ++i) {
+      ASSERT_EQ(swizzled.pixel(i), colors[i]) << From << To;
+    }
+  }
+}
+
+template <ChannelOrder From>
+void expectConversions() {
+  expectConversions<From, ChannelOrder::RGBA>();
+  expectConversions<From, ChannelOrder::BGRA>();
+  expectConversions<From, ChannelOrder::ARGB>();
+  expectConversions<From, ChannelOrder::ABGR>();
+}
+
+}  // namespace
+
+TEST(PackedColorTest, OrdersBytesInMemory) {
+  const Color4u color(1, 2, 3, 4);
+  const auto expectBytes = [](std::uint32_t value,
+                              std::vector<std::uint8_t> expected) {
+    const auto bytes = reinterpret_cast<const std::uint8_t *>(&value);
+    EXPECT_EQ(std::vector<std::uint8_t>(bytes, bytes + 4), expected);
+  };
+  expectBytes(PackedRGBA(color).value, {1, 2, 3, 4});
+  expectBytes(PackedBGRA(color).value, {3, 2, 1, 4});
+  expectBytes(PackedARGB(color).value, {4, 1, 2, 3});
+  expectBytes(PackedABGR(color).value, {4, 3, 2, 1});
+
+  PackedBGRA packed(color);
+  EXPECT_EQ(packed.color(), color);
+  EXPECT_EQ(packed.red(), 1);
+  EXPECT_EQ(packed.alpha(), 4);
+  packed.set_green(20);
+  EXPECT_EQ(packed.at(Channel::GREEN), 20);
+  EXPECT_EQ(packed.color(), Color4u(1, 20, 3, 4));
+  EXPECT_EQ(PackedBGRA(1, 2, 3), PackedBGRA(Color4u(1, 2, 3)));
+}
+
+TEST(PackedColorTest, ViewsBuffersInPlace) {
+  std::vector<std::uint8_t> buffer{10, 20, 30, 40, 50, 60, 70, 80};
+  PackedARGBView view(buffer.data(), 2);
+  ASSERT_EQ(view.size(), 2);
+  EXPECT_EQ(view.pixel(0), Color4u(20, 30, 40, 10));
+  EXPECT_EQ(view.packed(1).color(), Color4u(60, 70, 80, 50));
+  view.at(1, Channel::ALPHA) = 0;
+  EXPECT_EQ(buffer[4], 0);
+  view.setPixel(0, Color4u(1, 2, 3, 4));
+  EXPECT_EQ(buffer, std::vector<std::uint8_t>({4, 1, 2, 3, 0, 60, 70, 80}));
+  view.fill(Color4u(5, 6, 7, 8));
+  EXPECT_EQ(buffer, std::vector<std::uint8_t>({8, 5, 6, 7, 8, 5, 6, 7}));
+}
+
+TEST(PackedColorTest, ConvertsChannelOrders) {
+  expectConversions<ChannelOrder::RGBA>();
+  expectConversions<ChannelOrder::BGRA>();
+  expectConversions<ChannelOrder::ARGB>();
+  expectConversions<ChannelOrder::ABGR>();
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,177 @@
+//
+//  takram/graphics/palette_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/palette.h"
+#include "takram/graphics/palette_method.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+const PaletteMethod methods[] = {
+  PaletteMethod::MEDIAN_CUT,
+  PaletteMethod::K_MEANS
+};
+
+// A smooth image, in which every channel ramps in its own direction
+std::vector<Color4u> makeImage(int width, int height) {
+  std::vector<Color4u> result;
+  for (int y{}; y < height; ++y) {
+    for (int x{}; x < width; ++x) {
+      result.emplace_back(x * 255 / (width - 1), y * 255 / (height - 1),
+                          (x + y) * 255 / (width + height - 2));
+    }
+  }
+  return result;
+}
+
+template <int C>
+double rootMeanSquareError(const std::vector<Color<std::uint8_t, C>>& image,
+                           const std::vector<Color<std::uint8_t, C>>& mapped) {
+  double sum{};
+  for (std::size_t i{}; i < image.size(); ++i) {
+    for (int c{}; c < C; ++c) {
+      const double difference = image[i].vector[c] - mapped[i].vector[c];
+      sum += difference * difference;
+    }
+  }
+  return std::sqrt(sum / image.size() / C);
+}
+
+}  // namespace
+
+TEST(PaletteTest, GeneratesExactPalettes) {
+  const std::vector<Color4u> colors{
+    Color4u(255, 0, 0), Color4u(0, 255, 0), Color4u(0, 0, 255),
+    Color4u(255, 255, 255, 128)
+  };
+  std::vector<Color4u> image;
+  for (int i{}; i < 1000; ++i) {
+    image.push_back(colors[i % colors.size()]);
+  }
+  // Transparent colors make a single entry
+  image.emplace_back(10, 20, 30, 0);
+  image.emplace_back(40, 50, 60, 0);
+  for (const auto method : methods) {
+    auto palette = generatePalette(image.data(), image.size(), 16, method);
+    ASSERT_EQ(palette.size(), colors.size() + 1) << method;
+    for (const auto& color : colors) {
+      EXPECT_NE(std::find(palette.begin(), palette.end(), color),
+                palette.end()) << method;
+    }
+    EXPECT_NE(std::find(palette.begin(), palette.end(), Color4u(0, 0, 0, 0)),
+              palette.end()) << method;
+    palette = generatePalette(image.data(), image.size(), 1, method);
+    EXPECT_EQ(palette.size(), 1) << method;
+  }
+  EXPECT_TRUE(generatePalette(image.data(), 0, 16).empty());
+}
+
+TEST(PaletteTest, QuantizesImages) {
+  const auto image = makeImage(256, 256);
+  for (const auto method : methods) {
+    const auto palette = generatePalette(image.data(), image.size(), 64,
+                                         method);
+    EXPECT_EQ(palette.size(), 64) << method;
+    const PaletteMapper4u mapper(palette);
+    std::vector<Color4u> mapped(image.size());
+    mapper.map(image.data(), image.size(), mapped.data());
+    EXPECT_LT(rootMeanSquareError(image, mapped), 12) << method;
+    std::vector<std::uint8_t> indices(image.size());
+    mapper.map(image.data(), image.size(), indices.data());
+    for (std::size_t i{}; i < image.size(); ++i) {
+      ASSERT_EQ(palette[indices[i]], mapped[i]);
+    }
+  }
+
+  std::vector<Color3u> opaque(image.begin(), image.end());
+  const auto palette = generatePalette(opaque.data(), opaque.size(), 16);
+  EXPECT_EQ(palette.size(), 16);
+  const PaletteMapper3u mapper(palette);
+  std::vector<Color3u> mapped(opaque.size());
+  mapper.map(opaque.data(), opaque.size(), mapped.data());
+  EXPECT_LT(rootMeanSquareError(opaque, mapped), 24);
+}
+
+TEST(PaletteTest, MapsToNearestEntries) {
+  std::mt19937 engine(1);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  const auto random = [&]() {
+    return Color4u(distribution(engine), distribution(engine),
+                   distribution(engine), distribution(engine));
+  };
+  std::vector<Color4u> palette;
+  for (int i{}; i < 37; ++i) {
+    auto color = random();
+    color.a = std::max<int>(color.a, 1);
+    palette.push_back(color);
+  }
+  palette.emplace_back(255, 0, 255, 0);
+  PaletteMapper4u mapper;
+  EXPECT_EQ(mapper.nearest(Color4u()), -1);
+  mapper.set(palette);
+  for (int i{}; i < 10000; ++i) {
+    auto color = random();
+    if (i % 100 == 0) {
+      color.a = 0;
+    }
+    // Transparent colors are all transparent black
+    const auto normalize = [](const Color4u& color) {
+      return color.a ? color : Color4u(0, 0, 0, 0);
+    };
+    auto expected = -1;
+    auto distance = std::numeric_limits<int>::max();
+    for (std::size_t j{}; j < palette.size(); ++j) {
+      int d{};
+      for (int c{}; c < 4; ++c) {
+        const auto difference = normalize(color).vector[c] -
+                                normalize(palette[j]).vector[c];
+        d += difference * difference;
+      }
+      if (d < distance) {
+        distance = d;
+        expected = j;
+      }
+    }
+    ASSERT_EQ(mapper.nearest(color), expected);
+  }
+  EXPECT_EQ(mapper.nearest(Color4u(255, 255, 255, 0)), palette.size() - 1);
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,140 @@
+//
+//  takram/graphics/projector_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/path.h"
+#include "takram/graphics/projector.h"
+#include "takram/graphics/segment.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+TEST(ProjectorTest, ProjectsOntoCircles) {
+  Shape2d shape;
+  const auto w = std::sqrt(0.5);
+  shape.moveTo(1.0, 0.0);
+  shape.conicTo(1.0, 1.0, 0.0, 1.0, w);
+  shape.conicTo(-1.0, 1.0, -1.0, 0.0, w);
+  shape.conicTo(-1.0, -1.0, 0.0, -1.0, w);
+  shape.conicTo(1.0, -1.0, 1.0, 0.0, w);
+  const Projector2d projector(shape);
+  for (int i{}; i < 64; ++i) {
+    const auto angle = i * 0.1;
+    for (const auto radius : {0.25, 0.75, 1.5, 4.0}) {
+      const Vec2d point(radius * std::cos(angle), radius * std::sin(angle));
+      const auto projection = projector.nearest(point);
+      EXPECT_NEAR(projection.distance, std::abs(radius - 1), 1e-9);
+      EXPECT_NEAR(projection.point.x, std::cos(angle), 1e-6);
+      EXPECT_NEAR(projection.point.y, std::sin(angle), 1e-6);
+    }
+  }
+}
+
+TEST(ProjectorTest, ProjectsOntoPaths) {
+  Path2d path;
+  path.moveTo(0.0, 0.0);
+  path.cubicTo(3.0, 4.0, -1.0, 4.0, 2.0, 0.0);
+  path.quadraticTo(3.0, -2.0, 4.0, 1.0);
+  path.lineTo(5.0, -1.0);
+  const std::vector<Segment2d> segments(std::begin(path.segments()),
+                                        std::end(path.segments()));
+  const Projector2d projector(path);
+  std::vector<Vec2d> points;
+  for (int i{}; i < 16; ++i) {
+    for (int j{}; j < 16; ++j) {
+      points.emplace_back(-1 + i * 0.45, -2 + j * 0.4);
+    }
+  }
+  const auto projections = projector.nearest(points);
+  ASSERT_EQ(projections.size(), points.size());
+  for (std::size_t i{}; i < points.size(); ++i) {
+    const auto& point = points[i];
+    const auto& projection = projections[i];
+    ASSERT_LT(projection.index, segments.size());
+    const auto evaluated = segments[projection.index].evaluateAt(
+        projection.t);
+    EXPECT_NEAR(evaluated.x, projection.point.x, 1e-12);
+    EXPECT_NEAR(evaluated.y, projection.point.y, 1e-12);
+    EXPECT_NEAR(std::hypot(point.x - evaluated.x, point.y - evaluated.y),
+                projection.distance, 1e-12);
+
+    // Compare with dense sampling
+    auto nearest = projection.distance + 1;
+    for (const auto& segment : segments) {
+      for (int j{}; j <= 4096; ++j) {
+        const auto sample = segment.evaluateAt(j / 4096.0);
+        nearest = std::min(nearest, std::hypot(point.x - sample.x,
+                                               point.y - sample.y));
+      }
+    }
+    EXPECT_LE(projection.distance, nearest + 1e-12);
+    EXPECT_GE(projection.distance, nearest - 1e-3);
+  }
+}
+
+TEST(ProjectorTest, ProjectsOntoIntegralPaths) {
+  // Pieces of integral segments are truncated, which must not keep the
+  // nearest of them from being visited
+  Path2i path;
+  path.moveTo(0, 0);
+  path.cubicTo(3, 4, -1, 4, 2, 0);
+  path.quadraticTo(3, -2, 4, 1);
+  path.conicTo(5, 3, 7, 1, 0.5);
+  const std::vector<Segment2i> segments(std::begin(path.segments()),
+                                        std::end(path.segments()));
+  const Projector2i projector(path);
+  for (int i{}; i < 12; ++i) {
+    for (int j{}; j < 8; ++j) {
+      const Vec2d point(-1 + i * 0.7, -2 + j * 0.8);
+      const auto projection = projector.nearest(point);
+      auto nearest = projection.distance + 1;
+      for (const auto& segment : segments) {
+        for (int k{}; k <= 4096; ++k) {
+          const auto sample = segment.evaluateAt(k / 4096.0);
+          nearest = std::min(nearest, std::hypot(point.x - sample.x,
+                                                 point.y - sample.y));
+        }
+      }
+      EXPECT_LE(projection.distance, nearest + 1e-12);
+      EXPECT_GE(projection.distance, nearest - 1e-3);
+    }
+  }
+}
+
+TEST(ProjectorTest, ProjectsOntoNothing) {
+  const Projector2d projector;
+  EXPECT_TRUE(std::isinf(projector.nearest(Vec2d(0.0, 0.0)).distance));
+}
+
+}  // namespace graphics
+}  // namespace takram
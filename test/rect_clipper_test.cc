@@ -0,0 +1,181 @@
+//
+//  rect_clipper_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/rect_clipper.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+// Sum of the areas of the subpaths, each of which begins with a move
+double calculateArea(const Path2d& path) {
+  double area{};
+  Vec2d first;
+  Vec2d previous;
+  for (const auto& command : path) {
+    if (command.type() == CommandType::MOVE) {
+      area += previous.cross(first);
+      first = command.point();
+    } else if (command.type() != CommandType::CLOSE) {
+      area += previous.cross(command.point());
+    }
+    previous = command.point();
+  }
+  return (area + previous.cross(first)) / 2;
+}
+
+}  // namespace
+
+TEST(RectClipperTest, ClipsLines) {
+  Path2d path;
+  path.moveTo(-1, -1);
+  path.lineTo(2, -1);
+  path.lineTo(2, 2);
+  path.lineTo(-1, 2);
+  path.close();
+  const RectClipper2d clipper(Rect2d(Vec2d(0.0, 0.0), Vec2d(1.0, 1.0)));
+  const auto shape = clipper.clip(path);
+  ASSERT_EQ(shape.size(), 1);
+  const auto bounds = shape.front().bounds();
+  EXPECT_DOUBLE_EQ(bounds.minX(), 0);
+  EXPECT_DOUBLE_EQ(bounds.minY(), 0);
+  EXPECT_DOUBLE_EQ(bounds.maxX(), 1);
+  EXPECT_DOUBLE_EQ(bounds.maxY(), 1);
+  EXPECT_DOUBLE_EQ(calculateArea(shape.front()), 1);
+}
+
+TEST(RectClipperTest, ClipsSubpaths) {
+  Path2d path;
+  path.moveTo(-1, -1);
+  path.lineTo(1, -1);
+  path.lineTo(1, 1);
+  path.lineTo(-1, 1);
+  path.close();
+  auto& commands = path.commands();
+  commands.emplace_back(CommandType::MOVE, Vec2d(2.0, 0.5));
+  commands.emplace_back(CommandType::LINE, Vec2d(4.0, 0.5));
+  commands.emplace_back(CommandType::LINE, Vec2d(4.0, 3.0));
+  commands.emplace_back(CommandType::LINE, Vec2d(2.0, 3.0));
+  commands.emplace_back(CommandType::CLOSE);
+  const RectClipper2d clipper(Rect2d(Vec2d(0.0, 0.0), Vec2d(3.0, 2.0)));
+  const auto shape = clipper.clip(path);
+  ASSERT_EQ(shape.size(), 1);
+  int moves{};
+  for (const auto& command : shape.front()) {
+    moves += command.type() == CommandType::MOVE;
+  }
+  EXPECT_EQ(moves, 2);
+  EXPECT_DOUBLE_EQ(calculateArea(shape.front()), 2.5);
+}
+
+TEST(RectClipperTest, RoundsIntegers) {
+  Path2i path;
+  path.moveTo(-1, -1);
+  path.lineTo(4, -1);
+  path.lineTo(4, 4);
+  path.lineTo(-1, 4);
+  path.close();
+  const RectClipper2i clipper(Rect2d(Vec2d(0.25, 0.25), Vec2d(2.75, 2.75)));
+  const auto shape = clipper.clip(path);
+  ASSERT_EQ(shape.size(), 1);
+  const auto bounds = shape.front().bounds();
+  EXPECT_EQ(bounds.minX(), 0);
+  EXPECT_EQ(bounds.minY(), 0);
+  EXPECT_EQ(bounds.maxX(), 3);
+  EXPECT_EQ(bounds.maxY(), 3);
+}
+
+TEST(RectClipperTest, RejectsOutside) {
+  Path2d path;
+  path.moveTo(2, 2);
+  path.lineTo(3, 2);
+  path.lineTo(3, 3);
+  path.close();
+  const RectClipper2d clipper(Rect2d(Vec2d(0.0, 0.0), Vec2d(1.0, 1.0)));
+  EXPECT_TRUE(clipper.clip(path).empty());
+}
+
+TEST(RectClipperTest, SplitsCurves) {
+  Path2d path;
+  path.moveTo(0, 0);
+  path.quadraticTo(1, 2, 2, 0);
+  path.close();
+  const RectClipper2d clipper(Rect2d(Vec2d(0.0, 0.0), Vec2d(1.0, 2.0)));
+  const auto shape = clipper.clip(path);
+  ASSERT_EQ(shape.size(), 1);
+  const auto bounds = shape.front().bounds(true);
+  EXPECT_NEAR(bounds.maxX(), 1, 1e-9);
+  EXPECT_NEAR(bounds.maxY(), 1, 1e-9);
+  bool curved{};
+  for (const auto& command : shape.front()) {
+    curved = curved || command.type() == CommandType::QUADRATIC;
+  }
+  EXPECT_TRUE(curved);
+}
+
+TEST(RectClipperTest, SplitsOpenPaths) {
+  Path2d path;
+  path.moveTo(-1, 0.5);
+  path.lineTo(0.5, 0.5);
+  path.lineTo(0.5, 2);
+  path.lineTo(0.75, 0.5);
+  path.lineTo(2, 0.5);
+  const RectClipper2d clipper(Rect2d(Vec2d(0.0, 0.0), Vec2d(1.0, 1.0)));
+  EXPECT_EQ(clipper.clip(path).size(), 2);
+}
+
+TEST(RectClipperTest, Tiles) {
+  Shape2d shape;
+  shape.moveTo(0.5, 0.5);
+  shape.lineTo(3.5, 0.5);
+  shape.lineTo(3.5, 3.5);
+  shape.lineTo(0.5, 3.5);
+  shape.close();
+  const auto tiles = RectClipper2d::tile(
+      shape, Rect2d(Vec2d(0.0, 0.0), Vec2d(4.0, 4.0)), 4, 4);
+  ASSERT_EQ(tiles.size(), 16);
+  double area{};
+  for (const auto& tile : tiles) {
+    for (const auto& path : tile.paths()) {
+      area += calculateArea(path);
+    }
+  }
+  EXPECT_DOUBLE_EQ(area, 9);
+}
+
+}  // namespace graphics
+}  // namespace takram
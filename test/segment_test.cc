@@ -0,0 +1,88 @@
+//
+//  segment_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/segment.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+TEST(SegmentTest, SubsegmentOfConic) {
+  const Segment2d segment(Vec2d(1.0, 0.0), Command2d(
+      CommandType::CONIC, Vec2d(0.0, 2.0), Vec2d(-1.0, 0.0), 0.5));
+  const auto subsegment = segment.subsegment(0.25, 0.75);
+  const auto start = segment.evaluateAt(0.25);
+  const auto middle = segment.evaluateAt(0.5);
+  const auto end = segment.evaluateAt(0.75);
+  EXPECT_NEAR(subsegment.start().x, start.x, 1e-12);
+  EXPECT_NEAR(subsegment.start().y, start.y, 1e-12);
+  EXPECT_NEAR(subsegment.point().x, end.x, 1e-12);
+  EXPECT_NEAR(subsegment.point().y, end.y, 1e-12);
+  EXPECT_NEAR(subsegment.evaluateAt(0.5).x, middle.x, 1e-12);
+  EXPECT_NEAR(subsegment.evaluateAt(0.5).y, middle.y, 1e-12);
+}
+
+TEST(SegmentTest, SolveCubic) {
+  const Segment2d segment(Vec2d(0.0, 0.0), Command2d(
+      CommandType::CUBIC, Vec2d(0.0, 1.0), Vec2d(1.0, -1.0), Vec2d(1.0, 0.0)));
+  double roots[3];
+  const auto count = segment.solveY(0, roots);
+  ASSERT_EQ(count, 1);
+  EXPECT_NEAR(segment.evaluateAt(roots[0]).y, 0, 1e-12);
+  EXPECT_NEAR(roots[0], 0.5, 1e-12);
+}
+
+TEST(SegmentTest, SolveDegenerateCubic) {
+  // Half of a symmetric cubic, whose leading coefficient cancels out in y
+  const auto r = 0.8312279461950736;
+  const auto y = 5.1146221882214284;
+  const Segment2d segment(Vec2d(7.0, y), Command2d(
+      CommandType::CUBIC, Vec2d(7.0, y - r), Vec2d(7.0 + 3 * r, y - r),
+      Vec2d(7.0 + 2 * r, y)));
+  const auto half = segment.subsegment(0, 0.5);
+  double roots[3];
+  const auto count = half.solveY(4.908481, roots);
+  ASSERT_EQ(count, 1);
+  EXPECT_NEAR(half.evaluateAt(roots[0]).y, 4.908481, 1e-12);
+}
+
+TEST(SegmentTest, FindExtrema) {
+  const Segment2d segment(Vec2d(0.0, 0.0), Command2d(
+      CommandType::CONIC, Vec2d(1.0, 2.0), Vec2d(2.0, 0.0), 2.0));
+  double parameters[2];
+  ASSERT_EQ(segment.findExtremaX(parameters), 0);
+  ASSERT_EQ(segment.findExtremaY(parameters), 1);
+  EXPECT_NEAR(parameters[0], 0.5, 1e-12);
+  EXPECT_NEAR(segment.derivativeAt(parameters[0]).y, 0, 1e-12);
+}
+
+}  // namespace graphics
+}  // namespace takram
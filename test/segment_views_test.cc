@@ -0,0 +1,188 @@
+//
+//  takram/graphics/segment_views_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <iterator>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/segment_views.h"
+#include "takram/graphics/shape.h"
+#include "takram/math/rectangle.h"
+#include "takram/math/vector.h"
+
+namespace takram {
+namespace graphics {
+
+TEST(SegmentViewsTest, IteratesSegments) {
+  Path2d path;
+  path.moveTo(0.0, 0.0);
+  path.lineTo(1.0, 0.0);
+  path.quadraticTo(1.0, 1.0, 0.0, 1.0);
+  path.close();
+  const auto segments = path.segments();
+  auto itr = std::begin(segments);
+  ASSERT_NE(itr, std::end(segments));
+  EXPECT_EQ(itr->type(), CommandType::LINE);
+  EXPECT_EQ(itr->start(), Vec2d(0.0, 0.0));
+  ++itr;
+  ASSERT_NE(itr, std::end(segments));
+  EXPECT_EQ(itr->type(), CommandType::QUADRATIC);
+  EXPECT_EQ(itr->start(), Vec2d(1.0, 0.0));
+  ++itr;
+  ASSERT_NE(itr, std::end(segments));
+  EXPECT_TRUE(itr.closing());
+  EXPECT_EQ(itr->start(), Vec2d(0.0, 1.0));
+  EXPECT_EQ(itr->point(), Vec2d(0.0, 0.0));
+  ++itr;
+  EXPECT_EQ(itr, std::end(segments));
+}
+
+TEST(SegmentViewsTest, IteratesSubpaths) {
+  Shape2d shape;
+  shape.moveTo(0.0, 0.0);
+  shape.lineTo(1.0, 0.0);
+  shape.lineTo(0.0, 1.0);
+  shape.close();
+  shape.moveTo(2.0, 0.0);
+  shape.lineTo(3.0, 0.0);
+  std::size_t count{};
+  const auto segments = shape.segments();
+  for (auto itr = std::begin(segments); itr != std::end(segments); ++itr) {
+    EXPECT_EQ(itr.subpath(), count < 3 ? 0 : 1);
+    ++count;
+  }
+  EXPECT_EQ(count, 4);
+}
+
+TEST(SegmentViewsTest, Transforms) {
+  Path2d path;
+  path.moveTo(0.0, 0.0);
+  path.conicTo(1.0, 1.0, 2.0, 0.0, 0.5);
+  const auto view = path.segments() | transformed([](const Vec2d& point) {
+    return Vec2d(point.x * 2, point.y + 1);
+  });
+  auto itr = std::begin(view);
+  ASSERT_NE(itr, std::end(view));
+  EXPECT_EQ(itr->start(), Vec2d(0.0, 1.0));
+  EXPECT_EQ(itr->control(), Vec2d(2.0, 2.0));
+  EXPECT_EQ(itr->point(), Vec2d(4.0, 1.0));
+  EXPECT_EQ(itr->weight(), 0.5);
+  EXPECT_EQ(++itr, std::end(view));
+}
+
+TEST(SegmentViewsTest, Filters) {
+  Path2d path;
+  path.moveTo(0.0, 0.0);
+  path.lineTo(1.0, 0.0);
+  path.cubicTo(2.0, 0.0, 2.0, 1.0, 1.0, 1.0);
+  path.lineTo(0.0, 1.0);
+  std::size_t count{};
+  for (const auto& segment : path.segments() | filtered(CommandType::LINE)) {
+    EXPECT_EQ(segment.type(), CommandType::LINE);
+    ++count;
+  }
+  EXPECT_EQ(count, 2);
+}
+
+TEST(SegmentViewsTest, Flattens) {
+  Path2d path;
+  path.moveTo(1.0, 0.0);
+  path.conicTo(1.0, 1.0, 0.0, 1.0, std::sqrt(0.5));
+  const auto tolerance = 1e-3;
+  std::size_t count{};
+  Vec2d point(1.0, 0.0);
+  for (const auto& segment : path.segments() | flattened(tolerance)) {
+    ASSERT_EQ(segment.type(), CommandType::LINE);
+    EXPECT_EQ(segment.start(), point);
+    EXPECT_NEAR(std::hypot(segment.point().x, segment.point().y), 1, 1e-12);
+    const auto middle = (segment.start() + segment.point()) / 2;
+    EXPECT_GE(std::hypot(middle.x, middle.y), 1 - tolerance);
+    point = segment.point();
+    ++count;
+  }
+  EXPECT_GT(count, 1);
+  EXPECT_EQ(point, Vec2d(0.0, 1.0));
+}
+
+TEST(SegmentViewsTest, Clips) {
+  Path2d path;
+  path.moveTo(-1.0, 0.5);
+  path.lineTo(2.0, 0.5);
+  path.lineTo(2.0, 2.0);
+  path.cubicTo(1.0, 0.0, 0.0, 0.0, -1.0, 2.0);
+  const Rect2d rect(0.0, 0.0, 1.0, 1.0);
+  const auto paths = makePaths(path.segments() | clipped(rect));
+  ASSERT_EQ(paths.size(), 2);
+  const auto& line = paths.front();
+  ASSERT_EQ(line.size(), 2);
+  EXPECT_NEAR(line.front().point().x, 0, 1e-12);
+  EXPECT_NEAR(line.back().point().x, 1, 1e-12);
+  const auto& curve = paths.back();
+  ASSERT_EQ(curve.size(), 2);
+  EXPECT_EQ(curve.back().type(), CommandType::CUBIC);
+  EXPECT_NEAR(curve.front().point().x, 1, 1e-12);
+  EXPECT_NEAR(curve.back().point().x, 0, 1e-12);
+  const auto bounds = curve.bounds(true);
+  EXPECT_GE(bounds.minY(), 0 - 1e-12);
+  EXPECT_LE(bounds.maxY(), 1 + 1e-12);
+}
+
+TEST(SegmentViewsTest, Composes) {
+  Path2d path;
+  path.moveTo(0.0, 0.0);
+  path.quadraticTo(1.0, 2.0, 2.0, 0.0);
+  path.close();
+  const auto view = path.segments()
+      | transformed([](const Vec2d& point) { return point * 2; })
+      | flattened(1e-2)
+      | clipped(Rect2d(0.0, 0.0, 4.0, 1.0));
+  const auto paths = makePaths(view);
+  ASSERT_EQ(paths.size(), 2);
+  for (const auto& path : paths) {
+    for (const auto& command : path) {
+      EXPECT_GE(command.point().y, 0 - 1e-12);
+      EXPECT_LE(command.point().y, 1 + 1e-12);
+    }
+  }
+}
+
+TEST(SegmentViewsTest, CalculatesPreciseBoundsOfConics) {
+  Path2d path;
+  path.moveTo(1.0, 0.0);
+  path.conicTo(0.0, 1.0, -1.0, 0.0, 0.5);
+  const Segment2d segment(Vec2d(1.0, 0.0), path.back());
+  double parameters[1];
+  ASSERT_EQ(segment.findExtremaY(parameters), 1);
+  const auto bounds = path.bounds(true);
+  EXPECT_NEAR(bounds.maxY(), segment.evaluateAt(parameters[0]).y, 1e-12);
+  EXPECT_LT(bounds.maxY(), 1);
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,81 @@
+//
+//  test/shape_helpers.h
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+#ifndef TAKRAM_GRAPHICS_TEST_SHAPE_HELPERS_H_
+#define TAKRAM_GRAPHICS_TEST_SHAPE_HELPERS_H_
+
+#include "takram/graphics/command_type.h"
+#include "takram/graphics/segment.h"
+#include "takram/graphics/shape.h"
+
+namespace takram {
+namespace graphics {
+
+inline Shape2d makeRectangle(double x,
+                             double y,
+                             double width,
+                             double height) {
+  Shape2d shape;
+  shape.moveTo(x, y);
+  shape.lineTo(x + width, y);
+  shape.lineTo(x + width, y + height);
+  shape.lineTo(x, y + height);
+  shape.close();
+  return shape;
+}
+
+// Signed area enclosed by the paths, which approximates curved segments by
+// polylines of 256 pieces
+inline double calculateArea(const Shape2d& shape) {
+  double area{};
+  for (const auto& path : shape.paths()) {
+    auto start = path.front().point();
+    for (const auto& command : path) {
+      if (command.type() == CommandType::MOVE) {
+        continue;
+      }
+      if (command.type() == CommandType::CLOSE) {
+        break;
+      }
+      const Segment2d segment(start, command);
+      auto previous = segment.evaluateAt(0);
+      for (int i = 1; i <= 256; ++i) {
+        const auto point = segment.evaluateAt(i / 256.0);
+        area += previous.cross(point);
+        previous = point;
+      }
+      start = command.point();
+    }
+    area += start.cross(path.front().point());
+  }
+  return area / 2;
+}
+
+}  // namespace graphics
+}  // namespace takram
+
+#endif  // TAKRAM_GRAPHICS_TEST_SHAPE_HELPERS_H_
@@ -0,0 +1,112 @@
+//
+//  takram/graphics/shape_interner_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/command.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/shape.h"
+#include "takram/graphics/shape_interner.h"
+#include "takram/graphics/shared_shape.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+Path2d makePath(double offset) {
+  Path2d path;
+  path.moveTo(0.0 + offset, 0.0);
+  path.lineTo(4.0 + offset, 0.0);
+  path.cubicTo(5.0 + offset, 1.0, 5.0 + offset, 3.0, 4.0 + offset, 4.0);
+  path.close();
+  return path;
+}
+
+}  // namespace
+
+TEST(ShapeInternerTest, DeduplicatesShapes) {
+  ShapeInterner2d interner;
+  const auto shape1 = interner.intern(makePath(0.0));
+  const auto shape2 = interner.intern(makePath(0.0));
+  const auto shape3 = interner.intern(makePath(1.0));
+  EXPECT_TRUE(shape1.shares(shape2));
+  EXPECT_FALSE(shape1.shares(shape3));
+  EXPECT_TRUE(interner.intern(shape2).shares(shape1));
+  EXPECT_TRUE(interner.intern(SharedShape2d(makePath(1.0))).shares(shape3));
+  EXPECT_FALSE(interner.intern(makePath(1e-9)).shares(shape1));
+  EXPECT_EQ(interner.size(), 3);
+
+  const auto statistics = interner.statistics();
+  EXPECT_EQ(statistics.lookups, 6);
+  EXPECT_EQ(statistics.hits, 3);
+  EXPECT_EQ(statistics.entries, 3);
+  EXPECT_EQ(statistics.bytes_saved, 3 * 4 * sizeof(Command2d));
+  EXPECT_DOUBLE_EQ(statistics.hitRate(), 0.5);
+
+  interner.clear();
+  EXPECT_EQ(interner.size(), 0);
+  EXPECT_EQ(interner.statistics().lookups, 0);
+  EXPECT_FALSE(interner.intern(makePath(0.0)).shares(shape1));
+}
+
+TEST(ShapeInternerTest, DeduplicatesWithinTolerance) {
+  ShapeInterner2d interner(1e-6);
+  const auto shape = interner.intern(makePath(0.0));
+  EXPECT_TRUE(interner.intern(makePath(1e-9)).shares(shape));
+  EXPECT_TRUE(interner.intern(SharedShape2d(makePath(-1e-9))).shares(shape));
+  EXPECT_FALSE(interner.intern(makePath(1e-3)).shares(shape));
+
+  // Differs only in the command type
+  auto path = makePath(0.0);
+  path.commands().back().type() = CommandType::LINE;
+  path.commands().back().point() = path.front().point();
+  EXPECT_FALSE(interner.intern(path).shares(shape));
+  EXPECT_EQ(interner.size(), 3);
+}
+
+TEST(ShapeInternerTest, InternsConcurrently) {
+  ShapeInterner2d interner(0.0, 4);
+  std::vector<SharedShape2d> shapes(1000);
+  parallelFor(shapes.size(), [&](std::size_t index) {
+    shapes[index] = interner.intern(makePath(index % 10));
+  });
+  EXPECT_EQ(interner.size(), 10);
+  for (std::size_t index{}; index < shapes.size(); ++index) {
+    EXPECT_TRUE(shapes[index].shares(shapes[index % 10]));
+    EXPECT_EQ(shapes[index].path(0), makePath(index % 10));
+  }
+  const auto statistics = interner.statistics();
+  EXPECT_EQ(statistics.lookups, 1000);
+  EXPECT_EQ(statistics.hits, 990);
+}
+
+}  // namespace graphics
+}  // namespace takram
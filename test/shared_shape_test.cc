@@ -0,0 +1,136 @@
+//
+//  takram/graphics/shared_shape_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/hasher.h"
+#include "takram/graphics/parallel.h"
+#include "takram/graphics/path.h"
+#include "takram/graphics/shape.h"
+#include "takram/graphics/shared_shape.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+template <class T = double>
+Shape2<T> makeShape() {
+  Shape2<T> shape;
+  shape.moveTo(0.0, 0.0);
+  shape.lineTo(4.0, 0.0);
+  shape.quadraticTo(6.0, 2.0, 4.0, 4.0);
+  shape.close();
+  shape.moveTo(1.0, 1.0);
+  shape.cubicTo(1.0, 3.0, 3.0, 3.0, 3.0, 1.0);
+  shape.close();
+  return shape;
+}
+
+}  // namespace
+
+TEST(SharedShapeTest, StoresShapes) {
+  const auto shape = makeShape();
+  const SharedShape2d shared(shape);
+  ASSERT_EQ(shared.size(), shape.size());
+  EXPECT_EQ(shared.commands().size(), 7);
+  EXPECT_EQ(shared.shape(), shape);
+  EXPECT_EQ(shared.path(1), shape.back());
+  EXPECT_EQ(std::distance(shared.begin(0), shared.end(0)), 4);
+  EXPECT_EQ(shared.bounds(), shape.bounds());
+  EXPECT_EQ(shared.bounds(true), shape.bounds(true));
+  EXPECT_EQ(shared.hash(), hash(shape));
+  EXPECT_EQ(Hasher(1e-3).update(shared).digest(), hash(shape, 1e-3));
+  EXPECT_EQ(std::distance(std::begin(shared.segments()),
+                          std::end(shared.segments())),
+            std::distance(std::begin(shape.segments()),
+                          std::end(shape.segments())));
+
+  const SharedShape2d empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty.size(), 0);
+  EXPECT_EQ(empty.hash(), hash(Shape2d()));
+  EXPECT_EQ(empty, SharedShape2d(Shape2d()));
+}
+
+TEST(SharedShapeTest, SharesStorageBetweenCopies) {
+  SharedShape2d shared(makeShape());
+  auto copy = shared;
+  EXPECT_TRUE(copy.shares(shared));
+  EXPECT_EQ(copy.commands().data(), shared.commands().data());
+  EXPECT_EQ(copy, shared);
+
+  // Replacing the shape of one copy leaves the other intact
+  auto shape = makeShape();
+  shape.back().back().point() = Vec2d(2.0, 2.0);
+  shape.moveTo(5.0, 5.0);
+  shape.lineTo(6.0, 6.0);
+  copy.set(shape);
+  EXPECT_FALSE(copy.shares(shared));
+  EXPECT_NE(copy, shared);
+  EXPECT_EQ(shared.shape(), makeShape());
+  EXPECT_EQ(copy.shape(), shape);
+  copy.reset();
+  EXPECT_TRUE(copy.empty());
+}
+
+TEST(SharedShapeTest, ComparesContents) {
+  const SharedShape2d shared1(makeShape());
+  const SharedShape2d shared2(makeShape());
+  EXPECT_FALSE(shared1.shares(shared2));
+  EXPECT_EQ(shared1, shared2);
+  EXPECT_EQ(shared1.hash(), SharedShape2f(makeShape<float>()).hash());
+  EXPECT_NE(shared1, SharedShape2d(makeShape().paths().front()));
+
+  // The same commands split into paths differently
+  Shape2d shape;
+  shape.paths().emplace_back();
+  for (const auto& command : makeShape()) {
+    shape.paths().back().commands().emplace_back(command);
+  }
+  EXPECT_NE(shared1, SharedShape2d(shape));
+}
+
+TEST(SharedShapeTest, ReadsConcurrently) {
+  const SharedShape2d shared(makeShape());
+  std::vector<SharedShape2d> copies(64, shared);
+  std::atomic<std::size_t> count(0);
+  parallelFor(copies.size(), [&](std::size_t index) {
+    const auto copy = copies[index];
+    if (copy == shared && copy.shape() == makeShape()) {
+      ++count;
+    }
+  });
+  EXPECT_EQ(count, copies.size());
+}
+
+}  // namespace graphics
+}  // namespace takram
@@ -0,0 +1,223 @@
+//
+//  takram/graphics/srgb_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+#include "takram/graphics/srgb.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+// Floats in [0, 1] whose representations are apart by the step from the
+// offset, the boundaries between the pieces, and values just outside the
+// range. Representations of positive floats are ordered as their values.
+std::vector<float> makeValues(std::uint32_t step, std::uint32_t offset = 0) {
+  std::vector<float> result;
+  for (auto bits = offset; ; bits += step) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    if (value > 1.0f) {
+      break;
+    }
+    result.emplace_back(value);
+  }
+  for (const auto value : {0.0031308f, 0.04045f, 1.0f, -0.5f, 1.5f}) {
+    result.emplace_back(value);
+    result.emplace_back(std::nextafter(value, 0.0f));
+    result.emplace_back(std::nextafter(value, 2.0f));
+  }
+  return result;
+}
+
+double clamp(double value) {
+  return std::min(std::max(value, 0.0), 1.0);
+}
+
+// Relative errors are measured only where the results are normalized floats
+void expectWithinBounds(const std::vector<float>& values) {
+  std::vector<float> decoded(values.size());
+  std::vector<float> encoded(values.size());
+  decodeSRGB(values.data(), values.size(), decoded.data());
+  encodeSRGB(values.data(), values.size(), encoded.data());
+  double decode_error{};
+  double encode_error{};
+  for (std::size_t i{}; i < values.size(); ++i) {
+    const auto value = clamp(values[i]);
+    const auto expected = decodeSRGB(value);
+    if (expected >= std::numeric_limits<float>::min()) {
+      decode_error = std::max(
+          decode_error, std::abs(decoded[i] - expected) / expected);
+    } else {
+      EXPECT_NEAR(decoded[i], expected, std::numeric_limits<float>::min());
+    }
+    encode_error = std::max(
+        encode_error, std::abs(encoded[i] - encodeSRGB(value)));
+  }
+  EXPECT_LT(decode_error, 1e-6);
+  EXPECT_LT(encode_error, 1e-6);
+}
+
+void expectBytesExact(std::vector<float> values) {
+  // Values around the thresholds between codes
+  for (int code = 1; code < 256; ++code) {
+    const auto threshold = static_cast<float>(
+        decodeSRGB((code - 0.5) / 255.0));
+    auto value = threshold;
+    for (int i{}; i < 4; ++i) {
+      value = std::nextafter(value, 0.0f);
+    }
+    for (int i{}; i < 8; ++i) {
+      values.emplace_back(value);
+      value = std::nextafter(value, 1.0f);
+    }
+  }
+  std::vector<std::uint8_t> result(values.size());
+  encodeSRGB(values.data(), values.size(), result.data());
+  for (std::size_t i{}; i < values.size(); ++i) {
+    const auto expected = std::round(255.0 * encodeSRGB(clamp(values[i])));
+    ASSERT_EQ(result[i], expected) << values[i];
+  }
+}
+
+}  // namespace
+
+TEST(SRGBTest, ConvertsValues) {
+  EXPECT_DOUBLE_EQ(decodeSRGB(0.0), 0.0);
+  EXPECT_DOUBLE_EQ(decodeSRGB(1.0), 1.0);
+  EXPECT_NEAR(decodeSRGB(0.5), 0.214041140, 1e-9);
+  EXPECT_NEAR(encodeSRGB(0.214041140), 0.5, 1e-9);
+  for (int i{}; i <= 1000; ++i) {
+    const auto value = i / 1000.0;
+    EXPECT_NEAR(encodeSRGB(decodeSRGB(value)), value, 1e-12);
+  }
+  const auto color = decodeSRGB(Color4d(0.5, 0.0, 1.0, 0.5));
+  EXPECT_NEAR(color.r, 0.214041140, 1e-9);
+  EXPECT_EQ(color.g, 0.0);
+  EXPECT_EQ(color.b, 1.0);
+  EXPECT_EQ(color.a, 0.5);
+  EXPECT_NEAR(encodeSRGB(Color3f(color.r, 0.0f, 1.0f)).r, 0.5f, 1e-6f);
+}
+
+TEST(SRGBTest, DecodesBytes) {
+  std::vector<std::uint8_t> values(256);
+  for (int code{}; code < 256; ++code) {
+    values[code] = code;
+  }
+  std::vector<float> result(values.size());
+  decodeSRGB(values.data(), values.size(), result.data());
+  for (int code{}; code < 256; ++code) {
+    EXPECT_EQ(result[code], static_cast<float>(decodeSRGB(code / 255.0)));
+  }
+}
+
+TEST(SRGBTest, ConvertsFloatsWithinBounds) {
+  expectWithinBounds(makeValues(997));
+}
+
+TEST(SRGBTest, EncodesBytesExactly) {
+  expectBytesExact(makeValues(997));
+}
+
+// Every float in [0, 1], which takes about a minute
+TEST(SRGBTest, DISABLED_ConvertsAllFloatsWithinBounds) {
+  for (std::uint32_t offset{}; offset < 1024; ++offset) {
+    ASSERT_NO_FATAL_FAILURE(expectWithinBounds(makeValues(1024, offset)));
+  }
+}
+
+TEST(SRGBTest, DISABLED_EncodesAllBytesExactly) {
+  for (std::uint32_t offset{}; offset < 1024; ++offset) {
+    ASSERT_NO_FATAL_FAILURE(expectBytesExact(makeValues(1024, offset)));
+  }
+}
+
+TEST(SRGBTest, ClampsNonFiniteValues) {
+  const auto nan = std::numeric_limits<float>::quiet_NaN();
+  const auto infinity = std::numeric_limits<float>::infinity();
+  const float values[] = {0.5f, nan, infinity, -infinity, nan};
+  const std::uint8_t codes[] = {188, 0, 255, 0, 0};
+  const float clamped[] = {0.5f, 0.0f, 1.0f, 0.0f, 0.0f};
+
+  // Lengths that place every value both in blocks and in the remainder
+  for (std::size_t size = 1; size < 10; ++size) {
+    std::vector<float> buffer;
+    for (std::size_t i{}; i < size; ++i) {
+      buffer.push_back(values[i % 5]);
+    }
+    std::vector<std::uint8_t> encoded(size);
+    std::vector<float> encoded_floats(size);
+    std::vector<float> decoded(size);
+    encodeSRGB(buffer.data(), size, encoded.data());
+    encodeSRGB(buffer.data(), size, encoded_floats.data());
+    decodeSRGB(buffer.data(), size, decoded.data());
+    for (std::size_t i{}; i < size; ++i) {
+      const auto value = clamped[i % 5];
+      ASSERT_EQ(encoded[i], codes[i % 5]) << size << " " << i;
+      ASSERT_NEAR(encoded_floats[i], encodeSRGB(value), 1e-6)
+          << size << " " << i;
+      ASSERT_NEAR(decoded[i], decodeSRGB(value), 1e-6) << size << " " << i;
+    }
+  }
+}
+
+TEST(SRGBTest, ConvertsImages) {
+  Image4u image(19, 3);
+  for (int y{}; y < image.height(); ++y) {
+    for (int x{}; x < image.width(); ++x) {
+      image.setPixel(x, y, Color4u(x * 13, y * 100, 255 - x, x + y));
+    }
+  }
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    Image4f linear(image.width(), image.height(), layout);
+    decodeSRGB(image.view(), linear.view());
+    Image4u encoded(image.width(), image.height(), layout);
+    encodeSRGB(linear.view(), encoded.view());
+    for (int y{}; y < image.height(); ++y) {
+      for (int x{}; x < image.width(); ++x) {
+        const auto pixel = image.pixel(x, y);
+        EXPECT_NEAR(linear.at(x, y, 0), decodeSRGB(pixel.r / 255.0), 1e-7);
+        EXPECT_EQ(linear.at(x, y, 3), Depth<float>::convert(pixel.a));
+        EXPECT_EQ(encoded.pixel(x, y), pixel);
+      }
+    }
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram
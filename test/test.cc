@@ -33,10 +33,28 @@ namespace graphics {
 
 template class Color<float, 3>;
 template class Color<float, 4>;
+template class Color<Half, 4>;
+template class Image<float, 4>;
+template class ImageView<float, 4>;
+template class Gradient<float>;
+template class Histogram<float, 4>;
+template class PaletteMapper<4>;
+template class PackedColor<ChannelOrder::BGRA>;
+template class PackedView<ChannelOrder::ARGB>;
+template class PremultipliedColor<float>;
 template class Shape<float, 2>;
 template class Path<float, 2>;
 template class Command<float, 2>;
 template class Conic<float, 2>;
+template class Segment<float, 2>;
+template class RectClipper<float, 2>;
+template class Boolean<float, 2>;
+template class Offsetter<float, 2>;
+template class MonotoneSegments<float, 2>;
+template class Intersector<float, 2>;
+template class Projector<float, 2>;
+template class SharedShape<float, 2>;
+template class ShapeInterner<float, 2>;
 
 }  // namespace graphics
 }  // namespace takram
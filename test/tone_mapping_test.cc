@@ -0,0 +1,162 @@
+//
+//  takram/graphics/tone_mapping_test.cc
+//
+//  The MIT License
+//
+//  Copyright (C) 2015 Shota Matsuda
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+//  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "takram/graphics/color.h"
+#include "takram/graphics/image.h"
+#include "takram/graphics/image_layout.h"
+#include "takram/graphics/srgb.h"
+#include "takram/graphics/tone_map_operator.h"
+#include "takram/graphics/tone_mapping.h"
+
+namespace takram {
+namespace graphics {
+
+namespace {
+
+const ToneMapOperator operators[] = {
+  ToneMapOperator::REINHARD,
+  ToneMapOperator::ACES,
+  ToneMapOperator::FILMIC
+};
+
+// Colors of high dynamic range, along with values that need clamping
+std::vector<Color4f> makeColors(std::size_t size) {
+  std::mt19937 engine(1);
+  std::uniform_real_distribution<float> distribution(-4.0f, 4.0f);
+  std::vector<Color4f> result;
+  for (std::size_t i{}; i < size; ++i) {
+    result.emplace_back(std::exp2(distribution(engine) * 2),
+                        std::exp2(distribution(engine)),
+                        distribution(engine),
+                        distribution(engine) / 4 + 0.5f);
+  }
+  result[0].r = std::numeric_limits<float>::quiet_NaN();
+  result[1].g = std::numeric_limits<float>::infinity();
+  result[2].b = -std::numeric_limits<float>::infinity();
+  result[3].a = std::numeric_limits<float>::quiet_NaN();
+  return result;
+}
+
+std::uint8_t referenceAlpha(float alpha) {
+  return static_cast<std::uint8_t>(std::round(
+      alpha > 0 ? (alpha < 1 ? alpha : 1) * 255 : 0));
+}
+
+}  // namespace
+
+TEST(ToneMappingTest, MapsToDisplayRange) {
+  for (const auto op : operators) {
+    EXPECT_NEAR(toneMap(0.0, op), 0, 1e-12) << op;
+    EXPECT_EQ(toneMap(-1.0f, op), 0) << op;
+    EXPECT_EQ(toneMap(std::numeric_limits<float>::quiet_NaN(), op), 0) << op;
+    const auto white = toneMap(std::numeric_limits<float>::infinity(), op);
+    EXPECT_LE(white, 1) << op;
+    EXPECT_GT(white, 0.99f) << op;
+    double previous{};
+    for (double value = 0.01; value < 100; value *= 1.1) {
+      const auto mapped = toneMap(value, op);
+      EXPECT_GE(mapped, previous) << op;
+      EXPECT_LE(mapped, 1) << op;
+      previous = mapped;
+    }
+  }
+  EXPECT_EQ(toneMap(1.0, ToneMapOperator::REINHARD), 0.5);
+  EXPECT_NEAR(toneMap(11.2, ToneMapOperator::FILMIC), 1, 1e-12);
+  EXPECT_EQ(toneMap(20.0, ToneMapOperator::ACES), 1);
+  const auto color = toneMap(Color4d(1, 2, 4, 0.25),
+                             ToneMapOperator::REINHARD, 0.5);
+  EXPECT_EQ(color, Color4d(1 / 3.0, 0.5, 2 / 3.0, 0.25));
+}
+
+TEST(ToneMappingTest, FusesEncodingAndDepth) {
+  const auto colors = makeColors(40000);
+  std::vector<Color4u> result(colors.size());
+  std::vector<Color4s> wide(colors.size());
+  for (const auto op : operators) {
+    for (const auto exposure : {1.0f, 0.375f}) {
+      toneMapSRGB(colors.data(), colors.size(), result.data(), op, exposure);
+      toneMapSRGB(colors.data(), colors.size(), wide.data(), op, exposure);
+      for (std::size_t i{}; i < colors.size(); ++i) {
+        const auto mapped = toneMap(colors[i], op, exposure);
+        std::uint8_t codes[3];
+        encodeSRGB(mapped.pointer(), 3, codes);
+        const Color4u expected(codes[0], codes[1], codes[2],
+                               referenceAlpha(colors[i].a));
+        ASSERT_EQ(result[i], expected) << op << " " << i;
+        for (int c{}; c < 3; ++c) {
+          const auto encoded = encodeSRGB(static_cast<double>(
+              mapped.vector[c])) * 65535;
+          ASSERT_NEAR(wide[i].vector[c], encoded, 1) << op << " " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(ToneMappingTest, MapsImages) {
+  const int width = 67;
+  const int height = 31;
+  const auto colors = makeColors(width * height);
+  const auto op = ToneMapOperator::FILMIC;
+  std::vector<Color4u> expected(colors.size());
+  toneMapSRGB(colors.data(), colors.size(), expected.data(), op, 2.0f);
+  std::vector<Color3f> opaque(colors.begin(), colors.end());
+  std::vector<Color3u> expected3(opaque.size());
+  toneMapSRGB(opaque.data(), opaque.size(), expected3.data(), op, 2.0f);
+  for (const auto layout : {ImageLayout::INTERLEAVED, ImageLayout::PLANAR}) {
+    Image4f image(width, height, layout);
+    Image3f image3(width, height, layout);
+    for (int y{}; y < height; ++y) {
+      for (int x{}; x < width; ++x) {
+        image.setPixel(x, y, colors[y * width + x]);
+        image3.setPixel(x, y, opaque[y * width + x]);
+      }
+    }
+    Image4u result(width, height);
+    Image3u result3(width, height, layout);
+    toneMapSRGB(image.view(), result.view(), op, 2.0f);
+    toneMapSRGB(image3.view(), result3.view(), op, 2.0f);
+    for (int y{}; y < height; ++y) {
+      for (int x{}; x < width; ++x) {
+        ASSERT_EQ(result.pixel(x, y), expected[y * width + x]);
+        ASSERT_EQ(result3.pixel(x, y), expected3[y * width + x]);
+        ASSERT_EQ(result3.pixel(x, y), Color3u(expected[y * width + x]));
+      }
+    }
+  }
+}
+
+}  // namespace graphics
+}  // namespace takram